@@ -818,6 +818,8 @@ typedef enum libvlc_thumbnailer_seek_speed_t
 {
     libvlc_media_thumbnail_seek_precise,
     libvlc_media_thumbnail_seek_fast,
+    /** Decode the nearest keyframe only, at reduced resolution */
+    libvlc_media_thumbnail_seek_keyframe,
 } libvlc_thumbnailer_seek_speed_t;
 
 /**
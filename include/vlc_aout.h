@@ -480,6 +480,100 @@ static inline void aout_PauseDefault(audio_output_t *aout, bool paused,
     (void) date;
 }
 
+/**
+ * \defgroup aout_ring Audio output ring buffer
+ *
+ * Lock-free single producer, single consumer queue of audio frames, for
+ * audio outputs whose rendering thread pulls the samples from a callback.
+ *
+ * The producer is the thread calling play(), flush() and time_get(). It may
+ * never block the consumer, the (real-time) rendering callback, and the
+ * consumer never blocks nor allocates.
+ * @{
+ */
+typedef struct vlc_aout_ring vlc_aout_ring_t;
+
+/**
+ * Creates a ring buffer.
+ *
+ * \param frame_size size of an audio frame (bytes)
+ * \param rate sample rate (Hz)
+ * \param duration minimum duration of audio the buffer can hold
+ * \return a ring buffer or NULL on error
+ */
+VLC_API vlc_aout_ring_t *vlc_aout_ring_New(size_t frame_size, unsigned rate,
+                                           vlc_tick_t duration) VLC_USED;
+
+/**
+ * Destroys a ring buffer.
+ *
+ * \note Neither the producer nor the consumer may use the buffer anymore.
+ */
+VLC_API void vlc_aout_ring_Delete(vlc_aout_ring_t *);
+
+/**
+ * Queues audio frames (producer side).
+ *
+ * \return the number of frames queued, less than requested if the buffer
+ *         is full
+ */
+VLC_API size_t vlc_aout_ring_Write(vlc_aout_ring_t *, const void *buf,
+                                   size_t frames);
+
+/**
+ * Discards all queued frames (producer side).
+ *
+ * The consumer skips the frames on its next access.
+ */
+VLC_API void vlc_aout_ring_Flush(vlc_aout_ring_t *);
+
+/**
+ * Estimates the playback delay (producer side).
+ *
+ * This is the time until the next frame written is rendered, including
+ * the frames already consumed but still being rendered, as reported by
+ * vlc_aout_ring_Consume(). It can implement audio_output_t.time_get.
+ *
+ * \param now current system time
+ */
+VLC_API vlc_tick_t vlc_aout_ring_GetDelay(vlc_aout_ring_t *, vlc_tick_t now);
+
+/**
+ * Gets the queued frames (consumer side).
+ *
+ * The frames are not removed from the queue, until vlc_aout_ring_Consume().
+ *
+ * \param buf pointer to the first queued frame [OUT]
+ * \return the number of frames contiguous in memory from *buf, which can be
+ *         less than the number of frames queued if the buffer wraps around
+ */
+VLC_API size_t vlc_aout_ring_Peek(vlc_aout_ring_t *, const void **buf);
+
+/**
+ * Removes frames from the queue (consumer side).
+ *
+ * \param frames number of frames, at most the value from the last
+ *               vlc_aout_ring_Peek()
+ * \param date system time when the first of the frames will be rendered,
+ *             or VLC_TICK_INVALID if unknown
+ */
+VLC_API void vlc_aout_ring_Consume(vlc_aout_ring_t *, size_t frames,
+                                   vlc_tick_t date);
+
+/**
+ * Reads frames (consumer side).
+ *
+ * This copies and removes up to the given number of frames from the queue.
+ *
+ * \param date system time when the first frame will be rendered,
+ *             or VLC_TICK_INVALID if unknown
+ * \return the number of frames read
+ */
+VLC_API size_t vlc_aout_ring_Read(vlc_aout_ring_t *, void *buf, size_t frames,
+                                  vlc_tick_t date);
+
+/** @} */
+
 /* Audio output filters */
 
 /**
@@ -528,6 +622,38 @@ VLC_API block_t *aout_FiltersDrain(aout_filters_t *);
 VLC_API void     aout_FiltersFlush(aout_filters_t *);
 VLC_API void     aout_FiltersChangeViewpoint(aout_filters_t *, const vlc_viewpoint_t *vp);
 
+typedef struct
+{
+    uint64_t buffers; /**< output buffers requested by the filters */
+    uint64_t allocations; /**< of which required a heap allocation */
+} aout_filters_stats_t;
+
+/**
+ * Reads the output buffers statistics of a chain of audio filters.
+ *
+ * Once the chain has processed a few buffers, the number of allocations
+ * should not increase anymore.
+ */
+VLC_API void aout_FiltersGetStats(aout_filters_t *, aout_filters_stats_t *);
+
+/**
+ * Loudness measurements (EBU R128).
+ *
+ * Audio filters measuring the loudness publish these values as the
+ * "loudness-momentary", "loudness-short-term", "loudness-integrated",
+ * "loudness-range" and "loudness-peak" float variables of their parent
+ * object, in that order: setting "loudness-peak" completes an update.
+ * Values not measured (yet) are NAN.
+ */
+struct vlc_audio_loudness
+{
+    float momentary; /**< loudness of the last 400 ms (LUFS) */
+    float short_term; /**< loudness of the last 3 s (LUFS) */
+    float integrated; /**< gated loudness of the whole program (LUFS) */
+    float range; /**< loudness range of the program (LU) */
+    float true_peak; /**< highest true peak of the program (dBTP) */
+};
+
 VLC_API vout_thread_t *aout_filter_GetVout(filter_t *, const video_format_t *);
 
 /** @} */
@@ -46,7 +46,10 @@ struct audio_volume
     struct vlc_object_t obj;
 
     vlc_fourcc_t format; /**< Audio samples format */
+    vlc_fourcc_t output_format; /**< Amplified samples format (the amplifier
+                                     converts the samples if it differs) */
     void (*amplify)(audio_volume_t *, block_t *, float); /**< Amplifier */
+    void *sys; /**< Private data of the amplifier */
 };
 
 /** @} */
@@ -201,4 +201,30 @@ VLC_API unsigned vlc_CPU(void);
 
 # endif
 
+/**
+ * Requests worker threads from the process-wide budget.
+ *
+ * Multi-threaded decoders, encoders and filters share a budget of threads,
+ * by default the number of CPUs (see the "cpu-threads" option). A new user gets
+ * at most a fair share of the budget, i.e. the budget divided by the number
+ * of users, so that many concurrent pipelines do not each spawn one thread
+ * per CPU. As the earlier users keep their threads, the CPUs may be
+ * oversubscribed, but by no more than twice the budget.
+ *
+ * \param obj object requesting the threads (for the configuration)
+ * \param wanted number of threads the caller would use on an idle system
+ * \return the number of threads allotted, between 1 and wanted; it must be
+ *         given back to vlc_CPU_ReleaseThreads() when the threads stop
+ */
+VLC_API unsigned vlc_CPU_AcquireThreads(vlc_object_t *obj, unsigned wanted);
+#define vlc_CPU_AcquireThreads(o, n) \
+        vlc_CPU_AcquireThreads(VLC_OBJECT(o), n)
+
+/**
+ * Gives threads back to the process-wide budget.
+ *
+ * \param count value returned by vlc_CPU_AcquireThreads()
+ */
+VLC_API void vlc_CPU_ReleaseThreads(unsigned count);
+
 #endif /* !VLC_CPU_H */
@@ -27,6 +27,7 @@
 
 #include <vlc_es.h>
 #include <vlc_picture.h>
+#include <vlc_block.h>
 
 /**
  * \defgroup filter Filters
@@ -47,12 +48,18 @@ struct filter_subpicture_callbacks
     subpicture_t *(*buffer_new)(filter_t *);
 };
 
+struct filter_audio_callbacks
+{
+    block_t *(*buffer_new)(filter_t *, size_t);
+};
+
 typedef struct filter_owner_t
 {
     union
     {
         const struct filter_video_callbacks *video;
         const struct filter_subpicture_callbacks *sub;
+        const struct filter_audio_callbacks *audio;
     };
     void *sys;
 } filter_owner_t;
@@ -174,6 +181,31 @@ static inline picture_t *filter_NewPicture( filter_t *p_filter )
     return pic;
 }
 
+/**
+ * This function will return a new block usable by p_filter as an output
+ * audio buffer. You have to release it using block_Release or by returning
+ * it to the caller as a pf_audio_filter return value.
+ * Provided for convenience.
+ *
+ * The owner may recycle the buffers, which is why filters should prefer this
+ * function to block_Alloc().
+ *
+ * \param p_filter filter_t object
+ * \param size size of the buffer in bytes
+ * \return new block on success or NULL on failure
+ */
+static inline block_t *filter_NewAudioBuffer( filter_t *p_filter,
+                                              size_t size )
+{
+    block_t *block = NULL;
+    if ( p_filter->owner.audio != NULL
+      && p_filter->owner.audio->buffer_new != NULL )
+        block = p_filter->owner.audio->buffer_new( p_filter, size );
+    if ( block == NULL )
+        block = block_Alloc( size );
+    return block;
+}
+
 /**
  * Flush a filter
  *
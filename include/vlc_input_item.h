@@ -525,6 +525,11 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+    float f_loudness_momentary; /**< LUFS, NAN if not measured */
+    float f_loudness_short_term; /**< LUFS, NAN if not measured */
+    float f_loudness_integrated; /**< LUFS, NAN if not measured */
+    float f_loudness_range; /**< LU, NAN if not measured */
+    float f_true_peak; /**< dBTP, NAN if not measured */
 };
 
 /**
@@ -52,6 +52,8 @@ typedef struct {
  *
  * This avoids allocating and deallocationg pictures repeatedly, and ensures
  * that memory consumption remains within limits.
+ * There is no upper bound on the number of pictures, and free pictures are
+ * obtained without locking.
  *
  * To obtain a picture from the pool, use picture_pool_Get(). To increase and
  * decrease the reference count, use picture_Hold() and picture_Release()
@@ -169,6 +171,26 @@ VLC_USED;
  */
 VLC_API unsigned picture_pool_GetSize(const picture_pool_t *);
 
+/**
+ * Picture pool usage statistics
+ */
+typedef struct {
+    unsigned size; /**< total number of pictures */
+    unsigned in_use; /**< pictures currently handed out */
+    unsigned peak_in_use; /**< highest number of pictures handed out */
+    uint64_t exhausted; /**< picture_pool_Get() calls finding no picture */
+    uint64_t waited; /**< times picture_pool_Wait() had to block */
+} picture_pool_stats_t;
+
+/**
+ * Reads the usage statistics of a pool.
+ *
+ * A pool created with picture_pool_Reserve() accounts for its own consumer
+ * only, independently of the master pool.
+ * @note This function is thread-safe, but the values are only a snapshot.
+ */
+VLC_API void picture_pool_GetStats(picture_pool_t *, picture_pool_stats_t *);
+
 
 #endif /* VLC_PICTURE_POOL_H */
 
@@ -43,6 +43,32 @@ typedef struct vlc_thumbnailer_request_t vlc_thumbnailer_request_t;
  */
 typedef void(*vlc_thumbnailer_cb)( void* data, picture_t* thumbnail );
 
+/**
+ * \brief vlc_thumbnailer_batch_cb defines a callback invoked for each thumbnail
+ * of a batch request
+ *
+ * This callback will be called once for each requested time, in the order of
+ * the request, provided the request is not cancelled before its completion.
+ * The picture ownership rules are the same as for \link vlc_thumbnailer_cb \endlink
+ *
+ * \param data Is the opaque pointer passed as vlc_thumbnailer_RequestBatch last parameter
+ * \param index The index of the thumbnail time in the request
+ * \param thumbnail The generated thumbnail, or NULL in case of failure or timeout
+ */
+typedef void(*vlc_thumbnailer_batch_cb)( void* data, size_t index,
+                                         picture_t* thumbnail );
+
+/**
+ * \brief vlc_thumbnailer_file_cb defines a callback invoked when a thumbnail
+ * file is available
+ *
+ * \param data Is the opaque pointer passed as vlc_thumbnailer_RequestToFile
+ *             last parameter
+ * \param path The path of the thumbnail file, or NULL in case of failure or
+ *             timeout. It is only valid during the callback.
+ */
+typedef void(*vlc_thumbnailer_file_cb)( void* data, const char* path );
+
 
 /**
  * \brief vlc_thumbnailer_Create Creates a thumbnailer object
@@ -59,6 +85,8 @@ enum vlc_thumbnailer_seek_speed
     VLC_THUMBNAILER_SEEK_PRECISE,
     /** Fast, but potentially imprecise */
     VLC_THUMBNAILER_SEEK_FAST,
+    /** Fastest: only the nearest keyframe is decoded, at reduced resolution */
+    VLC_THUMBNAILER_SEEK_KEYFRAME,
 };
 
 /**
@@ -112,6 +140,71 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
                               input_item_t *input_item, vlc_tick_t timeout,
                               vlc_thumbnailer_cb cb, void* user_data );
 
+/**
+ * \brief vlc_thumbnailer_RequestBatch Requests thumbnails at several times
+ * \param thumbnailer A thumbnailer object
+ * \param times The times at which the thumbnails should be taken
+ * \param count The number of times
+ * \param speed The seeking speed \sa{enum vlc_thumbnailer_seek_speed}
+ * \param input_item The input item to generate the thumbnails for
+ * \param timeout A timeout value for the whole request, or VLC_TICK_INVALID to
+ *                disable timeout
+ * \param cb A user callback to be called for each thumbnail (success & error)
+ * \param user_data An opaque value, provided as pf_cb's first parameter
+ * \return An opaque request object, or NULL in case of failure
+ *
+ * The input item is opened only once, and seeked from one time to the next.
+ * If this function returns a valid request object, the callback is guaranteed
+ * to be called count times, even in case of later failure.
+ * The returned request object must not be used after the last callback has been
+ * invoked. The times array is copied and can be released after calling this
+ * function.
+ */
+VLC_API vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data );
+
+/**
+ * \brief vlc_thumbnailer_RequestToFile Requests a thumbnail file at a given time
+ * \param thumbnailer A thumbnailer object
+ * \param time The time at which the thumbnail should be taken
+ * \param speed The seeking speed \sa{enum vlc_thumbnailer_seek_speed}
+ * \param input_item The input item to generate the thumbnail for
+ * \param timeout A timeout value, or VLC_TICK_INVALID to disable timeout
+ * \param format The image format: VLC_CODEC_JPEG, VLC_CODEC_PNG or
+ *               VLC_CODEC_WEBP
+ * \param width The thumbnail width, or 0 to keep the picture aspect ratio
+ * \param height The thumbnail height, or 0 to keep the picture aspect ratio
+ * \param crop Whether the picture should be cropped to preserve its aspect
+ *             ratio
+ * \param cache_dir The directory of the thumbnail files, or NULL for the user
+ *                  cache directory
+ * \param cb A user callback to be called on completion (success & error)
+ * \param user_data An opaque value, provided as pf_cb's first parameter
+ * \return An opaque request object, or NULL in case of failure
+ *
+ * The thumbnail file is named after a hash of the input content, so that the
+ * same media is not thumbnailed twice, even if it was moved or renamed. If
+ * the file already exists, the callback is invoked without opening the input.
+ * Requests are processed by the thumbnailer worker threads
+ * ("thumbnailer-threads"), which reuse their encoders and scalers from one
+ * request to the next.
+ * The request object follows the same rules as the one returned by
+ * \link vlc_thumbnailer_RequestByTime \endlink
+ */
+VLC_API vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestToFile( vlc_thumbnailer_t *thumbnailer,
+                               vlc_tick_t time,
+                               enum vlc_thumbnailer_seek_speed speed,
+                               input_item_t *input_item, vlc_tick_t timeout,
+                               vlc_fourcc_t format,
+                               unsigned width, unsigned height, bool crop,
+                               const char *cache_dir,
+                               vlc_thumbnailer_file_cb cb, void* user_data );
+
 /**
  * \brief vlc_thumbnailer_Cancel Cancel a thumbnail request
  * \param thumbnailer A thumbnailer object
@@ -1114,6 +1114,20 @@ static void media_on_thumbnail_ready( void* data, picture_t* thumbnail )
     free( req );
 }
 
+static enum vlc_thumbnailer_seek_speed
+media_thumbnail_speed( libvlc_thumbnailer_seek_speed_t speed )
+{
+    switch ( speed )
+    {
+        case libvlc_media_thumbnail_seek_fast:
+            return VLC_THUMBNAILER_SEEK_FAST;
+        case libvlc_media_thumbnail_seek_keyframe:
+            return VLC_THUMBNAILER_SEEK_KEYFRAME;
+        default:
+            return VLC_THUMBNAILER_SEEK_PRECISE;
+    }
+}
+
 libvlc_media_thumbnail_request_t*
 libvlc_media_thumbnail_request_by_time( libvlc_media_t *md, libvlc_time_t time,
                                         libvlc_thumbnailer_seek_speed_t speed,
@@ -1137,8 +1151,7 @@ libvlc_media_thumbnail_request_by_time( libvlc_media_t *md, libvlc_time_t time,
     libvlc_media_retain( md );
     req->req = vlc_thumbnailer_RequestByTime( p_priv->p_thumbnailer,
         VLC_TICK_FROM_MS( time ),
-        speed == libvlc_media_thumbnail_seek_fast ?
-            VLC_THUMBNAILER_SEEK_FAST : VLC_THUMBNAILER_SEEK_PRECISE,
+        media_thumbnail_speed( speed ),
         md->p_input_item,
         timeout > 0 ? VLC_TICK_FROM_MS( timeout ) : VLC_TICK_INVALID,
         media_on_thumbnail_ready, req );
@@ -1173,8 +1186,7 @@ libvlc_media_thumbnail_request_by_pos( libvlc_media_t *md, float pos,
     req->type = picture_type;
     libvlc_media_retain( md );
     req->req = vlc_thumbnailer_RequestByPos( priv->p_thumbnailer, pos,
-        speed == libvlc_media_thumbnail_seek_fast ?
-            VLC_THUMBNAILER_SEEK_FAST : VLC_THUMBNAILER_SEEK_PRECISE,
+        media_thumbnail_speed( speed ),
         md->p_input_item,
         timeout > 0 ? VLC_TICK_FROM_MS( timeout ) : VLC_TICK_INVALID,
         media_on_thumbnail_ready, req );
@@ -0,0 +1,43 @@
+/*****************************************************************************
+ * round_neon.h: float to integer rounding with NEON intrinsics
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <arm_neon.h>
+
+/**
+ * Rounds to the nearest integer, ties to even, like lrintf() in the default
+ * rounding mode.
+ *
+ * The values must be within [-2^22, 2^22], e.g. clamped 16-bits samples.
+ */
+static inline int32x4_t RoundF32_NEON(float32x4_t v)
+{
+#ifdef __aarch64__
+    return vcvtnq_s32_f32(v);
+#else
+    /* ARMv7 has no rounding conversion. Adding 1.5 * 2^23 leaves the
+     * rounded value in the low mantissa bits, with the round-to-nearest-even
+     * mode of the NEON unit. The bits are read as an integer, so that the
+     * addition cannot be simplified away. */
+    const float32x4_t magic = vdupq_n_f32(12582912.f);
+
+    return vsubq_s32(vreinterpretq_s32_f32(vaddq_f32(v, magic)),
+                     vreinterpretq_s32_f32(magic));
+#endif
+}
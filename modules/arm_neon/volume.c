@@ -46,7 +46,7 @@ static int Probe(vlc_object_t *obj)
 {
     audio_volume_t *volume = (audio_volume_t *)obj;
 
-    if (!vlc_CPU_ARM_NEON())
+    if (!vlc_CPU_ARM_NEON() || volume->output_format != volume->format)
         return VLC_EGENERIC;
     if (volume->format == VLC_CODEC_FL32)
         volume->amplify = AmplifyFloat;
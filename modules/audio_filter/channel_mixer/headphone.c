@@ -29,6 +29,7 @@
 # include "config.h"
 #endif
 
+#include <limits.h>
 #include <math.h>                                        /* sqrt */
 
 #include <vlc_common.h>
@@ -37,12 +38,16 @@
 #include <vlc_filter.h>
 #include <vlc_block.h>
 
+#include "../convolution/convolver.h"
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 static int  OpenFilter ( vlc_object_t * );
 static void CloseFilter( vlc_object_t * );
 static block_t *Convert( filter_t *, block_t * );
+static block_t *Drain( filter_t * );
+static void Flush( filter_t * );
 
 /*****************************************************************************
  * Module descriptor
@@ -70,6 +75,12 @@ static block_t *Convert( filter_t *, block_t * );
      "Dolby Surround encoded streams won't be decoded before being " \
      "processed by this filter. Enabling this setting is not recommended.")
 
+#define HEADPHONE_HRIR_TEXT N_("Head-related impulse responses")
+#define HEADPHONE_HRIR_LONGTEXT N_( \
+     "WAV file containing measured head-related impulse responses, used " \
+     "instead of the physical model. It must contain the left ear and " \
+     "right ear responses of each input channel, in the input order.")
+
 vlc_module_begin ()
     set_description( N_("Headphone virtual spatialization effect") )
     set_shortname( N_("Headphone effect") )
@@ -83,6 +94,8 @@ vlc_module_begin ()
               HEADPHONE_COMPENSATE_LONGTEXT, true )
     add_bool( "headphone-dolby", false, HEADPHONE_DOLBY_TEXT,
               HEADPHONE_DOLBY_LONGTEXT, true )
+    add_loadfile( "headphone-hrir", NULL, HEADPHONE_HRIR_TEXT,
+                  HEADPHONE_HRIR_LONGTEXT )
 
     set_capability( "audio filter", 0 )
     set_callbacks( OpenFilter, CloseFilter )
@@ -103,10 +116,13 @@ struct atomic_operation_t
 
 typedef struct
 {
-    size_t i_overflow_buffer_size;/* in bytes */
-    float * p_overflow_buffer;
     unsigned int i_nb_atomic_operations;
     struct atomic_operation_t * p_atomic_operations;
+} headphone_model_t;
+
+typedef struct
+{
+    convolver_t * p_conv;
 } filter_sys_t;
 
 /*****************************************************************************
@@ -127,7 +143,7 @@ typedef struct
  *
  *          x-axis
  *  */
-static void ComputeChannelOperations( filter_sys_t * p_data
+static void ComputeChannelOperations( headphone_model_t * p_data
         , unsigned int i_rate, unsigned int i_next_atomic_operation
         , int i_source_channel_offset, double d_x, double d_z
         , double d_compensation_length, double d_channel_amplitude_factor )
@@ -184,7 +200,7 @@ static void ComputeChannelOperations( filter_sys_t * p_data
     }
 }
 
-static int Init( vlc_object_t *p_this, filter_sys_t * p_data
+static int InitModel( vlc_object_t *p_this, headphone_model_t * p_data
         , unsigned int i_nb_channels, uint32_t i_physical_channels
         , unsigned int i_rate )
 {
@@ -194,7 +210,6 @@ static int Init( vlc_object_t *p_this, filter_sys_t * p_data
     double d_min = 0;
     unsigned int i_next_atomic_operation;
     int i_source_channel_offset;
-    unsigned int i;
 
     if( var_InheritBool( p_this, "headphone-compensate" ) )
     {
@@ -302,131 +317,119 @@ static int Init( vlc_object_t *p_this, filter_sys_t * p_data
         i_source_channel_offset++;
     }
 
-    /* Initialize the overflow buffer
-     * we need it because the process induce a delay in the samples */
-    p_data->i_overflow_buffer_size = 0;
-    for( i = 0 ; i < p_data->i_nb_atomic_operations ; i++ )
-    {
-        if( p_data->i_overflow_buffer_size
-                < p_data->p_atomic_operations[i].i_delay * 2 * sizeof (float) )
-        {
-            p_data->i_overflow_buffer_size
-                = p_data->p_atomic_operations[i].i_delay * 2 * sizeof (float);
-        }
-    }
-    p_data->p_overflow_buffer = malloc( p_data->i_overflow_buffer_size );
-    if( p_data->p_overflow_buffer == NULL )
-    {
-        free( p_data->p_atomic_operations );
-        return -1;
-    }
-    memset( p_data->p_overflow_buffer, 0 , p_data->i_overflow_buffer_size );
-
     return 0;
 }
 
 /*****************************************************************************
- * DoWork: convert a buffer
+ * Init: sets up the convolution engine, either with measured responses or
+ * with the impulses of the physical model
  *****************************************************************************/
-static void DoWork( filter_t * p_filter,
-                    block_t * p_in_buf, block_t * p_out_buf )
+static int InitMeasured( vlc_object_t *p_this, filter_sys_t * p_sys
+        , unsigned int i_nb_channels, unsigned int i_rate )
 {
-    filter_sys_t *p_sys = p_filter->p_sys;
-    int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
-    int i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
+    char *psz_path = var_InheritString( p_this, "headphone-hrir" );
+    if( psz_path == NULL )
+        return -1;
 
-    float * p_in = (float*) p_in_buf->p_buffer;
-    float * p_out;
-    uint8_t * p_overflow;
-    uint8_t * p_end_overflow;
-    uint8_t * p_slide;
+    unsigned int i_ir_channels;
+    size_t i_length;
+    float *p_ir = convolver_LoadIR( p_this, psz_path, i_rate,
+                                    &i_ir_channels, &i_length );
+    free( psz_path );
+    if( p_ir == NULL )
+        return -1;
 
-    size_t i_overflow_size;     /* in bytes */
-    size_t i_out_size;          /* in bytes */
+    if( i_ir_channels != 2 * i_nb_channels )
+    {
+        msg_Warn( p_this, "head-related impulse responses for %u channels "
+                  "instead of %u, using the physical model",
+                  i_ir_channels / 2, i_nb_channels );
+        free( p_ir );
+        return -1;
+    }
+
+    p_sys->p_conv = convolver_New( CONVOLVER_BLOCK, i_nb_channels, 2,
+                                   i_length );
+    if( p_sys->p_conv == NULL )
+    {
+        free( p_ir );
+        return -1;
+    }
 
-    unsigned int i, j;
+    for( unsigned int i = 0; i < i_ir_channels; i++ )
+        if( convolver_SetIR( p_sys->p_conv, i / 2, i % 2,
+                             p_ir + i_length * i, i_length ) )
+        {
+            convolver_Delete( p_sys->p_conv );
+            free( p_ir );
+            return -1;
+        }
 
-    int i_source_channel_offset;
-    int i_dest_channel_offset;
-    unsigned int i_delay;
-    double d_amplitude_factor;
+    free( p_ir );
+    return 0;
+}
 
-    p_out = (float *)p_out_buf->p_buffer;
-    i_out_size = p_out_buf->i_buffer;
+static int Init( vlc_object_t *p_this, filter_sys_t * p_sys
+        , unsigned int i_nb_channels, uint32_t i_physical_channels
+        , unsigned int i_rate )
+{
+    headphone_model_t model;
+    unsigned int i_min_delay = UINT_MAX, i_max_delay = 0;
+    unsigned int i;
 
-    /* Slide the overflow buffer */
-    p_overflow = (uint8_t *) p_sys->p_overflow_buffer;
-    i_overflow_size = p_sys->i_overflow_buffer_size;
-    p_end_overflow = p_overflow + i_overflow_size;
+    if( InitMeasured( p_this, p_sys, i_nb_channels, i_rate ) == 0 )
+        return 0;
 
-    memset( p_out, 0, i_out_size );
-    memcpy( p_out, p_overflow, __MIN( i_out_size, i_overflow_size ) );
+    if( InitModel( p_this, &model, i_nb_channels, i_physical_channels,
+                   i_rate ) < 0 )
+        return -1;
 
-    p_slide = (uint8_t *) p_sys->p_overflow_buffer;
-    while( p_slide < p_end_overflow )
+    for( i = 0 ; i < model.i_nb_atomic_operations ; i++ )
     {
-        size_t i_bytes_copied;
+        i_min_delay = __MIN( i_min_delay, model.p_atomic_operations[i].i_delay );
+        i_max_delay = __MAX( i_max_delay, model.p_atomic_operations[i].i_delay );
+    }
 
-        if( p_slide + i_out_size < p_end_overflow )
-        {
-            memset( p_slide, 0, i_out_size );
-            if( p_slide + 2 * i_out_size < p_end_overflow )
-                i_bytes_copied = i_out_size;
-            else
-                i_bytes_copied = p_end_overflow - ( p_slide + i_out_size );
-            memcpy( p_slide, p_slide + i_out_size, i_bytes_copied );
-        }
-        else
-        {
-            i_bytes_copied = p_end_overflow - p_slide;
-            memset( p_slide, 0, i_bytes_copied );
-        }
-        p_slide += i_bytes_copied;
+    /* The impulses are sparse: advance them to absorb as much as possible
+     * of the latency of the convolution engine */
+    unsigned int i_advance = __MIN( i_min_delay, CONVOLVER_BLOCK );
+    size_t i_length = i_max_delay - i_advance + 1;
+    float *p_ir = calloc( 2 * i_nb_channels * i_length, sizeof (float) );
+
+    p_sys->p_conv = NULL;
+    if( p_ir != NULL )
+        p_sys->p_conv = convolver_New( CONVOLVER_BLOCK, i_nb_channels, 2,
+                                       i_length );
+    if( p_sys->p_conv == NULL )
+    {
+        free( p_ir );
+        free( model.p_atomic_operations );
+        return -1;
     }
 
-    /* apply the atomic operations */
-    for( i = 0; i < p_sys->i_nb_atomic_operations; i++ )
+    for( i = 0 ; i < model.i_nb_atomic_operations ; i++ )
     {
-        /* shorter variable names */
-        i_source_channel_offset
-            = p_sys->p_atomic_operations[i].i_source_channel_offset;
-        i_dest_channel_offset
-            = p_sys->p_atomic_operations[i].i_dest_channel_offset;
-        i_delay = p_sys->p_atomic_operations[i].i_delay;
-        d_amplitude_factor
-            = p_sys->p_atomic_operations[i].d_amplitude_factor;
-
-        if( p_out_buf->i_nb_samples > i_delay )
-        {
-            /* current buffer coefficients */
-            for( j = 0; j < p_out_buf->i_nb_samples - i_delay; j++ )
-            {
-                ((float*)p_out)[ (i_delay+j)*i_output_nb + i_dest_channel_offset ]
-                    += p_in[ j * i_input_nb + i_source_channel_offset ]
-                       * d_amplitude_factor;
-            }
-
-            /* overflow buffer coefficients */
-            for( j = 0; j < i_delay; j++ )
-            {
-                ((float*)p_overflow)[ j*i_output_nb + i_dest_channel_offset ]
-                    += p_in[ (p_out_buf->i_nb_samples - i_delay + j)
-                       * i_input_nb + i_source_channel_offset ]
-                       * d_amplitude_factor;
-            }
-        }
-        else
+        const struct atomic_operation_t *p_op = &model.p_atomic_operations[i];
+
+        p_ir[i_length * (2 * p_op->i_source_channel_offset
+                         + p_op->i_dest_channel_offset)
+             + p_op->i_delay - i_advance] += p_op->d_amplitude_factor;
+    }
+    free( model.p_atomic_operations );
+
+    for( i = 0 ; i < 2 * i_nb_channels ; i++ )
+        if( convolver_SetIR( p_sys->p_conv, i / 2, i % 2,
+                             p_ir + i_length * i, i_length ) )
         {
-            /* overflow buffer coefficients only */
-            for( j = 0; j < p_out_buf->i_nb_samples; j++ )
-            {
-                ((float*)p_overflow)[ (i_delay - p_out_buf->i_nb_samples + j)
-                                        * i_output_nb + i_dest_channel_offset ]
-                    += p_in[ j * i_input_nb + i_source_channel_offset ]
-                       * d_amplitude_factor;
-            }
+            convolver_Delete( p_sys->p_conv );
+            free( p_ir );
+            return -1;
         }
-    }
+
+    free( p_ir );
+    msg_Dbg( p_this, "%u samples long responses, %u samples of latency",
+             (unsigned int)i_length, CONVOLVER_BLOCK - i_advance );
+    return 0;
 }
 
 /*
@@ -448,14 +451,24 @@ static int OpenFilter( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    /* Request a specific format if not already compatible, before setting
+     * up the model, which depends on the input channels */
+    p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    p_filter->fmt_out.audio.i_format = VLC_CODEC_FL32;
+    p_filter->fmt_out.audio.i_rate = p_filter->fmt_in.audio.i_rate;
+    if( p_filter->fmt_in.audio.i_physical_channels == AOUT_CHANS_STEREO
+     && (p_filter->fmt_in.audio.i_chan_mode & AOUT_CHANMODE_DOLBYSTEREO)
+     && !var_InheritBool( p_filter, "headphone-dolby" ) )
+    {
+        p_filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_5_0;
+    }
+    p_filter->fmt_in.audio.i_chan_mode =
+                                   p_filter->fmt_out.audio.i_chan_mode;
+
     /* Allocate the memory needed to store the module's structure */
     p_sys = p_filter->p_sys = malloc( sizeof(filter_sys_t) );
     if( p_sys == NULL )
         return VLC_ENOMEM;
-    p_sys->i_overflow_buffer_size = 0;
-    p_sys->p_overflow_buffer = NULL;
-    p_sys->i_nb_atomic_operations = 0;
-    p_sys->p_atomic_operations = NULL;
 
     if( Init( VLC_OBJECT(p_filter), p_sys
                 , aout_FormatNbChannels ( &(p_filter->fmt_in.audio) )
@@ -466,19 +479,9 @@ static int OpenFilter( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
-    /* Request a specific format if not already compatible */
-    p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
-    p_filter->fmt_out.audio.i_format = VLC_CODEC_FL32;
-    p_filter->fmt_out.audio.i_rate = p_filter->fmt_in.audio.i_rate;
-    p_filter->fmt_in.audio.i_chan_mode =
-                                   p_filter->fmt_out.audio.i_chan_mode;
-    if( p_filter->fmt_in.audio.i_physical_channels == AOUT_CHANS_STEREO
-     && (p_filter->fmt_in.audio.i_chan_mode & AOUT_CHANMODE_DOLBYSTEREO)
-     && !var_InheritBool( p_filter, "headphone-dolby" ) )
-    {
-        p_filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_5_0;
-    }
     p_filter->pf_audio_filter = Convert;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
 
     aout_FormatPrepare(&p_filter->fmt_in.audio);
     aout_FormatPrepare(&p_filter->fmt_out.audio);
@@ -494,8 +497,7 @@ static void CloseFilter( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    free( p_sys->p_overflow_buffer );
-    free( p_sys->p_atomic_operations );
+    convolver_Delete( p_sys->p_conv );
     free( p_sys );
 }
 
@@ -512,7 +514,7 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
         aout_FormatNbChannels( &(p_filter->fmt_out.audio) ) /
         aout_FormatNbChannels( &(p_filter->fmt_in.audio) );
 
-    block_t *p_out = block_Alloc( i_out_size );
+    block_t *p_out = filter_NewAudioBuffer( p_filter, i_out_size );
     if( !p_out )
     {
         msg_Warn( p_filter, "can't get output buffer" );
@@ -525,8 +527,36 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
-    DoWork( p_filter, p_block, p_out );
+    filter_sys_t *p_sys = p_filter->p_sys;
+    convolver_Process( p_sys->p_conv, (float *)p_block->p_buffer,
+                       (float *)p_out->p_buffer, p_block->i_nb_samples );
 
     block_Release( p_block );
     return p_out;
 }
+
+/*****************************************************************************
+ * Drain: output the samples still delayed by the convolution
+ *****************************************************************************/
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    block_t *p_out = filter_NewAudioBuffer( p_filter,
+                                            CONVOLVER_BLOCK * 2 * sizeof (float) );
+    if( !p_out )
+        return NULL;
+
+    convolver_Process( p_sys->p_conv, NULL, (float *)p_out->p_buffer,
+                       CONVOLVER_BLOCK );
+    p_out->i_nb_samples = CONVOLVER_BLOCK;
+    p_out->i_length = vlc_tick_from_samples( CONVOLVER_BLOCK,
+                                             p_filter->fmt_out.audio.i_rate );
+    return p_out;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    convolver_Reset( p_sys->p_conv );
+}
@@ -183,7 +183,8 @@ static block_t *Mix( filter_t *p_filter, block_t *p_buf )
     const size_t i_outputBlockSize = sizeof(float) * p_sys->i_outputNb * AMB_BLOCK_TIME_LEN;
     const size_t i_nbBlocks = p_sys->inputSamples.size() * sizeof(float) / i_inputBlockSize;
 
-    block_t *p_out_buf = block_Alloc(i_outputBlockSize * i_nbBlocks);
+    block_t *p_out_buf = filter_NewAudioBuffer(p_filter,
+                                               i_outputBlockSize * i_nbBlocks);
     if (unlikely(p_out_buf == NULL))
     {
         block_Release(p_buf);
@@ -38,6 +38,18 @@
 #include <vlc_aout.h>
 #include <vlc_block.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include "../../arm_neon/round_neon.h"
+# define FORMAT_NEON 1
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -56,9 +68,44 @@ vlc_module_end()
  * Local prototypes
  *****************************************************************************/
 
-typedef block_t *(*cvt_t)(filter_t *, block_t *);
+/* Converts samples from src to dst. If the destination samples are not
+ * larger than the source ones, dst and src may be the same buffer. */
+typedef void (*cvt_t)(void *dst, const void *src, size_t samples);
+
+typedef struct
+{
+    cvt_t convert;
+    unsigned src_size; /* bytes per sample */
+    unsigned dst_size;
+} filter_sys_t;
+
 static cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst);
 
+static block_t *Convert(filter_t *filter, block_t *bsrc)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const size_t samples = bsrc->i_buffer / sys->src_size;
+    block_t *bdst = bsrc;
+
+    if (sys->dst_size > sys->src_size)
+    {
+        bdst = filter_NewAudioBuffer(filter, samples * sys->dst_size);
+        if (unlikely(bdst == NULL))
+        {
+            block_Release(bsrc);
+            return NULL;
+        }
+        block_CopyProperties(bdst, bsrc);
+    }
+
+    sys->convert(bdst->p_buffer, bsrc->p_buffer, samples);
+    bdst->i_buffer = samples * sys->dst_size;
+
+    if (bdst != bsrc)
+        block_Release(bsrc);
+    return bdst;
+}
+
 static int Open(vlc_object_t *object)
 {
     filter_t     *filter = (filter_t *)object;
@@ -71,10 +118,20 @@ static int Open(vlc_object_t *object)
     if (src->i_codec == dst->i_codec)
         return VLC_EGENERIC;
 
-    filter->pf_audio_filter = FindConversion(src->i_codec, dst->i_codec);
-    if (filter->pf_audio_filter == NULL)
+    cvt_t convert = FindConversion(src->i_codec, dst->i_codec);
+    if (convert == NULL)
         return VLC_EGENERIC;
 
+    filter_sys_t *sys = vlc_obj_malloc(object, sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    sys->convert = convert;
+    sys->src_size = aout_BitsPerSample(src->i_codec) / 8;
+    sys->dst_size = aout_BitsPerSample(dst->i_codec) / 8;
+    filter->p_sys = sys;
+    filter->pf_audio_filter = Convert;
+
     msg_Dbg(filter, "%4.4s->%4.4s, bits per sample: %i->%i",
             (char *)&src->i_codec, (char *)&dst->i_codec,
             src->audio.i_bitspersample, dst->audio.i_bitspersample);
@@ -83,368 +140,256 @@ static int Open(vlc_object_t *object)
 
 
 /*** from U8 ***/
-static block_t *U8toS16(filter_t *filter, block_t *bsrc)
-{
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    uint8_t *src = (uint8_t *)bsrc->p_buffer;
-    int16_t *dst = (int16_t *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer; i--;)
-        *dst++ = ((*src++) << 8) - 0x8000;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
+static void U8toS16(void *dst, const void *src, size_t samples)
+{
+    const uint8_t *s = src;
+    int16_t *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = ((*s++) << 8) - 0x8000;
 }
 
-static block_t *U8toFl32(filter_t *filter, block_t *bsrc)
+static void U8toFl32(void *dst, const void *src, size_t samples)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    uint8_t *src = (uint8_t *)bsrc->p_buffer;
-    float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer; i--;)
-        *dst++ = ((float)((*src++) - 128)) / 128.f;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
+    const uint8_t *s = src;
+    float *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = ((float)((*s++) - 128)) / 128.f;
 }
 
-static block_t *U8toS32(filter_t *filter, block_t *bsrc)
+static void U8toS32(void *dst, const void *src, size_t samples)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    uint8_t *src = (uint8_t *)bsrc->p_buffer;
-    int32_t *dst = (int32_t *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer; i--;)
-        *dst++ = ((*src++) << 24) - 0x80000000;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
+    const uint8_t *s = src;
+    int32_t *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = ((*s++) << 24) - 0x80000000;
 }
 
-static block_t *U8toFl64(filter_t *filter, block_t *bsrc)
+static void U8toFl64(void *dst, const void *src, size_t samples)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 8);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    uint8_t *src = (uint8_t *)bsrc->p_buffer;
-    double  *dst = (double *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer; i--;)
-        *dst++ = ((double)((*src++) - 128)) / 128.;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
+    const uint8_t *s = src;
+    double *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = ((double)((*s++) - 128)) / 128.;
 }
 
 
 /*** from S16N ***/
-static block_t *S16toU8(filter_t *filter, block_t *b)
+static void S16toU8(void *dst, const void *src, size_t samples)
 {
-    VLC_UNUSED(filter);
-    int16_t *src = (int16_t *)b->p_buffer;
-    uint8_t *dst = (uint8_t *)src;
-    for (size_t i = b->i_buffer / 2; i--;)
-        *dst++ = ((*src++) + 32768) >> 8;
-
-    b->i_buffer /= 2;
-    return b;
+    const int16_t *s = src;
+    uint8_t *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = ((*s++) + 32768) >> 8;
 }
 
-static block_t *S16toFl32(filter_t *filter, block_t *bsrc)
+static void S16toFl32(void *dst, const void *src, size_t samples)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    int16_t *src = (int16_t *)bsrc->p_buffer;
-    float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 2; i--;)
+    const int16_t *s = src;
+    float *d = dst;
+    for (size_t i = samples; i--;)
 #if 0
         /* Slow version */
-        *dst++ = (float)*src++ / 32768.f;
+        *d++ = (float)*s++ / 32768.f;
 #else
     {   /* This is Walken's trick based on IEEE float format. On my PIII
          * this takes 16 seconds to perform one billion conversions, instead
          * of 19 seconds for the above division. */
         union { float f; int32_t i; } u;
-        u.i = *src++ + 0x43c00000;
-        *dst++ = u.f - 384.f;
+        u.i = *s++ + 0x43c00000;
+        *d++ = u.f - 384.f;
     }
 #endif
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
 }
 
-static block_t *S16toS32(filter_t *filter, block_t *bsrc)
+static void S16toS32(void *dst, const void *src, size_t samples)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    int16_t *src = (int16_t *)bsrc->p_buffer;
-    int32_t *dst = (int32_t *)bdst->p_buffer;
-    for (int i = bsrc->i_buffer / 2; i--;)
-        *dst++ = *src++ << 16;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
+    const int16_t *s = src;
+    int32_t *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = *s++ << 16;
 }
 
-static block_t *S16toFl64(filter_t *filter, block_t *bsrc)
+static void S16toFl64(void *dst, const void *src, size_t samples)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    int16_t *src = (int16_t *)bsrc->p_buffer;
-    float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 2; i--;)
-        *dst++ = (double)*src++ / 32768.;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
+    const int16_t *s = src;
+    double *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = (double)*s++ / 32768.;
 }
 
 
 /*** from FL32 ***/
-static block_t *Fl32toU8(filter_t *filter, block_t *b)
+static void Fl32toU8(void *dst, const void *src, size_t samples)
 {
-    float   *src = (float *)b->p_buffer;
-    uint8_t *dst = (uint8_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    const float *s = src;
+    uint8_t *d = dst;
+    for (size_t i = samples; i--;)
     {
-        float s = *(src++) * 128.f;
-        if (s >= 127.f)
-            *(dst++) = 255;
+        float v = *(s++) * 128.f;
+        if (v >= 127.f)
+            *(d++) = 255;
         else
-        if (s <= -128.f)
-            *(dst++) = 0;
+        if (v <= -128.f)
+            *(d++) = 0;
         else
-            *(dst++) = lroundf(s) + 128;
+            *(d++) = lroundf(v) + 128;
     }
-    b->i_buffer /= 4;
-    VLC_UNUSED(filter);
-    return b;
 }
 
-static block_t *Fl32toS16(filter_t *filter, block_t *b)
+static void Fl32toS16(void *dst, const void *src, size_t samples)
 {
-    VLC_UNUSED(filter);
-    float   *src = (float *)b->p_buffer;
-    int16_t *dst = (int16_t *)src;
-    for (int i = b->i_buffer / 4; i--;) {
+    const float *s = src;
+    int16_t *d = dst;
+    for (size_t i = samples; i--;) {
 #if 0
         /* Slow version. */
-        if (*src >= 1.0) *dst = 32767;
-        else if (*src < -1.0) *dst = -32768;
-        else *dst = lroundf(*src * 32768.f);
-        src++; dst++;
+        if (*s >= 1.0) *d = 32767;
+        else if (*s < -1.0) *d = -32768;
+        else *d = lroundf(*s * 32768.f);
+        s++; d++;
 #else
         /* This is Walken's trick based on IEEE float format. */
         union { float f; int32_t i; } u;
-        u.f = *src++ + 384.f;
+        u.f = *s++ + 384.f;
         if (u.i > 0x43c07fff)
-            *dst++ = 32767;
+            *d++ = 32767;
         else if (u.i < 0x43bf8000)
-            *dst++ = -32768;
+            *d++ = -32768;
         else
-            *dst++ = u.i - 0x43c00000;
+            *d++ = u.i - 0x43c00000;
 #endif
     }
-    b->i_buffer /= 2;
-    return b;
 }
 
-static block_t *Fl32toS32(filter_t *filter, block_t *b)
+static void Fl32toS32(void *dst, const void *src, size_t samples)
 {
-    float   *src = (float *)b->p_buffer;
-    int32_t *dst = (int32_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    const float *s = src;
+    int32_t *d = dst;
+    for (size_t i = samples; i--;)
     {
-        float s = *(src++) * 2147483648.f;
-        if (s >= 2147483647.f)
-            *(dst++) = 2147483647;
+        float v = *(s++) * 2147483648.f;
+        if (v >= 2147483647.f)
+            *(d++) = 2147483647;
         else
-        if (s <= -2147483648.f)
-            *(dst++) = -2147483648;
+        if (v <= -2147483648.f)
+            *(d++) = -2147483648;
         else
-            *(dst++) = lroundf(s);
+            *(d++) = lroundf(v);
     }
-    VLC_UNUSED(filter);
-    return b;
 }
 
-static block_t *Fl32toFl64(filter_t *filter, block_t *bsrc)
+static void Fl32toFl64(void *dst, const void *src, size_t samples)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    float  *src = (float *)bsrc->p_buffer;
-    double *dst = (double *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 4; i--;)
-        *(dst++) = *(src++);
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
+    const float *s = src;
+    double *d = dst;
+    for (size_t i = samples; i--;)
+        *(d++) = *(s++);
 }
 
 
 /*** from S32N ***/
-static block_t *S32toU8(filter_t *filter, block_t *b)
+static void S32toU8(void *dst, const void *src, size_t samples)
 {
-    VLC_UNUSED(filter);
-    int32_t *src = (int32_t *)b->p_buffer;
-    uint8_t *dst = (uint8_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
-        *dst++ = ((*src++) >> 24) + 128;
-
-    b->i_buffer /= 4;
-    return b;
+    const int32_t *s = src;
+    uint8_t *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = ((*s++) >> 24) + 128;
 }
 
-static block_t *S32toS16(filter_t *filter, block_t *b)
+static void S32toS16(void *dst, const void *src, size_t samples)
 {
-    VLC_UNUSED(filter);
-    int32_t *src = (int32_t *)b->p_buffer;
-    int16_t *dst = (int16_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
-        *dst++ = (*src++) >> 16;
-
-    b->i_buffer /= 2;
-    return b;
+    const int32_t *s = src;
+    int16_t *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = (*s++) >> 16;
 }
 
-static block_t *S32toFl32(filter_t *filter, block_t *b)
+static void S32toFl32(void *dst, const void *src, size_t samples)
 {
-    VLC_UNUSED(filter);
-    int32_t *src = (int32_t*)b->p_buffer;
-    float   *dst = (float *)src;
-    for (int i = b->i_buffer / 4; i--;)
-        *dst++ = (float)(*src++) / 2147483648.f;
-    return b;
+    const int32_t *s = src;
+    float *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = (float)(*s++) / 2147483648.f;
 }
 
-static block_t *S32toFl64(filter_t *filter, block_t *bsrc)
+static void S32toFl64(void *dst, const void *src, size_t samples)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    int32_t *src = (int32_t*)bsrc->p_buffer;
-    double  *dst = (double *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 4; i--;)
-        *dst++ = (double)(*src++) / 2147483648.;
-out:
-    VLC_UNUSED(filter);
-    block_Release(bsrc);
-    return bdst;
+    const int32_t *s = src;
+    double *d = dst;
+    for (size_t i = samples; i--;)
+        *d++ = (double)(*s++) / 2147483648.;
 }
 
 
 /*** from FL64 ***/
-static block_t *Fl64toU8(filter_t *filter, block_t *b)
+static void Fl64toU8(void *dst, const void *src, size_t samples)
 {
-    double  *src = (double *)b->p_buffer;
-    uint8_t *dst = (uint8_t *)src;
-    for (size_t i = b->i_buffer / 8; i--;)
+    const double *s = src;
+    uint8_t *d = dst;
+    for (size_t i = samples; i--;)
     {
-        float s = *(src++) * 128.;
-        if (s >= 127.f)
-            *(dst++) = 255;
+        float v = *(s++) * 128.;
+        if (v >= 127.f)
+            *(d++) = 255;
         else
-        if (s <= -128.f)
-            *(dst++) = 0;
+        if (v <= -128.f)
+            *(d++) = 0;
         else
-            *(dst++) = lround(s) + 128;
+            *(d++) = lround(v) + 128;
     }
-    b->i_buffer /= 8;
-    VLC_UNUSED(filter);
-    return b;
 }
 
-static block_t *Fl64toS16(filter_t *filter, block_t *b)
+static void Fl64toS16(void *dst, const void *src, size_t samples)
 {
-    VLC_UNUSED(filter);
-    double  *src = (double *)b->p_buffer;
-    int16_t *dst = (int16_t *)src;
-    for (size_t i = b->i_buffer / 8; i--;) {
-        const double v = *src++ * 32768.;
+    const double *s = src;
+    int16_t *d = dst;
+    for (size_t i = samples; i--;) {
+        const double v = *s++ * 32768.;
         /* Slow version. */
         if (v >= 32767.)
-            *dst++ = 32767;
+            *d++ = 32767;
         else if (v < -32768.)
-            *dst++ = -32768;
+            *d++ = -32768;
         else
-            *dst++ = lround(v);
+            *d++ = lround(v);
     }
-    b->i_buffer /= 4;
-    return b;
 }
 
-static block_t *Fl64toFl32(filter_t *filter, block_t *b)
+static void Fl64toFl32(void *dst, const void *src, size_t samples)
 {
-    double *src = (double *)b->p_buffer;
-    float  *dst = (float *)src;
-    for (size_t i = b->i_buffer / 8; i--;)
-        *(dst++) = *(src++);
-
-    VLC_UNUSED(filter);
-    return b;
+    const double *s = src;
+    float *d = dst;
+    for (size_t i = samples; i--;)
+        *(d++) = *(s++);
 }
 
-static block_t *Fl64toS32(filter_t *filter, block_t *b)
+static void Fl64toS32(void *dst, const void *src, size_t samples)
 {
-    double  *src = (double *)b->p_buffer;
-    int32_t *dst = (int32_t *)src;
-    for (size_t i = b->i_buffer / 8; i--;)
+    const double *s = src;
+    int32_t *d = dst;
+    for (size_t i = samples; i--;)
     {
-        float s = *(src++) * 2147483648.;
-        if (s >= 2147483647.f)
-            *(dst++) = 2147483647;
+        float v = *(s++) * 2147483648.;
+        if (v >= 2147483647.f)
+            *(d++) = 2147483647;
         else
-        if (s <= -2147483648.f)
-            *(dst++) = -2147483648;
+        if (v <= -2147483648.f)
+            *(d++) = -2147483648;
         else
-            *(dst++) = lround(s);
+            *(d++) = lround(v);
     }
-    VLC_UNUSED(filter);
-    return b;
 }
 
-
 /* */
 /* */
-static const struct {
+struct cvt_entry
+{
     vlc_fourcc_t src;
     vlc_fourcc_t dst;
     cvt_t convert;
-} cvt_directs[] = {
+};
+
+static const struct cvt_entry cvt_directs[] = {
     { VLC_CODEC_U8,   VLC_CODEC_S16N, U8toS16    },
     { VLC_CODEC_U8,   VLC_CODEC_FL32, U8toFl32   },
     { VLC_CODEC_U8,   VLC_CODEC_S32N, U8toS32    },
@@ -473,12 +418,671 @@ static const struct {
     { 0, 0, NULL }
 };
 
-static cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst)
+/*** SIMD conversions ***/
+/* The vector kernels compute the same values as the scalar ones above,
+ * except for the float to S32 conversions which round ties to even (rather
+ * than away from zero). Leftover samples are converted with the scalar
+ * versions. */
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static void U8toS16_SSE2(void *dst, const void *src, size_t samples)
+{
+    const uint8_t *s = src;
+    int16_t *d = dst;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(-0x8000);
+    size_t i = 0;
+
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)&s[i]);
+        _mm_storeu_si128((__m128i *)&d[i],
+                         _mm_xor_si128(_mm_unpacklo_epi8(zero, v), bias));
+        _mm_storeu_si128((__m128i *)&d[i + 8],
+                         _mm_xor_si128(_mm_unpackhi_epi8(zero, v), bias));
+    }
+    U8toS16(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void U8toFl32_SSE2(void *dst, const void *src, size_t samples)
+{
+    const uint8_t *s = src;
+    float *d = dst;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi32(128);
+    const __m128 scale = _mm_set1_ps(1.f / 128.f);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)&s[i]),
+                                      zero);
+        __m128i lo = _mm_sub_epi32(_mm_unpacklo_epi16(v, zero), bias);
+        __m128i hi = _mm_sub_epi32(_mm_unpackhi_epi16(v, zero), bias);
+        _mm_storeu_ps(&d[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(&d[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    U8toFl32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S16toFl32_SSE2(void *dst, const void *src, size_t samples)
 {
-    for (int i = 0; cvt_directs[i].convert; i++) {
-        if (cvt_directs[i].src == src &&
-            cvt_directs[i].dst == dst)
-            return cvt_directs[i].convert;
+    const int16_t *s = src;
+    float *d = dst;
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)&s[i]);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(&d[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(&d[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    S16toFl32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S16toS32_SSE2(void *dst, const void *src, size_t samples)
+{
+    const int16_t *s = src;
+    int32_t *d = dst;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)&s[i]);
+        _mm_storeu_si128((__m128i *)&d[i], _mm_unpacklo_epi16(zero, v));
+        _mm_storeu_si128((__m128i *)&d[i + 4], _mm_unpackhi_epi16(zero, v));
+    }
+    S16toS32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S16toFl64_SSE2(void *dst, const void *src, size_t samples)
+{
+    const int16_t *s = src;
+    double *d = dst;
+    const __m128d scale = _mm_set1_pd(1. / 32768.);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128i v = _mm_loadl_epi64((const __m128i *)&s[i]);
+        v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        _mm_storeu_pd(&d[i], _mm_mul_pd(_mm_cvtepi32_pd(v), scale));
+        _mm_storeu_pd(&d[i + 2], _mm_mul_pd(
+                      _mm_cvtepi32_pd(_mm_srli_si128(v, 8)), scale));
+    }
+    S16toFl64(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl32toS16_SSE2(void *dst, const void *src, size_t samples)
+{
+    const float *s = src;
+    int16_t *d = dst;
+    const __m128 scale = _mm_set1_ps(32768.f);
+    const __m128 max = _mm_set1_ps(32767.f);
+    const __m128 min = _mm_set1_ps(-32768.f);
+    size_t i = 0;
+
+    /* In place: each iteration reads its input before writing its output,
+     * which never goes beyond the input of the next iteration. */
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(&s[i]), scale);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(&s[i + 4]), scale);
+        lo = _mm_max_ps(_mm_min_ps(lo, max), min);
+        hi = _mm_max_ps(_mm_min_ps(hi, max), min);
+        _mm_storeu_si128((__m128i *)&d[i],
+                         _mm_packs_epi32(_mm_cvtps_epi32(lo),
+                                         _mm_cvtps_epi32(hi)));
+    }
+    Fl32toS16(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl32toS32_SSE2(void *dst, const void *src, size_t samples)
+{
+    const float *s = src;
+    int32_t *d = dst;
+    const __m128 scale = _mm_set1_ps(2147483648.f);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(&s[i]), scale);
+        /* Out of range values convert to INT32_MIN: fix positive ones */
+        __m128i over = _mm_castps_si128(_mm_cmpge_ps(v, scale));
+        _mm_storeu_si128((__m128i *)&d[i],
+                         _mm_xor_si128(_mm_cvtps_epi32(v), over));
+    }
+    Fl32toS32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl32toFl64_SSE2(void *dst, const void *src, size_t samples)
+{
+    const float *s = src;
+    double *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(&s[i]);
+        _mm_storeu_pd(&d[i], _mm_cvtps_pd(v));
+        _mm_storeu_pd(&d[i + 2], _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    Fl32toFl64(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S32toS16_SSE2(void *dst, const void *src, size_t samples)
+{
+    const int32_t *s = src;
+    int16_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i lo = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)&s[i]),
+                                    16);
+        __m128i hi = _mm_srai_epi32(
+            _mm_loadu_si128((const __m128i *)&s[i + 4]), 16);
+        _mm_storeu_si128((__m128i *)&d[i], _mm_packs_epi32(lo, hi));
+    }
+    S32toS16(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S32toFl32_SSE2(void *dst, const void *src, size_t samples)
+{
+    const int32_t *s = src;
+    float *d = dst;
+    const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)&s[i]);
+        _mm_storeu_ps(&d[i], _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    S32toFl32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S32toFl64_SSE2(void *dst, const void *src, size_t samples)
+{
+    const int32_t *s = src;
+    double *d = dst;
+    const __m128d scale = _mm_set1_pd(1. / 2147483648.);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)&s[i]);
+        _mm_storeu_pd(&d[i], _mm_mul_pd(_mm_cvtepi32_pd(v), scale));
+        _mm_storeu_pd(&d[i + 2], _mm_mul_pd(
+                      _mm_cvtepi32_pd(_mm_srli_si128(v, 8)), scale));
+    }
+    S32toFl64(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl64toFl32_SSE2(void *dst, const void *src, size_t samples)
+{
+    const double *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(&s[i]));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(&s[i + 2]));
+        _mm_storeu_ps(&d[i], _mm_movelh_ps(lo, hi));
+    }
+    Fl64toFl32(&d[i], &s[i], samples - i);
+}
+
+static const struct cvt_entry cvt_sse2[] = {
+    { VLC_CODEC_U8,   VLC_CODEC_S16N, U8toS16_SSE2    },
+    { VLC_CODEC_U8,   VLC_CODEC_FL32, U8toFl32_SSE2   },
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32_SSE2  },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, S16toS32_SSE2   },
+    { VLC_CODEC_S16N, VLC_CODEC_FL64, S16toFl64_SSE2  },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16_SSE2  },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32_SSE2  },
+    { VLC_CODEC_FL32, VLC_CODEC_FL64, Fl32toFl64_SSE2 },
+    { VLC_CODEC_S32N, VLC_CODEC_S16N, S32toS16_SSE2   },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32_SSE2  },
+    { VLC_CODEC_S32N, VLC_CODEC_FL64, S32toFl64_SSE2  },
+    { VLC_CODEC_FL64, VLC_CODEC_FL32, Fl64toFl32_SSE2 },
+    { 0, 0, NULL }
+};
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static void U8toS16_AVX2(void *dst, const void *src, size_t samples)
+{
+    const uint8_t *s = src;
+    int16_t *d = dst;
+    const __m256i bias = _mm256_set1_epi16(-0x8000);
+    size_t i = 0;
+
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i v = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)&s[i]));
+        _mm256_storeu_si256((__m256i *)&d[i],
+                            _mm256_xor_si256(_mm256_slli_epi16(v, 8), bias));
+    }
+    U8toS16(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void U8toFl32_AVX2(void *dst, const void *src, size_t samples)
+{
+    const uint8_t *s = src;
+    float *d = dst;
+    const __m256i bias = _mm256_set1_epi32(128);
+    const __m256 scale = _mm256_set1_ps(1.f / 128.f);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256i v = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((const __m128i *)&s[i]));
+        v = _mm256_sub_epi32(v, bias);
+        _mm256_storeu_ps(&d[i], _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    U8toFl32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S16toFl32_AVX2(void *dst, const void *src, size_t samples)
+{
+    const int16_t *s = src;
+    float *d = dst;
+    const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256i v = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128((const __m128i *)&s[i]));
+        _mm256_storeu_ps(&d[i], _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    S16toFl32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S16toS32_AVX2(void *dst, const void *src, size_t samples)
+{
+    const int16_t *s = src;
+    int32_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256i v = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128((const __m128i *)&s[i]));
+        _mm256_storeu_si256((__m256i *)&d[i], _mm256_slli_epi32(v, 16));
+    }
+    S16toS32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S16toFl64_AVX2(void *dst, const void *src, size_t samples)
+{
+    const int16_t *s = src;
+    double *d = dst;
+    const __m256d scale = _mm256_set1_pd(1. / 32768.);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128i v = _mm_cvtepi16_epi32(
+            _mm_loadl_epi64((const __m128i *)&s[i]));
+        _mm256_storeu_pd(&d[i], _mm256_mul_pd(_mm256_cvtepi32_pd(v), scale));
+    }
+    S16toFl64(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Fl32toS16_AVX2(void *dst, const void *src, size_t samples)
+{
+    const float *s = src;
+    int16_t *d = dst;
+    const __m256 scale = _mm256_set1_ps(32768.f);
+    const __m256 max = _mm256_set1_ps(32767.f);
+    const __m256 min = _mm256_set1_ps(-32768.f);
+    size_t i = 0;
+
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256 lo = _mm256_mul_ps(_mm256_loadu_ps(&s[i]), scale);
+        __m256 hi = _mm256_mul_ps(_mm256_loadu_ps(&s[i + 8]), scale);
+        lo = _mm256_max_ps(_mm256_min_ps(lo, max), min);
+        hi = _mm256_max_ps(_mm256_min_ps(hi, max), min);
+        /* Packing is done per 128-bits lane: restore the order */
+        __m256i v = _mm256_packs_epi32(_mm256_cvtps_epi32(lo),
+                                       _mm256_cvtps_epi32(hi));
+        _mm256_storeu_si256((__m256i *)&d[i],
+                            _mm256_permute4x64_epi64(v, 0xd8));
+    }
+    Fl32toS16(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Fl32toS32_AVX2(void *dst, const void *src, size_t samples)
+{
+    const float *s = src;
+    int32_t *d = dst;
+    const __m256 scale = _mm256_set1_ps(2147483648.f);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(&s[i]), scale);
+        __m256i over = _mm256_castps_si256(_mm256_cmp_ps(v, scale,
+                                                         _CMP_GE_OQ));
+        _mm256_storeu_si256((__m256i *)&d[i],
+                            _mm256_xor_si256(_mm256_cvtps_epi32(v), over));
+    }
+    Fl32toS32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Fl32toFl64_AVX2(void *dst, const void *src, size_t samples)
+{
+    const float *s = src;
+    double *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+        _mm256_storeu_pd(&d[i], _mm256_cvtps_pd(_mm_loadu_ps(&s[i])));
+    Fl32toFl64(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S32toS16_AVX2(void *dst, const void *src, size_t samples)
+{
+    const int32_t *s = src;
+    int16_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= samples; i += 16)
+    {
+        __m256i lo = _mm256_srai_epi32(
+            _mm256_loadu_si256((const __m256i *)&s[i]), 16);
+        __m256i hi = _mm256_srai_epi32(
+            _mm256_loadu_si256((const __m256i *)&s[i + 8]), 16);
+        _mm256_storeu_si256((__m256i *)&d[i], _mm256_permute4x64_epi64(
+                            _mm256_packs_epi32(lo, hi), 0xd8));
+    }
+    S32toS16(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S32toFl32_AVX2(void *dst, const void *src, size_t samples)
+{
+    const int32_t *s = src;
+    float *d = dst;
+    const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)&s[i]);
+        _mm256_storeu_ps(&d[i], _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    S32toFl32(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S32toFl64_AVX2(void *dst, const void *src, size_t samples)
+{
+    const int32_t *s = src;
+    double *d = dst;
+    const __m256d scale = _mm256_set1_pd(1. / 2147483648.);
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)&s[i]);
+        _mm256_storeu_pd(&d[i], _mm256_mul_pd(_mm256_cvtepi32_pd(v), scale));
+    }
+    S32toFl64(&d[i], &s[i], samples - i);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Fl64toFl32_AVX2(void *dst, const void *src, size_t samples)
+{
+    const double *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+        _mm_storeu_ps(&d[i], _mm256_cvtpd_ps(_mm256_loadu_pd(&s[i])));
+    Fl64toFl32(&d[i], &s[i], samples - i);
+}
+
+static const struct cvt_entry cvt_avx2[] = {
+    { VLC_CODEC_U8,   VLC_CODEC_S16N, U8toS16_AVX2    },
+    { VLC_CODEC_U8,   VLC_CODEC_FL32, U8toFl32_AVX2   },
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32_AVX2  },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, S16toS32_AVX2   },
+    { VLC_CODEC_S16N, VLC_CODEC_FL64, S16toFl64_AVX2  },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16_AVX2  },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32_AVX2  },
+    { VLC_CODEC_FL32, VLC_CODEC_FL64, Fl32toFl64_AVX2 },
+    { VLC_CODEC_S32N, VLC_CODEC_S16N, S32toS16_AVX2   },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32_AVX2  },
+    { VLC_CODEC_S32N, VLC_CODEC_FL64, S32toFl64_AVX2  },
+    { VLC_CODEC_FL64, VLC_CODEC_FL32, Fl64toFl32_AVX2 },
+    { 0, 0, NULL }
+};
+#endif
+
+#ifdef FORMAT_NEON
+static void U8toS16_NEON(void *dst, const void *src, size_t samples)
+{
+    const uint8_t *s = src;
+    int16_t *d = dst;
+    const uint16x8_t bias = vdupq_n_u16(0x8000);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+        vst1q_s16(&d[i], vreinterpretq_s16_u16(
+                  veorq_u16(vshll_n_u8(vld1_u8(&s[i]), 8), bias)));
+    U8toS16(&d[i], &s[i], samples - i);
+}
+
+static void U8toFl32_NEON(void *dst, const void *src, size_t samples)
+{
+    const uint8_t *s = src;
+    float *d = dst;
+    const int16x8_t bias = vdupq_n_s16(128);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(&s[i]))),
+                                bias);
+        vst1q_f32(&d[i], vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(v)), 7));
+        vst1q_f32(&d[i + 4], vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(v)), 7));
+    }
+    U8toFl32(&d[i], &s[i], samples - i);
+}
+
+static void S16toFl32_NEON(void *dst, const void *src, size_t samples)
+{
+    const int16_t *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        int16x8_t v = vld1q_s16(&s[i]);
+        vst1q_f32(&d[i], vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(v)), 15));
+        vst1q_f32(&d[i + 4], vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(v)), 15));
+    }
+    S16toFl32(&d[i], &s[i], samples - i);
+}
+
+static void S16toS32_NEON(void *dst, const void *src, size_t samples)
+{
+    const int16_t *s = src;
+    int32_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+        vst1q_s32(&d[i], vshll_n_s16(vld1_s16(&s[i]), 16));
+    S16toS32(&d[i], &s[i], samples - i);
+}
+
+static void Fl32toS16_NEON(void *dst, const void *src, size_t samples)
+{
+    const float *s = src;
+    int16_t *d = dst;
+    const float32x4_t max = vdupq_n_f32(32767.f);
+    const float32x4_t min = vdupq_n_f32(-32768.f);
+    size_t i = 0;
+
+    for (; i + 8 <= samples; i += 8)
+    {
+        float32x4_t lo = vmulq_n_f32(vld1q_f32(&s[i]), 32768.f);
+        float32x4_t hi = vmulq_n_f32(vld1q_f32(&s[i + 4]), 32768.f);
+        lo = vmaxq_f32(vminq_f32(lo, max), min);
+        hi = vmaxq_f32(vminq_f32(hi, max), min);
+        vst1q_s16(&d[i], vcombine_s16(vqmovn_s32(RoundF32_NEON(lo)),
+                                      vqmovn_s32(RoundF32_NEON(hi))));
+    }
+    Fl32toS16(&d[i], &s[i], samples - i);
+}
+
+static void Fl32toS32_NEON(void *dst, const void *src, size_t samples)
+{
+    const float *s = src;
+    int32_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+# ifdef __aarch64__
+        vst1q_s32(&d[i], vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(&s[i]),
+                                                    2147483648.f)));
+# else
+        /* Truncates: at most one LSB off the scalar version */
+        vst1q_s32(&d[i], vcvtq_n_s32_f32(vld1q_f32(&s[i]), 31));
+# endif
+    Fl32toS32(&d[i], &s[i], samples - i);
+}
+
+static void S32toS16_NEON(void *dst, const void *src, size_t samples)
+{
+    const int32_t *s = src;
+    int16_t *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+        vst1_s16(&d[i], vshrn_n_s32(vld1q_s32(&s[i]), 16));
+    S32toS16(&d[i], &s[i], samples - i);
+}
+
+static void S32toFl32_NEON(void *dst, const void *src, size_t samples)
+{
+    const int32_t *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+        vst1q_f32(&d[i], vcvtq_n_f32_s32(vld1q_s32(&s[i]), 31));
+    S32toFl32(&d[i], &s[i], samples - i);
+}
+
+# ifdef __aarch64__
+static void Fl32toFl64_NEON(void *dst, const void *src, size_t samples)
+{
+    const float *s = src;
+    double *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        float32x4_t v = vld1q_f32(&s[i]);
+        vst1q_f64(&d[i], vcvt_f64_f32(vget_low_f32(v)));
+        vst1q_f64(&d[i + 2], vcvt_high_f64_f32(v));
+    }
+    Fl32toFl64(&d[i], &s[i], samples - i);
+}
+
+static void Fl64toFl32_NEON(void *dst, const void *src, size_t samples)
+{
+    const double *s = src;
+    float *d = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        float32x2_t lo = vcvt_f32_f64(vld1q_f64(&s[i]));
+        vst1q_f32(&d[i], vcvt_high_f32_f64(lo, vld1q_f64(&s[i + 2])));
+    }
+    Fl64toFl32(&d[i], &s[i], samples - i);
+}
+# endif
+
+static const struct cvt_entry cvt_neon[] = {
+    { VLC_CODEC_U8,   VLC_CODEC_S16N, U8toS16_NEON    },
+    { VLC_CODEC_U8,   VLC_CODEC_FL32, U8toFl32_NEON   },
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32_NEON  },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, S16toS32_NEON   },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16_NEON  },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32_NEON  },
+    { VLC_CODEC_S32N, VLC_CODEC_S16N, S32toS16_NEON   },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32_NEON  },
+# ifdef __aarch64__
+    { VLC_CODEC_FL32, VLC_CODEC_FL64, Fl32toFl64_NEON },
+    { VLC_CODEC_FL64, VLC_CODEC_FL32, Fl64toFl32_NEON },
+# endif
+    { 0, 0, NULL }
+};
+#endif
+
+static cvt_t LookupConversion(const struct cvt_entry *table,
+                              vlc_fourcc_t src, vlc_fourcc_t dst)
+{
+    for (int i = 0; table[i].convert; i++) {
+        if (table[i].src == src &&
+            table[i].dst == dst)
+            return table[i].convert;
     }
     return NULL;
 }
+
+static cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst)
+{
+    cvt_t convert = NULL;
+
+#ifdef HAVE_AVX2_INTRINSICS
+    if (convert == NULL && vlc_CPU_AVX2())
+        convert = LookupConversion(cvt_avx2, src, dst);
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    if (convert == NULL && vlc_CPU_SSE2())
+        convert = LookupConversion(cvt_sse2, src, dst);
+#endif
+#ifdef FORMAT_NEON
+    if (convert == NULL && vlc_CPU_ARM_NEON())
+        convert = LookupConversion(cvt_neon, src, dst);
+#endif
+    if (convert == NULL)
+        convert = LookupConversion(cvt_directs, src, dst);
+    return convert;
+}
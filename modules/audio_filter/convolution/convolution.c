@@ -0,0 +1,190 @@
+/*****************************************************************************
+ * convolution.c: impulse response convolution filter
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+
+#include "convolver.h"
+
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define IR_TEXT N_("Impulse response")
+#define IR_LONGTEXT N_("WAV file containing the impulse response to apply. " \
+    "A mono response is applied to every channel, a response with as many " \
+    "channels as the stream is applied per channel, and a response with " \
+    "the square of the channels count is applied as a full matrix.")
+
+#define WET_TEXT N_("Wet")
+#define WET_LONGTEXT N_("Gain of the convolved signal.")
+
+#define DRY_TEXT N_("Dry")
+#define DRY_LONGTEXT N_("Gain of the original signal.")
+
+vlc_module_begin ()
+    set_description( N_("Impulse response convolution") )
+    set_shortname( N_("Convolution") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_AFILTER )
+    add_loadfile( "convolution-ir", NULL, IR_TEXT, IR_LONGTEXT )
+    add_float_with_range( "convolution-wet", 1., 0., 4.,
+                          WET_TEXT, WET_LONGTEXT, false )
+    add_float_with_range( "convolution-dry", 0., 0., 4.,
+                          DRY_TEXT, DRY_LONGTEXT, false )
+    set_capability( "audio filter", 0 )
+    set_callbacks( Open, Close )
+    add_shortcut( "convolution" )
+vlc_module_end ()
+
+typedef struct
+{
+    convolver_t *conv;
+    unsigned channels;
+    size_t length;        /* of the impulse response */
+    vlc_tick_t latency;   /* of the engine (one block) */
+    vlc_tick_t next_pts;  /* end of the last output block */
+} filter_sys_t;
+
+static block_t *Process( filter_t *p_filter, block_t *p_block )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    float *p = (float *)p_block->p_buffer;
+
+    convolver_Process( p_sys->conv, p, p, p_block->i_nb_samples );
+
+    /* The output is the input of one block earlier */
+    if( p_block->i_pts != VLC_TICK_INVALID )
+    {
+        p_block->i_pts -= p_sys->latency;
+        p_block->i_dts = p_block->i_pts;
+        p_sys->next_pts = p_block->i_pts
+            + vlc_tick_from_samples( p_block->i_nb_samples,
+                                     p_filter->fmt_in.audio.i_rate );
+    }
+    return p_block;
+}
+
+/* Outputs the samples still delayed by the engine, and the tail of the
+ * impulse response */
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->next_pts == VLC_TICK_INVALID )
+        return NULL;
+
+    const size_t i_frames = CONVOLVER_BLOCK + p_sys->length - 1;
+    block_t *p_block = filter_NewAudioBuffer( p_filter, i_frames
+                                              * p_sys->channels
+                                              * sizeof (float) );
+    if( p_block == NULL )
+        return NULL;
+
+    convolver_Process( p_sys->conv, NULL, (float *)p_block->p_buffer,
+                       i_frames );
+    p_block->i_nb_samples = i_frames;
+    p_block->i_pts = p_block->i_dts = p_sys->next_pts;
+    p_block->i_length = vlc_tick_from_samples( i_frames,
+                                               p_filter->fmt_in.audio.i_rate );
+    p_sys->next_pts = VLC_TICK_INVALID;
+    return p_block;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    convolver_Reset( p_sys->conv );
+    p_sys->next_pts = VLC_TICK_INVALID;
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    audio_format_t *fmt = &p_filter->fmt_in.audio;
+
+    char *psz_path = var_InheritString( p_filter, "convolution-ir" );
+    if( psz_path == NULL )
+    {
+        msg_Err( p_filter, "no impulse response" );
+        return VLC_EGENERIC;
+    }
+
+    unsigned ir_channels;
+    size_t ir_length;
+    float *ir = convolver_LoadIR( p_this, psz_path, fmt->i_rate,
+                                  &ir_channels, &ir_length );
+    free( psz_path );
+    if( ir == NULL )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+    {
+        free( ir );
+        return VLC_ENOMEM;
+    }
+
+    p_sys->channels = aout_FormatNbChannels( fmt );
+    p_sys->length = ir_length;
+    p_sys->latency = vlc_tick_from_samples( CONVOLVER_BLOCK, fmt->i_rate );
+    p_sys->next_pts = VLC_TICK_INVALID;
+    p_sys->conv = convolver_New( CONVOLVER_BLOCK, p_sys->channels,
+                                 p_sys->channels, ir_length );
+    if( p_sys->conv == NULL
+     || convolver_SetResponses( p_sys->conv, ir, ir_channels, ir_length,
+                                var_InheritFloat( p_filter, "convolution-wet" ),
+                                var_InheritFloat( p_filter, "convolution-dry" ) ) )
+    {
+        msg_Err( p_filter, "cannot apply a %u channel(s) impulse response "
+                 "to %u channel(s)", ir_channels, p_sys->channels );
+        if( p_sys->conv != NULL )
+            convolver_Delete( p_sys->conv );
+        free( p_sys );
+        free( ir );
+        return VLC_EGENERIC;
+    }
+    free( ir );
+
+    fmt->i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare( fmt );
+    p_filter->fmt_out.audio = *fmt;
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_audio_filter = Process;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    convolver_Delete( p_sys->conv );
+    free( p_sys );
+}
@@ -0,0 +1,842 @@
+/*****************************************************************************
+ * convolver.c: uniformly partitioned FFT convolution engine
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_fs.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define CONVOLVER_NEON 1
+#endif
+
+#include "convolver.h"
+
+#define CONVOLVER_ALIGN 32
+
+/* Largest accepted impulse response file */
+#define MAX_FILE_SIZE (128 << 20)
+
+/*
+ * Spectra of the 2B samples long real blocks are stored as B real parts
+ * followed by B imaginary parts. Both the DC and the Nyquist bins are real:
+ * the Nyquist bin is stored in the imaginary part of the DC bin.
+ */
+struct convolver
+{
+    unsigned block;       /* B */
+    unsigned inputs;
+    unsigned outputs;
+    unsigned partitions;
+    unsigned head;        /* current slot of the frequency delay lines */
+    unsigned fill;        /* samples of the current block */
+
+    float *history;       /* inputs x 2B: previous and current input blocks */
+    float *pending;       /* outputs x B: output of the last block */
+    float *fdl;           /* inputs x partitions x 2B: input spectra */
+    float **irs;          /* inputs x outputs: partitions x 2B, or NULL */
+    float *spectrum;      /* 2B: output spectrum accumulator */
+    float *work;          /* 2B: time domain scratch */
+
+    /* Complex FFT of size B */
+    unsigned *reverse;    /* bit reversed indexes */
+    float *twiddle_re;    /* stage of half size h at [h, 2h) */
+    float *twiddle_im;
+    /* Real FFT split, cos and sin of pi * k / B */
+    float *split_cos;
+    float *split_sin;
+
+    void (*butterfly)(float *, float *, float *, float *,
+                      const float *, const float *, unsigned);
+    void (*mac)(float *, float *, const float *, const float *,
+                const float *, const float *, unsigned);
+};
+
+/*****************************************************************************
+ * Kernels
+ *****************************************************************************/
+
+/**
+ * Radix-2 decimation in time butterflies: a += w * b, b = a - w * b
+ */
+static void Butterfly(float *restrict ar, float *restrict ai,
+                      float *restrict br, float *restrict bi,
+                      const float *wr, const float *wi, unsigned count)
+{
+    for (unsigned j = 0; j < count; j++)
+    {
+        float tr = wr[j] * br[j] - wi[j] * bi[j];
+        float ti = wr[j] * bi[j] + wi[j] * br[j];
+
+        br[j] = ar[j] - tr;
+        bi[j] = ai[j] - ti;
+        ar[j] += tr;
+        ai[j] += ti;
+    }
+}
+
+/**
+ * Complex multiply-accumulate: y += x * h
+ */
+static void Mac(float *restrict yr, float *restrict yi,
+                const float *xr, const float *xi,
+                const float *hr, const float *hi, unsigned count)
+{
+    for (unsigned j = 0; j < count; j++)
+    {
+        yr[j] += xr[j] * hr[j] - xi[j] * hi[j];
+        yi[j] += xr[j] * hi[j] + xi[j] * hr[j];
+    }
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static void Butterfly_SSE2(float *restrict ar, float *restrict ai,
+                           float *restrict br, float *restrict bi,
+                           const float *wr, const float *wi, unsigned count)
+{
+    for (unsigned j = 0; j < count; j += 4)
+    {
+        __m128 vwr = _mm_load_ps(&wr[j]), vwi = _mm_load_ps(&wi[j]);
+        __m128 vbr = _mm_load_ps(&br[j]), vbi = _mm_load_ps(&bi[j]);
+        __m128 var = _mm_load_ps(&ar[j]), vai = _mm_load_ps(&ai[j]);
+        __m128 tr = _mm_sub_ps(_mm_mul_ps(vwr, vbr), _mm_mul_ps(vwi, vbi));
+        __m128 ti = _mm_add_ps(_mm_mul_ps(vwr, vbi), _mm_mul_ps(vwi, vbr));
+
+        _mm_store_ps(&br[j], _mm_sub_ps(var, tr));
+        _mm_store_ps(&bi[j], _mm_sub_ps(vai, ti));
+        _mm_store_ps(&ar[j], _mm_add_ps(var, tr));
+        _mm_store_ps(&ai[j], _mm_add_ps(vai, ti));
+    }
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Mac_SSE2(float *restrict yr, float *restrict yi,
+                     const float *xr, const float *xi,
+                     const float *hr, const float *hi, unsigned count)
+{
+    for (unsigned j = 0; j < count; j += 4)
+    {
+        __m128 vxr = _mm_load_ps(&xr[j]), vxi = _mm_load_ps(&xi[j]);
+        __m128 vhr = _mm_load_ps(&hr[j]), vhi = _mm_load_ps(&hi[j]);
+        __m128 re = _mm_sub_ps(_mm_mul_ps(vxr, vhr), _mm_mul_ps(vxi, vhi));
+        __m128 im = _mm_add_ps(_mm_mul_ps(vxr, vhi), _mm_mul_ps(vxi, vhr));
+
+        _mm_store_ps(&yr[j], _mm_add_ps(_mm_load_ps(&yr[j]), re));
+        _mm_store_ps(&yi[j], _mm_add_ps(_mm_load_ps(&yi[j]), im));
+    }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static void Butterfly_AVX2(float *restrict ar, float *restrict ai,
+                           float *restrict br, float *restrict bi,
+                           const float *wr, const float *wi, unsigned count)
+{
+    for (unsigned j = 0; j < count; j += 8)
+    {
+        __m256 vwr = _mm256_load_ps(&wr[j]), vwi = _mm256_load_ps(&wi[j]);
+        __m256 vbr = _mm256_load_ps(&br[j]), vbi = _mm256_load_ps(&bi[j]);
+        __m256 var = _mm256_load_ps(&ar[j]), vai = _mm256_load_ps(&ai[j]);
+        __m256 tr = _mm256_sub_ps(_mm256_mul_ps(vwr, vbr),
+                                  _mm256_mul_ps(vwi, vbi));
+        __m256 ti = _mm256_add_ps(_mm256_mul_ps(vwr, vbi),
+                                  _mm256_mul_ps(vwi, vbr));
+
+        _mm256_store_ps(&br[j], _mm256_sub_ps(var, tr));
+        _mm256_store_ps(&bi[j], _mm256_sub_ps(vai, ti));
+        _mm256_store_ps(&ar[j], _mm256_add_ps(var, tr));
+        _mm256_store_ps(&ai[j], _mm256_add_ps(vai, ti));
+    }
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Mac_AVX2(float *restrict yr, float *restrict yi,
+                     const float *xr, const float *xi,
+                     const float *hr, const float *hi, unsigned count)
+{
+    for (unsigned j = 0; j < count; j += 8)
+    {
+        __m256 vxr = _mm256_load_ps(&xr[j]), vxi = _mm256_load_ps(&xi[j]);
+        __m256 vhr = _mm256_load_ps(&hr[j]), vhi = _mm256_load_ps(&hi[j]);
+        __m256 re = _mm256_sub_ps(_mm256_mul_ps(vxr, vhr),
+                                  _mm256_mul_ps(vxi, vhi));
+        __m256 im = _mm256_add_ps(_mm256_mul_ps(vxr, vhi),
+                                  _mm256_mul_ps(vxi, vhr));
+
+        _mm256_store_ps(&yr[j], _mm256_add_ps(_mm256_load_ps(&yr[j]), re));
+        _mm256_store_ps(&yi[j], _mm256_add_ps(_mm256_load_ps(&yi[j]), im));
+    }
+}
+#endif
+
+#ifdef CONVOLVER_NEON
+static void Butterfly_NEON(float *restrict ar, float *restrict ai,
+                           float *restrict br, float *restrict bi,
+                           const float *wr, const float *wi, unsigned count)
+{
+    for (unsigned j = 0; j < count; j += 4)
+    {
+        float32x4_t vwr = vld1q_f32(&wr[j]), vwi = vld1q_f32(&wi[j]);
+        float32x4_t vbr = vld1q_f32(&br[j]), vbi = vld1q_f32(&bi[j]);
+        float32x4_t var = vld1q_f32(&ar[j]), vai = vld1q_f32(&ai[j]);
+        float32x4_t tr = vmlsq_f32(vmulq_f32(vwr, vbr), vwi, vbi);
+        float32x4_t ti = vmlaq_f32(vmulq_f32(vwr, vbi), vwi, vbr);
+
+        vst1q_f32(&br[j], vsubq_f32(var, tr));
+        vst1q_f32(&bi[j], vsubq_f32(vai, ti));
+        vst1q_f32(&ar[j], vaddq_f32(var, tr));
+        vst1q_f32(&ai[j], vaddq_f32(vai, ti));
+    }
+}
+
+static void Mac_NEON(float *restrict yr, float *restrict yi,
+                     const float *xr, const float *xi,
+                     const float *hr, const float *hi, unsigned count)
+{
+    for (unsigned j = 0; j < count; j += 4)
+    {
+        float32x4_t vxr = vld1q_f32(&xr[j]), vxi = vld1q_f32(&xi[j]);
+        float32x4_t vhr = vld1q_f32(&hr[j]), vhi = vld1q_f32(&hi[j]);
+        float32x4_t re = vmlaq_f32(vld1q_f32(&yr[j]), vxr, vhr);
+        float32x4_t im = vmlaq_f32(vld1q_f32(&yi[j]), vxr, vhi);
+
+        vst1q_f32(&yr[j], vmlsq_f32(re, vxi, vhi));
+        vst1q_f32(&yi[j], vmlaq_f32(im, vxi, vhr));
+    }
+}
+#endif
+
+/*****************************************************************************
+ * Transforms
+ *****************************************************************************/
+
+/**
+ * In-place forward complex FFT of size B (not normalized).
+ * The inverse transform is obtained by swapping the real and imaginary parts.
+ */
+static void FFT(const convolver_t *conv, float *re, float *im)
+{
+    const unsigned n = conv->block;
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        unsigned j = conv->reverse[i];
+        if (i < j)
+        {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    /* The first stages are too short for the vector kernels */
+    for (unsigned h = 1; h < n; h *= 2)
+    {
+        const float *wr = conv->twiddle_re + h;
+        const float *wi = conv->twiddle_im + h;
+
+        for (unsigned g = 0; g < n; g += 2 * h)
+        {
+            if (h >= 8)
+                conv->butterfly(re + g, im + g, re + g + h, im + g + h,
+                                wr, wi, h);
+            else
+                Butterfly(re + g, im + g, re + g + h, im + g + h, wr, wi, h);
+        }
+    }
+}
+
+/**
+ * Forward real FFT of 2B samples into a packed spectrum
+ */
+static void Forward(const convolver_t *conv, const float *in, float *spectrum)
+{
+    const unsigned n = conv->block;
+    float *re = spectrum, *im = spectrum + n;
+
+    for (unsigned k = 0; k < n; k++)
+    {
+        re[k] = in[2 * k];
+        im[k] = in[2 * k + 1];
+    }
+
+    FFT(conv, re, im);
+
+    /* Split the spectra of the even and odd samples */
+    const float r0 = re[0], i0 = im[0];
+    re[0] = r0 + i0;
+    im[0] = r0 - i0;
+
+    for (unsigned k = 1, m = n - 1; k <= m; k++, m--)
+    {
+        const float c = conv->split_cos[k], s = conv->split_sin[k];
+        const float er = .5f * (re[k] + re[m]), ei = .5f * (im[k] - im[m]);
+        const float ur = .5f * (im[k] + im[m]), ui = .5f * (re[m] - re[k]);
+        const float tr = c * ur + s * ui, ti = c * ui - s * ur;
+
+        re[k] = er + tr;
+        im[k] = ei + ti;
+        re[m] = er - tr;
+        im[m] = ti - ei;
+    }
+}
+
+/**
+ * Inverse real FFT of a packed spectrum into 2B samples (scaled by B)
+ */
+static void Inverse(const convolver_t *conv, float *spectrum, float *out)
+{
+    const unsigned n = conv->block;
+    float *re = spectrum, *im = spectrum + n;
+
+    const float x0 = re[0], xn = im[0];
+    re[0] = .5f * (x0 + xn);
+    im[0] = .5f * (x0 - xn);
+
+    for (unsigned k = 1, m = n - 1; k <= m; k++, m--)
+    {
+        const float c = conv->split_cos[k], s = conv->split_sin[k];
+        const float er = .5f * (re[k] + re[m]), ei = .5f * (im[k] - im[m]);
+        const float dr = .5f * (re[k] - re[m]), di = .5f * (im[k] + im[m]);
+        const float ur = c * dr - s * di, ui = c * di + s * dr;
+
+        re[k] = er - ui;
+        im[k] = ei + ur;
+        re[m] = er + ui;
+        im[m] = ur - ei;
+    }
+
+    FFT(conv, im, re);
+
+    for (unsigned k = 0; k < n; k++)
+    {
+        out[2 * k] = re[k];
+        out[2 * k + 1] = im[k];
+    }
+}
+
+/*****************************************************************************
+ * Engine
+ *****************************************************************************/
+
+static void *AllocFloats(size_t count)
+{
+    /* Sizes are multiples of the block length, hence of the alignment */
+    float *p = aligned_alloc(CONVOLVER_ALIGN, count * sizeof (float));
+    if (likely(p != NULL))
+        memset(p, 0, count * sizeof (float));
+    return p;
+}
+
+convolver_t *convolver_New(unsigned block, unsigned inputs, unsigned outputs,
+                           size_t length)
+{
+    if (block < 16 || block > 8192 || (block & (block - 1))
+     || inputs == 0 || outputs == 0 || inputs > 64 || outputs > 64
+     || length == 0 || length > CONVOLVER_MAX_LENGTH)
+        return NULL;
+
+    convolver_t *conv = calloc(1, sizeof (*conv));
+    if (unlikely(conv == NULL))
+        return NULL;
+
+    const unsigned n = block;
+    conv->block = n;
+    conv->inputs = inputs;
+    conv->outputs = outputs;
+    conv->partitions = (length + n - 1) / n;
+
+    conv->history = AllocFloats(2 * n * inputs);
+    conv->pending = AllocFloats(n * outputs);
+    conv->fdl = AllocFloats(2 * n * (size_t)conv->partitions * inputs);
+    conv->irs = calloc(inputs * outputs, sizeof (*conv->irs));
+    conv->spectrum = AllocFloats(2 * n);
+    conv->work = AllocFloats(2 * n);
+    conv->reverse = vlc_alloc(n, sizeof (*conv->reverse));
+    conv->twiddle_re = AllocFloats(n);
+    conv->twiddle_im = AllocFloats(n);
+    conv->split_cos = AllocFloats(n);
+    conv->split_sin = AllocFloats(n);
+    if (unlikely(conv->history == NULL || conv->pending == NULL
+              || conv->fdl == NULL || conv->irs == NULL
+              || conv->spectrum == NULL || conv->work == NULL
+              || conv->reverse == NULL || conv->twiddle_re == NULL
+              || conv->twiddle_im == NULL || conv->split_cos == NULL
+              || conv->split_sin == NULL))
+    {
+        convolver_Delete(conv);
+        return NULL;
+    }
+
+    unsigned bits = 0;
+    while ((1u << bits) < n)
+        bits++;
+    for (unsigned i = 0; i < n; i++)
+    {
+        unsigned r = 0;
+        for (unsigned b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        conv->reverse[i] = r;
+    }
+
+    for (unsigned h = 1; h < n; h *= 2)
+        for (unsigned j = 0; j < h; j++)
+        {
+            conv->twiddle_re[h + j] = cos(M_PI * j / h);
+            conv->twiddle_im[h + j] = -sin(M_PI * j / h);
+        }
+
+    for (unsigned k = 0; k < n; k++)
+    {
+        conv->split_cos[k] = cos(M_PI * k / n);
+        conv->split_sin[k] = sin(M_PI * k / n);
+    }
+
+    conv->butterfly = Butterfly;
+    conv->mac = Mac;
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE2())
+    {
+        conv->butterfly = Butterfly_SSE2;
+        conv->mac = Mac_SSE2;
+    }
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+    {
+        conv->butterfly = Butterfly_AVX2;
+        conv->mac = Mac_AVX2;
+    }
+#endif
+#ifdef CONVOLVER_NEON
+    if (vlc_CPU_ARM_NEON())
+    {
+        conv->butterfly = Butterfly_NEON;
+        conv->mac = Mac_NEON;
+    }
+#endif
+    return conv;
+}
+
+void convolver_Delete(convolver_t *conv)
+{
+    if (conv->irs != NULL)
+        for (unsigned i = 0; i < conv->inputs * conv->outputs; i++)
+            aligned_free(conv->irs[i]);
+    free(conv->irs);
+    aligned_free(conv->history);
+    aligned_free(conv->pending);
+    aligned_free(conv->fdl);
+    aligned_free(conv->spectrum);
+    aligned_free(conv->work);
+    free(conv->reverse);
+    aligned_free(conv->twiddle_re);
+    aligned_free(conv->twiddle_im);
+    aligned_free(conv->split_cos);
+    aligned_free(conv->split_sin);
+    free(conv);
+}
+
+int convolver_SetIR(convolver_t *conv, unsigned input, unsigned output,
+                    const float *ir, size_t length)
+{
+    const unsigned n = conv->block;
+    float **slot = &conv->irs[input * conv->outputs + output];
+
+    assert(input < conv->inputs && output < conv->outputs);
+
+    if (ir == NULL)
+    {
+        aligned_free(*slot);
+        *slot = NULL;
+        return VLC_SUCCESS;
+    }
+
+    if (length > (size_t)conv->partitions * n)
+        return VLC_EGENERIC;
+
+    float *spectra = *slot;
+    if (spectra == NULL)
+    {
+        spectra = AllocFloats(2 * n * (size_t)conv->partitions);
+        if (unlikely(spectra == NULL))
+            return VLC_ENOMEM;
+        *slot = spectra;
+    }
+
+    /* Each partition is zero-padded to 2B (overlap-save), and scaled to
+     * compensate for the unnormalized inverse transform. */
+    const float scale = 1.f / n;
+
+    for (unsigned p = 0; p < conv->partitions; p++)
+    {
+        size_t offset = (size_t)p * n;
+        size_t count = offset < length ? __MIN(length - offset, n) : 0;
+
+        for (size_t i = 0; i < count; i++)
+            conv->work[i] = ir[offset + i] * scale;
+        memset(conv->work + count, 0, (2 * n - count) * sizeof (float));
+        Forward(conv, conv->work, spectra + 2 * n * (size_t)p);
+    }
+    return VLC_SUCCESS;
+}
+
+int convolver_SetResponses(convolver_t *conv, const float *ir,
+                           unsigned channels, size_t length,
+                           float wet, float dry)
+{
+    const unsigned count = conv->inputs;
+    bool matrix;
+
+    if (conv->outputs != count || length == 0)
+        return VLC_EGENERIC;
+    if (channels == count * count && count > 1)
+        matrix = true;
+    else if (channels == 1 || channels == count)
+        matrix = false;
+    else
+        return VLC_EGENERIC;
+
+    float *buf = vlc_alloc(length, sizeof (*buf));
+    if (unlikely(buf == NULL))
+        return VLC_ENOMEM;
+
+    int ret = VLC_SUCCESS;
+    for (unsigned i = 0; i < count && ret == VLC_SUCCESS; i++)
+        for (unsigned o = 0; o < count && ret == VLC_SUCCESS; o++)
+        {
+            const float *src;
+
+            if (matrix)
+                src = ir + length * (i * count + o);
+            else if (i == o)
+                src = ir + length * (channels > 1 ? i : 0);
+            else
+            {
+                convolver_SetIR(conv, i, o, NULL, 0);
+                continue;
+            }
+
+            for (size_t k = 0; k < length; k++)
+                buf[k] = src[k] * wet;
+            if (i == o)
+                buf[0] += dry;
+            ret = convolver_SetIR(conv, i, o, buf, length);
+        }
+
+    free(buf);
+    return ret;
+}
+
+static void RunBlock(convolver_t *conv)
+{
+    const unsigned n = conv->block;
+    const unsigned partitions = conv->partitions;
+    const size_t fdl_size = 2 * n * (size_t)partitions;
+
+    for (unsigned i = 0; i < conv->inputs; i++)
+    {
+        float *history = conv->history + 2 * n * i;
+
+        Forward(conv, history,
+                conv->fdl + fdl_size * i + 2 * n * (size_t)conv->head);
+        memcpy(history, history + n, n * sizeof (float));
+    }
+
+    for (unsigned o = 0; o < conv->outputs; o++)
+    {
+        float *acc_re = conv->spectrum, *acc_im = conv->spectrum + n;
+        bool connected = false;
+
+        memset(conv->spectrum, 0, 2 * n * sizeof (float));
+
+        for (unsigned i = 0; i < conv->inputs; i++)
+        {
+            const float *ir = conv->irs[i * conv->outputs + o];
+            if (ir == NULL)
+                continue;
+
+            const float *fdl = conv->fdl + fdl_size * i;
+            unsigned slot = conv->head;
+
+            for (unsigned p = 0; p < partitions; p++)
+            {
+                const float *x = fdl + 2 * n * (size_t)slot;
+                const float *h = ir + 2 * n * (size_t)p;
+                const float dc = acc_re[0], nyquist = acc_im[0];
+
+                conv->mac(acc_re, acc_im, x, x + n, h, h + n, n);
+                /* DC and Nyquist bins are both real */
+                acc_re[0] = dc + x[0] * h[0];
+                acc_im[0] = nyquist + x[n] * h[n];
+
+                slot = (slot > 0 ? slot : partitions) - 1;
+            }
+            connected = true;
+        }
+
+        float *pending = conv->pending + n * o;
+        if (connected)
+        {
+            Inverse(conv, conv->spectrum, conv->work);
+            memcpy(pending, conv->work + n, n * sizeof (float));
+        }
+        else
+            memset(pending, 0, n * sizeof (float));
+    }
+
+    conv->head = (conv->head + 1) % partitions;
+}
+
+void convolver_Process(convolver_t *conv, const float *in, float *out,
+                       size_t frames)
+{
+    const unsigned n = conv->block;
+    const unsigned inputs = conv->inputs, outputs = conv->outputs;
+
+    assert(in != out || outputs <= inputs);
+
+    while (frames > 0)
+    {
+        const unsigned count = __MIN(frames, n - conv->fill);
+
+        /* Consume the whole chunk first, to allow in-place processing */
+        for (unsigned i = 0; i < inputs; i++)
+        {
+            float *history = conv->history + 2 * n * i + n + conv->fill;
+
+            if (in == NULL)
+                memset(history, 0, count * sizeof (float));
+            else
+                for (unsigned f = 0; f < count; f++)
+                    history[f] = in[f * inputs + i];
+        }
+
+        for (unsigned o = 0; o < outputs; o++)
+        {
+            const float *pending = conv->pending + n * o + conv->fill;
+            for (unsigned f = 0; f < count; f++)
+                out[f * outputs + o] = pending[f];
+        }
+
+        if (in != NULL)
+            in += count * inputs;
+        out += count * outputs;
+        frames -= count;
+        conv->fill += count;
+
+        if (conv->fill == n)
+        {
+            RunBlock(conv);
+            conv->fill = 0;
+        }
+    }
+}
+
+void convolver_Reset(convolver_t *conv)
+{
+    const unsigned n = conv->block;
+
+    memset(conv->history, 0, 2 * n * conv->inputs * sizeof (float));
+    memset(conv->pending, 0, n * conv->outputs * sizeof (float));
+    memset(conv->fdl, 0,
+           2 * n * (size_t)conv->partitions * conv->inputs * sizeof (float));
+    conv->head = 0;
+    conv->fill = 0;
+}
+
+/*****************************************************************************
+ * Impulse response files
+ *****************************************************************************/
+
+static float ReadSample(const uint8_t *p, unsigned tag, unsigned bits)
+{
+    if (tag == 3 /* IEEE float */)
+    {
+        if (bits == 64)
+        {
+            union { uint64_t u; double d; } v = { .u = GetQWLE(p) };
+            return v.d;
+        }
+        union { uint32_t u; float f; } v = { .u = GetDWLE(p) };
+        return v.f;
+    }
+
+    switch (bits)
+    {
+        case 8:
+            return (p[0] - 128) / 128.f;
+        case 16:
+            return (int16_t)GetWLE(p) / 32768.f;
+        case 24:
+            return (int32_t)((uint32_t)GetWLE(p) << 8
+                             | (uint32_t)p[2] << 24) / 2147483648.f;
+        default:
+            return (int32_t)GetDWLE(p) / 2147483648.f;
+    }
+}
+
+float *convolver_LoadIR(vlc_object_t *obj, const char *path, unsigned rate,
+                        unsigned *channels, size_t *length)
+{
+    FILE *file = vlc_fopen(path, "rb");
+    if (file == NULL)
+    {
+        msg_Err(obj, "cannot open impulse response %s: %s", path,
+                vlc_strerror_c(errno));
+        return NULL;
+    }
+
+    uint8_t *data = NULL;
+    float *ir = NULL;
+    long size = -1;
+
+    if (fseek(file, 0, SEEK_END) == 0)
+        size = ftell(file);
+    if (size < 12 || size > MAX_FILE_SIZE || fseek(file, 0, SEEK_SET))
+    {
+        msg_Err(obj, "invalid impulse response file size");
+        goto out;
+    }
+
+    data = malloc(size);
+    if (unlikely(data == NULL))
+        goto out;
+    if (fread(data, 1, size, file) != (size_t)size)
+    {
+        msg_Err(obj, "cannot read impulse response: %s",
+                vlc_strerror_c(errno));
+        goto out;
+    }
+
+    if (memcmp(data, "RIFF", 4) || memcmp(data + 8, "WAVE", 4))
+    {
+        msg_Err(obj, "impulse response is not a WAV file");
+        goto out;
+    }
+
+    unsigned tag = 0, nb_channels = 0, src_rate = 0, bits = 0;
+    const uint8_t *samples = NULL;
+    size_t samples_size = 0;
+
+    for (size_t offset = 12; offset + 8 <= (size_t)size;)
+    {
+        const uint8_t *chunk = data + offset + 8;
+        size_t chunk_size = GetDWLE(data + offset + 4);
+
+        if (chunk_size > (size_t)size - offset - 8)
+            chunk_size = size - offset - 8;
+
+        if (!memcmp(data + offset, "fmt ", 4) && chunk_size >= 16)
+        {
+            tag = GetWLE(chunk);
+            nb_channels = GetWLE(chunk + 2);
+            src_rate = GetDWLE(chunk + 4);
+            bits = GetWLE(chunk + 14);
+            if (tag == 0xFFFE /* extensible */ && chunk_size >= 26)
+                tag = GetWLE(chunk + 24);
+        }
+        else
+        if (!memcmp(data + offset, "data", 4))
+        {
+            samples = chunk;
+            samples_size = chunk_size;
+        }
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    if (!((tag == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32))
+       || (tag == 3 && (bits == 32 || bits == 64)))
+     || nb_channels == 0 || src_rate == 0 || samples == NULL)
+    {
+        msg_Err(obj, "unsupported impulse response format");
+        goto out;
+    }
+
+    const unsigned frame_size = nb_channels * (bits / 8);
+    const size_t frames = samples_size / frame_size;
+    /* Linear interpolation is coarse, but impulse responses are mostly
+     * recorded at the usual rates, and this only happens once. */
+    const double ratio = (double)src_rate / rate;
+    const size_t out_frames = ceil(frames / ratio);
+
+    if (frames == 0 || out_frames == 0 || out_frames > CONVOLVER_MAX_LENGTH)
+    {
+        msg_Err(obj, "unsupported impulse response length");
+        goto out;
+    }
+
+    ir = vlc_alloc(out_frames * nb_channels, sizeof (*ir));
+    if (unlikely(ir == NULL))
+        goto out;
+
+    for (unsigned c = 0; c < nb_channels; c++)
+    {
+        const uint8_t *p = samples + c * (bits / 8);
+        float *dst = ir + out_frames * c;
+
+        if (src_rate == rate)
+        {
+            for (size_t i = 0; i < frames; i++)
+                dst[i] = ReadSample(p + i * frame_size, tag, bits);
+            continue;
+        }
+
+        /* Keep the gain of the filter, i.e. the sum of the coefficients */
+        for (size_t i = 0; i < out_frames; i++)
+        {
+            double pos = i * ratio;
+            size_t idx = pos;
+            float frac = pos - idx;
+            float a = ReadSample(p + idx * frame_size, tag, bits);
+            float b = idx + 1 < frames
+                    ? ReadSample(p + (idx + 1) * frame_size, tag, bits) : 0.f;
+
+            dst[i] = (a + (b - a) * frac) * ratio;
+        }
+    }
+
+    msg_Dbg(obj, "loaded impulse response: %u channel(s), %zu samples",
+            nb_channels, out_frames);
+    *channels = nb_channels;
+    *length = out_frames;
+out:
+    free(data);
+    fclose(file);
+    return ir;
+}
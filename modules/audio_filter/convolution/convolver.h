@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * convolver.h: uniformly partitioned FFT convolution engine
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_CONVOLVER_H
+#define VLC_AUDIO_CONVOLVER_H 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Multi-channel convolution engine.
+ *
+ * The impulse responses are split in partitions of the block length, which
+ * are convolved in the frequency domain (overlap-save with a frequency domain
+ * delay line). Each input and each output is transformed only once per block,
+ * whatever the number of impulse responses connecting them.
+ *
+ * The output is delayed by exactly one block length.
+ */
+typedef struct convolver convolver_t;
+
+/** Default block length: 256 samples, i.e. 5.3 ms at 48 kHz */
+#define CONVOLVER_BLOCK 256
+
+/** Longest supported impulse response (in samples) */
+#define CONVOLVER_MAX_LENGTH (1 << 21)
+
+/**
+ * Creates a convolution engine.
+ *
+ * \param block block length, a power of two between 16 and 8192
+ * \param inputs number of input channels
+ * \param outputs number of output channels
+ * \param length length of the longest impulse response (in samples)
+ * \return the engine or NULL on error
+ */
+convolver_t *convolver_New(unsigned block, unsigned inputs, unsigned outputs,
+                           size_t length);
+
+void convolver_Delete(convolver_t *);
+
+/**
+ * Sets the impulse response from one input to one output.
+ *
+ * By default, no input is connected to any output.
+ *
+ * \param ir impulse response samples, or NULL to disconnect
+ * \param length number of samples, at most the length given at creation
+ */
+int convolver_SetIR(convolver_t *, unsigned input, unsigned output,
+                    const float *ir, size_t length);
+
+/**
+ * Sets the impulse responses of a filter with as many outputs as inputs.
+ *
+ * A single channel response is applied to every channel, a response with as
+ * many channels as the filter is applied per channel, and a response with
+ * the square of the channels count is a full matrix (input major).
+ * The dry signal is mixed in the response, so that it stays in sync.
+ *
+ * \param ir planar samples of the response
+ * \param channels number of channels of the response
+ * \param length number of samples per channel
+ * \param wet gain of the response
+ * \param dry gain of the original signal
+ */
+int convolver_SetResponses(convolver_t *, const float *ir, unsigned channels,
+                           size_t length, float wet, float dry);
+
+/**
+ * Processes interleaved samples.
+ *
+ * The input and output buffers can be the same if there are no more outputs
+ * than inputs. The input can be NULL to process silence, e.g. to drain.
+ *
+ * \param frames number of samples per channel
+ */
+void convolver_Process(convolver_t *, const float *in, float *out,
+                       size_t frames);
+
+/** Clears the pending samples and the history */
+void convolver_Reset(convolver_t *);
+
+/**
+ * Loads an impulse response from a WAV file.
+ *
+ * The impulse response is resampled to the given rate if needed.
+ *
+ * \param rate sample rate of the stream
+ * \param channels [OUT] number of channels of the impulse response
+ * \param length [OUT] number of samples per channel
+ * \return planar samples (to be freed with free()), or NULL on error
+ */
+float *convolver_LoadIR(vlc_object_t *, const char *path, unsigned rate,
+                        unsigned *channels, size_t *length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -28,6 +28,7 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
 #include <math.h>
 
 #include <vlc_common.h>
@@ -36,11 +37,22 @@
 
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define EQZ_NEON 1
+#endif
 
 #include "equalizer_presets.h"
 
 /* TODO:
- *  - optimize a bit (you can hardly do slower ;)
  *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
  *    computation (not too hard once the Q is found).
  *  - support for external preset
@@ -100,6 +112,37 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+
+/* Channels are filtered together, one per SIMD lane */
+#define EQZ_LANES 8
+/* Frames processed at once, with constant gains slopes */
+#define EQZ_BLOCK 32
+/* Fraction of a gain change applied per block, so that changes are smooth */
+#define EQZ_SMOOTH (0.125f)
+
+/* Filter state of a group of channels */
+typedef struct
+{
+    float x[2][EQZ_LANES];                  /* x[n-2], x[n-1] */
+    float y[EQZ_BANDS_MAX][2][EQZ_LANES];   /* y[n-1], y[n-2] */
+} eqz_state_t;
+
+typedef struct
+{
+    int i_band;
+    const float *f_alpha;
+    const float *f_beta;
+    const float *f_gamma;
+    const float *f_amp;     /* per band amp at the start of the block */
+    const float *f_step;    /* per band amp increment per frame */
+} eqz_bank_t;
+
+/* Runs the band filters on x (preceded by 2 frames of history), and
+ * accumulates their amplified output in o */
+typedef void (*eqz_kernel_t)( eqz_state_t *, const eqz_bank_t *,
+                              const float *x, float *o,
+                              unsigned i_frames, unsigned i_lanes );
+
 typedef struct
 {
     /* Filter static config */
@@ -113,13 +156,18 @@ typedef struct
     float f_gamp;   /* Global preamp */
     bool b_2eqz;
 
-    /* Filter state */
-    float x[32][2];
-    float y[32][128][2];
+    /* Gains currently applied, which follow the configuration */
+    float f_amp_cur[EQZ_BANDS_MAX];
+    float f_gamp_cur;
+
+    /* Filter state, per group of channels */
+    unsigned i_groups;
+    eqz_state_t *state;
 
     /* Second filter state */
-    float x2[32][2];
-    float y2[32][128][2];
+    eqz_state_t *state2;
+
+    eqz_kernel_t pf_bank;
 
     vlc_mutex_t lock;
 } filter_sys_t;
@@ -127,7 +175,7 @@ typedef struct
 static block_t *DoWork( filter_t *, block_t * );
 
 #define EQZ_IN_FACTOR (0.25f)
-static int  EqzInit( filter_t *, int );
+static int  EqzInit( filter_t *, int, unsigned );
 static void EqzFilter( filter_t *, float *, float *, int, int );
 static void EqzClean( filter_t * );
 
@@ -155,7 +203,9 @@ static int Open( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     vlc_mutex_init( &p_sys->lock );
-    if( EqzInit( p_filter, p_filter->fmt_in.audio.i_rate ) != VLC_SUCCESS )
+    if( EqzInit( p_filter, p_filter->fmt_in.audio.i_rate,
+                 aout_FormatNbChannels( &p_filter->fmt_in.audio ) )
+        != VLC_SUCCESS )
     {
         vlc_mutex_destroy( &p_sys->lock );
         free( p_sys );
@@ -276,11 +326,215 @@ static inline float EqzConvertdB( float db )
     return EQZ_IN_FACTOR * ( powf( 10.0f, db / 20.0f ) - 1.0f );
 }
 
-static int EqzInit( filter_t *p_filter, int i_rate )
+/*****************************************************************************
+ * Band filters kernels
+ *****************************************************************************/
+static void EqzBank( eqz_state_t *st, const eqz_bank_t *bank,
+                     const float *x, float *o,
+                     unsigned i_frames, unsigned i_lanes )
+{
+    for( int j = 0; j < bank->i_band; j++ )
+    {
+        const float a = bank->f_alpha[j];
+        const float b = bank->f_beta[j];
+        const float c = bank->f_gamma[j];
+
+        for( unsigned l = 0; l < i_lanes; l++ )
+        {
+            float y0 = st->y[j][0][l];
+            float y1 = st->y[j][1][l];
+            float amp = bank->f_amp[j];
+
+            for( unsigned n = 0; n < i_frames; n++ )
+            {
+                const float *xn = &x[n * EQZ_LANES + l];
+                float y = a * ( xn[2 * EQZ_LANES] - xn[0] ) + c * y0 - b * y1;
+
+                amp += bank->f_step[j];
+                y1 = y0;
+                y0 = y;
+                o[n * EQZ_LANES + l] += y * amp;
+            }
+            st->y[j][0][l] = y0;
+            st->y[j][1][l] = y1;
+        }
+    }
+}
+
+/* The vector kernels run two bands at once, to hide the latency of the
+ * recursion */
+static_assert( EQZ_BANDS_MAX % 2 == 0, "odd number of bands" );
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static void EqzBank_SSE2( eqz_state_t *st, const eqz_bank_t *bank,
+                          const float *x, float *o,
+                          unsigned i_frames, unsigned i_lanes )
+{
+    for( unsigned l = 0; l < i_lanes; l += 4 )
+        for( int j = 0; j < bank->i_band; j += 2 )
+        {
+            const __m128 a0 = _mm_set1_ps( bank->f_alpha[j] );
+            const __m128 a1 = _mm_set1_ps( bank->f_alpha[j + 1] );
+            const __m128 b0 = _mm_set1_ps( bank->f_beta[j] );
+            const __m128 b1 = _mm_set1_ps( bank->f_beta[j + 1] );
+            const __m128 c0 = _mm_set1_ps( bank->f_gamma[j] );
+            const __m128 c1 = _mm_set1_ps( bank->f_gamma[j + 1] );
+            const __m128 step0 = _mm_set1_ps( bank->f_step[j] );
+            const __m128 step1 = _mm_set1_ps( bank->f_step[j + 1] );
+            __m128 amp0 = _mm_set1_ps( bank->f_amp[j] );
+            __m128 amp1 = _mm_set1_ps( bank->f_amp[j + 1] );
+            __m128 y00 = _mm_loadu_ps( &st->y[j][0][l] );
+            __m128 y01 = _mm_loadu_ps( &st->y[j][1][l] );
+            __m128 y10 = _mm_loadu_ps( &st->y[j + 1][0][l] );
+            __m128 y11 = _mm_loadu_ps( &st->y[j + 1][1][l] );
+
+            for( unsigned n = 0; n < i_frames; n++ )
+            {
+                const float *xn = &x[n * EQZ_LANES + l];
+                float *on = &o[n * EQZ_LANES + l];
+                __m128 dx = _mm_sub_ps( _mm_loadu_ps( &xn[2 * EQZ_LANES] ),
+                                        _mm_loadu_ps( xn ) );
+                __m128 y0 = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( a0, dx ),
+                                                    _mm_mul_ps( c0, y00 ) ),
+                                        _mm_mul_ps( b0, y01 ) );
+                __m128 y1 = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( a1, dx ),
+                                                    _mm_mul_ps( c1, y10 ) ),
+                                        _mm_mul_ps( b1, y11 ) );
+
+                amp0 = _mm_add_ps( amp0, step0 );
+                amp1 = _mm_add_ps( amp1, step1 );
+                y01 = y00;
+                y00 = y0;
+                y11 = y10;
+                y10 = y1;
+                _mm_storeu_ps( on, _mm_add_ps( _mm_add_ps( _mm_loadu_ps( on ),
+                                                           _mm_mul_ps( y0, amp0 ) ),
+                                               _mm_mul_ps( y1, amp1 ) ) );
+            }
+            _mm_storeu_ps( &st->y[j][0][l], y00 );
+            _mm_storeu_ps( &st->y[j][1][l], y01 );
+            _mm_storeu_ps( &st->y[j + 1][0][l], y10 );
+            _mm_storeu_ps( &st->y[j + 1][1][l], y11 );
+        }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static void EqzBank_AVX2( eqz_state_t *st, const eqz_bank_t *bank,
+                          const float *x, float *o,
+                          unsigned i_frames, unsigned i_lanes )
+{
+    /* Narrow groups are not worth the wider vectors */
+    if( i_lanes <= 4 )
+    {
+        EqzBank_SSE2( st, bank, x, o, i_frames, i_lanes );
+        return;
+    }
+
+    for( int j = 0; j < bank->i_band; j += 2 )
+    {
+        const __m256 a0 = _mm256_set1_ps( bank->f_alpha[j] );
+        const __m256 a1 = _mm256_set1_ps( bank->f_alpha[j + 1] );
+        const __m256 b0 = _mm256_set1_ps( bank->f_beta[j] );
+        const __m256 b1 = _mm256_set1_ps( bank->f_beta[j + 1] );
+        const __m256 c0 = _mm256_set1_ps( bank->f_gamma[j] );
+        const __m256 c1 = _mm256_set1_ps( bank->f_gamma[j + 1] );
+        const __m256 step0 = _mm256_set1_ps( bank->f_step[j] );
+        const __m256 step1 = _mm256_set1_ps( bank->f_step[j + 1] );
+        __m256 amp0 = _mm256_set1_ps( bank->f_amp[j] );
+        __m256 amp1 = _mm256_set1_ps( bank->f_amp[j + 1] );
+        __m256 y00 = _mm256_loadu_ps( st->y[j][0] );
+        __m256 y01 = _mm256_loadu_ps( st->y[j][1] );
+        __m256 y10 = _mm256_loadu_ps( st->y[j + 1][0] );
+        __m256 y11 = _mm256_loadu_ps( st->y[j + 1][1] );
+
+        for( unsigned n = 0; n < i_frames; n++ )
+        {
+            const float *xn = &x[n * EQZ_LANES];
+            float *on = &o[n * EQZ_LANES];
+            __m256 dx = _mm256_sub_ps( _mm256_loadu_ps( &xn[2 * EQZ_LANES] ),
+                                       _mm256_loadu_ps( xn ) );
+            __m256 y0 = _mm256_sub_ps( _mm256_add_ps( _mm256_mul_ps( a0, dx ),
+                                                      _mm256_mul_ps( c0, y00 ) ),
+                                       _mm256_mul_ps( b0, y01 ) );
+            __m256 y1 = _mm256_sub_ps( _mm256_add_ps( _mm256_mul_ps( a1, dx ),
+                                                      _mm256_mul_ps( c1, y10 ) ),
+                                       _mm256_mul_ps( b1, y11 ) );
+
+            amp0 = _mm256_add_ps( amp0, step0 );
+            amp1 = _mm256_add_ps( amp1, step1 );
+            y01 = y00;
+            y00 = y0;
+            y11 = y10;
+            y10 = y1;
+            _mm256_storeu_ps( on,
+                _mm256_add_ps( _mm256_add_ps( _mm256_loadu_ps( on ),
+                                              _mm256_mul_ps( y0, amp0 ) ),
+                               _mm256_mul_ps( y1, amp1 ) ) );
+        }
+        _mm256_storeu_ps( st->y[j][0], y00 );
+        _mm256_storeu_ps( st->y[j][1], y01 );
+        _mm256_storeu_ps( st->y[j + 1][0], y10 );
+        _mm256_storeu_ps( st->y[j + 1][1], y11 );
+    }
+}
+#endif
+
+#ifdef EQZ_NEON
+static void EqzBank_NEON( eqz_state_t *st, const eqz_bank_t *bank,
+                          const float *x, float *o,
+                          unsigned i_frames, unsigned i_lanes )
+{
+    for( unsigned l = 0; l < i_lanes; l += 4 )
+        for( int j = 0; j < bank->i_band; j += 2 )
+        {
+            const float a0 = bank->f_alpha[j], a1 = bank->f_alpha[j + 1];
+            const float b0 = bank->f_beta[j], b1 = bank->f_beta[j + 1];
+            const float c0 = bank->f_gamma[j], c1 = bank->f_gamma[j + 1];
+            const float32x4_t step0 = vdupq_n_f32( bank->f_step[j] );
+            const float32x4_t step1 = vdupq_n_f32( bank->f_step[j + 1] );
+            float32x4_t amp0 = vdupq_n_f32( bank->f_amp[j] );
+            float32x4_t amp1 = vdupq_n_f32( bank->f_amp[j + 1] );
+            float32x4_t y00 = vld1q_f32( &st->y[j][0][l] );
+            float32x4_t y01 = vld1q_f32( &st->y[j][1][l] );
+            float32x4_t y10 = vld1q_f32( &st->y[j + 1][0][l] );
+            float32x4_t y11 = vld1q_f32( &st->y[j + 1][1][l] );
+
+            for( unsigned n = 0; n < i_frames; n++ )
+            {
+                const float *xn = &x[n * EQZ_LANES + l];
+                float *on = &o[n * EQZ_LANES + l];
+                float32x4_t dx = vsubq_f32( vld1q_f32( &xn[2 * EQZ_LANES] ),
+                                            vld1q_f32( xn ) );
+                float32x4_t y0 = vmulq_n_f32( dx, a0 );
+                float32x4_t y1 = vmulq_n_f32( dx, a1 );
+
+                y0 = vmlsq_n_f32( vmlaq_n_f32( y0, y00, c0 ), y01, b0 );
+                y1 = vmlsq_n_f32( vmlaq_n_f32( y1, y10, c1 ), y11, b1 );
+                amp0 = vaddq_f32( amp0, step0 );
+                amp1 = vaddq_f32( amp1, step1 );
+                y01 = y00;
+                y00 = y0;
+                y11 = y10;
+                y10 = y1;
+                vst1q_f32( on, vmlaq_f32( vmlaq_f32( vld1q_f32( on ), y0, amp0 ),
+                                          y1, amp1 ) );
+            }
+            vst1q_f32( &st->y[j][0][l], y00 );
+            vst1q_f32( &st->y[j][1][l], y01 );
+            vst1q_f32( &st->y[j + 1][0][l], y10 );
+            vst1q_f32( &st->y[j + 1][1][l], y11 );
+        }
+}
+#endif
+
+static int EqzInit( filter_t *p_filter, int i_rate, unsigned i_channels )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
+    int i;
     vlc_value_t val1, val2, val3;
     vlc_object_t *p_aout = vlc_object_parent(p_filter);
     int i_ret = VLC_ENOMEM;
@@ -289,6 +543,7 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     EqzCoeffs( i_rate, 1.0f, b_vlcFreqs, &cfg );
 
     /* Create the static filter config */
+    p_sys->state = p_sys->state2 = NULL;
     p_sys->i_band = cfg.i_band;
     p_sys->f_alpha = vlc_alloc( p_sys->i_band, sizeof(float) );
     p_sys->f_beta  = vlc_alloc( p_sys->i_band, sizeof(float) );
@@ -316,22 +571,29 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     }
 
     /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
+    p_sys->i_groups = ( i_channels + EQZ_LANES - 1 ) / EQZ_LANES;
+    p_sys->state  = calloc( p_sys->i_groups, sizeof(*p_sys->state) );
+    p_sys->state2 = calloc( p_sys->i_groups, sizeof(*p_sys->state2) );
+    if( !p_sys->state || !p_sys->state2 )
     {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
-
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
+        free( p_sys->f_amp );
+        goto error;
     }
 
+    p_sys->pf_bank = EqzBank;
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+        p_sys->pf_bank = EqzBank_SSE2;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        p_sys->pf_bank = EqzBank_AVX2;
+#endif
+#ifdef EQZ_NEON
+    if( vlc_CPU_ARM_NEON() )
+        p_sys->pf_bank = EqzBank_NEON;
+#endif
+
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
 
@@ -362,6 +624,11 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     }
     free( val2.psz_string );
 
+    /* Start with the initial gains, without transition */
+    for( i = 0; i < p_sys->i_band; i++ )
+        p_sys->f_amp_cur[i] = p_sys->f_amp[i];
+    p_sys->f_gamp_cur = p_sys->f_gamp;
+
     /* Add our own callbacks */
     var_AddCallback( p_aout, "equalizer-preset", PresetCallback, p_sys );
     var_AddCallback( p_aout, "equalizer-bands", BandsCallback, p_sys );
@@ -382,68 +649,110 @@ error:
     free( p_sys->f_alpha );
     free( p_sys->f_beta );
     free( p_sys->f_gamma );
+    free( p_sys->state );
+    free( p_sys->state2 );
     return i_ret;
 }
 
+/* Moves the applied gains toward the configured ones, for one block */
+static float EqzSmooth( float *pf_cur, float f_target )
+{
+    float f_start = *pf_cur;
+    float f_next = f_start + ( f_target - f_start ) * EQZ_SMOOTH;
+
+    if( fabsf( f_target - f_next ) < 1e-5f )
+        f_next = f_target;
+    *pf_cur = f_next;
+    return f_next - f_start;
+}
+
+static void EqzGroup( filter_sys_t *p_sys, const eqz_bank_t *bank,
+                      unsigned i_group, float *out, const float *in,
+                      unsigned i_frames, unsigned i_channels,
+                      float f_gamp, float f_gstep )
+{
+    /* Samples of the group, after 2 frames of history, one per lane */
+    float x[(EQZ_BLOCK + 2) * EQZ_LANES];
+    float o[EQZ_BLOCK * EQZ_LANES];
+    const unsigned i_first = i_group * EQZ_LANES;
+    const unsigned i_lanes = __MIN( i_channels - i_first, EQZ_LANES );
+    eqz_state_t *st = &p_sys->state[i_group];
+
+    memcpy( x, st->x, sizeof(st->x) );
+    memset( x + 2 * EQZ_LANES, 0, i_frames * sizeof(float) * EQZ_LANES );
+    for( unsigned n = 0; n < i_frames; n++ )
+        for( unsigned l = 0; l < i_lanes; l++ )
+            x[(n + 2) * EQZ_LANES + l] = in[n * i_channels + i_first + l];
+    memcpy( st->x, x + i_frames * EQZ_LANES, sizeof(st->x) );
+
+    memset( o, 0, i_frames * sizeof(float) * EQZ_LANES );
+    p_sys->pf_bank( st, bank, x, o, i_frames, i_lanes );
+
+    /* Second filter */
+    if( p_sys->b_2eqz )
+    {
+        st = &p_sys->state2[i_group];
+        memcpy( x, st->x, sizeof(st->x) );
+        for( unsigned i = 0; i < i_frames * EQZ_LANES; i++ )
+            x[2 * EQZ_LANES + i] = EQZ_IN_FACTOR * x[2 * EQZ_LANES + i] + o[i];
+        memcpy( st->x, x + i_frames * EQZ_LANES, sizeof(st->x) );
+
+        memset( o, 0, i_frames * sizeof(float) * EQZ_LANES );
+        p_sys->pf_bank( st, bank, x, o, i_frames, i_lanes );
+    }
+
+    for( unsigned n = 0; n < i_frames; n++ )
+    {
+        f_gamp += f_gstep;
+
+        const float f_gain = p_sys->b_2eqz ? f_gamp * f_gamp : f_gamp;
+        const float *xn = &x[(n + 2) * EQZ_LANES];
+        const float *on = &o[n * EQZ_LANES];
+
+        /* We add source PCM + filtered PCM */
+        for( unsigned l = 0; l < i_lanes; l++ )
+            out[n * i_channels + i_first + l] =
+                f_gain * ( EQZ_IN_FACTOR * xn[l] + on[l] );
+    }
+}
+
 static void EqzFilter( filter_t *p_filter, float *out, float *in,
                        int i_samples, int i_channels )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
+    float f_amp[EQZ_BANDS_MAX], f_step[EQZ_BANDS_MAX];
+    const eqz_bank_t bank = {
+        .i_band = p_sys->i_band,
+        .f_alpha = p_sys->f_alpha,
+        .f_beta = p_sys->f_beta,
+        .f_gamma = p_sys->f_gamma,
+        .f_amp = f_amp,
+        .f_step = f_step,
+    };
 
     vlc_mutex_lock( &p_sys->lock );
-    for( i = 0; i < i_samples; i++ )
+    for( int i = 0; i < i_samples; i += EQZ_BLOCK )
     {
-        for( ch = 0; ch < i_channels; ch++ )
-        {
-            const float x = in[ch];
-            float o = 0.0f;
-
-            for( j = 0; j < p_sys->i_band; j++ )
-            {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
+        const unsigned i_frames = __MIN( i_samples - i, EQZ_BLOCK );
 
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
+        /* The gains ramp linearly within each block */
+        for( int j = 0; j < p_sys->i_band; j++ )
+        {
+            f_amp[j] = p_sys->f_amp_cur[j];
+            f_step[j] = EqzSmooth( &p_sys->f_amp_cur[j], p_sys->f_amp[j] )
+                      / i_frames;
+        }
 
-                o += y * p_sys->f_amp[j];
-            }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
+        float f_gamp = p_sys->f_gamp_cur;
+        float f_gstep = EqzSmooth( &p_sys->f_gamp_cur, p_sys->f_gamp )
+                      / i_frames;
 
-            /* Second filter */
-            if( p_sys->b_2eqz )
-            {
-                const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
-                {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
-
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
-
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
-
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
-            }
-            else
-            {
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x + o );
-            }
-        }
+        for( unsigned g = 0; g < p_sys->i_groups; g++ )
+            EqzGroup( p_sys, &bank, g, out, in, i_frames, i_channels,
+                      f_gamp, f_gstep );
 
-        in  += i_channels;
-        out += i_channels;
+        in  += i_frames * i_channels;
+        out += i_frames * i_channels;
     }
     vlc_mutex_unlock( &p_sys->lock );
 }
@@ -463,6 +772,8 @@ static void EqzClean( filter_t *p_filter )
     free( p_sys->f_gamma );
 
     free( p_sys->f_amp );
+    free( p_sys->state );
+    free( p_sys->state2 );
 }
 
 
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * loudness.c: EBU R128 loudness meter and normalizer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+
+#include "r128.h"
+
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define NORMALIZE_TEXT N_("Normalize")
+#define NORMALIZE_LONGTEXT N_("Adjust the volume to the target loudness. " \
+    "Otherwise, the loudness is only measured.")
+
+#define TARGET_TEXT N_("Target loudness (LUFS)")
+#define TARGET_LONGTEXT N_("Loudness of the normalized audio. " \
+    "EBU R128 recommends -23 LUFS for broadcasting.")
+
+#define PEAK_TEXT N_("Maximum true peak (dBTP)")
+#define PEAK_LONGTEXT N_("Highest level of the normalized audio, including " \
+    "the peaks between samples. A look-ahead limiter keeps the audio below.")
+
+#define GAIN_TEXT N_("Maximum gain (dB)")
+#define GAIN_LONGTEXT N_("Largest amplification applied to quiet programs.")
+
+vlc_module_begin ()
+    set_description( N_("EBU R128 loudness normalizer") )
+    set_shortname( N_("Loudness") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_AFILTER )
+    add_bool( "loudness-normalize", true, NORMALIZE_TEXT, NORMALIZE_LONGTEXT,
+              false )
+    add_float_with_range( "loudness-target", -23., -70., -5.,
+                          TARGET_TEXT, TARGET_LONGTEXT, false )
+    add_float_with_range( "loudness-true-peak", -1., -12., 0.,
+                          PEAK_TEXT, PEAK_LONGTEXT, false )
+    add_float_with_range( "loudness-max-gain", 12., 0., 40.,
+                          GAIN_TEXT, GAIN_LONGTEXT, true )
+    set_capability( "audio filter", 0 )
+    set_callbacks( Open, Close )
+    add_shortcut( "loudness", "ebur128" )
+vlc_module_end ()
+
+typedef struct
+{
+    r128_t *meter;
+    unsigned channels;
+} filter_sys_t;
+
+/* Measurements published as variables of the parent object, the last one
+ * signals a complete update */
+static const char *const stats_vars[] = {
+    "loudness-momentary", "loudness-short-term", "loudness-integrated",
+    "loudness-range", "loudness-peak",
+};
+static_assert( ARRAY_SIZE(stats_vars)
+                == sizeof (struct vlc_audio_loudness) / sizeof (float),
+               "mismatched statistics" );
+
+static void Publish( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    vlc_object_t *p_parent = vlc_object_parent(p_filter);
+    struct vlc_audio_loudness l;
+
+    r128_GetLoudness( p_sys->meter, &l );
+
+    const float values[] = {
+        l.momentary, l.short_term, l.integrated, l.range, l.true_peak,
+    };
+    for( size_t i = 0; i < ARRAY_SIZE(stats_vars); i++ )
+        var_SetFloat( p_parent, stats_vars[i], values[i] );
+}
+
+static block_t *Process( filter_t *p_filter, block_t *p_block )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( r128_Process( p_sys->meter, (float *)p_block->p_buffer,
+                      p_block->i_nb_samples ) )
+        Publish( p_filter );
+    return p_block;
+}
+
+/* Outputs the samples delayed by the limiter */
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    unsigned i_delay = r128_GetDelay( p_sys->meter );
+    if( i_delay == 0 )
+        return NULL;
+
+    block_t *p_block = block_Alloc( i_delay * p_sys->channels
+                                    * sizeof (float) );
+    if( p_block == NULL )
+        return NULL;
+
+    r128_Drain( p_sys->meter, (float *)p_block->p_buffer );
+    p_block->i_nb_samples = i_delay;
+    p_block->i_length = vlc_tick_from_samples( i_delay,
+                                               p_filter->fmt_in.audio.i_rate );
+    return p_block;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    r128_Reset( p_sys->meter );
+}
+
+/* BS.1770 weighting: surround channels count more, the LFE not at all */
+static float ChannelWeight( uint32_t i_channel )
+{
+    switch( i_channel )
+    {
+        case AOUT_CHAN_LFE:
+            return 0.f;
+        case AOUT_CHAN_MIDDLELEFT:
+        case AOUT_CHAN_MIDDLERIGHT:
+        case AOUT_CHAN_REARLEFT:
+        case AOUT_CHAN_REARRIGHT:
+        case AOUT_CHAN_REARCENTER:
+            return 1.41f;
+        default:
+            return 1.f;
+    }
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    audio_format_t *fmt = &p_filter->fmt_in.audio;
+    float weights[AOUT_CHAN_MAX];
+    unsigned i_channels = 0;
+
+    for( unsigned i = 0; pi_vlc_chan_order_wg4[i]; i++ )
+        if( fmt->i_physical_channels & pi_vlc_chan_order_wg4[i] )
+            weights[i_channels++] = ChannelWeight( pi_vlc_chan_order_wg4[i] );
+    if( i_channels == 0 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->channels = i_channels;
+    p_sys->meter = r128_New( fmt->i_rate, i_channels, weights );
+    if( p_sys->meter == NULL )
+    {
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    if( var_InheritBool( p_filter, "loudness-normalize" ) )
+        r128_SetNormalization( p_sys->meter,
+                               var_InheritFloat( p_filter, "loudness-target" ),
+                               var_InheritFloat( p_filter, "loudness-max-gain" ),
+                               var_InheritFloat( p_filter, "loudness-true-peak" ) );
+
+    vlc_object_t *p_parent = vlc_object_parent(p_filter);
+    for( size_t i = 0; i < ARRAY_SIZE(stats_vars); i++ )
+    {
+        var_Create( p_parent, stats_vars[i], VLC_VAR_FLOAT );
+        var_SetFloat( p_parent, stats_vars[i], NAN );
+    }
+
+    fmt->i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare( fmt );
+    p_filter->fmt_out.audio = *fmt;
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_audio_filter = Process;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    vlc_object_t *p_parent = vlc_object_parent(p_filter);
+
+    /* Not measured anymore */
+    for( size_t i = 0; i < ARRAY_SIZE(stats_vars); i++ )
+    {
+        var_SetFloat( p_parent, stats_vars[i], NAN );
+        var_Destroy( p_parent, stats_vars[i] );
+    }
+
+    r128_Delete( p_sys->meter );
+    free( p_sys );
+}
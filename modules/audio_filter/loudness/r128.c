@@ -0,0 +1,844 @@
+/*****************************************************************************
+ * r128.c: EBU R128 loudness meter and normalizer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define R128_NEON 1
+#endif
+
+#include "r128.h"
+
+#define R128_ALIGN     32
+#define R128_LANES     8     /* channels processed together */
+#define R128_CHUNK     256   /* frames analyzed at once */
+#define R128_TAPS      12    /* taps per phase of the true peak interpolator */
+#define R128_STEPS     30    /* 100 ms steps of the short-term window */
+#define R128_BINS      1000  /* 0.1 LU bins, from -70 to +30 LUFS */
+#define R128_LOOKAHEAD 5     /* limiter look-ahead (ms) */
+#define R128_RELEASE   .1    /* limiter release time constant (s) */
+#define R128_SMOOTH    3.    /* normalization gain time constant (s) */
+
+/* The interpolated peaks of frame n lie between the input frames n - 6 and
+ * n - 5: the limiter delays the signal to look ahead of them */
+#define R128_PEAK_DELAY (R128_TAPS / 2 - 1)
+
+#define ABSOLUTE_GATE (-70.)
+
+/*
+ * True peak interpolation filter of ITU-R BS.1770-4 Annex 2: 4 phases of 12
+ * taps, for sample rates below 96 kHz.
+ */
+static const float tp_taps[4][R128_TAPS] = {
+    {  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,
+       0.0332031250000f, -0.0594482421875f,  0.1373291015625f,
+       0.9721679687500f, -0.1022949218750f,  0.0476074218750f,
+      -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+    { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,
+       0.0891113281250f, -0.1665039062500f,  0.4650878906250f,
+       0.7797851562500f, -0.2003173828125f,  0.1015625000000f,
+      -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+    { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,
+       0.1015625000000f, -0.2003173828125f,  0.7797851562500f,
+       0.4650878906250f, -0.1665039062500f,  0.0891113281250f,
+      -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+    { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,
+       0.0476074218750f, -0.1022949218750f,  0.9721679687500f,
+       0.1373291015625f, -0.0594482421875f,  0.0332031250000f,
+      -0.0196533203125f,  0.0109863281250f,  0.0017089843750f },
+};
+
+typedef struct
+{
+    float b[3];    /* high shelf feed forward */
+    float a[2];    /* high shelf feedback */
+    float c[2];    /* high pass feedback (the feed forward is 1, -2, 1) */
+    unsigned phases;
+    float taps[4][R128_TAPS];
+} r128_filter_t;
+
+/* State of a group of channels, lane major */
+typedef struct
+{
+    float z[4][R128_LANES];    /* K-weighting filters (transposed form II) */
+    float history[R128_TAPS - 1][R128_LANES];
+} r128_lanes_t;
+
+/**
+ * Analyzes a group of channels.
+ *
+ * \param x R128_TAPS - 1 frames of history, followed by the frames
+ * \param energy [IN/OUT] sum of the squared K-weighted samples, per lane
+ * \param peak [IN/OUT] largest interpolated peak, per frame and lane
+ */
+typedef void (*r128_kernel_t)(r128_lanes_t *, const r128_filter_t *,
+                              const float *x, float *energy, float *peak,
+                              unsigned frames, unsigned lanes);
+
+typedef struct
+{
+    uint64_t count;
+    double energy;
+} r128_bin_t;
+
+typedef struct
+{
+    r128_bin_t bins[R128_BINS];
+    uint64_t count;
+    double energy;
+} r128_histogram_t;
+
+struct r128
+{
+    unsigned channels;
+    unsigned groups;
+    r128_filter_t filter;
+    r128_kernel_t kernel;
+
+    r128_lanes_t *lanes;       /* groups */
+    float *x;                  /* (R128_TAPS - 1 + R128_CHUNK) x lanes */
+    float *peak;               /* R128_CHUNK x lanes */
+    float *frame_peak;         /* R128_CHUNK */
+    float *weights;            /* channels */
+    double *energy;            /* channels: current step */
+
+    /* Measurement */
+    unsigned step_frames;
+    unsigned step_pos;
+    unsigned step_head;
+    unsigned step_count;
+    double steps[R128_STEPS];  /* weighted energy of the last steps */
+    r128_histogram_t integrated;
+    r128_histogram_t range;
+    float max_peak;
+    struct vlc_audio_loudness loudness;
+
+    /* Normalization */
+    bool normalize;
+    float target;
+    float max_gain;
+    float ceiling;
+    float smooth;
+    float gain_db;
+    float gain;                /* linear, ramped per frame */
+    float gain_step;
+
+    /* Limiter */
+    unsigned lookahead;        /* frames */
+    unsigned delay;            /* frames */
+    float release;
+    float hold;
+    float *line;               /* delay x channels */
+    unsigned line_pos;
+    float *min_value;          /* lookahead + 1: sliding minimum */
+    uint64_t *min_date;
+    unsigned min_head;
+    unsigned min_size;
+    float *box;                /* lookahead: smoothing */
+    double box_sum;
+    unsigned box_pos;
+    uint64_t date;
+};
+
+/*****************************************************************************
+ * Kernels
+ *****************************************************************************/
+
+static void Kernel(r128_lanes_t *st, const r128_filter_t *f, const float *x,
+                   float *energy, float *peak, unsigned frames,
+                   unsigned lanes)
+{
+    for (unsigned l = 0; l < lanes; l++)
+    {
+        float s0 = st->z[0][l], s1 = st->z[1][l];
+        float t0 = st->z[2][l], t1 = st->z[3][l];
+        float e = 0.f;
+
+        for (unsigned n = 0; n < frames; n++)
+        {
+            const float *xn = &x[(n + R128_TAPS - 1) * R128_LANES + l];
+            const float in = *xn;
+            const float y = f->b[0] * in + s0;
+            const float z = y + t0;
+
+            s0 = f->b[1] * in - f->a[0] * y + s1;
+            s1 = f->b[2] * in - f->a[1] * y;
+            t0 = t1 - 2.f * y - f->c[0] * z;
+            t1 = y - f->c[1] * z;
+            e += z * z;
+
+            float p = peak[n * R128_LANES + l];
+            for (unsigned k = 0; k < f->phases; k++)
+            {
+                float acc = 0.f;
+                for (unsigned j = 0; j < R128_TAPS; j++)
+                    acc += f->taps[k][j] * xn[-(int)(j * R128_LANES)];
+                p = fmaxf(p, fabsf(acc));
+            }
+            peak[n * R128_LANES + l] = p;
+        }
+
+        st->z[0][l] = s0;
+        st->z[1][l] = s1;
+        st->z[2][l] = t0;
+        st->z[3][l] = t1;
+        energy[l] += e;
+    }
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static void Kernel_SSE2(r128_lanes_t *st, const r128_filter_t *f,
+                        const float *x, float *energy, float *peak,
+                        unsigned frames, unsigned lanes)
+{
+    const __m128 b0 = _mm_set1_ps(f->b[0]), b1 = _mm_set1_ps(f->b[1]);
+    const __m128 b2 = _mm_set1_ps(f->b[2]);
+    const __m128 a0 = _mm_set1_ps(f->a[0]), a1 = _mm_set1_ps(f->a[1]);
+    const __m128 c0 = _mm_set1_ps(f->c[0]), c1 = _mm_set1_ps(f->c[1]);
+    const __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    for (unsigned l = 0; l < lanes; l += 4)
+    {
+        __m128 s0 = _mm_load_ps(&st->z[0][l]), s1 = _mm_load_ps(&st->z[1][l]);
+        __m128 t0 = _mm_load_ps(&st->z[2][l]), t1 = _mm_load_ps(&st->z[3][l]);
+        __m128 e = _mm_setzero_ps();
+
+        for (unsigned n = 0; n < frames; n++)
+        {
+            const float *xn = &x[(n + R128_TAPS - 1) * R128_LANES + l];
+            const __m128 in = _mm_load_ps(xn);
+            const __m128 y = _mm_add_ps(_mm_mul_ps(b0, in), s0);
+            const __m128 z = _mm_add_ps(y, t0);
+
+            s0 = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(b1, in), s1),
+                            _mm_mul_ps(a0, y));
+            s1 = _mm_sub_ps(_mm_mul_ps(b2, in), _mm_mul_ps(a1, y));
+            t0 = _mm_sub_ps(_mm_sub_ps(t1, _mm_add_ps(y, y)),
+                            _mm_mul_ps(c0, z));
+            t1 = _mm_sub_ps(y, _mm_mul_ps(c1, z));
+            e = _mm_add_ps(e, _mm_mul_ps(z, z));
+
+            float *pn = &peak[n * R128_LANES + l];
+            __m128 p = _mm_load_ps(pn);
+            for (unsigned k = 0; k < f->phases; k++)
+            {
+                __m128 acc = _mm_setzero_ps();
+                for (unsigned j = 0; j < R128_TAPS; j++)
+                    acc = _mm_add_ps(acc,
+                              _mm_mul_ps(_mm_set1_ps(f->taps[k][j]),
+                                         _mm_load_ps(xn - j * R128_LANES)));
+                p = _mm_max_ps(p, _mm_and_ps(acc, mask));
+            }
+            _mm_store_ps(pn, p);
+        }
+
+        _mm_store_ps(&st->z[0][l], s0);
+        _mm_store_ps(&st->z[1][l], s1);
+        _mm_store_ps(&st->z[2][l], t0);
+        _mm_store_ps(&st->z[3][l], t1);
+        _mm_storeu_ps(&energy[l], _mm_add_ps(_mm_loadu_ps(&energy[l]), e));
+    }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static void Kernel_AVX2(r128_lanes_t *st, const r128_filter_t *f,
+                        const float *x, float *energy, float *peak,
+                        unsigned frames, unsigned lanes)
+{
+    /* Narrow groups are not worth the wider vectors */
+    if (lanes <= 4)
+    {
+        Kernel_SSE2(st, f, x, energy, peak, frames, lanes);
+        return;
+    }
+
+    const __m256 b0 = _mm256_set1_ps(f->b[0]), b1 = _mm256_set1_ps(f->b[1]);
+    const __m256 b2 = _mm256_set1_ps(f->b[2]);
+    const __m256 a0 = _mm256_set1_ps(f->a[0]), a1 = _mm256_set1_ps(f->a[1]);
+    const __m256 c0 = _mm256_set1_ps(f->c[0]), c1 = _mm256_set1_ps(f->c[1]);
+    const __m256 mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+    __m256 s0 = _mm256_load_ps(st->z[0]), s1 = _mm256_load_ps(st->z[1]);
+    __m256 t0 = _mm256_load_ps(st->z[2]), t1 = _mm256_load_ps(st->z[3]);
+    __m256 e = _mm256_setzero_ps();
+
+    for (unsigned n = 0; n < frames; n++)
+    {
+        const float *xn = &x[(n + R128_TAPS - 1) * R128_LANES];
+        const __m256 in = _mm256_load_ps(xn);
+        const __m256 y = _mm256_add_ps(_mm256_mul_ps(b0, in), s0);
+        const __m256 z = _mm256_add_ps(y, t0);
+
+        s0 = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(b1, in), s1),
+                           _mm256_mul_ps(a0, y));
+        s1 = _mm256_sub_ps(_mm256_mul_ps(b2, in), _mm256_mul_ps(a1, y));
+        t0 = _mm256_sub_ps(_mm256_sub_ps(t1, _mm256_add_ps(y, y)),
+                           _mm256_mul_ps(c0, z));
+        t1 = _mm256_sub_ps(y, _mm256_mul_ps(c1, z));
+        e = _mm256_add_ps(e, _mm256_mul_ps(z, z));
+
+        float *pn = &peak[n * R128_LANES];
+        __m256 p = _mm256_load_ps(pn);
+        for (unsigned k = 0; k < f->phases; k++)
+        {
+            __m256 acc = _mm256_setzero_ps();
+            for (unsigned j = 0; j < R128_TAPS; j++)
+                acc = _mm256_add_ps(acc,
+                          _mm256_mul_ps(_mm256_set1_ps(f->taps[k][j]),
+                                        _mm256_load_ps(xn - j * R128_LANES)));
+            p = _mm256_max_ps(p, _mm256_and_ps(acc, mask));
+        }
+        _mm256_store_ps(pn, p);
+    }
+
+    _mm256_store_ps(st->z[0], s0);
+    _mm256_store_ps(st->z[1], s1);
+    _mm256_store_ps(st->z[2], t0);
+    _mm256_store_ps(st->z[3], t1);
+    _mm256_storeu_ps(energy, _mm256_add_ps(_mm256_loadu_ps(energy), e));
+}
+#endif
+
+#ifdef R128_NEON
+static void Kernel_NEON(r128_lanes_t *st, const r128_filter_t *f,
+                        const float *x, float *energy, float *peak,
+                        unsigned frames, unsigned lanes)
+{
+    for (unsigned l = 0; l < lanes; l += 4)
+    {
+        float32x4_t s0 = vld1q_f32(&st->z[0][l]), s1 = vld1q_f32(&st->z[1][l]);
+        float32x4_t t0 = vld1q_f32(&st->z[2][l]), t1 = vld1q_f32(&st->z[3][l]);
+        float32x4_t e = vdupq_n_f32(0.f);
+
+        for (unsigned n = 0; n < frames; n++)
+        {
+            const float *xn = &x[(n + R128_TAPS - 1) * R128_LANES + l];
+            const float32x4_t in = vld1q_f32(xn);
+            const float32x4_t y = vmlaq_n_f32(s0, in, f->b[0]);
+            const float32x4_t z = vaddq_f32(y, t0);
+
+            s0 = vmlsq_n_f32(vmlaq_n_f32(s1, in, f->b[1]), y, f->a[0]);
+            s1 = vmlsq_n_f32(vmulq_n_f32(in, f->b[2]), y, f->a[1]);
+            t0 = vmlsq_n_f32(vsubq_f32(t1, vaddq_f32(y, y)), z, f->c[0]);
+            t1 = vmlsq_n_f32(y, z, f->c[1]);
+            e = vmlaq_f32(e, z, z);
+
+            float *pn = &peak[n * R128_LANES + l];
+            float32x4_t p = vld1q_f32(pn);
+            for (unsigned k = 0; k < f->phases; k++)
+            {
+                float32x4_t acc = vdupq_n_f32(0.f);
+                for (unsigned j = 0; j < R128_TAPS; j++)
+                    acc = vmlaq_n_f32(acc, vld1q_f32(xn - j * R128_LANES),
+                                      f->taps[k][j]);
+                p = vmaxq_f32(p, vabsq_f32(acc));
+            }
+            vst1q_f32(pn, p);
+        }
+
+        vst1q_f32(&st->z[0][l], s0);
+        vst1q_f32(&st->z[1][l], s1);
+        vst1q_f32(&st->z[2][l], t0);
+        vst1q_f32(&st->z[3][l], t1);
+        vst1q_f32(&energy[l], vaddq_f32(vld1q_f32(&energy[l]), e));
+    }
+}
+#endif
+
+/*****************************************************************************
+ * Measurement
+ *****************************************************************************/
+
+static double Loudness(double energy)
+{
+    return -0.691 + 10. * log10(energy);
+}
+
+static void HistogramAdd(r128_histogram_t *h, double energy)
+{
+    double loudness = Loudness(energy);
+
+    if (!(loudness >= ABSOLUTE_GATE))
+        return;
+
+    int bin = (loudness - ABSOLUTE_GATE) * 10.;
+    if (bin >= R128_BINS)
+        bin = R128_BINS - 1;
+
+    h->bins[bin].count++;
+    h->bins[bin].energy += energy;
+    h->count++;
+    h->energy += energy;
+}
+
+/* Returns the first bin above the relative gate */
+static unsigned HistogramGate(const r128_histogram_t *h, double gate)
+{
+    double threshold = Loudness(h->energy / h->count) + gate;
+    double bin = ceil((threshold - ABSOLUTE_GATE) * 10.);
+
+    return bin > 0. ? __MIN(bin, R128_BINS) : 0;
+}
+
+static float Integrated(const r128_histogram_t *h)
+{
+    if (h->count == 0)
+        return NAN;
+
+    uint64_t count = 0;
+    double energy = 0.;
+    for (unsigned i = HistogramGate(h, -10.); i < R128_BINS; i++)
+    {
+        count += h->bins[i].count;
+        energy += h->bins[i].energy;
+    }
+    return count > 0 ? Loudness(energy / count) : NAN;
+}
+
+static float Range(const r128_histogram_t *h)
+{
+    if (h->count == 0)
+        return NAN;
+
+    const unsigned first = HistogramGate(h, -20.);
+    uint64_t count = 0;
+    for (unsigned i = first; i < R128_BINS; i++)
+        count += h->bins[i].count;
+    if (count == 0)
+        return NAN;
+
+    /* 10th and 95th percentiles */
+    const uint64_t low = count / 10, high = count * 95 / 100;
+    unsigned low_bin = first, high_bin = first;
+    uint64_t sum = 0;
+    for (unsigned i = first; i < R128_BINS; i++)
+    {
+        if (sum <= low)
+            low_bin = i;
+        if (sum <= high)
+            high_bin = i;
+        sum += h->bins[i].count;
+    }
+    return (high_bin - low_bin) / 10.f;
+}
+
+static void UpdateGain(r128_t *r)
+{
+    const struct vlc_audio_loudness *l = &r->loudness;
+    float ref = isnan(l->short_term) ? l->momentary : l->short_term;
+
+    /* Hold the gain during silences and quiet passages */
+    if (!isnan(ref) && ref > ABSOLUTE_GATE
+     && (isnan(l->integrated) || ref > l->integrated - 20.f))
+    {
+        float want = __MIN(r->target - ref, r->max_gain);
+        r->gain_db += (want - r->gain_db) * r->smooth;
+    }
+
+    r->gain_step = (powf(10.f, r->gain_db / 20.f) - r->gain) / r->step_frames;
+}
+
+/* Completes a 100 ms step */
+static void Step(r128_t *r)
+{
+    double energy = 0.;
+    for (unsigned c = 0; c < r->channels; c++)
+    {
+        energy += r->weights[c] * r->energy[c];
+        r->energy[c] = 0.;
+    }
+
+    r->steps[r->step_head] = energy;
+    r->step_head = (r->step_head + 1) % R128_STEPS;
+    if (r->step_count < R128_STEPS)
+        r->step_count++;
+    r->step_pos = 0;
+
+    energy = 0.;
+    for (unsigned i = 1; i <= r->step_count; i++)
+    {
+        energy += r->steps[(r->step_head + R128_STEPS - i) % R128_STEPS];
+
+        if (i == 4)
+        {
+            double block = energy / (4 * r->step_frames);
+            r->loudness.momentary = Loudness(block);
+            HistogramAdd(&r->integrated, block);
+        }
+        else if (i == R128_STEPS)
+        {
+            double block = energy / (R128_STEPS * r->step_frames);
+            r->loudness.short_term = Loudness(block);
+            HistogramAdd(&r->range, block);
+        }
+    }
+
+    r->loudness.integrated = Integrated(&r->integrated);
+    r->loudness.range = Range(&r->range);
+    r->loudness.true_peak = 20.f * log10f(r->max_peak);
+
+    if (r->normalize)
+        UpdateGain(r);
+}
+
+/* Computes the peak of each frame, and the energy of each channel if meter */
+static void Analyze(r128_t *r, const float *in, unsigned frames, bool meter)
+{
+    const unsigned hist = (R128_TAPS - 1) * R128_LANES;
+
+    memset(r->peak, 0, frames * R128_LANES * sizeof (float));
+
+    for (unsigned g = 0; g < r->groups; g++)
+    {
+        r128_lanes_t *st = &r->lanes[g];
+        const unsigned first = g * R128_LANES;
+        const unsigned lanes = __MIN(R128_LANES, r->channels - first);
+        float *x = r->x + hist;
+        float energy[R128_LANES] = { 0.f };
+
+        memcpy(r->x, st->history, sizeof (st->history));
+        if (lanes < R128_LANES || in == NULL)
+            memset(x, 0, frames * R128_LANES * sizeof (float));
+        if (in != NULL)
+            for (unsigned n = 0; n < frames; n++)
+                memcpy(&x[n * R128_LANES], &in[n * r->channels + first],
+                       lanes * sizeof (float));
+        memcpy(st->history, &r->x[frames * R128_LANES],
+               sizeof (st->history));
+
+        r->kernel(st, &r->filter, r->x, energy, r->peak, frames, lanes);
+
+        if (meter)
+            for (unsigned l = 0; l < lanes; l++)
+                r->energy[first + l] += energy[l];
+    }
+
+    for (unsigned n = 0; n < frames; n++)
+    {
+        float p = r->peak[n * R128_LANES];
+        for (unsigned l = 1; l < R128_LANES; l++)
+            p = fmaxf(p, r->peak[n * R128_LANES + l]);
+        r->frame_peak[n] = p;
+        if (meter)
+            r->max_peak = fmaxf(r->max_peak, p);
+    }
+}
+
+/*****************************************************************************
+ * Normalization
+ *****************************************************************************/
+
+/* Applies the normalization gain, and the look-ahead limiter */
+static void Limit(r128_t *r, float *buf, unsigned frames)
+{
+    const unsigned channels = r->channels;
+    const unsigned window = r->lookahead + 1;
+
+    for (unsigned n = 0; n < frames; n++)
+    {
+        const float gain = r->gain;
+        const float p = r->frame_peak[n] * gain;
+        const float need = p > r->ceiling ? r->ceiling / p : 1.f;
+
+        r->gain += r->gain_step;
+
+        /* Sliding minimum of the needed gains over the look-ahead window */
+        while (r->min_size > 0)
+        {
+            unsigned last = (r->min_head + r->min_size - 1) % window;
+            if (r->min_value[last] < need)
+                break;
+            r->min_size--;
+        }
+        unsigned slot = (r->min_head + r->min_size) % window;
+        r->min_value[slot] = need;
+        r->min_date[slot] = r->date;
+        r->min_size++;
+        if (r->min_date[r->min_head] + r->lookahead < r->date)
+        {
+            r->min_head = (r->min_head + 1) % window;
+            r->min_size--;
+        }
+
+        /* Release, then smoothing over the look-ahead: the gain is lowered
+         * progressively before each peak, and never exceeds the needed gain
+         * when the peak is output */
+        float m = r->min_value[r->min_head];
+        r->hold = m < r->hold ? m : r->hold + (m - r->hold) * r->release;
+        r->box_sum += r->hold - r->box[r->box_pos];
+        r->box[r->box_pos] = r->hold;
+        r->box_pos = (r->box_pos + 1) % r->lookahead;
+        const float smoothed = r->box_sum / r->lookahead;
+
+        float *line = &r->line[r->line_pos * channels];
+        float *frame = &buf[n * channels];
+        for (unsigned c = 0; c < channels; c++)
+        {
+            const float v = line[c];
+            line[c] = frame[c] * gain;
+            frame[c] = v * smoothed;
+        }
+        r->line_pos = (r->line_pos + 1) % r->delay;
+        r->date++;
+    }
+}
+
+/*****************************************************************************
+ * Engine
+ *****************************************************************************/
+
+static void *AllocFloats(size_t count)
+{
+    size_t size = (count * sizeof (float) + R128_ALIGN - 1)
+                & ~(size_t)(R128_ALIGN - 1);
+    float *p = aligned_alloc(R128_ALIGN, size);
+    if (likely(p != NULL))
+        memset(p, 0, size);
+    return p;
+}
+
+/* K-weighting filters of BS.1770, for any sample rate */
+static void InitFilter(r128_filter_t *f, unsigned rate)
+{
+    double f0 = 1681.974450955533;
+    double g = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10., g / 20.);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1. + k / q + k * k;
+
+    f->b[0] = (vh + vb * k / q + k * k) / a0;
+    f->b[1] = 2. * (k * k - vh) / a0;
+    f->b[2] = (vh - vb * k / q + k * k) / a0;
+    f->a[0] = 2. * (k * k - 1.) / a0;
+    f->a[1] = (1. - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1. + k / q + k * k;
+    f->c[0] = 2. * (k * k - 1.) / a0;
+    f->c[1] = (1. - k / q + k * k) / a0;
+
+    if (rate < 96000)
+    {
+        f->phases = 4;
+        memcpy(f->taps, tp_taps, sizeof (tp_taps));
+    }
+    else
+    {   /* Use the sample peaks, with the same delay */
+        f->phases = 1;
+        memset(f->taps, 0, sizeof (f->taps));
+        f->taps[0][R128_PEAK_DELAY + 1] = 1.f;
+    }
+}
+
+r128_t *r128_New(unsigned rate, unsigned channels, const float *weights)
+{
+    if (rate < 8000 || rate > 384000 || channels == 0 || channels > 255)
+        return NULL;
+
+    r128_t *r = calloc(1, sizeof (*r));
+    if (unlikely(r == NULL))
+        return NULL;
+
+    r->channels = channels;
+    r->groups = (channels + R128_LANES - 1) / R128_LANES;
+    r->lanes = aligned_alloc(R128_ALIGN, r->groups * sizeof (*r->lanes));
+    r->x = AllocFloats((R128_TAPS - 1 + R128_CHUNK) * R128_LANES);
+    r->peak = AllocFloats(R128_CHUNK * R128_LANES);
+    r->frame_peak = AllocFloats(R128_CHUNK);
+    r->weights = vlc_alloc(channels, sizeof (*r->weights));
+    r->energy = vlc_alloc(channels, sizeof (*r->energy));
+    if (unlikely(r->lanes == NULL || r->x == NULL || r->peak == NULL
+              || r->frame_peak == NULL || r->weights == NULL
+              || r->energy == NULL))
+    {
+        r128_Delete(r);
+        return NULL;
+    }
+
+    for (unsigned c = 0; c < channels; c++)
+        r->weights[c] = weights != NULL ? weights[c] : 1.f;
+
+    InitFilter(&r->filter, rate);
+    r->step_frames = rate / 10;
+    r->lookahead = rate * R128_LOOKAHEAD / 1000;
+    r->delay = r->lookahead + R128_PEAK_DELAY;
+    r->release = 1. - exp(-1. / (R128_RELEASE * rate));
+    r->smooth = 1. - exp(-.1 / R128_SMOOTH);
+    r->gain = 1.f;
+    r->loudness.momentary = r->loudness.short_term = NAN;
+    r->loudness.integrated = r->loudness.range = NAN;
+    r->loudness.true_peak = NAN;
+
+    r->kernel = Kernel;
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE2())
+        r->kernel = Kernel_SSE2;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        r->kernel = Kernel_AVX2;
+#endif
+#ifdef R128_NEON
+    if (vlc_CPU_ARM_NEON())
+        r->kernel = Kernel_NEON;
+#endif
+
+    r128_Reset(r);
+    return r;
+}
+
+void r128_Delete(r128_t *r)
+{
+    aligned_free(r->lanes);
+    aligned_free(r->x);
+    aligned_free(r->peak);
+    aligned_free(r->frame_peak);
+    free(r->weights);
+    free(r->energy);
+    free(r->line);
+    free(r->min_value);
+    free(r->min_date);
+    free(r->box);
+    free(r);
+}
+
+void r128_SetNormalization(r128_t *r, float target, float max_gain,
+                           float ceiling)
+{
+    if (r->line == NULL)
+    {
+        r->line = vlc_alloc(r->delay, r->channels * sizeof (float));
+        r->min_value = vlc_alloc(r->lookahead + 1, sizeof (*r->min_value));
+        r->min_date = vlc_alloc(r->lookahead + 1, sizeof (*r->min_date));
+        r->box = vlc_alloc(r->lookahead, sizeof (*r->box));
+        if (unlikely(r->line == NULL || r->min_value == NULL
+                  || r->min_date == NULL || r->box == NULL))
+            return; /* measure only */
+        r->normalize = true;
+        r128_Reset(r);
+    }
+
+    r->target = target;
+    r->max_gain = max_gain;
+    r->ceiling = powf(10.f, ceiling / 20.f);
+}
+
+unsigned r128_GetDelay(const r128_t *r)
+{
+    return r->normalize ? r->delay : 0;
+}
+
+bool r128_Process(r128_t *r, float *buf, size_t frames)
+{
+    bool updated = false;
+
+    while (frames > 0)
+    {
+        unsigned count = __MIN(frames, R128_CHUNK);
+        count = __MIN(count, r->step_frames - r->step_pos);
+
+        Analyze(r, buf, count, true);
+        if (r->normalize)
+            Limit(r, buf, count);
+
+        r->step_pos += count;
+        if (r->step_pos == r->step_frames)
+        {
+            Step(r);
+            updated = true;
+        }
+        buf += count * r->channels;
+        frames -= count;
+    }
+    return updated;
+}
+
+void r128_Drain(r128_t *r, float *buf)
+{
+    if (!r->normalize)
+        return;
+
+    memset(buf, 0, r->delay * r->channels * sizeof (float));
+    for (unsigned done = 0; done < r->delay;)
+    {
+        unsigned count = __MIN(r->delay - done, R128_CHUNK);
+        float *p = &buf[done * r->channels];
+
+        Analyze(r, NULL, count, false);
+        Limit(r, p, count);
+        done += count;
+    }
+}
+
+void r128_Reset(r128_t *r)
+{
+    memset(r->lanes, 0, r->groups * sizeof (*r->lanes));
+    for (unsigned c = 0; c < r->channels; c++)
+        r->energy[c] = 0.;
+    r->step_pos = 0;
+    r->step_head = 0;
+    r->step_count = 0;
+    r->loudness.momentary = r->loudness.short_term = NAN;
+
+    if (r->normalize)
+    {
+        memset(r->line, 0, r->delay * r->channels * sizeof (float));
+        r->line_pos = 0;
+        r->min_head = 0;
+        r->min_size = 0;
+        for (unsigned i = 0; i < r->lookahead; i++)
+            r->box[i] = 1.f;
+        r->box_sum = r->lookahead;
+        r->box_pos = 0;
+        r->hold = 1.f;
+        r->gain = powf(10.f, r->gain_db / 20.f);
+        r->gain_step = 0.f;
+    }
+}
+
+void r128_GetLoudness(const r128_t *r, struct vlc_audio_loudness *loudness)
+{
+    *loudness = r->loudness;
+}
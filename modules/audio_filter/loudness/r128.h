@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * r128.h: EBU R128 loudness meter and normalizer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_R128_H
+#define VLC_AUDIO_R128_H 1
+
+/**
+ * Loudness meter following ITU-R BS.1770-4 and EBU R128 / Tech 3341-3342:
+ * K-weighting, momentary (400 ms) and short-term (3 s) loudness, gated
+ * integrated loudness, loudness range, and true peak (4x oversampling).
+ *
+ * The channels are processed in vector lanes, so that the cost per channel
+ * stays low for streams with many channels.
+ *
+ * The meter can also normalize the signal to a target loudness, followed by
+ * a look-ahead true peak limiter.
+ */
+typedef struct r128 r128_t;
+
+/**
+ * Creates a loudness meter.
+ *
+ * \param rate sample rate
+ * \param channels number of channels
+ * \param weights gain of each channel in the loudness sum (BS.1770 G
+ *                weighting), or NULL to weight all channels by 1
+ * \return the meter or NULL on error
+ */
+r128_t *r128_New(unsigned rate, unsigned channels, const float *weights);
+
+void r128_Delete(r128_t *);
+
+/**
+ * Enables the normalization.
+ *
+ * The output is then delayed by r128_GetDelay() samples.
+ *
+ * \param target target loudness (LUFS)
+ * \param max_gain largest gain applied (dB)
+ * \param ceiling largest true peak level of the output (dBTP)
+ */
+void r128_SetNormalization(r128_t *, float target, float max_gain,
+                           float ceiling);
+
+/** Returns the delay of the output, in samples */
+unsigned r128_GetDelay(const r128_t *);
+
+/**
+ * Measures and normalizes interleaved samples, in place.
+ *
+ * \param frames number of samples per channel
+ * \return true if the measurements were updated
+ */
+bool r128_Process(r128_t *, float *buf, size_t frames);
+
+/**
+ * Outputs the samples delayed by the normalization.
+ *
+ * \param buf r128_GetDelay() samples per channel
+ */
+void r128_Drain(r128_t *, float *buf);
+
+/**
+ * Clears the signal history, e.g. on discontinuities.
+ *
+ * The program measurements (integrated loudness, loudness range and maximum
+ * true peak) are kept.
+ */
+void r128_Reset(r128_t *);
+
+/** Reads the last measurements */
+void r128_GetLoudness(const r128_t *, struct vlc_audio_loudness *);
+
+#endif
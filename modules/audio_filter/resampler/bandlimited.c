@@ -23,28 +23,54 @@
 /*****************************************************************************
  * Preamble:
  *
- * This implementation of the band-limited interpolationis based on the
+ * This implementation of the band-limited interpolation is based on the
  * following paper:
  * http://ccrma-www.stanford.edu/~jos/resample/resample.html
  *
- * It uses a Kaiser-windowed sinc-function low-pass filter and the width of the
- * filter is 13 samples.
+ * It uses a Kaiser-windowed sinc-function low-pass filter spanning
+ * FILTER_ZEROS zero-crossings on each side, sampled into a polyphase table.
  *
+ * If the ratio between the sample rates is simple enough (e.g. 44100 and
+ * 48000 Hz), the table has one row per possible output phase and each output
+ * sample is a plain dot product. Otherwise, and while the input rate is
+ * adjusted to compensate for the clock drift, the coefficients are linearly
+ * interpolated between two consecutive rows.
+ *
+ * The samples are kept deinterleaved so that the dot products run over
+ * contiguous memory, with SIMD when available.
  *****************************************************************************/
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
 #endif
 
+#include <math.h>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
+#include <vlc_cpu.h>
 
-#include <assert.h>
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define BANDLIMITED_NEON 1
+#endif
 
-#include "bandlimited.h"
+#define FILTER_ZEROS   24    /* zero-crossings on each side of the sinc */
+#define FILTER_CUTOFF  0.88  /* relative to the lowest Nyquist frequency */
+#define FILTER_BETA    8.6   /* Kaiser window parameter (~85 dB rejection) */
+#define MAX_PHASES     1024  /* largest table with one row per phase */
+#define INTERP_PHASES  256   /* rows of a table with interpolation */
+#define MAX_TAPS       512
+#define RATE_TOLERANCE 10    /* input rate change (%) without a new table */
 
 /*****************************************************************************
  * Local prototypes
@@ -54,26 +80,33 @@
 static int  OpenFilter ( vlc_object_t * );
 static void CloseFilter( vlc_object_t * );
 static block_t *Resample( filter_t *, block_t * );
-
-static void ResampleFloat( filter_t *p_filter,
-                           block_t **pp_out_buf,  size_t *pi_out,
-                           float **pp_in,
-                           int i_in, int i_in_end,
-                           double d_factor, bool b_factor_old,
-                           int i_nb_channels, int i_bytes_per_frame );
+static void Flush( filter_t * );
 
 /*****************************************************************************
  * Local structures
  *****************************************************************************/
+typedef float (*dot_t)( const float *, const float *, unsigned );
+typedef void (*lerp_t)( float *, const float *, float, unsigned );
+
 typedef struct
 {
-    int32_t *p_buf;                        /* this filter introduces a delay */
-    size_t i_buf_size;
-
-    double d_old_factor;
-    size_t i_old_wing;
-
-    unsigned int i_remainder;                /* remainder of previous sample */
+    float *p_table;       /* i_phases + 1 rows of i_taps coefficients */
+    float *p_coefs;       /* interpolated coefficients */
+    unsigned i_phases;
+    unsigned i_taps;      /* multiple of 8 */
+    unsigned i_half;      /* half of the filter length (before padding) */
+    unsigned i_table_rate; /* input rate the table was computed for */
+
+    float *p_planes;      /* deinterleaved input samples */
+    size_t i_stride;      /* allocated samples per plane */
+    size_t i_avail;       /* valid samples per plane */
+
+    /* Position of the first tap of the next output sample, in units of
+     * 1/i_phases input sample, as 32.32 fixed point */
+    uint64_t i_pos;
+
+    dot_t pf_dot;
+    lerp_t pf_lerp;
     bool b_first;
 
     date_t end_date;
@@ -95,190 +128,520 @@ vlc_module_begin ()
 vlc_module_end ()
 
 /*****************************************************************************
- * Resample: convert a buffer
+ * Dot products, and interpolation of the coefficients between a row and the
+ * next one (i_taps is a multiple of 8)
  *****************************************************************************/
-static block_t *Resample( filter_t * p_filter, block_t * p_in_buf )
+static float Dot( const float *x, const float *h, unsigned i_taps )
 {
-    if( !p_in_buf || !p_in_buf->i_nb_samples )
+    float a0 = 0.f, a1 = 0.f, a2 = 0.f, a3 = 0.f;
+
+    for( unsigned i = 0; i < i_taps; i += 4 )
     {
-        if( p_in_buf )
-            block_Release( p_in_buf );
-        return NULL;
+        a0 += x[i]     * h[i];
+        a1 += x[i + 1] * h[i + 1];
+        a2 += x[i + 2] * h[i + 2];
+        a3 += x[i + 3] * h[i + 3];
+    }
+    return (a0 + a1) + (a2 + a3);
+}
+
+static void Lerp( float *restrict p_dst, const float *restrict h, float f,
+                  unsigned i_taps )
+{
+    for( unsigned i = 0; i < i_taps; i++ )
+        p_dst[i] = h[i] + f * (h[i_taps + i] - h[i]);
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static float Dot_SSE2( const float *x, const float *h, unsigned i_taps )
+{
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+
+    for( unsigned i = 0; i < i_taps; i += 8 )
+    {
+        a0 = _mm_add_ps( a0, _mm_mul_ps( _mm_loadu_ps( &x[i] ),
+                                         _mm_loadu_ps( &h[i] ) ) );
+        a1 = _mm_add_ps( a1, _mm_mul_ps( _mm_loadu_ps( &x[i + 4] ),
+                                         _mm_loadu_ps( &h[i + 4] ) ) );
+    }
+    a0 = _mm_add_ps( a0, a1 );
+    a0 = _mm_add_ps( a0, _mm_movehl_ps( a0, a0 ) );
+    a0 = _mm_add_ss( a0, _mm_shuffle_ps( a0, a0, 1 ) );
+    return _mm_cvtss_f32( a0 );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Lerp_SSE2( float *restrict p_dst, const float *restrict h, float f,
+                       unsigned i_taps )
+{
+    const __m128 vf = _mm_set1_ps( f );
+
+    for( unsigned i = 0; i < i_taps; i += 4 )
+    {
+        __m128 a = _mm_loadu_ps( &h[i] );
+        __m128 b = _mm_loadu_ps( &h[i_taps + i] );
+        _mm_storeu_ps( &p_dst[i],
+                       _mm_add_ps( a, _mm_mul_ps( vf, _mm_sub_ps( b, a ) ) ) );
+    }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static float Dot_AVX2( const float *x, const float *h, unsigned i_taps )
+{
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 16 <= i_taps; i += 16 )
+    {
+        a0 = _mm256_add_ps( a0, _mm256_mul_ps( _mm256_loadu_ps( &x[i] ),
+                                               _mm256_loadu_ps( &h[i] ) ) );
+        a1 = _mm256_add_ps( a1, _mm256_mul_ps( _mm256_loadu_ps( &x[i + 8] ),
+                                               _mm256_loadu_ps( &h[i + 8] ) ) );
+    }
+    if( i < i_taps )
+        a0 = _mm256_add_ps( a0, _mm256_mul_ps( _mm256_loadu_ps( &x[i] ),
+                                               _mm256_loadu_ps( &h[i] ) ) );
+    a0 = _mm256_add_ps( a0, a1 );
+
+    __m128 s = _mm_add_ps( _mm256_castps256_ps128( a0 ),
+                           _mm256_extractf128_ps( a0, 1 ) );
+    s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+    s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+    return _mm_cvtss_f32( s );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Lerp_AVX2( float *restrict p_dst, const float *restrict h, float f,
+                       unsigned i_taps )
+{
+    const __m256 vf = _mm256_set1_ps( f );
+
+    for( unsigned i = 0; i < i_taps; i += 8 )
+    {
+        __m256 a = _mm256_loadu_ps( &h[i] );
+        __m256 b = _mm256_loadu_ps( &h[i_taps + i] );
+        _mm256_storeu_ps( &p_dst[i], _mm256_add_ps( a,
+                          _mm256_mul_ps( vf, _mm256_sub_ps( b, a ) ) ) );
+    }
+}
+#endif
+
+#ifdef BANDLIMITED_NEON
+static float Dot_NEON( const float *x, const float *h, unsigned i_taps )
+{
+    float32x4_t a0 = vdupq_n_f32( 0.f ), a1 = vdupq_n_f32( 0.f );
+
+    for( unsigned i = 0; i < i_taps; i += 8 )
+    {
+        a0 = vmlaq_f32( a0, vld1q_f32( &x[i] ), vld1q_f32( &h[i] ) );
+        a1 = vmlaq_f32( a1, vld1q_f32( &x[i + 4] ), vld1q_f32( &h[i + 4] ) );
+    }
+    a0 = vaddq_f32( a0, a1 );
+
+    float32x2_t s = vadd_f32( vget_low_f32( a0 ), vget_high_f32( a0 ) );
+    return vget_lane_f32( vpadd_f32( s, s ), 0 );
+}
+
+static void Lerp_NEON( float *restrict p_dst, const float *restrict h, float f,
+                       unsigned i_taps )
+{
+    for( unsigned i = 0; i < i_taps; i += 4 )
+    {
+        float32x4_t a = vld1q_f32( &h[i] );
+        float32x4_t b = vld1q_f32( &h[i_taps + i] );
+        vst1q_f32( &p_dst[i], vmlaq_n_f32( a, vsubq_f32( b, a ), f ) );
+    }
+}
+#endif
+
+/*****************************************************************************
+ * Filter design
+ *****************************************************************************/
+
+/* Modified Bessel function of the first kind, order 0 */
+static double BesselI0( double x )
+{
+    double sum = 1., term = 1.;
+
+    for( unsigned k = 1; term > sum * 1e-12; k++ )
+    {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static void ComputeRow( float *p_row, unsigned i_taps, unsigned i_half,
+                        double offset, double cutoff )
+{
+    const double i0_beta = BesselI0( FILTER_BETA );
+    double sum = 0.;
+
+    for( unsigned k = 0; k < i_taps; k++ )
+    {
+        /* Distance from the tap to the interpolated point, in samples */
+        double d = (double)k - (i_half - 1) - offset;
+        double u = d / i_half;
+        double h = 0.;
+
+        if( fabs( u ) < 1. )
+        {
+            double x = M_PI * cutoff * d;
+            h = cutoff * (x != 0. ? sin( x ) / x : 1.)
+              * BesselI0( FILTER_BETA * sqrt( 1. - u * u ) ) / i0_beta;
+        }
+        p_row[k] = h;
+        sum += h;
+    }
+
+    /* Unity gain at DC */
+    for( unsigned k = 0; k < i_taps; k++ )
+        p_row[k] /= sum;
+}
+
+/* Moves the samples of each plane by i_shift (may be negative) */
+static void ShiftPlanes( filter_sys_t *p_sys, unsigned i_channels,
+                         ptrdiff_t i_shift )
+{
+    for( unsigned i = 0; i < i_channels; i++ )
+    {
+        float *p_plane = p_sys->p_planes + i * p_sys->i_stride;
+
+        if( i_shift > 0 )
+        {
+            memmove( p_plane + i_shift, p_plane,
+                     p_sys->i_avail * sizeof (float) );
+            memset( p_plane, 0, i_shift * sizeof (float) );
+        }
+        else
+            memmove( p_plane, p_plane - i_shift,
+                     (p_sys->i_avail + i_shift) * sizeof (float) );
+    }
+    p_sys->i_avail += i_shift;
+}
+
+static int ReservePlanes( filter_sys_t *p_sys, unsigned i_channels,
+                          size_t i_samples )
+{
+    if( i_samples <= p_sys->i_stride )
+        return VLC_SUCCESS;
+
+    /* Leave some room, so that slightly larger blocks fit next time */
+    size_t i_stride = i_samples + i_samples / 4;
+    float *p_planes = vlc_alloc( i_channels * i_stride, sizeof (float) );
+    if( unlikely(p_planes == NULL) )
+        return VLC_ENOMEM;
+
+    if( p_sys->i_avail > 0 )
+        for( unsigned i = 0; i < i_channels; i++ )
+            memcpy( p_planes + i * i_stride,
+                    p_sys->p_planes + i * p_sys->i_stride,
+                    p_sys->i_avail * sizeof (float) );
+    free( p_sys->p_planes );
+    p_sys->p_planes = p_planes;
+    p_sys->i_stride = i_stride;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Computes the table for the given input rate, and converts the current
+ * position and history accordingly.
+ */
+static int SetupTable( filter_t *p_filter, unsigned i_in_rate )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_out_rate = p_filter->fmt_out.audio.i_rate;
+    const unsigned i_channels = p_filter->fmt_in.audio.i_channels;
+
+    /* With one row per output phase, the coefficients of the nominal rate
+     * never need to be interpolated. Short tables are still refined so that
+     * interpolating them (for drift compensation) remains accurate. */
+    unsigned i_phases = i_out_rate / GCD( i_in_rate, i_out_rate );
+    const bool b_exact = i_phases <= MAX_PHASES;
+    if( b_exact )
+        i_phases *= (INTERP_PHASES + i_phases - 1) / i_phases;
+    else
+        i_phases = INTERP_PHASES;
+
+    /* When downsampling, the cut-off frequency is lowered and the filter
+     * stretched accordingly. */
+    double ratio = __MIN( 1., (double)i_out_rate / i_in_rate );
+    unsigned i_half = ceil( FILTER_ZEROS / ratio );
+    if( i_half > MAX_TAPS / 2 )
+        i_half = MAX_TAPS / 2;
+    unsigned i_taps = (2 * i_half + 7) & ~7u;
+
+    float *p_table = vlc_alloc( (i_phases + 1) * i_taps, sizeof (float) );
+    float *p_coefs = vlc_alloc( i_taps, sizeof (float) );
+    if( unlikely(p_table == NULL || p_coefs == NULL) )
+    {
+        free( p_table );
+        free( p_coefs );
+        return VLC_ENOMEM;
+    }
+
+    for( unsigned i = 0; i <= i_phases; i++ )
+        ComputeRow( p_table + i * i_taps, i_taps, i_half,
+                    (double)i / i_phases, ratio * FILTER_CUTOFF );
+
+    if( p_sys->p_table != NULL )
+    {
+        /* Keep the same interpolated position, with the new phases and
+         * filter length */
+        uint64_t i_phase = p_sys->i_pos >> 32;
+        uint64_t i_first = i_phase / p_sys->i_phases;
+        uint64_t i_sub = ((i_phase % p_sys->i_phases) << 32)
+                       | (p_sys->i_pos & UINT32_MAX);
+
+        i_sub = i_sub * i_phases / p_sys->i_phases;
+        i_first += p_sys->i_half;
+        if( i_first < i_half )
+        {
+            if( ReservePlanes( p_sys, i_channels,
+                               p_sys->i_avail + i_half - i_first ) )
+            {
+                free( p_table );
+                free( p_coefs );
+                return VLC_ENOMEM;
+            }
+            ShiftPlanes( p_sys, i_channels, i_half - i_first );
+            i_first = i_half;
+        }
+        i_first -= i_half;
+        p_sys->i_pos = ((i_first * i_phases) << 32) + i_sub;
     }
 
+    free( p_sys->p_table );
+    free( p_sys->p_coefs );
+    p_sys->p_table = p_table;
+    p_sys->p_coefs = p_coefs;
+    p_sys->i_phases = i_phases;
+    p_sys->i_taps = i_taps;
+    p_sys->i_half = i_half;
+    p_sys->i_table_rate = i_in_rate;
+
+    msg_Dbg( p_filter, "%u Hz -> %u Hz: %u phases of %u taps%s", i_in_rate,
+             i_out_rate, i_phases, i_taps,
+             b_exact ? "" : " (interpolated)" );
+    return VLC_SUCCESS;
+}
+
+static int Reset( filter_t *p_filter )
+{
     filter_sys_t *p_sys = p_filter->p_sys;
-    unsigned int i_out_rate = p_filter->fmt_out.audio.i_rate;
-    int i_nb_channels = p_filter->fmt_in.audio.i_channels;
+    const unsigned i_channels = p_filter->fmt_in.audio.i_channels;
 
-    /* Check if we really need to run the resampler */
-    if( i_out_rate == p_filter->fmt_in.audio.i_rate )
+    /* Start with silence, so that the first output sample is centered on the
+     * first input sample. */
+    p_sys->i_avail = 0;
+    p_sys->i_pos = 0;
+    if( ReservePlanes( p_sys, i_channels, p_sys->i_half - 1 ) )
+        return VLC_ENOMEM;
+    ShiftPlanes( p_sys, i_channels, p_sys->i_half - 1 );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Passthrough: the input rate went back to the output rate (drift
+ * compensation), output the samples still pending and the block as is
+ *****************************************************************************/
+static block_t *Passthrough( filter_t *p_filter, block_t *p_in_buf )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_channels = p_filter->fmt_in.audio.i_channels;
+    const uint64_t i_unit = (uint64_t)p_sys->i_phases << 32;
+    size_t i_pending = 0;
+
+    if( !(p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY) && !p_sys->b_first )
     {
-        if( !(p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY) &&
-            p_sys->i_old_wing )
+        /* First input sample no output sample was centered on yet */
+        const size_t i_first = (p_sys->i_pos + i_unit - 1) / i_unit
+                             + p_sys->i_half - 1;
+        if( i_first < p_sys->i_avail )
+            i_pending = p_sys->i_avail - i_first;
+
+        if( i_pending > 0 )
         {
-            /* output the whole thing with the samples from last time */
-            p_in_buf = block_Realloc( p_in_buf,
-                p_sys->i_old_wing * p_filter->fmt_in.audio.i_bytes_per_frame,
-                p_in_buf->i_buffer );
-            if( !p_in_buf )
+            const size_t i_bytes = i_pending * i_channels * sizeof (float);
+
+            p_in_buf = block_Realloc( p_in_buf, i_bytes, p_in_buf->i_buffer );
+            if( unlikely(p_in_buf == NULL) )
                 return NULL;
-            memcpy( p_in_buf->p_buffer, p_sys->p_buf +
-                    i_nb_channels * p_sys->i_old_wing,
-                    p_sys->i_old_wing *
-                    p_filter->fmt_in.audio.i_bytes_per_frame );
 
-            p_in_buf->i_nb_samples += p_sys->i_old_wing;
+            float *p_out = (float *)p_in_buf->p_buffer;
+            for( unsigned i = 0; i < i_channels; i++ )
+            {
+                const float *p_plane = p_sys->p_planes + i * p_sys->i_stride
+                                     + i_first;
 
-            p_in_buf->i_pts = date_Get( &p_sys->end_date );
-            p_in_buf->i_length =
-                date_Increment( &p_sys->end_date,
-                                p_in_buf->i_nb_samples ) - p_in_buf->i_pts;
+                for( size_t j = 0; j < i_pending; j++ )
+                    p_out[j * i_channels + i] = p_plane[j];
+            }
+            p_in_buf->i_nb_samples += i_pending;
         }
-        p_sys->i_old_wing = 0;
-        p_sys->b_first = true;
-        return p_in_buf;
+
+        p_in_buf->i_dts =
+        p_in_buf->i_pts = date_Get( &p_sys->end_date );
+        p_in_buf->i_length = date_Increment( &p_sys->end_date,
+                                 p_in_buf->i_nb_samples ) - p_in_buf->i_pts;
     }
 
-    unsigned i_bytes_per_frame = p_filter->fmt_out.audio.i_channels *
-                                 p_filter->fmt_out.audio.i_bitspersample / 8;
-    size_t i_out_size = i_bytes_per_frame * ( 1 + ( p_in_buf->i_nb_samples *
-              p_filter->fmt_out.audio.i_rate / p_filter->fmt_in.audio.i_rate) )
-            + p_filter->p_sys->i_buf_size;
-    block_t *p_out_buf = block_Alloc( i_out_size );
-    if( !p_out_buf )
+    /* Start over from silence if the rates differ again */
+    p_sys->b_first = true;
+    return p_in_buf;
+}
+
+/*****************************************************************************
+ * Resample: convert a buffer
+ *****************************************************************************/
+static block_t *Resample( filter_t * p_filter, block_t * p_in_buf )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned i_out_rate = p_filter->fmt_out.audio.i_rate;
+    const unsigned i_channels = p_filter->fmt_in.audio.i_channels;
+    bool b_discontinuity = false;
+
+    if( !p_in_buf->i_nb_samples )
     {
         block_Release( p_in_buf );
         return NULL;
     }
 
+    /* Check if we really need to run the resampler */
+    if( i_in_rate == i_out_rate )
+        return Passthrough( p_filter, p_in_buf );
+
+    /* Small rate variations (drift compensation) reuse the current table */
+    if( i_in_rate * 100 < p_sys->i_table_rate * (100 - RATE_TOLERANCE)
+     || i_in_rate * 100 > p_sys->i_table_rate * (100 + RATE_TOLERANCE) )
+    {
+        if( SetupTable( p_filter, i_in_rate ) )
+        {
+            block_Release( p_in_buf );
+            return NULL;
+        }
+    }
+
     if( (p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY) || p_sys->b_first )
     {
         /* Continuity in sound samples has been broken, we'd better reset
          * everything. */
-        p_out_buf->i_flags |= BLOCK_FLAG_DISCONTINUITY;
-        p_sys->i_remainder = 0;
+        b_discontinuity = true;
+        if( Reset( p_filter ) )
+        {
+            block_Release( p_in_buf );
+            return NULL;
+        }
         date_Init( &p_sys->end_date, i_out_rate, 1 );
         date_Set( &p_sys->end_date, p_in_buf->i_pts );
-        p_sys->d_old_factor = 1;
-        p_sys->i_old_wing   = 0;
         p_sys->b_first = false;
     }
 
-    size_t i_in_nb = p_in_buf->i_nb_samples;
-    size_t i_in, i_out = 0;
-    double d_factor, d_scale_factor, d_old_scale_factor;
-    size_t i_filter_wing;
-
-#if 0
-    msg_Err( p_filter, "old rate: %i, old factor: %f, old wing: %i, i_in: %i",
-             p_sys->i_old_rate, p_sys->d_old_factor,
-             p_sys->i_old_wing, i_in_nb );
-#endif
-
-    /* Same format in and out... */
-    assert( p_filter->fmt_in.audio.i_bytes_per_frame == i_bytes_per_frame );
-
-    /* Prepare the source buffer */
-    if( p_sys->i_old_wing )
-    {   /* Copy all our samples in p_in_buf */
-        /* Normally, there should be enough room for the old wing in the
-         * buffer head room. Otherwise, we need to copy memory anyway. */
-        p_in_buf = block_Realloc( p_in_buf,
-                                  p_sys->i_old_wing * 2 * i_bytes_per_frame,
-                                  p_in_buf->i_buffer );
-        if( unlikely(p_in_buf == NULL) )
-            return NULL;
-        memcpy( p_in_buf->p_buffer, p_sys->p_buf,
-                p_sys->i_old_wing * 2 * i_bytes_per_frame );
-    }
-    i_in_nb += (p_sys->i_old_wing * 2);
-    float *p_in = (float *)p_in_buf->p_buffer;
-    const float *p_in_orig = p_in;
-
-    /* Make sure the output buffer is reset */
-    memset( p_out_buf->p_buffer, 0, p_out_buf->i_buffer );
-
-    /* Calculate the new length of the filter wing */
-    d_factor = (double)i_out_rate / p_filter->fmt_in.audio.i_rate;
-    i_filter_wing = ((SMALL_FILTER_NMULT+1)/2.0) * __MAX(1.0,1.0/d_factor) + 1;
-
-    /* Account for increased filter gain when using factors less than 1 */
-    d_old_scale_factor = SMALL_FILTER_SCALE *
-        p_sys->d_old_factor + 0.5;
-    d_scale_factor = SMALL_FILTER_SCALE * d_factor + 0.5;
-
-    /* Apply the old rate until we have enough samples for the new one */
-    i_in = p_sys->i_old_wing;
-    p_in += p_sys->i_old_wing * i_nb_channels;
-
-    size_t i_old_in_end = 0;
-    if( p_sys->i_old_wing <= i_in_nb )
-        i_old_in_end = __MIN( i_filter_wing, i_in_nb - p_sys->i_old_wing );
-
-    ResampleFloat( p_filter,
-                   &p_out_buf, &i_out, &p_in,
-                   i_in, i_old_in_end,
-                   p_sys->d_old_factor, true,
-                   i_nb_channels, i_bytes_per_frame );
-    i_in = __MAX( i_in, i_old_in_end );
-
-    /* Apply the new rate for the rest of the samples */
-    if( i_in < i_in_nb - i_filter_wing )
+    /* Deinterleave the new samples after the history */
+    const size_t i_in_nb = p_in_buf->i_nb_samples;
+    if( ReservePlanes( p_sys, i_channels, p_sys->i_avail + i_in_nb ) )
     {
-        p_sys->d_old_factor = d_factor;
-        p_sys->i_old_wing   = i_filter_wing;
+        block_Release( p_in_buf );
+        return NULL;
     }
-    if( p_out_buf )
+
+    const float *p_in = (const float *)p_in_buf->p_buffer;
+    for( unsigned i = 0; i < i_channels; i++ )
     {
-        ResampleFloat( p_filter,
-                       &p_out_buf, &i_out, &p_in,
-                       i_in, i_in_nb - i_filter_wing,
-                       d_factor, false,
-                       i_nb_channels, i_bytes_per_frame );
-
-        /* Finalize aout buffer */
-        p_out_buf->i_nb_samples = i_out;
-        p_out_buf->i_dts =
-        p_out_buf->i_pts = date_Get( &p_sys->end_date );
-        p_out_buf->i_length = date_Increment( &p_sys->end_date,
-                                      p_out_buf->i_nb_samples ) - p_out_buf->i_pts;
-
-        p_out_buf->i_buffer = p_out_buf->i_nb_samples *
-            i_nb_channels * sizeof(int32_t);
+        float *p_plane = p_sys->p_planes + i * p_sys->i_stride
+                       + p_sys->i_avail;
+
+        for( size_t j = 0; j < i_in_nb; j++ )
+            p_plane[j] = p_in[j * i_channels + i];
     }
+    p_sys->i_avail += i_in_nb;
+    block_Release( p_in_buf );
+
+    const unsigned i_phases = p_sys->i_phases;
+    const unsigned i_taps = p_sys->i_taps;
+    const uint64_t i_step = ((uint64_t)i_in_rate * i_phases << 32)
+                          / i_out_rate;
+    if( p_sys->i_avail < i_taps )
+        return NULL;
+
+    /* Outputs are possible while the last tap is within the samples */
+    const uint64_t i_end = (uint64_t)(p_sys->i_avail + 1 - i_taps)
+                         * i_phases << 32;
+    if( p_sys->i_pos >= i_end )
+        return NULL;
 
-    /* Buffer i_filter_wing * 2 samples for next time */
-    if( p_sys->i_old_wing )
+    size_t i_out_nb = (i_end - 1 - p_sys->i_pos) / i_step + 1;
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter, i_out_nb *
+                                                i_channels * sizeof (float) );
+    if( unlikely(p_out_buf == NULL) )
+        return NULL;
+
+    float *p_out = (float *)p_out_buf->p_buffer;
+    uint64_t i_pos = p_sys->i_pos;
+
+    /* Split the position and the step, to avoid divisions per sample */
+    size_t i_first = (i_pos >> 32) / i_phases;
+    unsigned i_phase = (i_pos >> 32) % i_phases;
+    uint32_t i_frac = i_pos & UINT32_MAX;
+    const size_t i_step_first = (i_step >> 32) / i_phases;
+    const unsigned i_step_phase = (i_step >> 32) % i_phases;
+    const uint32_t i_step_frac = i_step & UINT32_MAX;
+
+    for( size_t j = 0; j < i_out_nb; j++ )
     {
-        size_t newsize = p_sys->i_old_wing * 2 * i_bytes_per_frame;
-        if( newsize > p_sys->i_buf_size )
+        const float *p_coefs = p_sys->p_table + i_phase * i_taps;
+
+        if( i_frac != 0 )
+        {   /* Between two rows of the table */
+            p_sys->pf_lerp( p_sys->p_coefs, p_coefs,
+                            i_frac * (1.f / 4294967296.f), i_taps );
+            p_coefs = p_sys->p_coefs;
+        }
+
+        for( unsigned i = 0; i < i_channels; i++ )
+            *(p_out++) = p_sys->pf_dot( p_sys->p_planes
+                                        + i * p_sys->i_stride + i_first,
+                                        p_coefs, i_taps );
+
+        i_frac += i_step_frac;
+        i_phase += i_step_phase + (i_frac < i_step_frac);
+        i_first += i_step_first;
+        if( i_phase >= i_phases )
         {
-            free( p_sys->p_buf );
-            p_sys->p_buf = malloc( newsize );
-            if( p_sys->p_buf != NULL )
-                p_sys->i_buf_size = newsize;
-            else
-            {
-                p_sys->i_buf_size = p_sys->i_old_wing = 0; /* oops! */
-                block_Release( p_in_buf );
-                return p_out_buf;
-            }
+            i_phase -= i_phases;
+            i_first++;
         }
-        memcpy( p_sys->p_buf,
-                p_in_orig + (i_in_nb - 2 * p_sys->i_old_wing) *
-                i_nb_channels, (2 * p_sys->i_old_wing) *
-                p_filter->fmt_in.audio.i_bytes_per_frame );
     }
+    i_pos = ((uint64_t)i_first * i_phases + i_phase) << 32 | i_frac;
 
-#if 0
-    msg_Err( p_filter, "p_out size: %i, nb bytes out: %i", p_out_buf->i_buffer,
-             i_out * p_filter->fmt_in.audio.i_bytes_per_frame );
-#endif
+    /* Only keep the samples that will still be needed */
+    size_t i_drop = __MIN( (i_pos >> 32) / i_phases, p_sys->i_avail );
+    ShiftPlanes( p_sys, i_channels, -(ptrdiff_t)i_drop );
+    p_sys->i_pos = i_pos - (((uint64_t)i_drop * i_phases) << 32);
 
-    block_Release( p_in_buf );
+    /* Finalize aout buffer */
+    if( b_discontinuity )
+        p_out_buf->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+    p_out_buf->i_nb_samples = i_out_nb;
+    p_out_buf->i_buffer = i_out_nb * i_channels * sizeof (float);
+    p_out_buf->i_dts =
+    p_out_buf->i_pts = date_Get( &p_sys->end_date );
+    p_out_buf->i_length = date_Increment( &p_sys->end_date,
+                                          i_out_nb ) - p_out_buf->i_pts;
     return p_out_buf;
 }
 
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    p_sys->b_first = true;
+}
+
 /*****************************************************************************
  * OpenFilter:
  *****************************************************************************/
@@ -297,16 +660,43 @@ static int OpenFilter( vlc_object_t *p_this )
     }
 
     /* Allocate the memory needed to store the module's structure */
-    p_filter->p_sys = p_sys = malloc( sizeof(struct filter_sys_t) );
+    p_filter->p_sys = p_sys = calloc( 1, sizeof(*p_sys) );
     if( p_sys == NULL )
         return VLC_ENOMEM;
 
-    p_sys->p_buf = NULL;
-    p_sys->i_buf_size = 0;
+    if( SetupTable( p_filter, p_filter->fmt_in.audio.i_rate ) )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    p_sys->pf_dot = Dot;
+    p_sys->pf_lerp = Lerp;
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+    {
+        p_sys->pf_dot = Dot_SSE2;
+        p_sys->pf_lerp = Lerp_SSE2;
+    }
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+    {
+        p_sys->pf_dot = Dot_AVX2;
+        p_sys->pf_lerp = Lerp_AVX2;
+    }
+#endif
+#ifdef BANDLIMITED_NEON
+    if( vlc_CPU_ARM_NEON() )
+    {
+        p_sys->pf_dot = Dot_NEON;
+        p_sys->pf_lerp = Lerp_NEON;
+    }
+#endif
 
-    p_sys->i_old_wing = 0;
     p_sys->b_first = true;
     p_filter->pf_audio_filter = Resample;
+    p_filter->pf_flush = Flush;
 
     msg_Dbg( p_this, "%4.4s/%iKHz/%i->%4.4s/%iKHz/%i",
              (char *)&p_filter->fmt_in.i_codec,
@@ -328,218 +718,10 @@ static int OpenFilter( vlc_object_t *p_this )
 static void CloseFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
-    free( p_filter->p_sys->p_buf );
-    free( p_filter->p_sys );
-}
-
-static void FilterFloatUP( const float Imp[], const float ImpD[], uint16_t Nwing, float *p_in,
-                            float *p_out, uint32_t ui_remainder,
-                            uint32_t ui_output_rate, int16_t Inc, int i_nb_channels )
-{
-    const float *Hp, *Hdp, *End;
-    float t, temp;
-    uint32_t ui_linear_remainder;
-    int i;
-
-    Hp = &Imp[(ui_remainder<<Nhc)/ui_output_rate];
-    Hdp = &ImpD[(ui_remainder<<Nhc)/ui_output_rate];
-
-    End = &Imp[Nwing];
-
-    ui_linear_remainder = (ui_remainder<<Nhc) -
-                            (ui_remainder<<Nhc)/ui_output_rate*ui_output_rate;
-
-    if (Inc == 1)               /* If doing right wing...              */
-    {                           /* ...drop extra coeff, so when Ph is  */
-        End--;                  /*    0.5, we don't do too many mult's */
-        if (ui_remainder == 0)  /* If the phase is zero...           */
-        {                       /* ...then we've already skipped the */
-            Hp += Npc;          /*    first sample, so we must also  */
-            Hdp += Npc;         /*    skip ahead in Imp[] and ImpD[] */
-        }
-    }
-
-    while (Hp < End) {
-        t = *Hp;                /* Get filter coeff */
-                                /* t is now interp'd filter coeff */
-        t += *Hdp * ui_linear_remainder / ui_output_rate / Npc;
-        for( i = 0; i < i_nb_channels; i++ )
-        {
-            temp = t;
-            temp *= *(p_in+i);  /* Mult coeff by input sample */
-            *(p_out+i) += temp; /* The filter output */
-        }
-        Hdp += Npc;             /* Filter coeff differences step */
-        Hp += Npc;              /* Filter coeff step */
-        p_in += (Inc * i_nb_channels); /* Input signal step */
-    }
-}
-
-static void FilterFloatUD( const float Imp[], const float ImpD[], uint16_t Nwing, float *p_in,
-                           float *p_out, uint32_t ui_remainder,
-                           uint32_t ui_output_rate, uint32_t ui_input_rate,
-                           int16_t Inc, int i_nb_channels )
-{
-    const float *Hp, *Hdp, *End;
-    float t, temp;
-    uint32_t ui_linear_remainder;
-    int i, ui_counter = 0;
-
-    Hp = Imp + (ui_remainder<<Nhc) / ui_input_rate;
-    Hdp = ImpD  + (ui_remainder<<Nhc) / ui_input_rate;
-
-    End = &Imp[Nwing];
-
-    if (Inc == 1)               /* If doing right wing...              */
-    {                           /* ...drop extra coeff, so when Ph is  */
-        End--;                  /*    0.5, we don't do too many mult's */
-        if (ui_remainder == 0)  /* If the phase is zero...           */
-        {                       /* ...then we've already skipped the */
-            Hp = Imp +          /* first sample, so we must also  */
-                  (ui_output_rate << Nhc) / ui_input_rate;
-            Hdp = ImpD +        /* skip ahead in Imp[] and ImpD[] */
-                  (ui_output_rate << Nhc) / ui_input_rate;
-            ui_counter++;
-        }
-    }
-
-    while (Hp < End) {
-        t = *Hp;                /* Get filter coeff */
-                                /* t is now interp'd filter coeff */
-        ui_linear_remainder =
-          ((ui_output_rate * ui_counter + ui_remainder)<< Nhc) -
-          ((ui_output_rate * ui_counter + ui_remainder)<< Nhc) /
-          ui_input_rate * ui_input_rate;
-        t += *Hdp * ui_linear_remainder / ui_input_rate / Npc;
-        for( i = 0; i < i_nb_channels; i++ )
-        {
-            temp = t;
-            temp *= *(p_in+i);  /* Mult coeff by input sample */
-            *(p_out+i) += temp; /* The filter output */
-        }
-
-        ui_counter++;
-
-        /* Filter coeff step */
-        Hp = Imp + ((ui_output_rate * ui_counter + ui_remainder)<< Nhc)
-                    / ui_input_rate;
-        /* Filter coeff differences step */
-        Hdp = ImpD + ((ui_output_rate * ui_counter + ui_remainder)<< Nhc)
-                     / ui_input_rate;
-
-        p_in += (Inc * i_nb_channels); /* Input signal step */
-    }
-}
-
-static int ReallocBuffer( block_t **pp_out_buf,
-                          float **pp_out, size_t i_out,
-                          int i_nb_channels, int i_bytes_per_frame )
-{
-    if( i_out < (*pp_out_buf)->i_buffer/i_bytes_per_frame )
-        return VLC_SUCCESS;
-
-    /* It may happen when the wing size changes */
-    const unsigned i_extra_frame = 256;
-    *pp_out_buf = block_Realloc( *pp_out_buf, 0,
-                                 (*pp_out_buf)->i_buffer +
-                                    i_extra_frame * i_bytes_per_frame );
-    if( !*pp_out_buf )
-        return VLC_EGENERIC;
-
-    *pp_out = (float*)(*pp_out_buf)->p_buffer + i_out * i_nb_channels;
-    memset( *pp_out, 0, i_extra_frame * i_bytes_per_frame );
-    return VLC_SUCCESS;
-}
-
-static void ResampleFloat( filter_t *p_filter,
-                           block_t **pp_out_buf,  size_t *pi_out,
-                           float **pp_in,
-                           int i_in, int i_in_end,
-                           double d_factor, bool b_factor_old,
-                           int i_nb_channels, int i_bytes_per_frame )
-{
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    float *p_in = *pp_in;
-    size_t i_out = *pi_out;
-    float *p_out = (float*)(*pp_out_buf)->p_buffer + i_out * i_nb_channels;
-
-    for( ; i_in < i_in_end; i_in++ )
-    {
-        if( b_factor_old && d_factor == 1 )
-        {
-            if( ReallocBuffer( pp_out_buf, &p_out,
-                               i_out, i_nb_channels, i_bytes_per_frame ) )
-                return;
-            /* Just copy the samples */
-            memcpy( p_out, p_in, i_bytes_per_frame );
-            p_in += i_nb_channels;
-            p_out += i_nb_channels;
-            i_out++;
-            continue;
-        }
-
-        while( p_sys->i_remainder < p_filter->fmt_out.audio.i_rate )
-        {
-            if( ReallocBuffer( pp_out_buf, &p_out,
-                               i_out, i_nb_channels, i_bytes_per_frame ) )
-                return;
-
-            if( d_factor >= 1 )
-            {
-                /* FilterFloatUP() is faster if we can use it */
-
-                /* Perform left-wing inner product */
-                FilterFloatUP( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in, p_out,
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate,
-                               -1, i_nb_channels );
-                /* Perform right-wing inner product */
-                FilterFloatUP( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in + i_nb_channels, p_out,
-                               p_filter->fmt_out.audio.i_rate -
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate,
-                               1, i_nb_channels );
-
-#if 0
-                /* Normalize for unity filter gain */
-                for( i = 0; i < i_nb_channels; i++ )
-                {
-                    *(p_out+i) *= d_old_scale_factor;
-                }
-#endif
-            }
-            else
-            {
-                /* Perform left-wing inner product */
-                FilterFloatUD( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in, p_out,
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate, p_filter->fmt_in.audio.i_rate,
-                               -1, i_nb_channels );
-                /* Perform right-wing inner product */
-                FilterFloatUD( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in + i_nb_channels, p_out,
-                               p_filter->fmt_out.audio.i_rate -
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate, p_filter->fmt_in.audio.i_rate,
-                               1, i_nb_channels );
-            }
-
-            p_out += i_nb_channels;
-            i_out++;
-
-            p_sys->i_remainder += p_filter->fmt_in.audio.i_rate;
-        }
-
-        p_in += i_nb_channels;
-        p_sys->i_remainder -= p_filter->fmt_out.audio.i_rate;
-    }
-
-    *pp_in  = p_in;
-    *pi_out = i_out;
+    free( p_sys->p_planes );
+    free( p_sys->p_coefs );
+    free( p_sys->p_table );
+    free( p_sys );
 }
-
-
@@ -246,7 +246,7 @@ SoXR_Resample( filter_t *p_filter, soxr_t soxr, block_t *p_in, size_t i_olen )
         p_out = p_in;
     }
     else
-        p_out = block_Alloc( i_olen * i_oframesize );
+        p_out = filter_NewAudioBuffer( p_filter, i_olen * i_oframesize );
 
     soxr_error_t error = soxr_process( soxr, p_in ? p_in->p_buffer : NULL,
                                        i_ilen, &i_idone, p_out->p_buffer,
@@ -31,12 +31,24 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_atomic.h>
+#include <vlc_cpu.h>
 #include <vlc_filter.h>
 #include <vlc_modules.h>
 
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
 
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define SCALETEMPO_NEON 1
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -128,7 +140,10 @@ typedef struct
     unsigned  frames_search;
     void     *buf_pre_corr;
     void     *table_window;
+    float    *buf_corr;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    void    (*correlate)( const float *pc, const float *ps, unsigned n,
+                          unsigned stride, unsigned count, float *corr );
 #ifdef PITCH_SHIFTER
     /* pitch */
     filter_t * resampler;
@@ -136,13 +151,173 @@ typedef struct
 #endif
 } filter_sys_t;
 
+/*****************************************************************************
+ * correlate: cross correlation of the overlap with each search position
+ *****************************************************************************
+ * corr[k] = sum( pc[i] * ps[k * stride + i] ) for i < n and k < count
+ *
+ * The vector versions correlate 4 positions at once, so that each vector of
+ * the windowed overlap is loaded once for 4 positions.
+ *****************************************************************************/
+static void correlate_float( const float *pc, const float *ps, unsigned n,
+                             unsigned stride, unsigned count, float *corr )
+{
+    for( unsigned k = 0; k < count; k++ ) {
+        const float *pk = ps + k * stride;
+        float sum = 0;
+        for( unsigned i = 0; i < n; i++ )
+            sum += pc[i] * pk[i];
+        corr[k] = sum;
+    }
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static inline float hsum_sse2( __m128 v )
+{
+    v = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+    v = _mm_add_ss( v, _mm_shuffle_ps( v, v, 1 ) );
+    return _mm_cvtss_f32( v );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void correlate_sse2( const float *pc, const float *ps, unsigned n,
+                            unsigned stride, unsigned count, float *corr )
+{
+    const unsigned n4 = n & ~3u;
+    unsigned k = 0;
+
+    for( ; k + 4 <= count; k += 4 ) {
+        const float *p0 = ps + k * stride, *p1 = p0 + stride;
+        const float *p2 = p1 + stride, *p3 = p2 + stride;
+        __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+        __m128 a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+        unsigned i = 0;
+
+        for( ; i < n4; i += 4 ) {
+            const __m128 c = _mm_load_ps( pc + i );
+            a0 = _mm_add_ps( a0, _mm_mul_ps( c, _mm_loadu_ps( p0 + i ) ) );
+            a1 = _mm_add_ps( a1, _mm_mul_ps( c, _mm_loadu_ps( p1 + i ) ) );
+            a2 = _mm_add_ps( a2, _mm_mul_ps( c, _mm_loadu_ps( p2 + i ) ) );
+            a3 = _mm_add_ps( a3, _mm_mul_ps( c, _mm_loadu_ps( p3 + i ) ) );
+        }
+        corr[k]     = hsum_sse2( a0 );
+        corr[k + 1] = hsum_sse2( a1 );
+        corr[k + 2] = hsum_sse2( a2 );
+        corr[k + 3] = hsum_sse2( a3 );
+        for( ; i < n; i++ ) {
+            corr[k]     += pc[i] * p0[i];
+            corr[k + 1] += pc[i] * p1[i];
+            corr[k + 2] += pc[i] * p2[i];
+            corr[k + 3] += pc[i] * p3[i];
+        }
+    }
+    correlate_float( pc, ps + k * stride, n, stride, count - k, corr + k );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static inline float hsum_avx2( __m256 v )
+{
+    __m128 h = _mm_add_ps( _mm256_castps256_ps128( v ),
+                           _mm256_extractf128_ps( v, 1 ) );
+    h = _mm_add_ps( h, _mm_movehl_ps( h, h ) );
+    h = _mm_add_ss( h, _mm_shuffle_ps( h, h, 1 ) );
+    return _mm_cvtss_f32( h );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void correlate_avx2( const float *pc, const float *ps, unsigned n,
+                            unsigned stride, unsigned count, float *corr )
+{
+    const unsigned n8 = n & ~7u;
+    unsigned k = 0;
+
+    /* Mono positions are too close for the wider loads */
+    if( stride < 2 ) {
+        correlate_sse2( pc, ps, n, stride, count, corr );
+        return;
+    }
+
+    for( ; k + 4 <= count; k += 4 ) {
+        const float *p0 = ps + k * stride, *p1 = p0 + stride;
+        const float *p2 = p1 + stride, *p3 = p2 + stride;
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+        unsigned i = 0;
+
+        for( ; i < n8; i += 8 ) {
+            const __m256 c = _mm256_load_ps( pc + i );
+            a0 = _mm256_add_ps( a0, _mm256_mul_ps( c, _mm256_loadu_ps( p0 + i ) ) );
+            a1 = _mm256_add_ps( a1, _mm256_mul_ps( c, _mm256_loadu_ps( p1 + i ) ) );
+            a2 = _mm256_add_ps( a2, _mm256_mul_ps( c, _mm256_loadu_ps( p2 + i ) ) );
+            a3 = _mm256_add_ps( a3, _mm256_mul_ps( c, _mm256_loadu_ps( p3 + i ) ) );
+        }
+        corr[k]     = hsum_avx2( a0 );
+        corr[k + 1] = hsum_avx2( a1 );
+        corr[k + 2] = hsum_avx2( a2 );
+        corr[k + 3] = hsum_avx2( a3 );
+        for( ; i < n; i++ ) {
+            corr[k]     += pc[i] * p0[i];
+            corr[k + 1] += pc[i] * p1[i];
+            corr[k + 2] += pc[i] * p2[i];
+            corr[k + 3] += pc[i] * p3[i];
+        }
+    }
+    correlate_float( pc, ps + k * stride, n, stride, count - k, corr + k );
+}
+#endif
+
+#ifdef SCALETEMPO_NEON
+static inline float hsum_neon( float32x4_t v )
+{
+    float32x2_t h = vadd_f32( vget_low_f32( v ), vget_high_f32( v ) );
+    return vget_lane_f32( vpadd_f32( h, h ), 0 );
+}
+
+static void correlate_neon( const float *pc, const float *ps, unsigned n,
+                            unsigned stride, unsigned count, float *corr )
+{
+    const unsigned n4 = n & ~3u;
+    unsigned k = 0;
+
+    for( ; k + 4 <= count; k += 4 ) {
+        const float *p0 = ps + k * stride, *p1 = p0 + stride;
+        const float *p2 = p1 + stride, *p3 = p2 + stride;
+        float32x4_t a0 = vdupq_n_f32( 0 ), a1 = vdupq_n_f32( 0 );
+        float32x4_t a2 = vdupq_n_f32( 0 ), a3 = vdupq_n_f32( 0 );
+        unsigned i = 0;
+
+        for( ; i < n4; i += 4 ) {
+            const float32x4_t c = vld1q_f32( pc + i );
+            a0 = vmlaq_f32( a0, c, vld1q_f32( p0 + i ) );
+            a1 = vmlaq_f32( a1, c, vld1q_f32( p1 + i ) );
+            a2 = vmlaq_f32( a2, c, vld1q_f32( p2 + i ) );
+            a3 = vmlaq_f32( a3, c, vld1q_f32( p3 + i ) );
+        }
+        corr[k]     = hsum_neon( a0 );
+        corr[k + 1] = hsum_neon( a1 );
+        corr[k + 2] = hsum_neon( a2 );
+        corr[k + 3] = hsum_neon( a3 );
+        for( ; i < n; i++ ) {
+            corr[k]     += pc[i] * p0[i];
+            corr[k + 1] += pc[i] * p1[i];
+            corr[k + 2] += pc[i] * p2[i];
+            corr[k + 3] += pc[i] * p3[i];
+        }
+    }
+    correlate_float( pc, ps + k * stride, n, stride, count - k, corr + k );
+}
+#endif
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
 static unsigned best_overlap_offset_float( filter_t *p_filter )
 {
     filter_sys_t *p = p_filter->p_sys;
-    float *pw, *po, *ppc, *search_start;
+    float *pw, *po, *ppc;
     float best_corr = INT_MIN;
     unsigned best_off = 0;
     unsigned i, off;
@@ -155,19 +330,18 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
       *ppc++ = *pw++ * *po++;
     }
 
-    search_start = (float *)p->buf_queue + p->samples_per_frame;
+    /* All the channels are interleaved: a single dot product per position
+     * covers every channel */
+    p->correlate( p->buf_pre_corr,
+                  (float *)p->buf_queue + p->samples_per_frame,
+                  p->samples_overlap - p->samples_per_frame,
+                  p->samples_per_frame, p->frames_search, p->buf_corr );
+
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
-      if( corr > best_corr ) {
-        best_corr = corr;
+      if( p->buf_corr[off] > best_corr ) {
+        best_corr = p->buf_corr[off];
         best_off  = off;
       }
-      search_start += p->samples_per_frame;
     }
 
     return best_off * p->bytes_per_frame;
@@ -313,9 +487,13 @@ static int reinit_buffers( filter_t *p_filter )
         p->samples_overlap  = frames_overlap * p->samples_per_frame;
         p->bytes_standing   = p->bytes_stride - p->bytes_overlap;
         p->samples_standing = p->bytes_standing / p->bytes_per_sample;
-        p->buf_overlap      = vlc_alloc( 1, p->bytes_overlap );
+        void *buf_overlap   = realloc( p->buf_overlap, p->bytes_overlap );
+        if( !buf_overlap )
+            return VLC_ENOMEM;
+        p->buf_overlap      = buf_overlap;
+        free( p->table_blend );
         p->table_blend      = vlc_alloc( 4, p->samples_overlap ); /* sizeof (int32|float) */
-        if( !p->buf_overlap || !p->table_blend )
+        if( !p->table_blend )
             return VLC_ENOMEM;
         if( p->bytes_overlap > prev_overlap )
             memset( (uint8_t *)p->buf_overlap + prev_overlap, 0, p->bytes_overlap - prev_overlap );
@@ -340,9 +518,14 @@ static int reinit_buffers( filter_t *p_filter )
     else
     {
         unsigned bytes_pre_corr = ( p->samples_overlap - p->samples_per_frame ) * 4; /* sizeof (int32|float) */
-        p->buf_pre_corr = malloc( bytes_pre_corr );
+        /* Aligned for the vector correlation */
+        aligned_free( p->buf_pre_corr );
+        free( p->table_window );
+        free( p->buf_corr );
+        p->buf_pre_corr = aligned_alloc( 32, ( bytes_pre_corr + 31 ) & ~31u );
         p->table_window = malloc( bytes_pre_corr );
-        if( ! p->buf_pre_corr || ! p->table_window )
+        p->buf_corr     = vlc_alloc( p->frames_search, sizeof (float) );
+        if( ! p->buf_pre_corr || ! p->table_window || ! p->buf_corr )
             return VLC_ENOMEM;
         float *pw = p->table_window;
         for( i = 1; i<frames_overlap; i++ )
@@ -352,6 +535,19 @@ static int reinit_buffers( filter_t *p_filter )
                 *pw++ = v;
         }
         p->best_overlap_offset = best_overlap_offset_float;
+        p->correlate = correlate_float;
+#ifdef HAVE_SSE2_INTRINSICS
+        if( vlc_CPU_SSE2() )
+            p->correlate = correlate_sse2;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+        if( vlc_CPU_AVX2() )
+            p->correlate = correlate_avx2;
+#endif
+#ifdef SCALETEMPO_NEON
+        if( vlc_CPU_ARM_NEON() )
+            p->correlate = correlate_neon;
+#endif
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -373,9 +569,10 @@ static int reinit_buffers( filter_t *p_filter )
         }
     }
     p->bytes_queue_max = new_size;
-    p->buf_queue = malloc( p->bytes_queue_max );
-    if( ! p->buf_queue )
+    uint8_t *buf_queue = realloc( p->buf_queue, p->bytes_queue_max );
+    if( ! buf_queue )
         return VLC_ENOMEM;
+    p->buf_queue = buf_queue;
 
     p->bytes_stride_scaled  = p->bytes_stride * p->scale;
     p->frames_stride_scaled = p->bytes_stride_scaled / p->bytes_per_frame;
@@ -430,6 +627,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->buf_corr       = NULL;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
@@ -524,8 +722,9 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->buf_queue );
     free( p_sys->buf_overlap );
     free( p_sys->table_blend );
-    free( p_sys->buf_pre_corr );
+    aligned_free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->buf_corr );
     free( p_sys );
 }
 
@@ -571,7 +770,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
                                    p_in_buf->i_buffer, 0 );
     if( i_outsize > 0 )
     {
-        p_out_buf = block_Alloc( i_outsize );
+        p_out_buf = filter_NewAudioBuffer( p_filter, i_outsize );
         if( p_out_buf == NULL )
         {
             block_Release( p_in_buf );
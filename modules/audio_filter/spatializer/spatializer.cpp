@@ -43,6 +43,7 @@ using std::nothrow;
 #include <vlc_filter.h>
 
 #include "revmodel.hpp"
+#include "../convolution/convolver.h"
 #define SPAT_AMP 0.3
 
 /*****************************************************************************
@@ -67,6 +68,10 @@ static void Close( vlc_object_t * );
 #define DAMP_TEXT N_("Damp")
 #define DAMP_LONGTEXT NULL
 
+#define IR_TEXT N_("Room impulse response")
+#define IR_LONGTEXT N_("WAV file containing an impulse response of a real " \
+                       "room, convolved instead of the synthetic reverberation." )
+
 vlc_module_begin ()
     set_description( N_("Audio Spatializer") )
     set_shortname( N_("Spatializer" ) )
@@ -86,6 +91,7 @@ vlc_module_begin ()
                             DRY_TEXT,DRY_LONGTEXT, false )
     add_float_with_range( "spatializer-damp",  0.5,   0.,  1.,
                             DAMP_TEXT,DAMP_LONGTEXT, false )
+    add_loadfile( "spatializer-ir", NULL, IR_TEXT, IR_LONGTEXT )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -98,6 +104,14 @@ struct filter_sys_t
 {
     vlc_mutex_t lock;
     revmodel *p_reverbm;
+
+    /* Measured room, if any */
+    convolver_t *p_conv;
+    float *p_ir;
+    unsigned i_ir_channels;
+    size_t i_ir_length;
+    float f_wet;
+    float f_dry;
 };
 
 } // namespace
@@ -134,6 +148,44 @@ enum { num_callbacks=sizeof(callbacks)/sizeof(callback_s) };
 
 static block_t *DoWork( filter_t *, block_t * );
 
+/*****************************************************************************
+ * OpenConvolver: use a measured room impulse response
+ *****************************************************************************/
+static void OpenConvolver( filter_t *p_filter, filter_sys_t *p_sys,
+                           vlc_object_t *p_aout )
+{
+    char *psz_path = var_InheritString( p_filter, "spatializer-ir" );
+    if( psz_path == NULL )
+        return;
+
+    p_sys->p_ir = convolver_LoadIR( VLC_OBJECT(p_filter), psz_path,
+                                    p_filter->fmt_in.audio.i_rate,
+                                    &p_sys->i_ir_channels,
+                                    &p_sys->i_ir_length );
+    free( psz_path );
+    if( p_sys->p_ir == NULL )
+        return;
+
+    unsigned i_channels = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    p_sys->f_wet = var_GetFloat( p_aout, "spatializer-wet" );
+    p_sys->f_dry = var_GetFloat( p_aout, "spatializer-dry" );
+    p_sys->p_conv = convolver_New( CONVOLVER_BLOCK, i_channels, i_channels,
+                                   p_sys->i_ir_length );
+    if( p_sys->p_conv != NULL
+     && convolver_SetResponses( p_sys->p_conv, p_sys->p_ir,
+                                p_sys->i_ir_channels, p_sys->i_ir_length,
+                                p_sys->f_wet, p_sys->f_dry ) == VLC_SUCCESS )
+        return;
+
+    msg_Warn( p_filter, "cannot use the room impulse response, "
+              "using the synthetic reverberation" );
+    if( p_sys->p_conv != NULL )
+        convolver_Delete( p_sys->p_conv );
+    p_sys->p_conv = NULL;
+    free( p_sys->p_ir );
+    p_sys->p_ir = NULL;
+}
+
 /*****************************************************************************
  * Open:
  *****************************************************************************/
@@ -172,6 +224,10 @@ static int Open( vlc_object_t *p_this )
     aout_FormatPrepare(&p_filter->fmt_in.audio);
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+
+    p_sys->p_conv = NULL;
+    p_sys->p_ir = NULL;
+    OpenConvolver( p_filter, p_sys, p_aout );
     return VLC_SUCCESS;
 }
 
@@ -191,6 +247,9 @@ static void Close( vlc_object_t *p_this )
                          callbacks[i].fp_callback, p_sys );
     }
 
+    if( p_sys->p_conv != NULL )
+        convolver_Delete( p_sys->p_conv );
+    free( p_sys->p_ir );
     delete p_sys->p_reverbm;
     vlc_mutex_destroy( &p_sys->lock );
     free( p_sys );
@@ -222,6 +281,17 @@ static void SpatFilter( filter_t *p_filter, float *out, float *in,
 
 static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
+    filter_sys_t *p_sys = reinterpret_cast<filter_sys_t *>( p_filter->p_sys );
+
+    if( p_sys->p_conv != NULL )
+    {
+        vlc_mutex_locker locker( &p_sys->lock );
+        float *p = reinterpret_cast<float *>( p_in_buf->p_buffer );
+
+        convolver_Process( p_sys->p_conv, p, p, p_in_buf->i_nb_samples );
+        return p_in_buf;
+    }
+
     SpatFilter( p_filter, (float*)p_in_buf->p_buffer,
                (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples,
                aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
@@ -262,6 +332,13 @@ static int WetCallback( vlc_object_t *p_this, char const *,
     vlc_mutex_locker locker( &p_sys->lock );
 
     p_sys->p_reverbm->setwet(newval.f_float);
+    if( p_sys->p_conv != NULL )
+    {
+        p_sys->f_wet = newval.f_float;
+        convolver_SetResponses( p_sys->p_conv, p_sys->p_ir,
+                                p_sys->i_ir_channels, p_sys->i_ir_length,
+                                p_sys->f_wet, p_sys->f_dry );
+    }
     msg_Dbg( p_this, "'wet' value is now %3.1f", newval.f_float );
     return VLC_SUCCESS;
 }
@@ -273,6 +350,13 @@ static int DryCallback( vlc_object_t *p_this, char const *,
     vlc_mutex_locker locker( &p_sys->lock );
 
     p_sys->p_reverbm->setdry(newval.f_float);
+    if( p_sys->p_conv != NULL )
+    {
+        p_sys->f_dry = newval.f_float;
+        convolver_SetResponses( p_sys->p_conv, p_sys->p_ir,
+                                p_sys->i_ir_channels, p_sys->i_ir_length,
+                                p_sys->f_wet, p_sys->f_dry );
+    }
     msg_Dbg( p_this, "'dry' value is now %3.1f", newval.f_float );
     return VLC_SUCCESS;
 }
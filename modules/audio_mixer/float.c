@@ -28,16 +28,33 @@
 # include "config.h"
 #endif
 
+#include <math.h>
 #include <stddef.h>
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include "../arm_neon/round_neon.h"
+# define VOLUME_NEON 1
+#endif
+
+/* Length of the transition when the gain changes, to avoid zipper noise */
+#define RAMP_FRAMES 512
 
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
-static int Create( vlc_object_t * );
+static int  Create ( vlc_object_t * );
+static void Destroy( vlc_object_t * );
 
 /*****************************************************************************
  * Module descriptor
@@ -47,37 +64,308 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_AUDIO_MISC )
     set_description( N_("Single precision audio volume") )
     set_capability( "audio volume", 10 )
-    set_callback( Create )
+    set_callbacks( Create, Destroy )
 vlc_module_end ()
 
+typedef struct
+{
+    float gain; /* last applied gain, or NAN */
+
+    /* Multiplies samples by a constant gain */
+    void (*scale)( float *, size_t, float );
+    /* Multiplies the i-th sample by (gain + i * step) */
+    void (*ramp)( float *, size_t, float, float );
+    /* Multiplies, clips and converts samples to 16-bits (may be in place) */
+    void (*to_s16)( int16_t *, const float *, size_t, float );
+} volume_sys_t;
+
+/*****************************************************************************
+ * Kernels
+ *****************************************************************************/
+static void Scale( float *p, size_t samples, float gain )
+{
+    for( size_t i = samples; i > 0; i-- )
+        *(p++) *= gain;
+}
+
+static void Ramp( float *p, size_t samples, float gain, float step )
+{
+    for( size_t i = 0; i < samples; i++ )
+        p[i] *= gain + i * step;
+}
+
+static void ToS16( int16_t *dst, const float *src, size_t samples,
+                   float gain )
+{
+    gain *= 32768.f;
+
+    for( size_t i = 0; i < samples; i++ )
+    {
+        float s = src[i] * gain;
+
+        if( s >= 32767.f )
+            dst[i] = INT16_MAX;
+        else
+        if( s <= -32768.f )
+            dst[i] = INT16_MIN;
+        else
+            dst[i] = lrintf( s );
+    }
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static void Scale_SSE2( float *p, size_t samples, float gain )
+{
+    const __m128 g = _mm_set1_ps( gain );
+    size_t i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        _mm_storeu_ps( &p[i], _mm_mul_ps( _mm_loadu_ps( &p[i] ), g ) );
+        _mm_storeu_ps( &p[i + 4], _mm_mul_ps( _mm_loadu_ps( &p[i + 4] ), g ) );
+    }
+    Scale( &p[i], samples - i, gain );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Ramp_SSE2( float *p, size_t samples, float gain, float step )
+{
+    const __m128 g = _mm_set1_ps( gain );
+    const __m128 s = _mm_set1_ps( step );
+    const __m128 four = _mm_set1_ps( 4.f );
+    __m128 k = _mm_setr_ps( 0.f, 1.f, 2.f, 3.f );
+    size_t i = 0;
+
+    /* The index is kept as float to avoid accumulating rounding errors */
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        __m128 v = _mm_add_ps( g, _mm_mul_ps( k, s ) );
+        _mm_storeu_ps( &p[i], _mm_mul_ps( _mm_loadu_ps( &p[i] ), v ) );
+        k = _mm_add_ps( k, four );
+    }
+    Ramp( &p[i], samples - i, gain + i * step, step );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void ToS16_SSE2( int16_t *dst, const float *src, size_t samples,
+                        float gain )
+{
+    const __m128 g = _mm_set1_ps( gain * 32768.f );
+    const __m128 max = _mm_set1_ps( 32767.f );
+    const __m128 min = _mm_set1_ps( -32768.f );
+    size_t i = 0;
+
+    /* In place: each iteration reads its input before writing its output */
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        __m128 lo = _mm_mul_ps( _mm_loadu_ps( &src[i] ), g );
+        __m128 hi = _mm_mul_ps( _mm_loadu_ps( &src[i + 4] ), g );
+        lo = _mm_max_ps( _mm_min_ps( lo, max ), min );
+        hi = _mm_max_ps( _mm_min_ps( hi, max ), min );
+        _mm_storeu_si128( (__m128i *)&dst[i],
+                          _mm_packs_epi32( _mm_cvtps_epi32( lo ),
+                                           _mm_cvtps_epi32( hi ) ) );
+    }
+    ToS16( &dst[i], &src[i], samples - i, gain );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static void Scale_AVX2( float *p, size_t samples, float gain )
+{
+    const __m256 g = _mm256_set1_ps( gain );
+    size_t i = 0;
+
+    for( ; i + 16 <= samples; i += 16 )
+    {
+        _mm256_storeu_ps( &p[i], _mm256_mul_ps( _mm256_loadu_ps( &p[i] ), g ) );
+        _mm256_storeu_ps( &p[i + 8],
+                          _mm256_mul_ps( _mm256_loadu_ps( &p[i + 8] ), g ) );
+    }
+    Scale( &p[i], samples - i, gain );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Ramp_AVX2( float *p, size_t samples, float gain, float step )
+{
+    const __m256 g = _mm256_set1_ps( gain );
+    const __m256 s = _mm256_set1_ps( step );
+    const __m256 eight = _mm256_set1_ps( 8.f );
+    __m256 k = _mm256_setr_ps( 0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f );
+    size_t i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        __m256 v = _mm256_add_ps( g, _mm256_mul_ps( k, s ) );
+        _mm256_storeu_ps( &p[i], _mm256_mul_ps( _mm256_loadu_ps( &p[i] ), v ) );
+        k = _mm256_add_ps( k, eight );
+    }
+    Ramp( &p[i], samples - i, gain + i * step, step );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void ToS16_AVX2( int16_t *dst, const float *src, size_t samples,
+                        float gain )
+{
+    const __m256 g = _mm256_set1_ps( gain * 32768.f );
+    const __m256 max = _mm256_set1_ps( 32767.f );
+    const __m256 min = _mm256_set1_ps( -32768.f );
+    size_t i = 0;
+
+    for( ; i + 16 <= samples; i += 16 )
+    {
+        __m256 lo = _mm256_mul_ps( _mm256_loadu_ps( &src[i] ), g );
+        __m256 hi = _mm256_mul_ps( _mm256_loadu_ps( &src[i + 8] ), g );
+        lo = _mm256_max_ps( _mm256_min_ps( lo, max ), min );
+        hi = _mm256_max_ps( _mm256_min_ps( hi, max ), min );
+        /* Packing is done per 128-bits lane: restore the order */
+        __m256i v = _mm256_packs_epi32( _mm256_cvtps_epi32( lo ),
+                                        _mm256_cvtps_epi32( hi ) );
+        _mm256_storeu_si256( (__m256i *)&dst[i],
+                             _mm256_permute4x64_epi64( v, 0xd8 ) );
+    }
+    ToS16( &dst[i], &src[i], samples - i, gain );
+}
+#endif
+
+#ifdef VOLUME_NEON
+static void Scale_NEON( float *p, size_t samples, float gain )
+{
+    size_t i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        vst1q_f32( &p[i], vmulq_n_f32( vld1q_f32( &p[i] ), gain ) );
+        vst1q_f32( &p[i + 4], vmulq_n_f32( vld1q_f32( &p[i + 4] ), gain ) );
+    }
+    Scale( &p[i], samples - i, gain );
+}
+
+static void Ramp_NEON( float *p, size_t samples, float gain, float step )
+{
+    static const float idx[4] = { 0.f, 1.f, 2.f, 3.f };
+    const float32x4_t g = vdupq_n_f32( gain );
+    float32x4_t k = vld1q_f32( idx );
+    size_t i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        float32x4_t v = vmlaq_n_f32( g, k, step );
+        vst1q_f32( &p[i], vmulq_f32( vld1q_f32( &p[i] ), v ) );
+        k = vaddq_f32( k, vdupq_n_f32( 4.f ) );
+    }
+    Ramp( &p[i], samples - i, gain + i * step, step );
+}
+
+static void ToS16_NEON( int16_t *dst, const float *src, size_t samples,
+                        float gain )
+{
+    const float g = gain * 32768.f;
+    const float32x4_t max = vdupq_n_f32( 32767.f );
+    const float32x4_t min = vdupq_n_f32( -32768.f );
+    size_t i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        float32x4_t lo = vmulq_n_f32( vld1q_f32( &src[i] ), g );
+        float32x4_t hi = vmulq_n_f32( vld1q_f32( &src[i + 4] ), g );
+        lo = vmaxq_f32( vminq_f32( lo, max ), min );
+        hi = vmaxq_f32( vminq_f32( hi, max ), min );
+        vst1q_s16( &dst[i], vcombine_s16( vqmovn_s32( RoundF32_NEON( lo ) ),
+                                          vqmovn_s32( RoundF32_NEON( hi ) ) ) );
+    }
+    ToS16( &dst[i], &src[i], samples - i, gain );
+}
+#endif
+
+/**
+ * Applies the transition from the previously applied gain, if it changed.
+ * \return the number of samples already amplified
+ */
+static size_t ApplyRamp( volume_sys_t *sys, block_t *p_buffer, float *p,
+                         size_t samples, float gain )
+{
+    const float from = sys->gain;
+
+    sys->gain = gain;
+    if( from == gain || isnan( from ) )
+        return 0;
+
+    /* Keep the transition time independent of the channels count */
+    size_t channels = 1;
+    if( p_buffer->i_nb_samples > 0 )
+        channels = __MAX( samples / p_buffer->i_nb_samples, 1 );
+
+    size_t length = __MIN( samples, RAMP_FRAMES * channels );
+    sys->ramp( p, length, from, (gain - from) / length );
+    return length;
+}
+
 /**
  * Mixes a new output buffer
  */
 static void FilterFL32( audio_volume_t *p_volume, block_t *p_buffer,
                         float f_multiplier )
 {
+    volume_sys_t *sys = p_volume->sys;
+    float *p = (float *)p_buffer->p_buffer;
+    size_t samples = p_buffer->i_buffer / sizeof(*p);
+    size_t done = ApplyRamp( sys, p_buffer, p, samples, f_multiplier );
+
     if( f_multiplier == 1.f )
         return; /* nothing to do */
 
+    sys->scale( p + done, samples - done, f_multiplier );
+}
+
+/**
+ * Mixes a new output buffer and converts it to 16-bits integers
+ */
+static void FilterFL32toS16( audio_volume_t *p_volume, block_t *p_buffer,
+                             float f_multiplier )
+{
+    volume_sys_t *sys = p_volume->sys;
     float *p = (float *)p_buffer->p_buffer;
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
-        *(p++) *= f_multiplier;
+    int16_t *dst = (int16_t *)p;
+    size_t samples = p_buffer->i_buffer / sizeof(*p);
+    size_t done = ApplyRamp( sys, p_buffer, p, samples, f_multiplier );
 
-    (void) p_volume;
+    sys->to_s16( dst, p, done, 1.f );
+    sys->to_s16( dst + done, p + done, samples - done, f_multiplier );
+    p_buffer->i_buffer = samples * sizeof(*dst);
 }
 
 static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
                         float f_multiplier )
 {
+    volume_sys_t *sys = p_volume->sys;
     double *p = (double *)p_buffer->p_buffer;
     double mult = f_multiplier;
+    size_t samples = p_buffer->i_buffer / sizeof(*p);
+    double from = sys->gain;
+
+    sys->gain = f_multiplier;
+    if( from != mult && !isnan( from ) )
+    {
+        size_t channels = 1;
+        if( p_buffer->i_nb_samples > 0 )
+            channels = __MAX( samples / p_buffer->i_nb_samples, 1 );
+
+        size_t length = __MIN( samples, RAMP_FRAMES * channels );
+        double step = (mult - from) / length;
+
+        for( size_t i = 0; i < length; i++ )
+            *(p++) *= from + i * step;
+        samples -= length;
+    }
+
     if( mult == 1. )
         return; /* nothing to do */
 
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
+    for( size_t i = samples; i > 0; i-- )
         *(p++) *= mult;
-
-    (void) p_volume;
 }
 
 /**
@@ -90,13 +378,61 @@ static int Create( vlc_object_t *p_this )
     switch (p_volume->format)
     {
         case VLC_CODEC_FL32:
-            p_volume->amplify = FilterFL32;
+            if( p_volume->output_format == VLC_CODEC_FL32 )
+                p_volume->amplify = FilterFL32;
+            else if( p_volume->output_format == VLC_CODEC_S16N )
+                p_volume->amplify = FilterFL32toS16;
+            else
+                return -1;
             break;
         case VLC_CODEC_FL64:
+            if( p_volume->output_format != VLC_CODEC_FL64 )
+                return -1;
             p_volume->amplify = FilterFL64;
             break;
         default:
             return -1;
     }
+
+    volume_sys_t *sys = malloc( sizeof (*sys) );
+    if( unlikely(sys == NULL) )
+        return -1;
+
+    sys->gain = NAN;
+    sys->scale = Scale;
+    sys->ramp = Ramp;
+    sys->to_s16 = ToS16;
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+    {
+        sys->scale = Scale_SSE2;
+        sys->ramp = Ramp_SSE2;
+        sys->to_s16 = ToS16_SSE2;
+    }
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+    {
+        sys->scale = Scale_AVX2;
+        sys->ramp = Ramp_AVX2;
+        sys->to_s16 = ToS16_AVX2;
+    }
+#endif
+#ifdef VOLUME_NEON
+    if( vlc_CPU_ARM_NEON() )
+    {
+        sys->scale = Scale_NEON;
+        sys->ramp = Ramp_NEON;
+        sys->to_s16 = ToS16_NEON;
+    }
+#endif
+    p_volume->sys = sys;
     return 0;
 }
+
+static void Destroy( vlc_object_t *p_this )
+{
+    audio_volume_t *p_volume = (audio_volume_t *)p_this;
+
+    free( p_volume->sys );
+}
@@ -107,6 +107,9 @@ static int Activate (vlc_object_t *obj)
 {
     audio_volume_t *vol = (audio_volume_t *)obj;
 
+    if (vol->output_format != vol->format)
+        return -1;
+
     switch (vol->format)
     {
         case VLC_CODEC_S32N:
@@ -37,8 +37,8 @@
 #include <vlc_aout.h>
 
 #include <jack/jack.h>
-#include <jack/ringbuffer.h>
 
+#include <stdatomic.h>
 #include <stdio.h>
 #include <unistd.h>                                      /* write(), close() */
 
@@ -52,16 +52,17 @@ typedef jack_default_audio_sample_t jack_sample_t;
  *****************************************************************************/
 typedef struct
 {
-    jack_ringbuffer_t *p_jack_ringbuffer;
+    vlc_aout_ring_t *p_ring;
     jack_client_t  *p_jack_client;
     jack_port_t   **p_jack_ports;
     jack_sample_t **p_jack_buffers;
     unsigned int    i_channels;
     unsigned int    i_rate;
-    jack_nframes_t latency;
+    atomic_uint latency; /**< Playback latency (frames) */
     float soft_gain;
     bool soft_mute;
-    vlc_tick_t paused; /**< Time when (last) paused */
+    atomic_bool paused;
+    vlc_tick_t pause_date; /**< Time when (last) paused */
 } aout_sys_t;
 
 /*****************************************************************************
@@ -123,8 +124,9 @@ static int Start( audio_output_t *p_aout, audio_sample_format_t *restrict fmt )
     if( aout_FormatNbChannels( fmt ) == 0 )
         return VLC_EGENERIC;
 
-    p_sys->latency = 0;
-    p_sys->paused = VLC_TICK_INVALID;
+    p_sys->p_ring = NULL;
+    atomic_init( &p_sys->latency, 0 );
+    atomic_init( &p_sys->paused, false );
 
     /* Connect to the JACK server */
     psz_name = var_InheritString( p_aout, "jack-name" );
@@ -179,21 +181,14 @@ static int Start( audio_output_t *p_aout, audio_sample_format_t *restrict fmt )
         goto error_out;
     }
 
-    const size_t buf_sz =
-        samples_from_vlc_tick(AOUT_MAX_ADVANCE_TIME, fmt->i_rate * fmt->i_bytes_per_frame);
-    p_sys->p_jack_ringbuffer = jack_ringbuffer_create( buf_sz );
-
-    if( p_sys->p_jack_ringbuffer == NULL )
+    p_sys->p_ring = vlc_aout_ring_New( fmt->i_bytes_per_frame, fmt->i_rate,
+                                       AOUT_MAX_ADVANCE_TIME );
+    if( p_sys->p_ring == NULL )
     {
         status = VLC_ENOMEM;
         goto error_out;
     }
 
-    if( jack_ringbuffer_mlock( p_sys->p_jack_ringbuffer ))
-    {
-        msg_Warn( p_aout, "failed to lock JACK ringbuffer in memory" );
-    }
-
     /* Create the output ports */
     for( i = 0; i < p_sys->i_channels; i++ )
     {
@@ -272,8 +267,8 @@ error_out:
             jack_deactivate( p_sys->p_jack_client );
             jack_client_close( p_sys->p_jack_client );
         }
-        if( p_sys->p_jack_ringbuffer )
-            jack_ringbuffer_free( p_sys->p_jack_ringbuffer );
+        if( p_sys->p_ring )
+            vlc_aout_ring_Delete( p_sys->p_ring );
 
         free( p_sys->p_jack_ports );
         free( p_sys->p_jack_buffers );
@@ -285,28 +280,13 @@ error_out:
 static void Play(audio_output_t * p_aout, block_t * p_block, vlc_tick_t date)
 {
     aout_sys_t *p_sys = p_aout->sys;
-    jack_ringbuffer_t *rb = p_sys->p_jack_ringbuffer;
-    const size_t bytes_per_frame = p_sys->i_channels * sizeof(jack_sample_t);
-
-    while (p_block->i_buffer > 0) {
-
-        /* move data to buffer */
-        const size_t write_space = jack_ringbuffer_write_space(rb);
-        const size_t bytes = p_block->i_buffer < write_space ?
-            p_block->i_buffer : write_space;
+    size_t frames = vlc_aout_ring_Write( p_sys->p_ring, p_block->p_buffer,
+                                         p_block->i_nb_samples );
 
-        /* If our audio thread is not reading fast enough */
-        if( unlikely( bytes == 0 ) ) {
-            msg_Warn( p_aout, "%"PRIuPTR " frames of audio dropped",
-                    p_block->i_buffer /  bytes_per_frame );
-            break;
-        }
-
-        jack_ringbuffer_write( rb, (const char *) p_block->p_buffer, bytes );
-
-        p_block->p_buffer += bytes;
-        p_block->i_buffer -= bytes;
-    }
+    /* If our audio thread is not reading fast enough */
+    if( unlikely( frames < p_block->i_nb_samples ) )
+        msg_Warn( p_aout, "%zu frames of audio dropped",
+                  p_block->i_nb_samples - frames );
 
     block_Release(p_block);
     (void) date;
@@ -320,33 +300,27 @@ static void Pause(audio_output_t *aout, bool paused, vlc_tick_t date)
     aout_sys_t *sys = aout->sys;
 
     if( paused ) {
-        sys->paused = date;
+        sys->pause_date = date;
     } else {
-        date -= sys->paused;
+        date -= sys->pause_date;
         msg_Dbg(aout, "resuming after %"PRId64" us", date);
-        sys->paused = VLC_TICK_INVALID;
     }
+    atomic_store_explicit( &sys->paused, paused, memory_order_relaxed );
 }
 
 static void Flush(audio_output_t *p_aout)
 {
     aout_sys_t * p_sys = p_aout->sys;
-    jack_ringbuffer_t *rb = p_sys->p_jack_ringbuffer;
 
-    /* reset ringbuffer read and write pointers */
-    jack_ringbuffer_reset(rb);
+    vlc_aout_ring_Flush( p_sys->p_ring );
 }
 
 static int TimeGet(audio_output_t *p_aout, vlc_tick_t *delay)
 {
     aout_sys_t * p_sys = p_aout->sys;
-    jack_ringbuffer_t *rb = p_sys->p_jack_ringbuffer;
-    const size_t bytes_per_frame = p_sys->i_channels * sizeof(jack_sample_t);
-
-    *delay = p_sys->latency +
-            vlc_tick_from_samples(jack_ringbuffer_read_space(rb) / bytes_per_frame,
-                                  p_sys->i_rate);
 
+    /* The process callback accounts for the JACK latency */
+    *delay = vlc_aout_ring_GetDelay( p_sys->p_ring, vlc_tick_now() );
     return 0;
 }
 
@@ -355,43 +329,59 @@ static int TimeGet(audio_output_t *p_aout, vlc_tick_t *delay)
  *****************************************************************************/
 int Process( jack_nframes_t i_frames, void *p_arg )
 {
-    unsigned int i, j, frames_from_rb = 0;
-    size_t bytes_read = 0;
-    size_t frames_read;
     audio_output_t *p_aout = (audio_output_t*) p_arg;
     aout_sys_t *p_sys = p_aout->sys;
-
-    /* Get the next audio data buffer unless paused */
-
-    if( p_sys->paused == VLC_TICK_INVALID )
-        frames_from_rb = i_frames;
+    const unsigned i_channels = p_sys->i_channels;
+    jack_nframes_t i_read = 0;
 
     /* Get the JACK buffers to write to */
-    for( i = 0; i < p_sys->i_channels; i++ )
+    for( unsigned i = 0; i < i_channels; i++ )
     {
         p_sys->p_jack_buffers[i] = jack_port_get_buffer( p_sys->p_jack_ports[i],
                                                          i_frames );
     }
 
-    /* Copy in the audio data */
-    for( j = 0; j < frames_from_rb; j++ )
+    /* When the first sample of this cycle will be heard */
+    vlc_tick_t date = vlc_tick_now()
+        + vlc_tick_from_samples( atomic_load_explicit( &p_sys->latency,
+                                                       memory_order_relaxed ),
+                                 p_sys->i_rate );
+
+    /* Copy in the audio data unless paused, at most in two parts if the
+     * ring buffer wraps around */
+    for( unsigned part = 0; part < 2; part++ )
     {
-        for( i = 0; i < p_sys->i_channels; i++ )
+        const void *p_src;
+        size_t i_count = vlc_aout_ring_Peek( p_sys->p_ring, &p_src );
+
+        if( atomic_load_explicit( &p_sys->paused, memory_order_relaxed ) )
+            i_count = 0;
+        if( i_count > i_frames - i_read )
+            i_count = i_frames - i_read;
+
+        for( unsigned i = 0; i < i_channels; i++ )
         {
-            jack_sample_t *p_dst = p_sys->p_jack_buffers[i] + j;
-            bytes_read += jack_ringbuffer_read( p_sys->p_jack_ringbuffer,
-                    (char *) p_dst, sizeof(jack_sample_t) );
+            const jack_sample_t *p_in = (const jack_sample_t *) p_src + i;
+            jack_sample_t *p_out = p_sys->p_jack_buffers[i] + i_read;
+
+            for( size_t j = 0; j < i_count; j++ )
+                p_out[j] = p_in[j * i_channels];
         }
+
+        vlc_aout_ring_Consume( p_sys->p_ring, i_count,
+                date + vlc_tick_from_samples( i_read, p_sys->i_rate ) );
+        i_read += i_count;
+        if( i_count == 0 || i_read == i_frames )
+            break;
     }
 
     /* Fill any remaining buffer with silence */
-    frames_read = (bytes_read / sizeof(jack_sample_t)) / p_sys->i_channels;
-    if( frames_read < i_frames )
+    if( i_read < i_frames )
     {
-        for( i = 0; i < p_sys->i_channels; i++ )
+        for( unsigned i = 0; i < i_channels; i++ )
         {
-            memset( p_sys->p_jack_buffers[i] + frames_read, 0,
-                    sizeof( jack_sample_t ) * (i_frames - frames_read) );
+            memset( p_sys->p_jack_buffers[i] + i_read, 0,
+                    sizeof( jack_sample_t ) * (i_frames - i_read) );
         }
     }
 
@@ -410,17 +400,18 @@ static int GraphChange( void *p_arg )
   unsigned int i;
   jack_latency_range_t port_latency;
 
-  p_sys->latency = 0;
+  jack_nframes_t latency = 0;
 
   for( i = 0; i < p_sys->i_channels; ++i )
   {
     jack_port_get_latency_range( p_sys->p_jack_ports[i], JackPlaybackLatency,
                                  &port_latency );
-    p_sys->latency = __MAX( p_sys->latency, port_latency.max );
+    latency = __MAX( latency, port_latency.max );
   }
+  atomic_store_explicit( &p_sys->latency, latency, memory_order_relaxed );
 
   msg_Dbg(p_aout, "JACK graph reordered. Our maximum latency=%d.",
-          p_sys->latency);
+          latency);
 
   return 0;
 }
@@ -446,7 +437,7 @@ static void Stop( audio_output_t *p_aout )
     }
     free( p_sys->p_jack_ports );
     free( p_sys->p_jack_buffers );
-    jack_ringbuffer_free( p_sys->p_jack_ringbuffer );
+    vlc_aout_ring_Delete( p_sys->p_ring );
 }
 
 static int Open(vlc_object_t *obj)
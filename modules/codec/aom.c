@@ -31,6 +31,7 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
+#include <vlc_cpu.h>
 
 #include <aom/aom_decoder.h>
 #include <aom/aomdx.h>
@@ -116,6 +117,7 @@ typedef struct
     aom_codec_ctx_t ctx;
     struct frame_priv_s frame_priv[AOM_MAX_FRAMES_DEPTH];
     unsigned i_next_frame_priv;
+    unsigned i_threads; /* taken from the process-wide budget */
 } decoder_sys_t;
 
 static const struct
@@ -338,8 +340,12 @@ static int OpenDecoder(vlc_object_t *p_this)
 
     sys->i_next_frame_priv = 0;
 
+    /* Share the CPUs with the other decoders and encoders */
+    sys->i_threads = vlc_CPU_AcquireThreads(dec,
+                                            __MIN(vlc_GetCPUCount(), 16));
+
     struct aom_codec_dec_cfg deccfg = {
-        .threads = __MIN(vlc_GetCPUCount(), 16),
+        .threads = sys->i_threads,
         .allow_lowbitdepth = 1
     };
 
@@ -348,6 +354,7 @@ static int OpenDecoder(vlc_object_t *p_this)
 
     if (aom_codec_dec_init(&sys->ctx, iface, &deccfg, 0) != AOM_CODEC_OK) {
         AOM_ERR(p_this, &sys->ctx, "Failed to initialize decoder");
+        vlc_CPU_ReleaseThreads(sys->i_threads);
         free(sys);
         return VLC_EGENERIC;;
     }
@@ -390,6 +397,7 @@ static void CloseDecoder(vlc_object_t *p_this)
 
     destroy_context(p_this, &sys->ctx);
 
+    vlc_CPU_ReleaseThreads(sys->i_threads);
     free(sys);
 }
 
@@ -401,6 +409,7 @@ static void CloseDecoder(vlc_object_t *p_this)
 typedef struct
 {
     struct aom_codec_ctx ctx;
+    unsigned i_threads; /* taken from the process-wide budget */
 } encoder_sys_t;
 
 /*****************************************************************************
@@ -427,7 +436,6 @@ static int OpenEncoder(vlc_object_t *p_this)
     aom_codec_enc_config_default(iface, &enccfg, 0);
     enccfg.g_timebase.num = p_enc->fmt_in.video.i_frame_rate_base;
     enccfg.g_timebase.den = p_enc->fmt_in.video.i_frame_rate;
-    enccfg.g_threads = __MIN(vlc_GetCPUCount(), 4);
     enccfg.g_w = p_enc->fmt_in.video.i_visible_width;
     enccfg.g_h = p_enc->fmt_in.video.i_visible_height;
     enccfg.g_lag_in_frames = 16; /* we have no pcr on sout */
@@ -480,10 +488,15 @@ static int OpenEncoder(vlc_object_t *p_this)
     msg_Dbg(p_this, "AV1: using libaom version %s (build options %s)",
         aom_codec_version_str(), aom_codec_build_config());
 
+    p_sys->i_threads = vlc_CPU_AcquireThreads(p_enc,
+                                              __MIN(vlc_GetCPUCount(), 4));
+    enccfg.g_threads = p_sys->i_threads;
+
     struct aom_codec_ctx *ctx = &p_sys->ctx;
     if (aom_codec_enc_init(ctx, iface, &enccfg, enc_flags) != AOM_CODEC_OK)
     {
         AOM_ERR(p_this, ctx, "Failed to initialize encoder");
+        vlc_CPU_ReleaseThreads(p_sys->i_threads);
         free(p_sys);
         return VLC_EGENERIC;
     }
@@ -493,6 +506,7 @@ static int OpenEncoder(vlc_object_t *p_this)
     {
         AOM_ERR(p_this, ctx, "Failed to set tile rows");
         destroy_context(p_this, ctx);
+        vlc_CPU_ReleaseThreads(p_sys->i_threads);
         free(p_sys);
         return VLC_EGENERIC;
     }
@@ -502,6 +516,7 @@ static int OpenEncoder(vlc_object_t *p_this)
     {
         AOM_ERR(p_this, ctx, "Failed to set tile columns");
         destroy_context(p_this, ctx);
+        vlc_CPU_ReleaseThreads(p_sys->i_threads);
         free(p_sys);
         return VLC_EGENERIC;
     }
@@ -512,6 +527,7 @@ static int OpenEncoder(vlc_object_t *p_this)
     {
         AOM_ERR(p_this, ctx, "Failed to set row-multithreading");
         destroy_context(p_this, ctx);
+        vlc_CPU_ReleaseThreads(p_sys->i_threads);
         free(p_sys);
         return VLC_EGENERIC;
     }
@@ -593,6 +609,7 @@ static void CloseEncoder(vlc_object_t *p_this)
     encoder_t *p_enc = (encoder_t *)p_this;
     encoder_sys_t *p_sys = p_enc->p_sys;
     destroy_context(p_this, &p_sys->ctx);
+    vlc_CPU_ReleaseThreads(p_sys->i_threads);
     free(p_sys);
 }
 
@@ -34,6 +34,18 @@
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
 #include <vlc_aout.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define ARAW_NEON 1
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -95,6 +107,9 @@ static void F64NDecode( void *, const uint8_t *, unsigned );
 static void F64IDecode( void *, const uint8_t *, unsigned );
 static void DAT12Decode( void *, const uint8_t *, unsigned );
 
+typedef void (*decode_func_t)( void *, const uint8_t *, unsigned );
+static decode_func_t FindVectorDecode( decode_func_t );
+
 /*****************************************************************************
  * DecoderOpen: probe the decoder and return score
  *****************************************************************************/
@@ -283,7 +298,7 @@ static int DecoderOpen( vlc_object_t *p_this )
     }
     aout_FormatPrepare( &p_dec->fmt_out.audio );
 
-    p_sys->decode = decode;
+    p_sys->decode = decode != NULL ? FindVectorDecode( decode ) : NULL;
     p_sys->framebits = bits * p_dec->fmt_out.audio.i_channels;
     assert( p_sys->framebits );
 
@@ -629,6 +644,314 @@ static void DAT12Decode( void *outp, const uint8_t *in, unsigned samples )
         *(out++) = dat12tos16(U16_AT(in) >> 4);
 }
 
+/*** SIMD decoders ***/
+/* The vector kernels compute the same samples as the scalar ones above,
+ * which convert the leftover samples. */
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i Swap16_SSE2( __m128i v )
+{
+    return _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i Swap32_SSE2( __m128i v )
+{
+    v = _mm_or_si128( _mm_slli_epi32( v, 16 ), _mm_srli_epi32( v, 16 ) );
+    return Swap16_SSE2( v );
+}
+
+/* Zeroes infinities and NaNs, as the scalar isfinite() checks */
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i Finite_SSE2( __m128i v )
+{
+    const __m128i exp = _mm_set1_epi32( 0x7F800000 );
+
+    return _mm_andnot_si128( _mm_cmpeq_epi32( _mm_and_si128( v, exp ), exp ),
+                             v );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S16IDecode_SSE2( void *outp, const uint8_t *in, unsigned samples )
+{
+    int16_t *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+        _mm_storeu_si128( (__m128i *)&out[i], Swap16_SSE2(
+            _mm_loadu_si128( (const __m128i *)&in[2 * i] ) ) );
+    S16IDecode( &out[i], &in[2 * i], samples - i );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S32IDecode_SSE2( void *outp, const uint8_t *in, unsigned samples )
+{
+    int32_t *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+        _mm_storeu_si128( (__m128i *)&out[i], Swap32_SSE2(
+            _mm_loadu_si128( (const __m128i *)&in[4 * i] ) ) );
+    S32IDecode( &out[i], &in[4 * i], samples - i );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void F32NDecode_SSE2( void *outp, const uint8_t *in, unsigned samples )
+{
+    float *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+        _mm_storeu_si128( (__m128i *)&out[i], Finite_SSE2(
+            _mm_loadu_si128( (const __m128i *)&in[4 * i] ) ) );
+    F32NDecode( &out[i], &in[4 * i], samples - i );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void F32IDecode_SSE2( void *outp, const uint8_t *in, unsigned samples )
+{
+    float *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+        _mm_storeu_si128( (__m128i *)&out[i], Finite_SSE2( Swap32_SSE2(
+            _mm_loadu_si128( (const __m128i *)&in[4 * i] ) ) ) );
+    F32IDecode( &out[i], &in[4 * i], samples - i );
+}
+
+static const decode_func_t decode_sse2[][2] = {
+    { S16IDecode, S16IDecode_SSE2 },
+    { S32IDecode, S32IDecode_SSE2 },
+    { F32NDecode, F32NDecode_SSE2 },
+    { F32IDecode, F32IDecode_SSE2 },
+};
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static void Shuffle_AVX2( void *outp, const uint8_t *in, size_t bytes,
+                          __m256i shuf )
+{
+    uint8_t *out = outp;
+
+    for( size_t i = 0; i < bytes; i += 32 )
+        _mm256_storeu_si256( (__m256i *)&out[i], _mm256_shuffle_epi8(
+            _mm256_loadu_si256( (const __m256i *)&in[i] ), shuf ) );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S16IDecode_AVX2( void *outp, const uint8_t *in, unsigned samples )
+{
+    const __m256i shuf = _mm256_setr_epi8(
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 );
+    unsigned i = samples & ~15u;
+
+    Shuffle_AVX2( outp, in, 2 * i, shuf );
+    S16IDecode( (int16_t *)outp + i, &in[2 * i], samples - i );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S32IDecode_AVX2( void *outp, const uint8_t *in, unsigned samples )
+{
+    const __m256i shuf = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+    unsigned i = samples & ~7u;
+
+    Shuffle_AVX2( outp, in, 4 * i, shuf );
+    S32IDecode( (int32_t *)outp + i, &in[4 * i], samples - i );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void F32IDecode_AVX2( void *outp, const uint8_t *in, unsigned samples )
+{
+    float *out = outp;
+    const __m256i shuf = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+    const __m256i exp = _mm256_set1_epi32( 0x7F800000 );
+    unsigned i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        __m256i v = _mm256_shuffle_epi8(
+            _mm256_loadu_si256( (const __m256i *)&in[4 * i] ), shuf );
+        v = _mm256_andnot_si256(
+            _mm256_cmpeq_epi32( _mm256_and_si256( v, exp ), exp ), v );
+        _mm256_storeu_si256( (__m256i *)&out[i], v );
+    }
+    F32IDecode( &out[i], &in[4 * i], samples - i );
+}
+
+/* 4 samples of 3 bytes per lane, to the upper bytes of 32-bit words */
+__attribute__ ((__target__ ("avx2")))
+static unsigned Unpack24_AVX2( uint32_t *out, const uint8_t *in,
+                               unsigned samples, __m256i shuf )
+{
+    unsigned i = 0;
+
+    /* Each lane loads 16 bytes and uses 12: stay off the end of the input */
+    for( ; i + 10 <= samples; i += 8 )
+    {
+        __m128i lo = _mm_loadu_si128( (const __m128i *)&in[3 * i] );
+        __m128i hi = _mm_loadu_si128( (const __m128i *)&in[3 * i + 12] );
+        __m256i v = _mm256_inserti128_si256( _mm256_castsi128_si256( lo ),
+                                             hi, 1 );
+        _mm256_storeu_si256( (__m256i *)&out[i],
+                             _mm256_shuffle_epi8( v, shuf ) );
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S24LDecode_AVX2( void *outp, const uint8_t *in, unsigned samples )
+{
+    uint32_t *out = outp;
+    const __m256i shuf = _mm256_setr_epi8(
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11 );
+    unsigned i = Unpack24_AVX2( out, in, samples, shuf );
+
+    S24LDecode( &out[i], &in[3 * i], samples - i );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S24BDecode_AVX2( void *outp, const uint8_t *in, unsigned samples )
+{
+    uint32_t *out = outp;
+    const __m256i shuf = _mm256_setr_epi8(
+        -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9,
+        -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9 );
+    unsigned i = Unpack24_AVX2( out, in, samples, shuf );
+
+    S24BDecode( &out[i], &in[3 * i], samples - i );
+}
+
+static const decode_func_t decode_avx2[][2] = {
+    { S16IDecode, S16IDecode_AVX2 },
+    { S32IDecode, S32IDecode_AVX2 },
+    { F32IDecode, F32IDecode_AVX2 },
+    { S24LDecode, S24LDecode_AVX2 },
+    { S24BDecode, S24BDecode_AVX2 },
+};
+#endif
+
+#ifdef ARAW_NEON
+static inline uint32x4_t Finite_NEON( uint32x4_t v )
+{
+    const uint32x4_t exp = vdupq_n_u32( 0x7F800000 );
+
+    return vbicq_u32( v, vceqq_u32( vandq_u32( v, exp ), exp ) );
+}
+
+static void S16IDecode_NEON( void *outp, const uint8_t *in, unsigned samples )
+{
+    uint8_t *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+        vst1q_u8( &out[2 * i], vrev16q_u8( vld1q_u8( &in[2 * i] ) ) );
+    S16IDecode( &out[2 * i], &in[2 * i], samples - i );
+}
+
+static void S32IDecode_NEON( void *outp, const uint8_t *in, unsigned samples )
+{
+    uint8_t *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+        vst1q_u8( &out[4 * i], vrev32q_u8( vld1q_u8( &in[4 * i] ) ) );
+    S32IDecode( &out[4 * i], &in[4 * i], samples - i );
+}
+
+static void F32NDecode_NEON( void *outp, const uint8_t *in, unsigned samples )
+{
+    uint32_t *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+        vst1q_u32( &out[i], Finite_NEON(
+            vreinterpretq_u32_u8( vld1q_u8( &in[4 * i] ) ) ) );
+    F32NDecode( &out[i], &in[4 * i], samples - i );
+}
+
+static void F32IDecode_NEON( void *outp, const uint8_t *in, unsigned samples )
+{
+    uint32_t *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+        vst1q_u32( &out[i], Finite_NEON(
+            vreinterpretq_u32_u8( vrev32q_u8( vld1q_u8( &in[4 * i] ) ) ) ) );
+    F32IDecode( &out[i], &in[4 * i], samples - i );
+}
+
+# ifndef WORDS_BIGENDIAN
+static void S24LDecode_NEON( void *outp, const uint8_t *in, unsigned samples )
+{
+    uint8_t *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 16 <= samples; i += 16 )
+    {
+        uint8x16x3_t v = vld3q_u8( &in[3 * i] );
+        uint8x16x4_t w = { { vdupq_n_u8( 0 ), v.val[0], v.val[1], v.val[2] } };
+        vst4q_u8( &out[4 * i], w );
+    }
+    S24LDecode( &out[4 * i], &in[3 * i], samples - i );
+}
+
+static void S24BDecode_NEON( void *outp, const uint8_t *in, unsigned samples )
+{
+    uint8_t *out = outp;
+    unsigned i = 0;
+
+    for( ; i + 16 <= samples; i += 16 )
+    {
+        uint8x16x3_t v = vld3q_u8( &in[3 * i] );
+        uint8x16x4_t w = { { vdupq_n_u8( 0 ), v.val[2], v.val[1], v.val[0] } };
+        vst4q_u8( &out[4 * i], w );
+    }
+    S24BDecode( &out[4 * i], &in[3 * i], samples - i );
+}
+# endif
+
+static const decode_func_t decode_neon[][2] = {
+    { S16IDecode, S16IDecode_NEON },
+    { S32IDecode, S32IDecode_NEON },
+    { F32NDecode, F32NDecode_NEON },
+    { F32IDecode, F32IDecode_NEON },
+# ifndef WORDS_BIGENDIAN
+    { S24LDecode, S24LDecode_NEON },
+    { S24BDecode, S24BDecode_NEON },
+# endif
+};
+#endif
+
+#define LOOKUP_DECODE(table, decode) \
+    for( size_t i = 0; i < ARRAY_SIZE(table); i++ ) \
+        if( table[i][0] == decode ) \
+            return table[i][1]
+
+static decode_func_t FindVectorDecode( decode_func_t decode )
+{
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        LOOKUP_DECODE( decode_avx2, decode );
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+        LOOKUP_DECODE( decode_sse2, decode );
+#endif
+#ifdef ARAW_NEON
+    if( vlc_CPU_ARM_NEON() )
+        LOOKUP_DECODE( decode_neon, decode );
+#endif
+    return decode;
+}
+
 /*****************************************************************************
  * DecoderClose: decoder destruction
  *****************************************************************************/
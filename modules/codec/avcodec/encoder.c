@@ -142,6 +142,9 @@ typedef struct
     float      f_lumi_masking, f_dark_masking, f_p_masking, f_border_masking;
     int        i_aac_profile; /* AAC profile to use.*/
 
+    /* Threads taken from the process-wide budget */
+    unsigned   i_cpu_threads;
+
     AVFrame    *frame;
 } encoder_sys_t;
 
@@ -864,6 +867,13 @@ int InitVideoEnc( vlc_object_t *p_this )
 
     if( p_enc->i_threads >= 1)
         p_context->thread_count = p_enc->i_threads;
+    else if( p_enc->fmt_in.i_cat == VIDEO_ES )
+    {
+        /* Share the CPUs with the other decoders and encoders */
+        p_sys->i_cpu_threads = vlc_CPU_AcquireThreads( p_enc,
+                                                       vlc_GetCPUCount() );
+        p_context->thread_count = p_sys->i_cpu_threads;
+    }
     else
         p_context->thread_count = vlc_GetCPUCount();
 
@@ -1052,6 +1062,8 @@ errmsg:
 
     return VLC_SUCCESS;
 error:
+    if( p_sys->i_cpu_threads > 0 )
+        vlc_CPU_ReleaseThreads( p_sys->i_cpu_threads );
     free( p_enc->fmt_out.p_extra );
     av_free( p_sys->p_buffer );
     av_free( p_sys->p_interleave_buf );
@@ -1174,6 +1186,14 @@ static block_t *encode_avframe( encoder_t *p_enc, encoder_sys_t *p_sys, AVFrame
     return p_block;
 }
 
+static void ReleasePicture( void *opaque, uint8_t *data )
+{
+    VLC_UNUSED(data);
+    picture_t *p_pict = opaque;
+
+    picture_Release( p_pict );
+}
+
 /****************************************************************************
  * EncodeVideo: the whole thing
  ****************************************************************************/
@@ -1193,6 +1213,25 @@ static block_t *EncodeVideo( encoder_t *p_enc, picture_t *p_pict )
             p_sys->frame->linesize[i_plane] = p_pict->p[i_plane].i_pitch;
         }
 
+        /* Hand the picture over by reference: libavcodec would otherwise copy
+         * every frame it keeps for its lookahead and reordering */
+        for( i_plane = 0; i_plane < p_pict->i_planes; i_plane++ )
+        {
+            const plane_t *p = &p_pict->p[i_plane];
+
+            frame->buf[i_plane] = av_buffer_create( p->p_pixels,
+                                                    p->i_pitch * p->i_lines,
+                                                    ReleasePicture, p_pict, 0 );
+            if( unlikely(frame->buf[i_plane] == NULL) )
+            {
+                /* Fall back to the copy */
+                while( i_plane > 0 )
+                    av_buffer_unref( &frame->buf[--i_plane] );
+                break;
+            }
+            picture_Hold( p_pict );
+        }
+
         /* Let libavcodec select the frame type */
         frame->pict_type = 0;
 
@@ -1478,5 +1517,7 @@ void EndVideoEnc( vlc_object_t *p_this )
     av_free( p_sys->p_interleave_buf );
     av_free( p_sys->p_buffer );
 
+    if( p_sys->i_cpu_threads > 0 )
+        vlc_CPU_ReleaseThreads( p_sys->i_cpu_threads );
     free( p_sys );
 }
@@ -107,6 +107,9 @@ typedef struct
     int profile;
     int level;
 
+    /* Threads taken from the process-wide budget */
+    unsigned i_cpu_threads;
+
     /* Protect dec->fmt_out, decoder_Update*() and decoder_NewPicture()
      * functions */
     vlc_mutex_t lock;
@@ -473,10 +476,7 @@ static int OpenVideoCodec( decoder_t *p_dec )
     }
 
     if( var_InheritBool(p_dec, "low-delay") )
-    {
         ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
-        ctx->active_thread_type = FF_THREAD_SLICE;
-    }
 
     ret = ffmpeg_OpenCodec( p_dec, ctx, codec );
     if( ret < 0 )
@@ -603,25 +603,6 @@ int InitVideoDec( vlc_object_t *obj )
     p_context->opaque = p_dec;
     p_context->reordered_opaque = 0;
 
-    int i_thread_count = var_InheritInteger( p_dec, "avcodec-threads" );
-    if( i_thread_count <= 0 )
-    {
-        i_thread_count = vlc_GetCPUCount();
-        if( i_thread_count > 1 )
-            i_thread_count++;
-
-        //FIXME: take in count the decoding time
-#if VLC_WINSTORE_APP
-        i_thread_count = __MIN( i_thread_count, 6 );
-#else
-        i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 10 : 6 );
-#endif
-    }
-    i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 32 : 16 );
-    msg_Dbg( p_dec, "allowing %d thread(s) for decoding", i_thread_count );
-    p_context->thread_count = i_thread_count;
-    p_context->thread_safe_callbacks = true;
-
     switch( p_codec->id )
     {
         case AV_CODEC_ID_MPEG4:
@@ -642,6 +623,36 @@ int InitVideoDec( vlc_object_t *obj )
             break;
     }
 
+    /* Each frame thread delays the output by one picture */
+    if( var_InheritBool( p_dec, "low-delay" ) )
+        p_context->thread_type &= ~FF_THREAD_FRAME;
+
+    int i_thread_count = var_InheritInteger( p_dec, "avcodec-threads" );
+    p_sys->i_cpu_threads = 0;
+    if( p_context->thread_type == 0 )
+        i_thread_count = 1;
+    else if( i_thread_count <= 0 )
+    {
+        i_thread_count = vlc_GetCPUCount();
+        /* One more frame thread, to keep the CPUs busy */
+        if( i_thread_count > 1 && (p_context->thread_type & FF_THREAD_FRAME) )
+            i_thread_count++;
+
+        //FIXME: take in count the decoding time
+#if VLC_WINSTORE_APP
+        i_thread_count = __MIN( i_thread_count, 6 );
+#else
+        i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 10 : 6 );
+#endif
+        /* Share the CPUs with the other decoders and encoders */
+        p_sys->i_cpu_threads = vlc_CPU_AcquireThreads( p_dec, i_thread_count );
+        i_thread_count = p_sys->i_cpu_threads;
+    }
+    i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 32 : 16 );
+    msg_Dbg( p_dec, "allowing %d thread(s) for decoding", i_thread_count );
+    p_context->thread_count = i_thread_count;
+    p_context->thread_safe_callbacks = true;
+
     if( p_context->thread_type & FF_THREAD_FRAME )
         p_dec->i_extra_picture_buffers = 2 * p_context->thread_count;
 
@@ -677,6 +688,8 @@ int InitVideoDec( vlc_object_t *obj )
     /* ***** Open the codec ***** */
     if( OpenVideoCodec( p_dec ) < 0 )
     {
+        if( p_sys->i_cpu_threads > 0 )
+            vlc_CPU_ReleaseThreads( p_sys->i_cpu_threads );
         vlc_mutex_destroy( &p_sys->lock );
         free( p_sys );
         avcodec_free_context( &p_context );
@@ -1381,6 +1394,8 @@ void EndVideoDec( vlc_object_t *obj )
     if( p_sys->p_va )
         vlc_va_Delete( p_sys->p_va );
 
+    if( p_sys->i_cpu_threads > 0 )
+        vlc_CPU_ReleaseThreads( p_sys->i_cpu_threads );
     vlc_mutex_destroy( &p_sys->lock );
     free( p_sys );
 }
@@ -37,6 +37,7 @@
 #include <vlc_codec.h>
 #include <vlc_codecs.h>
 #include <vlc_aout.h>
+#include <vlc_cpu.h>
 
 #ifdef _WIN32
 # define FLAC__NO_DLL
@@ -52,6 +53,39 @@
 #   define USE_NEW_FLAC_API
 #endif
 
+/*****************************************************************************
+ * flac_worker_t : frame decoding thread
+ *****************************************************************************
+ * FLAC frames are independent: each worker owns a libflac decoder, which is
+ * fed with the stream header once, then with one frame at a time.
+ *****************************************************************************/
+typedef struct
+{
+    decoder_t *p_dec;
+    FLAC__StreamDecoder *p_flac;
+    vlc_thread_t thread;
+
+    vlc_mutex_t lock;
+    vlc_cond_t  wait; /* a frame was posted, or the worker must exit */
+    vlc_cond_t  done; /* the posted frame was decoded */
+    block_t    *p_in; /* frame being decoded, NULL when idle */
+    bool        b_exit;
+
+    /* Errors of the posted frame, reported by the decoder thread */
+    bool        b_error;
+    FLAC__StreamDecoderErrorStatus error;
+    bool        b_failed;
+    FLAC__StreamDecoderState state;
+
+    /* Decoder thread only */
+    bool        b_pending; /* a frame was posted and not collected yet */
+    vlc_tick_t  i_pts;
+
+    /* Decoded frame, interleaved */
+    block_t    *p_out;
+    FLAC__FrameHeader header;
+} flac_worker_t;
+
 /*****************************************************************************
  * decoder_sys_t : FLAC decoder descriptor
  *****************************************************************************/
@@ -72,6 +106,15 @@ typedef struct
 
     uint8_t rgi_channels_reorder[AOUT_CHAN_MAX];
     bool b_stream_info;
+
+    /*
+     * Frame threads
+     */
+    flac_worker_t *p_workers;
+    unsigned i_workers;
+    unsigned i_next_worker; /* fed next, holds the oldest pending frame */
+    unsigned i_threads;
+    unsigned i_cpu_threads; /* taken from the process-wide budget */
 } decoder_sys_t;
 
 static const int pi_channels_maps[FLAC__MAX_CHANNELS + 1] =
@@ -150,6 +193,11 @@ static void CloseEncoder ( vlc_object_t * );
 
 static int DecodeBlock( decoder_t *, block_t * );
 static void Flush( decoder_t * );
+static void decoder_state_error( decoder_t *, FLAC__StreamDecoderState );
+
+#define THREADS_TEXT N_( "Threads" )
+#define THREADS_LONGTEXT N_( "Number of threads decoding frames in parallel, " \
+    "0=auto. Each thread adds one frame of latency." )
 
 /*****************************************************************************
  * Module descriptor
@@ -163,6 +211,8 @@ vlc_module_begin ()
     set_description( N_("Flac audio decoder") )
     set_capability( "audio decoder", 100 )
     set_callbacks( OpenDecoder, CloseDecoder )
+    add_integer_with_range( "flac-threads", 1, 0, 64, THREADS_TEXT,
+                            THREADS_LONGTEXT, true )
 
 #ifdef ENABLE_SOUT
     add_submodule ()
@@ -216,24 +266,20 @@ static int DecoderSetOutputFormat( unsigned i_channels, unsigned i_rate,
 }
 
 /*****************************************************************************
- * DecoderWriteCallback: called by libflac to output decoded samples
+ * DecoderUpdateOutput: sets up the output format and date for a frame
  *****************************************************************************/
-static FLAC__StreamDecoderWriteStatus
-DecoderWriteCallback( const FLAC__StreamDecoder *decoder,
-                      const FLAC__Frame *frame,
-                      const FLAC__int32 *const buffer[], void *client_data )
+static int DecoderUpdateOutput( decoder_t *p_dec,
+                                const FLAC__FrameHeader *header )
 {
-    VLC_UNUSED(decoder);
-    decoder_t *p_dec = (decoder_t *)client_data;
     decoder_sys_t *p_sys = p_dec->p_sys;
 
-    if( DecoderSetOutputFormat( frame->header.channels,
-                                frame->header.sample_rate,
+    if( DecoderSetOutputFormat( header->channels,
+                                header->sample_rate,
                                 p_sys->b_stream_info ? p_sys->stream_info.sample_rate : 0,
-                                frame->header.bits_per_sample,
+                                header->bits_per_sample,
                                 &p_dec->fmt_out.audio,
                                 p_sys->rgi_channels_reorder ) )
-        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+        return VLC_EGENERIC;
 
     if( p_sys->end_date.i_divider_num != p_dec->fmt_out.audio.i_rate )
     {
@@ -244,9 +290,39 @@ DecoderWriteCallback( const FLAC__StreamDecoder *decoder,
     }
 
     if( decoder_UpdateAudioFormat( p_dec ) )
-        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+        return VLC_EGENERIC;
 
     if( date_Get( &p_sys->end_date ) == VLC_TICK_INVALID )
+        return VLC_EGENERIC;
+
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * DecoderSetDate: dates an output buffer of i_samples
+ *****************************************************************************/
+static void DecoderSetDate( decoder_sys_t *p_sys, block_t *p_out,
+                            unsigned i_samples )
+{
+    /* Date management (already done by packetizer) */
+    p_out->i_pts = date_Get( &p_sys->end_date );
+    p_out->i_length =
+        date_Increment( &p_sys->end_date, i_samples ) - p_out->i_pts;
+}
+
+/*****************************************************************************
+ * DecoderWriteCallback: called by libflac to output decoded samples
+ *****************************************************************************/
+static FLAC__StreamDecoderWriteStatus
+DecoderWriteCallback( const FLAC__StreamDecoder *decoder,
+                      const FLAC__Frame *frame,
+                      const FLAC__int32 *const buffer[], void *client_data )
+{
+    VLC_UNUSED(decoder);
+    decoder_t *p_dec = (decoder_t *)client_data;
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    if( DecoderUpdateOutput( p_dec, &frame->header ) )
         return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 
     p_sys->p_aout_buffer =
@@ -260,32 +336,23 @@ DecoderWriteCallback( const FLAC__StreamDecoder *decoder,
                  frame->header.channels, frame->header.blocksize,
                  frame->header.bits_per_sample );
 
-    /* Date management (already done by packetizer) */
-    p_sys->p_aout_buffer->i_pts = date_Get( &p_sys->end_date );
-    p_sys->p_aout_buffer->i_length =
-        date_Increment( &p_sys->end_date, frame->header.blocksize ) -
-        p_sys->p_aout_buffer->i_pts;
+    DecoderSetDate( p_sys, p_sys->p_aout_buffer, frame->header.blocksize );
 
     return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 }
 
 /*****************************************************************************
- * DecoderReadCallback: called by libflac when it needs more data
+ * ReadBlock: hands the data of a block to libflac
  *****************************************************************************/
 static FLAC__StreamDecoderReadStatus
-DecoderReadCallback( const FLAC__StreamDecoder *decoder, FLAC__byte buffer[],
-                     size_t *bytes, void *client_data )
+ReadBlock( block_t *p_block, FLAC__byte buffer[], size_t *bytes )
 {
-    VLC_UNUSED(decoder);
-    decoder_t *p_dec = (decoder_t *)client_data;
-    decoder_sys_t *p_sys = p_dec->p_sys;
-
-    if( p_sys->p_block && p_sys->p_block->i_buffer )
+    if( p_block && p_block->i_buffer )
     {
-        *bytes = __MIN(*bytes, p_sys->p_block->i_buffer);
-        memcpy( buffer, p_sys->p_block->p_buffer, *bytes );
-        p_sys->p_block->i_buffer -= *bytes;
-        p_sys->p_block->p_buffer += *bytes;
+        *bytes = __MIN(*bytes, p_block->i_buffer);
+        memcpy( buffer, p_block->p_buffer, *bytes );
+        p_block->i_buffer -= *bytes;
+        p_block->p_buffer += *bytes;
     }
     else
     {
@@ -296,6 +363,21 @@ DecoderReadCallback( const FLAC__StreamDecoder *decoder, FLAC__byte buffer[],
     return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
 }
 
+/*****************************************************************************
+ * DecoderReadCallback: called by libflac when it needs more data
+ *****************************************************************************/
+static FLAC__StreamDecoderReadStatus
+DecoderReadCallback( const FLAC__StreamDecoder *decoder, FLAC__byte buffer[],
+                     size_t *bytes, void *client_data )
+{
+    VLC_UNUSED(decoder);
+    decoder_t *p_dec = (decoder_t *)client_data;
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    return ReadBlock( p_sys->p_block, buffer, bytes );
+}
+
+
 /*****************************************************************************
  * DecoderMetadataCallback: called by libflac to when it encounters metadata
  *****************************************************************************/
@@ -384,16 +466,11 @@ static void DecoderMetadataCallback( const FLAC__StreamDecoder *decoder,
 }
 
 /*****************************************************************************
- * DecoderErrorCallback: called when the libflac decoder encounters an error
+ * decoder_error_status: print meaningful error messages
  *****************************************************************************/
-static void DecoderErrorCallback( const FLAC__StreamDecoder *decoder,
-                                  FLAC__StreamDecoderErrorStatus status,
-                                  void *client_data )
+static void decoder_error_status( decoder_t *p_dec,
+                                  FLAC__StreamDecoderErrorStatus status )
 {
-    VLC_UNUSED(decoder);
-    decoder_t *p_dec = (decoder_t *)client_data;
-    decoder_sys_t *p_sys = p_dec->p_sys;
-
     switch( status )
     {
     case FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC:
@@ -414,10 +491,342 @@ static void DecoderErrorCallback( const FLAC__StreamDecoder *decoder,
     default:
         msg_Err( p_dec, "got decoder error: %d", status );
     }
+}
 
+/*****************************************************************************
+ * DecoderErrorCallback: called when the libflac decoder encounters an error
+ *****************************************************************************/
+static void DecoderErrorCallback( const FLAC__StreamDecoder *decoder,
+                                  FLAC__StreamDecoderErrorStatus status,
+                                  void *client_data )
+{
+    VLC_UNUSED(decoder);
+    decoder_t *p_dec = (decoder_t *)client_data;
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    decoder_error_status( p_dec, status );
     FLAC__stream_decoder_flush( p_sys->p_flac );
     return;
 }
+/*****************************************************************************
+ * HeaderBlock: builds the stream header from the Flac extra data
+ *****************************************************************************/
+static block_t *HeaderBlock( decoder_t *p_dec )
+{
+    int i_extra = p_dec->fmt_in.i_extra;
+
+    static const char header[4] = { 'f', 'L', 'a', 'C' };
+
+    if( memcmp( p_dec->fmt_in.p_extra, header, 4 ) )
+        i_extra += 8;
+
+    block_t *p_block = block_Alloc( i_extra );
+    if( p_block == NULL )
+        return NULL;
+
+    uint8_t *p_data = p_block->p_buffer;
+    if( i_extra != p_dec->fmt_in.i_extra )
+    {
+        memcpy( p_data, header, 4);
+        p_data[4] = 0x80 | 0; /* STREAMINFO faked as last block */
+        p_data[5] = 0;
+        p_data[6] = 0;
+        p_data[7] = 34; /* block size */
+        p_data += 8;
+    }
+    memcpy( p_data, p_dec->fmt_in.p_extra, p_dec->fmt_in.i_extra );
+    return p_block;
+}
+
+#ifdef USE_NEW_FLAC_API
+/*****************************************************************************
+ * Worker callbacks: same as the decoder ones, on the worker frame
+ *****************************************************************************/
+static FLAC__StreamDecoderWriteStatus
+WorkerWriteCallback( const FLAC__StreamDecoder *decoder,
+                     const FLAC__Frame *frame,
+                     const FLAC__int32 *const buffer[], void *client_data )
+{
+    VLC_UNUSED(decoder);
+    flac_worker_t *p_worker = client_data;
+    const unsigned i_channels = frame->header.channels;
+
+    if( i_channels == 0 || i_channels > FLAC__MAX_CHANNELS ||
+        frame->header.bits_per_sample == 0 )
+        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+
+    /* The format is set up on the decoder thread, from the header: the
+     * samples are interleaved as decoder_NewAudioBuffer() would have */
+    block_t *p_out = block_Alloc( frame->header.blocksize * i_channels
+                                  * sizeof(int32_t) );
+    if( p_out == NULL )
+        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+    p_out->i_nb_samples = frame->header.blocksize;
+
+    Interleave( (int32_t *)p_out->p_buffer, buffer, ppi_reorder[i_channels],
+                i_channels, frame->header.blocksize,
+                frame->header.bits_per_sample );
+
+    if( p_worker->p_out != NULL )
+        block_Release( p_worker->p_out );
+    p_worker->p_out = p_out;
+    p_worker->header = frame->header;
+    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+static FLAC__StreamDecoderReadStatus
+WorkerReadCallback( const FLAC__StreamDecoder *decoder, FLAC__byte buffer[],
+                    size_t *bytes, void *client_data )
+{
+    VLC_UNUSED(decoder);
+    flac_worker_t *p_worker = client_data;
+
+    return ReadBlock( p_worker->p_in, buffer, bytes );
+}
+
+static void WorkerErrorCallback( const FLAC__StreamDecoder *decoder,
+                                 FLAC__StreamDecoderErrorStatus status,
+                                 void *client_data )
+{
+    VLC_UNUSED(decoder);
+    flac_worker_t *p_worker = client_data;
+
+    p_worker->b_error = true;
+    p_worker->error = status;
+    FLAC__stream_decoder_flush( p_worker->p_flac );
+}
+
+static void *WorkerThread( void *data )
+{
+    flac_worker_t *p_worker = data;
+
+    vlc_mutex_lock( &p_worker->lock );
+    for( ;; )
+    {
+        while( p_worker->p_in == NULL && !p_worker->b_exit )
+            vlc_cond_wait( &p_worker->wait, &p_worker->lock );
+        if( p_worker->b_exit )
+            break;
+        vlc_mutex_unlock( &p_worker->lock );
+
+        /* The decoder thread does not touch the frame until it is done */
+        p_worker->b_error = p_worker->b_failed = false;
+        if( !FLAC__stream_decoder_process_single( p_worker->p_flac ) )
+        {
+            p_worker->b_failed = true;
+            p_worker->state =
+                FLAC__stream_decoder_get_state( p_worker->p_flac );
+            FLAC__stream_decoder_flush( p_worker->p_flac );
+        }
+
+        /* Flush rather than reset, which would drop the stream header */
+        switch( FLAC__stream_decoder_get_state( p_worker->p_flac ) )
+        {
+            case FLAC__STREAM_DECODER_ABORTED:
+            case FLAC__STREAM_DECODER_END_OF_STREAM:
+                FLAC__stream_decoder_flush( p_worker->p_flac );
+                break;
+            default:
+                break;
+        }
+
+        vlc_mutex_lock( &p_worker->lock );
+        block_Release( p_worker->p_in );
+        p_worker->p_in = NULL;
+        vlc_cond_signal( &p_worker->done );
+    }
+    vlc_mutex_unlock( &p_worker->lock );
+    return NULL;
+}
+
+static int WorkerInit( decoder_t *p_dec, flac_worker_t *p_worker )
+{
+    p_worker->p_dec = p_dec;
+    p_worker->p_in = NULL;
+    p_worker->p_out = NULL;
+    p_worker->b_exit = false;
+    p_worker->b_pending = false;
+    p_worker->b_error = false;
+    p_worker->b_failed = false;
+
+    p_worker->p_flac = FLAC__stream_decoder_new();
+    if( p_worker->p_flac == NULL )
+        return VLC_ENOMEM;
+
+    if( FLAC__stream_decoder_init_stream( p_worker->p_flac,
+                                          WorkerReadCallback,
+                                          NULL, NULL, NULL, NULL,
+                                          WorkerWriteCallback,
+                                          NULL,
+                                          WorkerErrorCallback,
+                                          p_worker )
+        != FLAC__STREAM_DECODER_INIT_STATUS_OK )
+        goto error;
+
+    /* The frames may refer to the STREAMINFO sample rate and size */
+    p_worker->p_in = HeaderBlock( p_dec );
+    if( p_worker->p_in == NULL )
+        goto error;
+    FLAC__stream_decoder_process_until_end_of_metadata( p_worker->p_flac );
+    block_Release( p_worker->p_in );
+    p_worker->p_in = NULL;
+
+    vlc_mutex_init( &p_worker->lock );
+    vlc_cond_init( &p_worker->wait );
+    vlc_cond_init( &p_worker->done );
+    if( vlc_clone( &p_worker->thread, WorkerThread, p_worker,
+                   VLC_THREAD_PRIORITY_AUDIO ) )
+    {
+        vlc_cond_destroy( &p_worker->done );
+        vlc_cond_destroy( &p_worker->wait );
+        vlc_mutex_destroy( &p_worker->lock );
+        goto error;
+    }
+    return VLC_SUCCESS;
+
+error:
+    FLAC__stream_decoder_delete( p_worker->p_flac );
+    return VLC_EGENERIC;
+}
+
+static void WorkerClean( flac_worker_t *p_worker )
+{
+    vlc_mutex_lock( &p_worker->lock );
+    p_worker->b_exit = true;
+    vlc_cond_signal( &p_worker->wait );
+    vlc_mutex_unlock( &p_worker->lock );
+    vlc_join( p_worker->thread, NULL );
+
+    if( p_worker->p_in != NULL )
+        block_Release( p_worker->p_in );
+    if( p_worker->p_out != NULL )
+        block_Release( p_worker->p_out );
+    FLAC__stream_decoder_finish( p_worker->p_flac );
+    FLAC__stream_decoder_delete( p_worker->p_flac );
+    vlc_cond_destroy( &p_worker->done );
+    vlc_cond_destroy( &p_worker->wait );
+    vlc_mutex_destroy( &p_worker->lock );
+}
+
+static void WorkerPost( flac_worker_t *p_worker, block_t *p_block )
+{
+    assert( !p_worker->b_pending );
+    p_worker->b_pending = true;
+    p_worker->i_pts = p_block->i_pts;
+
+    vlc_mutex_lock( &p_worker->lock );
+    p_worker->p_in = p_block;
+    vlc_cond_signal( &p_worker->wait );
+    vlc_mutex_unlock( &p_worker->lock );
+}
+
+/*****************************************************************************
+ * WorkerCollect: waits for the frame of a worker, reports its errors as the
+ * decoder thread would have, and outputs it
+ *****************************************************************************/
+static void WorkerCollect( decoder_t *p_dec, flac_worker_t *p_worker,
+                           bool b_output )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    if( !p_worker->b_pending )
+        return;
+    p_worker->b_pending = false;
+
+    vlc_mutex_lock( &p_worker->lock );
+    while( p_worker->p_in != NULL )
+        vlc_cond_wait( &p_worker->done, &p_worker->lock );
+    vlc_mutex_unlock( &p_worker->lock );
+
+    if( p_worker->b_error )
+        decoder_error_status( p_dec, p_worker->error );
+    if( p_worker->b_failed )
+        decoder_state_error( p_dec, p_worker->state );
+
+    block_t *p_out = p_worker->p_out;
+    p_worker->p_out = NULL;
+    if( p_out == NULL )
+        return;
+
+    if( b_output )
+    {
+        if( p_worker->i_pts != VLC_TICK_INVALID &&
+            p_worker->i_pts != date_Get( &p_sys->end_date ) )
+            date_Set( &p_sys->end_date, p_worker->i_pts );
+
+        if( DecoderUpdateOutput( p_dec, &p_worker->header ) == VLC_SUCCESS )
+        {
+            DecoderSetDate( p_sys, p_out, p_worker->header.blocksize );
+            decoder_QueueAudio( p_dec, p_out );
+            return;
+        }
+    }
+    block_Release( p_out );
+}
+
+/*****************************************************************************
+ * WorkersCollect: outputs (or drops) all the pending frames, in order
+ *****************************************************************************/
+static void WorkersCollect( decoder_t *p_dec, bool b_output )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    for( unsigned i = 0; i < p_sys->i_workers; i++ )
+    {
+        unsigned i_worker = (p_sys->i_next_worker + i) % p_sys->i_workers;
+        WorkerCollect( p_dec, &p_sys->p_workers[i_worker], b_output );
+    }
+}
+
+static void DeleteWorkers( decoder_t *p_dec )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    for( unsigned i = 0; i < p_sys->i_workers; i++ )
+        WorkerClean( &p_sys->p_workers[i] );
+    free( p_sys->p_workers );
+    p_sys->p_workers = NULL;
+    p_sys->i_workers = 0;
+}
+
+static void CreateWorkers( decoder_t *p_dec, unsigned i_threads )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    p_sys->p_workers = vlc_alloc( i_threads, sizeof(*p_sys->p_workers) );
+    if( p_sys->p_workers == NULL )
+        return;
+
+    while( p_sys->i_workers < i_threads &&
+           WorkerInit( p_dec, &p_sys->p_workers[p_sys->i_workers] ) == VLC_SUCCESS )
+        p_sys->i_workers++;
+    p_sys->i_next_worker = 0;
+
+    if( p_sys->i_workers < 2 )
+    {
+        /* Decode on the decoder thread */
+        DeleteWorkers( p_dec );
+        return;
+    }
+    msg_Dbg( p_dec, "decoding frames with %u threads", p_sys->i_workers );
+}
+#else
+static void WorkersCollect( decoder_t *p_dec, bool b_output )
+{
+    VLC_UNUSED(p_dec); VLC_UNUSED(b_output);
+}
+
+static void DeleteWorkers( decoder_t *p_dec )
+{
+    VLC_UNUSED(p_dec);
+}
+
+static void CreateWorkers( decoder_t *p_dec, unsigned i_threads )
+{
+    VLC_UNUSED(p_dec); VLC_UNUSED(i_threads);
+}
+#endif
+
 /*****************************************************************************
  * OpenDecoder: probe the decoder and return score
  *****************************************************************************/
@@ -439,6 +848,10 @@ static int OpenDecoder( vlc_object_t *p_this )
     p_sys->b_stream_info = false;
     memset(p_sys->rgi_channels_reorder, 0, AOUT_CHAN_MAX);
     p_sys->p_block = NULL;
+    p_sys->p_workers = NULL;
+    p_sys->i_workers = 0;
+    p_sys->i_next_worker = 0;
+    p_sys->i_cpu_threads = 0;
 
     /* Take care of flac init */
     if( !(p_sys->p_flac = FLAC__stream_decoder_new()) )
@@ -484,6 +897,17 @@ static int OpenDecoder( vlc_object_t *p_this )
     FLAC__stream_decoder_init( p_sys->p_flac );
 #endif
 
+    /* The frame threads start with the first frame, once the header is
+     * known */
+    p_sys->i_threads = var_InheritInteger( p_dec, "flac-threads" );
+    if( p_sys->i_threads == 0 )
+    {
+        /* Share the CPUs with the other decoders and encoders */
+        p_sys->i_cpu_threads = vlc_CPU_AcquireThreads( p_dec,
+                                                       vlc_GetCPUCount() );
+        p_sys->i_threads = p_sys->i_cpu_threads;
+    }
+
     /* Set output properties */
     p_dec->fmt_out.i_codec = VLC_CODEC_S32N;
 
@@ -502,6 +926,10 @@ static void CloseDecoder( vlc_object_t *p_this )
     decoder_t *p_dec = (decoder_t *)p_this;
     decoder_sys_t *p_sys = p_dec->p_sys;
 
+    DeleteWorkers( p_dec );
+    if( p_sys->i_cpu_threads > 0 )
+        vlc_CPU_ReleaseThreads( p_sys->i_cpu_threads );
+
     FLAC__stream_decoder_finish( p_sys->p_flac );
     FLAC__stream_decoder_delete( p_sys->p_flac );
 
@@ -522,29 +950,10 @@ static void ProcessHeader( decoder_t *p_dec )
 
     /* Decode STREAMINFO */
     msg_Dbg( p_dec, "decode STREAMINFO" );
-    int i_extra = p_dec->fmt_in.i_extra;
-
-    static const char header[4] = { 'f', 'L', 'a', 'C' };
-
-    if( memcmp( p_dec->fmt_in.p_extra, header, 4 ) )
-        i_extra += 8;
-
-    p_sys->p_block = block_Alloc( i_extra );
+    p_sys->p_block = HeaderBlock( p_dec );
     if( p_sys->p_block == NULL )
         return;
 
-    uint8_t *p_data = p_sys->p_block->p_buffer;
-    if( i_extra != p_dec->fmt_in.i_extra )
-    {
-        memcpy( p_data, header, 4);
-        p_data[4] = 0x80 | 0; /* STREAMINFO faked as last block */
-        p_data[5] = 0;
-        p_data[6] = 0;
-        p_data[7] = 34; /* block size */
-        p_data += 8;
-    }
-    memcpy( p_data, p_dec->fmt_in.p_extra, p_dec->fmt_in.i_extra );
-
     FLAC__stream_decoder_process_until_end_of_metadata( p_sys->p_flac );
     msg_Dbg( p_dec, "STREAMINFO decoded" );
 
@@ -624,6 +1033,9 @@ static void Flush( decoder_t *p_dec )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
 
+    /* The workers are idle once collected, and have no state left to flush
+     * between frames */
+    WorkersCollect( p_dec, false );
     if( p_sys->b_stream_info )
         FLAC__stream_decoder_flush( p_sys->p_flac );
     date_Set( &p_sys->end_date, VLC_TICK_INVALID );
@@ -636,10 +1048,15 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
 
-    if( p_block == NULL ) /* No Drain */
+    if( p_block == NULL ) /* Drain */
+    {
+        WorkersCollect( p_dec, true );
         return VLCDEC_SUCCESS;
+    }
     if( p_block->i_flags & (BLOCK_FLAG_DISCONTINUITY | BLOCK_FLAG_CORRUPTED) )
     {
+        /* Output the frames before the discontinuity */
+        WorkersCollect( p_dec, true );
         Flush( p_dec );
         if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
         {
@@ -656,6 +1073,20 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
             block_Release( p_block );
             return VLCDEC_ECRITICAL;
         }
+        if( p_sys->i_threads > 1 )
+            CreateWorkers( p_dec, p_sys->i_threads );
+    }
+
+    if( p_sys->i_workers > 0 )
+    {
+        /* The next worker holds the oldest frame: output it, so that the
+         * frames keep their order, then hand it the new one */
+        flac_worker_t *p_worker = &p_sys->p_workers[p_sys->i_next_worker];
+
+        WorkerCollect( p_dec, p_worker, true );
+        WorkerPost( p_worker, p_block );
+        p_sys->i_next_worker = (p_sys->i_next_worker + 1) % p_sys->i_workers;
+        return VLCDEC_SUCCESS;
     }
 
     p_sys->p_block = p_block;
@@ -914,6 +1345,8 @@ static void CloseEncoder( vlc_object_t *p_this )
     encoder_sys_t *p_sys = p_enc->p_sys;
 
     FLAC__stream_encoder_delete( p_sys->p_flac );
+    /* The last frame, written while finishing the stream */
+    block_ChainRelease( p_sys->p_chain );
 
     free( p_sys->p_buffer );
     free( p_sys );
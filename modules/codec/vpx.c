@@ -30,6 +30,7 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
+#include <vlc_cpu.h>
 
 #include <vpx/vpx_decoder.h>
 #include <vpx/vp8dx.h>
@@ -100,6 +101,7 @@ static void vpx_err_msg(vlc_object_t *this, struct vpx_codec_ctx *ctx,
 typedef struct
 {
     struct vpx_codec_ctx ctx;
+    unsigned threads; /* taken from the process-wide budget */
 } decoder_sys_t;
 
 static const struct
@@ -324,8 +326,11 @@ static int OpenDecoder(vlc_object_t *p_this)
         return VLC_ENOMEM;
     dec->p_sys = sys;
 
+    /* Share the CPUs with the other decoders and encoders */
+    sys->threads = vlc_CPU_AcquireThreads(dec, __MIN(vlc_GetCPUCount(), 16));
+
     struct vpx_codec_dec_cfg deccfg = {
-        .threads = __MIN(vlc_GetCPUCount(), 16)
+        .threads = sys->threads
     };
 
     msg_Dbg(p_this, "VP%d: using libvpx version %s (build options %s)",
@@ -333,6 +338,7 @@ static int OpenDecoder(vlc_object_t *p_this)
 
     if (vpx_codec_dec_init(&sys->ctx, iface, &deccfg, 0) != VPX_CODEC_OK) {
         VPX_ERR(p_this, &sys->ctx, "Failed to initialize decoder");
+        vlc_CPU_ReleaseThreads(sys->threads);
         free(sys);
         return VLC_EGENERIC;;
     }
@@ -369,6 +375,7 @@ static void CloseDecoder(vlc_object_t *p_this)
 
     vpx_codec_destroy(&sys->ctx);
 
+    vlc_CPU_ReleaseThreads(sys->threads);
     free(sys);
 }
 
@@ -381,6 +388,7 @@ typedef struct
 {
     struct vpx_codec_ctx ctx;
     unsigned long quality;
+    unsigned threads; /* taken from the process-wide budget */
 } encoder_sys_t;
 
 /*****************************************************************************
@@ -421,7 +429,9 @@ static int OpenEncoder(vlc_object_t *p_this)
 
     struct vpx_codec_enc_cfg enccfg = {0};
     vpx_codec_enc_config_default(iface, &enccfg, 0);
-    enccfg.g_threads = __MIN(vlc_GetCPUCount(), 4);
+    p_sys->threads = vlc_CPU_AcquireThreads(p_enc,
+                                            __MIN(vlc_GetCPUCount(), 4));
+    enccfg.g_threads = p_sys->threads;
     enccfg.g_w = p_enc->fmt_in.video.i_visible_width;
     enccfg.g_h = p_enc->fmt_in.video.i_visible_height;
 
@@ -431,6 +441,7 @@ static int OpenEncoder(vlc_object_t *p_this)
     struct vpx_codec_ctx *ctx = &p_sys->ctx;
     if (vpx_codec_enc_init(ctx, iface, &enccfg, 0) != VPX_CODEC_OK) {
         VPX_ERR(p_this, ctx, "Failed to initialize encoder");
+        vlc_CPU_ReleaseThreads(p_sys->threads);
         free(p_sys);
         return VLC_EGENERIC;
     }
@@ -527,6 +538,7 @@ static void CloseEncoder(vlc_object_t *p_this)
     encoder_sys_t *p_sys = p_enc->p_sys;
     if (vpx_codec_destroy(&p_sys->ctx))
         VPX_ERR(p_this, &p_sys->ctx, "Failed to destroy codec");
+    vlc_CPU_ReleaseThreads(p_sys->threads);
     free(p_sys);
 }
 
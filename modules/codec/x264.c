@@ -765,6 +765,7 @@ typedef struct
     int             i_sei_size;
     uint32_t         i_colorspace;
     uint8_t         *p_sei;
+    unsigned        i_cpu_threads; /* taken from the process-wide budget */
 } encoder_sys_t;
 
 #ifdef PTW32_STATIC_LIB
@@ -865,6 +866,7 @@ static int  Open ( vlc_object_t *p_this )
     p_sys->psz_stat_name = NULL;
     p_sys->i_sei_size = 0;
     p_sys->p_sei = NULL;
+    p_sys->i_cpu_threads = 0;
 
     char *psz_preset = var_GetString( p_enc, SOUT_CFG_PREFIX  "preset" );
     char *psz_tune = var_GetString( p_enc, SOUT_CFG_PREFIX  "tune" );
@@ -1329,6 +1331,13 @@ static int  Open ( vlc_object_t *p_this )
        threads = 1, however VLC usage differs and uses threads = 0 (auto) by
        default unless ofcourse transcode threads is explicitly specified.. */
     p_sys->param.i_threads = p_enc->i_threads;
+    if( p_sys->param.i_threads == 0 )
+    {
+        /* Share the CPUs with the other decoders and encoders */
+        p_sys->i_cpu_threads = vlc_CPU_AcquireThreads( p_enc,
+                                                vlc_GetCPUCount() * 3 / 2 );
+        p_sys->param.i_threads = p_sys->i_cpu_threads;
+    }
 
     psz_val = var_GetString( p_enc, SOUT_CFG_PREFIX "stats" );
     if( psz_val )
@@ -1570,6 +1579,9 @@ static void Close( vlc_object_t *p_this )
         x264_encoder_close( p_sys->h );
     }
 
+    if( p_sys->i_cpu_threads > 0 )
+        vlc_CPU_ReleaseThreads( p_sys->i_cpu_threads );
+
 #ifdef PTW32_STATIC_LIB
     vlc_mutex_lock( &pthread_win32_mutex );
     pthread_win32_count--;
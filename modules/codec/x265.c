@@ -33,6 +33,7 @@
 #include <vlc_threads.h>
 #include <vlc_sout.h>
 #include <vlc_codec.h>
+#include <vlc_cpu.h>
 
 #include <x265.h>
 
@@ -55,6 +56,7 @@ typedef struct
     x265_encoder    *h;
     x265_param      param;
 
+    unsigned        threads; /* taken from the process-wide budget */
     unsigned        frame_count;
     vlc_tick_t      initial_date;
 #ifndef NDEBUG
@@ -153,7 +155,6 @@ static int  Open (vlc_object_t *p_this)
     x265_param *param = &p_sys->param;
     x265_param_default(param);
 
-    param->frameNumThreads = vlc_GetCPUCount();
     param->bEnableWavefront = 0; // buggy in x265, use frame threading for now
     param->maxCUSize = 16; /* use smaller macroblock */
 
@@ -192,9 +193,14 @@ static int  Open (vlc_object_t *p_this)
         param->rc.rateControlMode = X265_RC_ABR;
     }
 
+    /* Share the CPUs with the other decoders and encoders */
+    p_sys->threads = vlc_CPU_AcquireThreads(p_enc, vlc_GetCPUCount());
+    param->frameNumThreads = p_sys->threads;
+
     p_sys->h = x265_encoder_open(param);
     if (p_sys->h == NULL) {
         msg_Err(p_enc, "cannot open x265 encoder");
+        vlc_CPU_ReleaseThreads(p_sys->threads);
         free(p_sys);
         return VLC_EGENERIC;
     }
@@ -240,5 +246,6 @@ static void Close(vlc_object_t *p_this)
 
     x265_encoder_close(p_sys->h);
 
+    vlc_CPU_ReleaseThreads(p_sys->threads);
     free(p_sys);
 }
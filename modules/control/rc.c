@@ -1228,6 +1228,17 @@ static void Statistics(intf_thread_t *intf)
                   item->p_stats->i_played_abuffers);
         msg_print(intf, _("| buffers lost     :    %5"PRIi64),
                   item->p_stats->i_lost_abuffers);
+        if (!isnan(item->p_stats->f_loudness_integrated))
+        {
+            msg_print(intf, _("| loudness         :  %7.1f LUFS"),
+                      item->p_stats->f_loudness_short_term);
+            msg_print(intf, _("| integrated       :  %7.1f LUFS"),
+                      item->p_stats->f_loudness_integrated);
+            msg_print(intf, _("| loudness range   :  %7.1f LU"),
+                      item->p_stats->f_loudness_range);
+            msg_print(intf, _("| true peak        :  %7.1f dBTP"),
+                      item->p_stats->f_true_peak);
+        }
         msg_print(intf, "|");
 
         vlc_mutex_unlock(&item->lock);
@@ -92,6 +92,7 @@ var_InheritFourcc(vlc_object_t *obj, const char *name)
     X(audio_sample_length, vlc_tick_t, add_integer, var_InheritInteger, VLC_TICK_FROM_MS(40) ) \
     X(video_track_count, ssize_t, add_integer, var_InheritSsize, 0) \
     X(video_chroma, vlc_fourcc_t, add_string, var_InheritFourcc, "I420") \
+    X(video_codec, vlc_fourcc_t, add_string, var_InheritFourcc, NULL) \
     X(video_width, unsigned, add_integer, var_InheritUnsigned, 640) \
     X(video_height, unsigned, add_integer, var_InheritUnsigned, 480) \
     X(video_frame_rate, unsigned, add_integer, var_InheritUnsigned, 25) \
@@ -374,6 +375,17 @@ static block_t *
 CreateVideoBlock(demux_t *demux, struct mock_track *track)
 {
     struct demux_sys *sys = demux->p_sys;
+
+    if (sys->video_codec != 0)
+    {   /* Compressed video: opaque frames */
+        block_t *b = block_Alloc(64);
+        if (!b)
+            return NULL;
+        memset(b->p_buffer, (sys->video_pts / VLC_TICK_FROM_MS(10)) % 255,
+               b->i_buffer);
+        return b;
+    }
+
     picture_t *pic = picture_NewFromFormat(&track->fmt.video);
     if (!pic)
         return NULL;
@@ -458,6 +470,8 @@ InitVideoTracks(demux_t *demux, int group, size_t count)
         vlc_fourcc_GetChromaDescription(sys->video_chroma);
     if (!desc || desc->plane_count == 0)
         sys->video_chroma = 0;
+    if (sys->video_codec != 0)
+        sys->video_chroma = sys->video_codec;
 
     const bool frame_rate_ok =
         sys->video_frame_rate != 0 && sys->video_frame_rate != UINT_MAX &&
@@ -483,7 +497,8 @@ InitVideoTracks(demux_t *demux, int group, size_t count)
     {
         es_format_t fmt;
         es_format_Init(&fmt, VIDEO_ES, sys->video_chroma);
-        fmt.video.i_chroma = fmt.i_codec;
+        if (sys->video_codec == 0)
+            fmt.video.i_chroma = fmt.i_codec;
         fmt.video.i_width = fmt.video.i_visible_width = sys->video_width;
         fmt.video.i_height = fmt.video.i_visible_height = sys->video_height;
         fmt.video.i_frame_rate = sys->video_frame_rate;
@@ -629,7 +644,9 @@ DemuxVideo(demux_t *demux, vlc_tick_t step_length, vlc_tick_t end_pts)
             if (!block)
                 return VLC_EGENERIC;
 
-            block->i_length = step_length;
+            /* As in most containers, compressed frames have no length */
+            if (track->fmt.i_cat != VIDEO_ES || sys->video_codec == 0)
+                block->i_length = step_length;
             block->i_pts = block->i_dts = sys->video_pts;
 
             int ret = es_out_Send(demux->out, track->id, block);
@@ -625,6 +625,11 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_INT( lost_pictures )
         STATS_INT( played_abuffers )
         STATS_INT( lost_abuffers )
+        STATS_FLOAT( loudness_momentary )
+        STATS_FLOAT( loudness_short_term )
+        STATS_FLOAT( loudness_integrated )
+        STATS_FLOAT( loudness_range )
+        STATS_FLOAT( true_peak )
 #undef STATS_INT
 #undef STATS_FLOAT
     }
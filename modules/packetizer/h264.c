@@ -340,6 +340,8 @@ static int Open( vlc_object_t *p_this )
                      p_h264_startcode, 1, 5,
                      PacketizeReset, PacketizeParse, PacketizeValidate, PacketizeDrain,
                      p_dec );
+    /* Slices are only read, and their trailing zeros stripped */
+    p_sys->packetizer.b_zero_copy = true;
 
     p_sys->b_slice = false;
     p_sys->frame.p_head = NULL;
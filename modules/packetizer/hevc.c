@@ -216,6 +216,8 @@ static int Open(vlc_object_t *p_this)
                     p_hevc_startcode, 1, 5,
                     PacketizeReset, PacketizeParse, PacketizeValidate, PacketizeDrain,
                     p_dec);
+    /* Slices are only read, and their trailing zeros stripped */
+    p_sys->packetizer.b_zero_copy = true;
 
     /* Copy properties */
     es_format_Copy(&p_dec->fmt_out, &p_dec->fmt_in);
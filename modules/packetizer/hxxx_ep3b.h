@@ -20,6 +20,12 @@
  *****************************************************************************/
 #include <vlc_bits.h>
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
 static inline uint8_t *hxxx_ep3b_to_rbsp( uint8_t *p, uint8_t *end, unsigned *pi_prev, size_t i_count )
 {
     for( size_t i=0; i<i_count; i++ )
@@ -81,6 +87,42 @@ static void hxxx_bsfw_ep3b_ctx_init( struct hxxx_bsfw_ep3b_ctx_s *ctx )
     ctx->i_bytesize = 0;
 }
 
+/* Returns the number of leading non-zero bytes, a whole vector at a time.
+ * None of them can be an emulation prevention byte, but the first one. */
+static inline size_t hxxx_ep3b_plain_size( const uint8_t *p, const uint8_t *p_end )
+{
+    const uint8_t *p_start = p;
+#ifdef __SSE2__
+    const __m128i zeros = _mm_setzero_si128();
+    for( ; p_end - p >= 16; p += 16 )
+    {
+        __m128i v = _mm_loadu_si128( (const __m128i *)p );
+        unsigned i_zeros = _mm_movemask_epi8( _mm_cmpeq_epi8( v, zeros ) );
+        if( i_zeros )
+            return p - p_start + ctz( i_zeros );
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint8x16_t zeros = vdupq_n_u8( 0x00 );
+    for( ; p_end - p >= 16; p += 16 )
+    {
+        uint8x16_t v = vceqq_u8( vld1q_u8( p ), zeros );
+        uint8x8_t narrow = vshrn_n_u16( vreinterpretq_u16_u8( v ), 4 );
+        uint64_t i_zeros = vget_lane_u64( vreinterpret_u64_u8( narrow ), 0 );
+        if( i_zeros )
+            return p - p_start + ctz( i_zeros ) / 4;
+    }
+#else
+    for( ; p_end - p >= 8; p += 8 )
+    {
+        uint64_t x;
+        memcpy( &x, p, 8 );
+        if( (x - 0x0101010101010101) & ~x & 0x8080808080808080 )
+            break;
+    }
+#endif
+    return p - p_start;
+}
+
 static size_t hxxx_ep3b_total_size( const uint8_t *p, const uint8_t *p_end )
 {
     /* compute final size */
@@ -88,6 +130,20 @@ static size_t hxxx_ep3b_total_size( const uint8_t *p, const uint8_t *p_end )
     size_t i = 0;
     while( p < p_end )
     {
+        /* Unless preceded by two zeros, runs of non-zero bytes are copied
+         * as is: count them at once */
+        if( (i_prev & 0x03) != 0x03 )
+        {
+            size_t i_plain = hxxx_ep3b_plain_size( p + 1, p_end );
+            if( i_plain > 0 )
+            {
+                p += i_plain;
+                i += i_plain;
+                i_prev = 0;
+                continue;
+            }
+        }
+
         uint8_t *n = hxxx_ep3b_to_rbsp( (uint8_t *)p, (uint8_t *)p_end, &i_prev, 1 );
         if( n > p )
             ++i;
@@ -24,6 +24,7 @@
 #define VLC_PACKETIZER_HELPER_H_
 
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 
 enum
 {
@@ -56,6 +57,8 @@ typedef struct
 
     unsigned i_au_min_size;
 
+    bool b_zero_copy;
+
     void *p_private;
     packetizer_reset_t    pf_reset;
     packetizer_parse_t    pf_parse;
@@ -82,6 +85,7 @@ static inline void packetizer_Init( packetizer_t *p_pack,
     p_pack->i_au_prepend = i_au_prepend;
     p_pack->p_au_prepend = p_au_prepend;
     p_pack->i_au_min_size = i_au_min_size;
+    p_pack->b_zero_copy = false;
 
     p_pack->i_startcode = i_startcode;
     p_pack->p_startcode = p_startcode;
@@ -106,6 +110,117 @@ static inline void packetizer_Flush( packetizer_t *p_pack )
     p_pack->pf_reset( p_pack->p_private, true );
 }
 
+/*
+ * Zero-copy mode: the input blocks are wrapped into reference counted
+ * sources, and the fragments lying within a single input block are
+ * returned as slices of it instead of copies. Only fragments crossing
+ * input blocks boundaries, or too small to be worth keeping the whole input
+ * block alive, are copied.
+ */
+#define PACKETIZER_SLICE_MIN_SIZE 4096
+
+struct packetizer_source
+{
+    vlc_atomic_rc_t rc;
+    block_t *p_block;
+};
+
+typedef struct
+{
+    block_t self;
+    struct packetizer_source *p_source;
+} packetizer_slice_t;
+
+static void packetizer_SliceRelease( block_t *p_block )
+{
+    packetizer_slice_t *p_slice = container_of( p_block, packetizer_slice_t, self );
+    struct packetizer_source *p_source = p_slice->p_source;
+
+    if( vlc_atomic_rc_dec( &p_source->rc ) )
+    {
+        block_Release( p_source->p_block );
+        free( p_source );
+    }
+    free( p_slice );
+}
+
+static const struct vlc_block_callbacks packetizer_slice_cbs =
+{
+    packetizer_SliceRelease,
+};
+
+static block_t *packetizer_SliceNew( struct packetizer_source *p_source,
+                                     uint8_t *p_data, size_t i_data )
+{
+    packetizer_slice_t *p_slice = malloc( sizeof(*p_slice) );
+    if( unlikely(p_slice == NULL) )
+        return NULL;
+
+    p_slice->p_source = p_source;
+    return block_Init( &p_slice->self, &packetizer_slice_cbs, p_data, i_data );
+}
+
+/* Returns the input block wrapped into a source, or unchanged on error */
+static block_t *packetizer_SourceNew( block_t *p_block )
+{
+    struct packetizer_source *p_source = malloc( sizeof(*p_source) );
+    if( unlikely(p_source == NULL) )
+        return p_block;
+
+    vlc_atomic_rc_init( &p_source->rc );
+    p_source->p_block = p_block;
+
+    block_t *p_wrap = packetizer_SliceNew( p_source, p_block->p_buffer,
+                                           p_block->i_buffer );
+    if( unlikely(p_wrap == NULL) )
+    {
+        free( p_source );
+        return p_block;
+    }
+    block_CopyProperties( p_wrap, p_block );
+    return p_wrap;
+}
+
+/* Returns the next i_size bytes of the bytestream as a slice of the current
+ * input block, or NULL if they must be copied.
+ * The AU prepend bytes are not added but taken from the input, where 4 bytes
+ * startcodes have them: the slices leave them out at their end, for the next
+ * fragment. */
+static block_t *packetizer_GetSlice( packetizer_t *p_pack, size_t i_size )
+{
+    block_bytestream_t *p_bs = &p_pack->bytestream;
+    block_t *p_block = p_bs->p_block;
+    const size_t i_prepend = p_pack->i_au_prepend;
+
+    if( !p_pack->b_zero_copy || i_size < PACKETIZER_SLICE_MIN_SIZE ||
+        p_block->cbs != &packetizer_slice_cbs ||
+        p_block->i_buffer - p_bs->i_block_offset < i_size )
+        return NULL;
+
+    uint8_t *p_data = &p_block->p_buffer[p_bs->i_block_offset];
+    if( i_prepend > 0 )
+    {
+        if( (size_t)(p_data - p_block->p_start) < i_prepend ||
+            memcmp( p_data - i_prepend, p_pack->p_au_prepend, i_prepend ) )
+            return NULL;
+    }
+
+    size_t i_data = i_prepend + i_size;
+    if( i_prepend > 0 &&
+        !memcmp( &p_data[i_size - i_prepend], p_pack->p_au_prepend, i_prepend ) )
+        i_data -= i_prepend;
+
+    struct packetizer_source *p_source =
+        container_of( p_block, packetizer_slice_t, self )->p_source;
+    block_t *p_slice = packetizer_SliceNew( p_source, p_data - i_prepend, i_data );
+    if( p_slice == NULL )
+        return NULL;
+
+    vlc_atomic_rc_inc( &p_source->rc );
+    block_SkipBytes( p_bs, i_size );
+    return p_slice;
+}
+
 static block_t *packetizer_PacketizeBlock( packetizer_t *p_pack, block_t **pp_block )
 {
     block_t *p_block = ( pp_block ) ? *pp_block : NULL;
@@ -126,7 +241,12 @@ static block_t *packetizer_PacketizeBlock( packetizer_t *p_pack, block_t **pp_bl
     }
 
     if( p_block )
+    {
+        /* Blocks given back by block_BytestreamPop() are already wrapped */
+        if( p_pack->b_zero_copy && p_block->cbs != &packetizer_slice_cbs )
+            p_block = packetizer_SourceNew( p_block );
         block_BytestreamPush( &p_pack->bytestream, p_block );
+    }
 
     for( ;; )
     {
@@ -180,21 +300,30 @@ static block_t *packetizer_PacketizeBlock( packetizer_t *p_pack, block_t **pp_bl
             /* Get the new fragment and set the pts/dts */
             block_t *p_block_bytestream = p_pack->bytestream.p_block;
 
-            p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
-            p_pic->i_pts = p_block_bytestream->i_pts;
-            p_pic->i_dts = p_block_bytestream->i_dts;
-
             /* Do not wait for next sync code if notified block ends AU */
-            if( (p_block_bytestream->i_flags & BLOCK_FLAG_AU_END) &&
-                 p_block_bytestream->i_buffer == p_pack->i_offset )
+            const bool b_au_end = (p_block_bytestream->i_flags & BLOCK_FLAG_AU_END) &&
+                                  p_block_bytestream->i_buffer == p_pack->i_offset;
+
+            p_pic = packetizer_GetSlice( p_pack, p_pack->i_offset );
+            if( p_pic == NULL )
             {
-                p_pic->i_flags |= BLOCK_FLAG_AU_END;
+                p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
+                if( unlikely(p_pic == NULL) )
+                {
+                    block_SkipBytes( &p_pack->bytestream, p_pack->i_offset );
+                    p_pack->i_offset = 0;
+                    p_pack->i_state = STATE_NOSYNC;
+                    break;
+                }
+                block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[p_pack->i_au_prepend],
+                                p_pic->i_buffer - p_pack->i_au_prepend );
+                if( p_pack->i_au_prepend > 0 )
+                    memcpy( p_pic->p_buffer, p_pack->p_au_prepend, p_pack->i_au_prepend );
             }
-
-            block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[p_pack->i_au_prepend],
-                            p_pic->i_buffer - p_pack->i_au_prepend );
-            if( p_pack->i_au_prepend > 0 )
-                memcpy( p_pic->p_buffer, p_pack->p_au_prepend, p_pack->i_au_prepend );
+            p_pic->i_pts = p_block_bytestream->i_pts;
+            p_pic->i_dts = p_block_bytestream->i_dts;
+            if( b_au_end )
+                p_pic->i_flags |= BLOCK_FLAG_AU_END;
 
             p_pack->i_offset = 0;
 
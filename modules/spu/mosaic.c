@@ -40,6 +40,7 @@
 #include "mosaic.h"
 
 #define BLANK_DELAY  VLC_TICK_FROM_SEC(1)
+#define STATS_PERIOD VLC_TICK_FROM_SEC(10)
 
 /*****************************************************************************
  * Local prototypes
@@ -63,6 +64,7 @@ typedef struct
     int i_position;           /* Mosaic positioning method */
     bool b_ar;          /* Do we keep the aspect ratio ? */
     bool b_keep;        /* Do we keep the original picture format ? */
+    bool b_prescale;    /* Do the bridges scale the pictures ? */
     int i_width, i_height;    /* Mosaic height and width */
     int i_cols, i_rows;       /* Mosaic rows and cols */
     int i_align;              /* Mosaic alignment in background video */
@@ -78,6 +80,8 @@ typedef struct
     int i_offsets_length;
 
     vlc_tick_t i_delay;
+
+    vlc_tick_t i_stats_date;  /* Last statistics report */
 } filter_sys_t;
 
 /*****************************************************************************
@@ -138,6 +142,12 @@ typedef struct
 #define KEEP_LONGTEXT N_( \
         "Keep the original size of mosaic elements." )
 
+#define PRESCALE_TEXT N_("Scale in the bridges")
+#define PRESCALE_LONGTEXT N_( \
+        "Let each mosaic bridge scale its pictures to the size of its " \
+        "element as they are decoded, in parallel, instead of scaling " \
+        "all elements in the video output thread." )
+
 #define ORDER_TEXT N_("Elements order" )
 #define ORDER_LONGTEXT N_( \
         "You can enforce the order of the elements on " \
@@ -213,6 +223,8 @@ vlc_module_begin ()
               AR_TEXT, AR_LONGTEXT, false )
     add_bool( CFG_PREFIX "keep-picture", false,
               KEEP_TEXT, KEEP_LONGTEXT, false )
+    add_bool( CFG_PREFIX "prescale", false,
+              PRESCALE_TEXT, PRESCALE_LONGTEXT, true )
 
     add_string( CFG_PREFIX "order", "",
                 ORDER_TEXT, ORDER_LONGTEXT, false )
@@ -227,7 +239,7 @@ vlc_module_end ()
 static const char *const ppsz_filter_options[] = {
     "alpha", "height", "width", "align", "xoffset", "yoffset",
     "borderw", "borderh", "position", "rows", "cols",
-    "keep-aspect-ratio", "keep-picture", "order", "offsets",
+    "keep-aspect-ratio", "keep-picture", "prescale", "order", "offsets",
     "delay", NULL
 };
 
@@ -333,6 +345,9 @@ static int CreateFilter( vlc_object_t *p_this )
         p_sys->p_image = image_HandlerCreate( p_filter );
     }
 
+    p_sys->b_prescale = var_CreateGetBool( p_filter, CFG_PREFIX "prescale" );
+    p_sys->i_stats_date = vlc_tick_now();
+
     p_sys->i_order_length = 0;
     p_sys->ppsz_order = NULL;
     psz_order = var_CreateGetStringCommand( p_filter, CFG_PREFIX "order" );
@@ -401,6 +416,17 @@ static void DestroyFilter( vlc_object_t *p_this )
     DEL_CB( order );
 #undef DEL_CB
 
+    if( p_sys->b_prescale )
+    {
+        /* Stop the bridges scaling for us */
+        vlc_global_lock( VLC_MOSAIC_MUTEX );
+        bridge_t *p_bridge = GetBridge( p_filter );
+        if( p_bridge != NULL )
+            for( int i = 0; i < p_bridge->i_es_num; i++ )
+                p_bridge->pp_es[i]->i_tile_width = 0;
+        vlc_global_unlock( VLC_MOSAIC_MUTEX );
+    }
+
     if( !p_sys->b_keep )
     {
         image_HandlerDelete( p_sys->p_image );
@@ -425,6 +451,35 @@ static void DestroyFilter( vlc_object_t *p_this )
     free( p_sys );
 }
 
+/*****************************************************************************
+ * ReportStats: log and reset the statistics of each element
+ *****************************************************************************
+ * Must be called with VLC_MOSAIC_MUTEX held.
+ *****************************************************************************/
+static void ReportStats( filter_t *p_filter, bridge_t *p_bridge )
+{
+    for( int i_index = 0; i_index < p_bridge->i_es_num; i_index++ )
+    {
+        bridged_es_t *p_es = p_bridge->pp_es[i_index];
+
+        if( p_es->b_empty )
+            continue;
+
+        msg_Dbg( p_filter, "element %s: %u composed (%u scaled here, "
+                 "lateness avg %"PRId64" max %"PRId64" ms), %u scaled by the "
+                 "bridge (avg %"PRId64" max %"PRId64" us)", p_es->psz_id,
+                 p_es->stats.i_composed, p_es->stats.i_converted,
+                 p_es->stats.i_composed ? MS_FROM_VLC_TICK(
+                    p_es->stats.i_late_total / p_es->stats.i_composed ) : 0,
+                 MS_FROM_VLC_TICK( p_es->stats.i_late_max ),
+                 p_es->stats.i_scaled,
+                 p_es->stats.i_scaled ? US_FROM_VLC_TICK(
+                    p_es->stats.i_scale_total / p_es->stats.i_scaled ) : 0,
+                 US_FROM_VLC_TICK( p_es->stats.i_scale_max ) );
+        memset( &p_es->stats, 0, sizeof (p_es->stats) );
+    }
+}
+
 /*****************************************************************************
  * Filter
  *****************************************************************************/
@@ -587,10 +642,20 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
 
         if ( !p_sys->b_keep )
         {
-            /* Convert the images */
-            fmt_in.i_chroma = p_es->p_picture->format.i_chroma;
-            fmt_in.i_height = p_es->p_picture->format.i_height;
-            fmt_in.i_width = p_es->p_picture->format.i_width;
+            /* Convert the images. The geometry of the element depends on
+             * the format of the bridged pictures before any prescaling. */
+            if( p_sys->b_prescale && p_es->i_src_width && p_es->i_src_height )
+            {
+                fmt_in.i_chroma = p_es->i_src_chroma;
+                fmt_in.i_height = p_es->i_src_height;
+                fmt_in.i_width = p_es->i_src_width;
+            }
+            else
+            {
+                fmt_in.i_chroma = p_es->p_picture->format.i_chroma;
+                fmt_in.i_height = p_es->p_picture->format.i_height;
+                fmt_in.i_width = p_es->p_picture->format.i_width;
+            }
 
             if( fmt_in.i_chroma == VLC_CODEC_YUVA ||
                 fmt_in.i_chroma == VLC_CODEC_RGBA )
@@ -618,19 +683,43 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             fmt_out.i_visible_width = fmt_out.i_width;
             fmt_out.i_visible_height = fmt_out.i_height;
 
-            p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
-                                         &fmt_in, &fmt_out );
-            if( !p_converted )
+            if( p_sys->b_prescale )
+            {
+                /* Request the geometry for the next pictures */
+                p_es->i_tile_chroma = fmt_out.i_chroma;
+                p_es->i_tile_width = fmt_out.i_width;
+                p_es->i_tile_height = fmt_out.i_height;
+            }
+
+            if( p_es->p_picture->format.i_chroma == fmt_out.i_chroma
+             && p_es->p_picture->format.i_width == fmt_out.i_width
+             && p_es->p_picture->format.i_height == fmt_out.i_height )
             {
-                msg_Warn( p_filter,
-                           "image resizing and chroma conversion failed" );
-                video_format_Clean( &fmt_in );
-                video_format_Clean( &fmt_out );
-                continue;
+                /* Already scaled by the bridge */
+                p_converted = picture_Hold( p_es->p_picture );
+            }
+            else
+            {
+                fmt_in.i_chroma = p_es->p_picture->format.i_chroma;
+                fmt_in.i_height = p_es->p_picture->format.i_height;
+                fmt_in.i_width = p_es->p_picture->format.i_width;
+
+                p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
+                                             &fmt_in, &fmt_out );
+                if( !p_converted )
+                {
+                    msg_Warn( p_filter,
+                               "image resizing and chroma conversion failed" );
+                    video_format_Clean( &fmt_in );
+                    video_format_Clean( &fmt_out );
+                    continue;
+                }
+                p_es->stats.i_converted++;
             }
         }
         else
         {
+            p_es->i_tile_width = 0;
             p_converted = p_es->p_picture;
             fmt_in.i_width = fmt_out.i_width = p_converted->format.i_width;
             fmt_in.i_height = fmt_out.i_height = p_converted->format.i_height;
@@ -640,11 +729,21 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
         }
 
         p_region = subpicture_region_New( &fmt_out );
+        if( !p_sys->b_keep )
+        {
+            /* The converted picture is not modified afterwards: hand it
+             * over to the region rather than copying it */
+            if( p_region )
+            {
+                picture_Release( p_region->p_picture );
+                p_region->p_picture = p_converted;
+            }
+            else
+                picture_Release( p_converted );
+        }
         /* FIXME the copy is probably not needed anymore */
-        if( p_region )
+        else if( p_region )
             picture_Copy( p_region->p_picture, p_converted );
-        if( !p_sys->b_keep )
-            picture_Release( p_converted );
 
         if( !p_region )
         {
@@ -708,6 +807,14 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
         p_region->i_align = p_sys->i_align;
         p_region->i_alpha = p_es->i_alpha;
 
+        vlc_tick_t i_late = date - p_es->p_picture->date - p_sys->i_delay;
+        if( i_late < 0 )
+            i_late = 0;
+        p_es->stats.i_composed++;
+        p_es->stats.i_late_total += i_late;
+        if( i_late > p_es->stats.i_late_max )
+            p_es->stats.i_late_max = i_late;
+
         if( p_region_prev == NULL )
         {
             p_spu->p_region = p_region;
@@ -723,6 +830,13 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
         p_region_prev = p_region;
     }
 
+    vlc_tick_t now = vlc_tick_now();
+    if( now - p_sys->i_stats_date >= STATS_PERIOD )
+    {
+        ReportStats( p_filter, p_bridge );
+        p_sys->i_stats_date = now;
+    }
+
     vlc_global_unlock( VLC_MOSAIC_MUTEX );
     vlc_mutex_unlock( &p_sys->lock );
 
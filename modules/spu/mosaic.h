@@ -32,6 +32,29 @@ typedef struct bridged_es_t
     int i_alpha;
     int i_x;
     int i_y;
+
+    /* Tile format requested by the mosaic when prescaling, set by the
+     * mosaic; a zero width means the bridge shall not prescale */
+    vlc_fourcc_t i_tile_chroma;
+    unsigned i_tile_width;
+    unsigned i_tile_height;
+
+    /* Format of the pictures before prescaling, set by the bridge */
+    vlc_fourcc_t i_src_chroma;
+    unsigned i_src_width;
+    unsigned i_src_height;
+
+    /* Per tile statistics, reset by the mosaic when reported */
+    struct
+    {
+        unsigned i_scaled;        /* pictures scaled by the bridge */
+        vlc_tick_t i_scale_total; /* time spent scaling by the bridge */
+        vlc_tick_t i_scale_max;
+        unsigned i_composed;      /* tiles composed by the mosaic */
+        unsigned i_converted;     /* tiles scaled by the mosaic */
+        vlc_tick_t i_late_total;  /* lateness of the composed pictures */
+        vlc_tick_t i_late_max;
+    } stats;
 } bridged_es_t;
 
 typedef struct bridge_t
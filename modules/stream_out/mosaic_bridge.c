@@ -51,6 +51,7 @@ typedef struct
 
     decoder_t       *p_decoder;
     image_handler_t *p_image; /* filter for resizing */
+    image_handler_t *p_tile_image; /* filter for prescaling to the tile */
     int i_height, i_width;
     unsigned int i_sar_num, i_sar_den;
     char *psz_id;
@@ -366,6 +367,12 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     p_es->pp_last = &p_es->p_picture;
     p_es->b_empty = false;
 
+    p_es->i_tile_chroma = 0;
+    p_es->i_tile_width = p_es->i_tile_height = 0;
+    p_es->i_src_chroma = 0;
+    p_es->i_src_width = p_es->i_src_height = 0;
+    memset( &p_es->stats, 0, sizeof (p_es->stats) );
+
     vlc_global_unlock( VLC_MOSAIC_MUTEX );
 
     if ( p_sys->i_height || p_sys->i_width )
@@ -376,6 +383,7 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     {
         p_sys->p_image = NULL;
     }
+    p_sys->p_tile_image = NULL;
 
     msg_Dbg( p_stream, "mosaic bridge id=%s pos=%d", p_es->psz_id, i );
 
@@ -473,6 +481,8 @@ static void Del( sout_stream_t *p_stream, void *id )
     {
         image_HandlerDelete( p_sys->p_image );
     }
+    if ( p_sys->p_tile_image )
+        image_HandlerDelete( p_sys->p_tile_image );
 
     p_sys->b_inited = false;
 }
@@ -548,10 +558,62 @@ static void decoder_queue_video( decoder_t *p_dec, picture_t *p_pic )
 
     if( p_sys->p_vf2 )
         p_new_pic = filter_chain_VideoFilter( p_sys->p_vf2, p_new_pic );
+    if( p_new_pic == NULL )
+        return;
 
-    /* push the picture in the mosaic-struct structure */
     bridged_es_t *p_es = p_sys->p_es;
+    vlc_fourcc_t i_src_chroma = p_new_pic->format.i_chroma;
+    unsigned i_src_width = p_new_pic->format.i_width;
+    unsigned i_src_height = p_new_pic->format.i_height;
+    vlc_tick_t i_scale_time = 0;
+    bool b_scaled = false;
+
     vlc_global_lock( VLC_MOSAIC_MUTEX );
+    video_format_t fmt_tile;
+    video_format_Init( &fmt_tile, p_es->i_tile_chroma );
+    fmt_tile.i_width = fmt_tile.i_visible_width = p_es->i_tile_width;
+    fmt_tile.i_height = fmt_tile.i_visible_height = p_es->i_tile_height;
+    vlc_global_unlock( VLC_MOSAIC_MUTEX );
+
+    /* Scale the picture to its tile here, in the thread of this input,
+     * rather than in the video output thread of the mosaic. This only
+     * works for the geometry published for the previous pictures. */
+    if( fmt_tile.i_width && fmt_tile.i_height &&
+        ( fmt_tile.i_chroma != i_src_chroma ||
+          fmt_tile.i_width != i_src_width ||
+          fmt_tile.i_height != i_src_height ) )
+    {
+        if( p_sys->p_tile_image == NULL )
+            p_sys->p_tile_image = image_HandlerCreate( p_stream );
+        if( p_sys->p_tile_image != NULL )
+        {
+            vlc_tick_t i_start = vlc_tick_now();
+            picture_t *p_tile = image_Convert( p_sys->p_tile_image, p_new_pic,
+                                               &p_new_pic->format,
+                                               &fmt_tile );
+            if( p_tile != NULL )
+            {
+                i_scale_time = vlc_tick_now() - i_start;
+                b_scaled = true;
+                picture_Release( p_new_pic );
+                p_new_pic = p_tile;
+            }
+        }
+    }
+    video_format_Clean( &fmt_tile );
+
+    /* push the picture in the mosaic-struct structure */
+    vlc_global_lock( VLC_MOSAIC_MUTEX );
+    p_es->i_src_chroma = i_src_chroma;
+    p_es->i_src_width = i_src_width;
+    p_es->i_src_height = i_src_height;
+    if( b_scaled )
+    {
+        p_es->stats.i_scaled++;
+        p_es->stats.i_scale_total += i_scale_time;
+        if( i_scale_time > p_es->stats.i_scale_max )
+            p_es->stats.i_scale_max = i_scale_time;
+    }
     *p_es->pp_last = p_new_pic;
     p_new_pic->p_next = NULL;
     p_es->pp_last = &p_new_pic->p_next;
@@ -79,6 +79,12 @@
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
     "are applied). You can enter a colon-separated list of filters." )
+#define LADDER_TEXT N_("Video ladder")
+#define LADDER_LONGTEXT N_( \
+    "Additional renditions of the video, encoded from the same decoded " \
+    "pictures, as a comma-separated list of WIDTHxHEIGHT@KBPS rungs " \
+    "(eg: 1280x720@3000,640x360@800). Each rung is a new output stream, " \
+    "scaled from the next larger one." )
 
 #define AENC_TEXT N_("Audio encoder")
 #define AENC_LONGTEXT N_( \
@@ -177,6 +183,8 @@ vlc_module_begin ()
                  MAXHEIGHT_LONGTEXT, true )
     add_module_list(SOUT_CFG_PREFIX "vfilter", "video filter", NULL,
                     VFILTER_TEXT, VFILTER_LONGTEXT)
+    add_string( SOUT_CFG_PREFIX "ladder", NULL, LADDER_TEXT,
+                LADDER_LONGTEXT, true )
 
     set_section( N_("Audio"), NULL )
     add_module(SOUT_CFG_PREFIX "aenc", "encoder", NULL,
@@ -224,7 +232,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
-    NULL
+    "ladder", NULL
 };
 
 /*****************************************************************************
@@ -332,6 +340,60 @@ static void SetVideoEncoderConfig( sout_stream_t *p_stream, transcode_encoder_co
         p_cfg->video.threads.i_priority = VLC_THREAD_PRIORITY_VIDEO;
 }
 
+static int CompareRungs( const void *a, const void *b )
+{
+    const transcode_encoder_config_t *p_a = a, *p_b = b;
+    uint64_t i_a = (uint64_t)p_a->video.i_width * p_a->video.i_height;
+    uint64_t i_b = (uint64_t)p_b->video.i_width * p_b->video.i_height;
+    return (i_a < i_b) - (i_a > i_b);
+}
+
+static void SetVideoLadderConfig( sout_stream_t *p_stream, sout_stream_sys_t *p_sys )
+{
+    char *psz_ladder = var_GetNonEmptyString( p_stream, SOUT_CFG_PREFIX "ladder" );
+    if( !psz_ladder )
+        return;
+
+    char *psz_save;
+    for( char *psz_rung = strtok_r( psz_ladder, ",", &psz_save );
+         psz_rung != NULL; psz_rung = strtok_r( NULL, ",", &psz_save ) )
+    {
+        /* Signed, so that negative values are not read modulo 2^32 */
+        int i_width, i_height, i_kbps = 0;
+        if( sscanf( psz_rung, "%dx%d@%d", &i_width, &i_height, &i_kbps ) < 2 ||
+            i_width < 16 || i_height < 16 || i_kbps < 0 )
+        {
+            msg_Warn( p_stream, "ignoring invalid ladder rung `%s'", psz_rung );
+            continue;
+        }
+
+        transcode_encoder_config_t *p_rungs =
+            realloc( p_sys->p_ladder, (p_sys->i_ladder + 1) * sizeof(*p_rungs) );
+        if( !p_rungs )
+            break;
+        p_sys->p_ladder = p_rungs;
+
+        /* Same encoder and options as the main output, at another size */
+        transcode_encoder_config_t *p_cfg = &p_rungs[p_sys->i_ladder++];
+        *p_cfg = p_sys->venc_cfg;
+        p_cfg->video.f_scale = 0.f;
+        p_cfg->video.i_width = i_width;
+        p_cfg->video.i_height = i_height;
+        p_cfg->video.i_maxwidth = p_cfg->video.i_maxheight = 0;
+        if( i_kbps )
+            p_cfg->video.i_bitrate = i_kbps * 1000;
+
+        msg_Dbg( p_stream, "ladder rung %dx%d %ukb/s", i_width, i_height,
+                 p_cfg->video.i_bitrate / 1000 );
+    }
+    free( psz_ladder );
+
+    /* Largest first: each rung is scaled from the previous one */
+    if( p_sys->i_ladder > 1 )
+        qsort( p_sys->p_ladder, p_sys->i_ladder, sizeof(*p_sys->p_ladder),
+               CompareRungs );
+}
+
 static void SetSPUEncoderConfig( sout_stream_t *p_stream, transcode_encoder_config_t *p_cfg )
 {
     char *psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "senc" );
@@ -424,6 +486,7 @@ static int Open( vlc_object_t *p_this )
                  p_sys->venc_cfg.video.i_height,
                  p_sys->venc_cfg.video.f_scale,
                  p_sys->venc_cfg.video.i_bitrate / 1000 );
+        SetVideoLadderConfig( p_stream, p_sys );
     }
 
     /* Video Filter Parameters */
@@ -486,6 +549,8 @@ static void Close( vlc_object_t * p_this )
     sout_stream_t       *p_stream = (sout_stream_t*)p_this;
     sout_stream_sys_t   *p_sys = p_stream->p_sys;
 
+    /* The ladder rungs share the strings of the video encoder config */
+    free( p_sys->p_ladder );
     transcode_encoder_config_clean( &p_sys->venc_cfg );
     sout_filters_config_clean( &p_sys->vfilters_cfg );
 
@@ -624,6 +689,8 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
         case VIDEO_ES:
             id->p_filterscfg = &p_sys->vfilters_cfg;
             id->p_enccfg = &p_sys->venc_cfg;
+            id->p_laddercfg = p_sys->p_ladder;
+            id->i_ladder = p_sys->i_ladder;
             break;
         case SPU_ES:
             id->p_filterscfg = NULL;
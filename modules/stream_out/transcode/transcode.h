@@ -52,6 +52,8 @@ typedef struct
     /* Video */
     transcode_encoder_config_t venc_cfg;
     sout_filters_config_t vfilters_cfg;
+    transcode_encoder_config_t *p_ladder; /**< Rungs, largest first */
+    size_t          i_ladder;
 
     /* SPU */
     transcode_encoder_config_t senc_cfg;
@@ -68,6 +70,17 @@ typedef struct
 
 struct aout_filters;
 
+/* Additional rendition of a transcoded video stream */
+typedef struct
+{
+    const transcode_encoder_config_t *p_enccfg;
+    transcode_encoder_t *encoder;
+    filter_chain_t      *p_conv; /**< Scaler from the next larger rendition */
+    video_format_t       fmt_src; /**< Input format of the scaler */
+    void                *downstream_id;
+    bool                 b_error;
+} transcode_rung_t;
+
 struct sout_stream_id_sys_t
 {
     bool            b_transcode;
@@ -129,6 +142,10 @@ struct sout_stream_id_sys_t
              vlc_blender_t   *p_spu_blender;
              spu_t           *p_spu;
              video_format_t  fmt_input_video;
+             const transcode_encoder_config_t *p_laddercfg;
+             size_t          i_ladder;
+             transcode_rung_t *p_rungs; /**< Ladder renditions */
+             size_t          i_rungs;
          };
          struct
          {
@@ -147,6 +147,77 @@ static picture_t *transcode_dequeue_all_pics( sout_stream_id_sys_t *id )
     return p_pics;
 }
 
+/*
+ * Ladder: additional renditions encoded from the same decoded pictures.
+ * The rungs are sorted largest first, and each one is scaled from the
+ * picture of the previous rung, or from the main output for the first one.
+ * If a rung cannot provide its picture, the next one is scaled from the
+ * larger picture it gets instead.
+ */
+static void transcode_video_ladder_clean( sout_stream_t *p_stream,
+                                          sout_stream_id_sys_t *id )
+{
+    for( size_t i = 0; i < id->i_rungs; i++ )
+    {
+        transcode_rung_t *p_rung = &id->p_rungs[i];
+
+        transcode_encoder_close( p_rung->encoder );
+        transcode_encoder_delete( p_rung->encoder );
+        transcode_remove_filters( &p_rung->p_conv );
+        video_format_Clean( &p_rung->fmt_src );
+        if( p_rung->downstream_id )
+            sout_StreamIdDel( p_stream->p_next, p_rung->downstream_id );
+    }
+    free( id->p_rungs );
+    id->p_rungs = NULL;
+    id->i_rungs = 0;
+}
+
+static int transcode_video_ladder_init( sout_stream_t *p_stream,
+                                        sout_stream_id_sys_t *id )
+{
+    id->p_rungs = NULL;
+    id->i_rungs = 0;
+    if( id->i_ladder == 0 )
+        return VLC_SUCCESS;
+
+    id->p_rungs = vlc_alloc( id->i_ladder, sizeof(*id->p_rungs) );
+    if( !id->p_rungs )
+        return VLC_ENOMEM;
+
+    for( size_t i = 0; i < id->i_ladder; i++ )
+    {
+        transcode_rung_t *p_rung = &id->p_rungs[i];
+        es_format_t fmt;
+
+        es_format_Init( &fmt, VIDEO_ES, 0 );
+        p_rung->p_enccfg = &id->p_laddercfg[i];
+        p_rung->p_conv = NULL;
+        video_format_Init( &p_rung->fmt_src, 0 );
+        p_rung->downstream_id = NULL;
+        p_rung->b_error = false;
+        p_rung->encoder = NULL;
+
+        if( transcode_encoder_test( VLC_OBJECT(p_stream), p_rung->p_enccfg,
+                                    &id->p_decoder->fmt_in,
+                                    id->p_decoder->fmt_out.i_codec,
+                                    &fmt ) == VLC_SUCCESS )
+            p_rung->encoder = transcode_encoder_new( VLC_OBJECT(p_stream), &fmt );
+        if( p_rung->encoder )
+            transcode_encoder_update_format_in( p_rung->encoder, &fmt );
+        es_format_Clean( &fmt );
+
+        if( !p_rung->encoder )
+        {
+            transcode_video_ladder_clean( p_stream, id );
+            return VLC_EGENERIC;
+        }
+        id->i_rungs++;
+    }
+
+    return VLC_SUCCESS;
+}
+
 int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
                           sout_stream_id_sys_t *id )
 {
@@ -232,6 +303,16 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
 
     es_format_Clean( &encoder_tested_fmt_in );
 
+    if( transcode_video_ladder_init( p_stream, id ) != VLC_SUCCESS )
+    {
+        transcode_encoder_delete( id->encoder );
+        module_unneed( id->p_decoder, id->p_decoder->p_module );
+        id->p_decoder->p_module = NULL;
+        video_format_Clean( &id->fmt_input_video );
+        es_format_Clean( &id->decoder_out );
+        return VLC_EGENERIC;
+    }
+
     return VLC_SUCCESS;
 }
 
@@ -374,11 +455,10 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
 void transcode_video_clean( sout_stream_t *p_stream,
                                    sout_stream_id_sys_t *id )
 {
-    VLC_UNUSED(p_stream);
-
-    /* Close encoder */
+    /* Close encoders */
     transcode_encoder_close( id->encoder );
     transcode_encoder_delete( id->encoder );
+    transcode_video_ladder_clean( p_stream, id );
 
     video_format_Clean( &id->fmt_input_video );
     es_format_Clean( &id->decoder_out );
@@ -486,6 +566,179 @@ static void tag_last_block_with_flag( block_t **out, int i_flag )
     }
 }
 
+static void transcode_video_rung_send( sout_stream_t *p_stream,
+                                       transcode_rung_t *p_rung,
+                                       block_t *p_out )
+{
+    if( !p_out )
+        return;
+    if( p_rung->b_error || !p_rung->downstream_id )
+        block_ChainRelease( p_out );
+    else if( sout_StreamIdSend( p_stream->p_next, p_rung->downstream_id, p_out ) )
+        p_rung->b_error = true;
+}
+
+/* (Re)creates the scaler from the picture format the rung gets */
+static int transcode_video_rung_scaler( sout_stream_t *p_stream,
+                                        sout_stream_id_sys_t *id,
+                                        transcode_rung_t *p_rung,
+                                        const video_format_t *p_src )
+{
+    const es_format_t *p_dst = transcode_encoder_format_in( p_rung->encoder );
+    es_format_t src;
+    es_format_Init( &src, VIDEO_ES, p_src->i_chroma );
+    src.video = *p_src;
+
+    transcode_remove_filters( &p_rung->p_conv );
+    video_format_Clean( &p_rung->fmt_src );
+
+    if( src.video.i_width != p_dst->video.i_width ||
+        src.video.i_height != p_dst->video.i_height ||
+        src.video.i_chroma != p_dst->video.i_chroma )
+    {
+        filter_owner_t owner = {
+            .video = &transcode_filter_video_cbs,
+            .sys = id,
+        };
+        p_rung->p_conv = filter_chain_NewVideo( p_stream, false, &owner );
+        if( !p_rung->p_conv )
+            return VLC_EGENERIC;
+        filter_chain_Reset( p_rung->p_conv, &src, p_dst );
+        if( filter_chain_AppendConverter( p_rung->p_conv, &src, p_dst ) != VLC_SUCCESS )
+        {
+            transcode_remove_filters( &p_rung->p_conv );
+            return VLC_EGENERIC;
+        }
+    }
+
+    /* The scaler is usable from this format only */
+    video_format_Copy( &p_rung->fmt_src, p_src );
+    return VLC_SUCCESS;
+}
+
+static int transcode_video_rung_open( sout_stream_t *p_stream,
+                                      sout_stream_id_sys_t *id,
+                                      transcode_rung_t *p_rung,
+                                      const video_format_t *p_src )
+{
+    transcode_encoder_video_configure( VLC_OBJECT(p_stream),
+                                       &id->p_decoder->fmt_out.video,
+                                       p_rung->p_enccfg, p_src,
+                                       p_rung->encoder );
+
+    /* Scaler, from the next larger rendition */
+    if( transcode_video_rung_scaler( p_stream, id, p_rung, p_src ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+
+    const es_format_t *p_dst = transcode_encoder_format_in( p_rung->encoder );
+    if( transcode_encoder_open( p_rung->encoder, p_rung->p_enccfg ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+
+    if( !p_rung->downstream_id )
+    {
+        /* A new elementary stream, in the group of the input one */
+        es_format_t fmt;
+        es_format_Init( &fmt, VIDEO_ES, 0 );
+        es_format_Copy( &fmt, transcode_encoder_format_out( p_rung->encoder ) );
+        es_format_SetMeta( &fmt, &id->p_decoder->fmt_in );
+        fmt.i_id = -1;
+
+        p_rung->downstream_id = sout_StreamIdAdd( p_stream->p_next, &fmt );
+        es_format_Clean( &fmt );
+        if( !p_rung->downstream_id )
+            return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_stream, "ladder rendition %ux%u",
+             p_dst->video.i_visible_width, p_dst->video.i_visible_height );
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_ladder_encode( sout_stream_t *p_stream,
+                                           sout_stream_id_sys_t *id,
+                                           picture_t *p_pic )
+{
+    /* Shared by reference: the encoders hold what they keep */
+    picture_t *p_src = picture_Hold( p_pic );
+
+    for( size_t i = 0; i < id->i_rungs; i++ )
+    {
+        transcode_rung_t *p_rung = &id->p_rungs[i];
+
+        if( !p_rung->b_error && !transcode_encoder_opened( p_rung->encoder ) &&
+            transcode_video_rung_open( p_stream, id, p_rung,
+                                       &p_src->format ) != VLC_SUCCESS )
+        {
+            msg_Err( p_stream, "cannot output ladder rendition %ux%u",
+                     p_rung->p_enccfg->video.i_width,
+                     p_rung->p_enccfg->video.i_height );
+            p_rung->b_error = true;
+        }
+
+        /* A larger rung could not scale its picture: use the one we got */
+        if( p_rung->fmt_src.i_chroma != 0 &&
+            !video_format_IsSimilar( &p_rung->fmt_src, &p_src->format ) &&
+            transcode_video_rung_scaler( p_stream, id, p_rung,
+                                         &p_src->format ) != VLC_SUCCESS )
+        {
+            msg_Err( p_stream, "cannot scale ladder rendition %ux%u",
+                     p_rung->p_enccfg->video.i_width,
+                     p_rung->p_enccfg->video.i_height );
+            p_rung->b_error = true;
+        }
+
+        /* Without a scaler, the next rung gets the larger picture */
+        if( p_rung->fmt_src.i_chroma == 0 )
+            continue;
+
+        picture_t *p_scaled = picture_Hold( p_src );
+        if( p_rung->p_conv )
+            p_scaled = filter_chain_VideoFilter( p_rung->p_conv, p_scaled );
+        if( !p_scaled )
+            continue;
+
+        /* Even when its output is disabled, the rung still scales the
+         * picture of the next one */
+        if( !p_rung->b_error )
+            transcode_video_rung_send( p_stream, p_rung,
+                                       transcode_encoder_encode( p_rung->encoder,
+                                                                 p_scaled ) );
+
+        /* The next rung is scaled from this one */
+        picture_Release( p_src );
+        p_src = p_scaled;
+    }
+
+    picture_Release( p_src );
+}
+
+static void transcode_video_ladder_output( sout_stream_t *p_stream,
+                                           sout_stream_id_sys_t *id,
+                                           bool b_drain, bool b_eos )
+{
+    for( size_t i = 0; i < id->i_rungs; i++ )
+    {
+        transcode_rung_t *p_rung = &id->p_rungs[i];
+        block_t *p_out = NULL;
+
+        if( !transcode_encoder_opened( p_rung->encoder ) )
+            continue;
+
+        if( b_drain )
+            transcode_encoder_drain( p_rung->encoder, &p_out );
+        else if( p_rung->p_enccfg->video.threads.i_count >= 1 )
+            p_out = transcode_encoder_get_output_async( p_rung->encoder );
+
+        if( b_eos )
+        {
+            transcode_encoder_close( p_rung->encoder );
+            tag_last_block_with_flag( &p_out, BLOCK_FLAG_END_OF_SEQUENCE );
+        }
+
+        transcode_video_rung_send( p_stream, p_rung, p_out );
+    }
+}
+
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                     block_t *in, block_t **out )
 {
@@ -633,6 +886,7 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                     block_t *p_encoded = transcode_encoder_encode( id->encoder, p_in );
                     if( p_encoded )
                         block_ChainAppend( out, p_encoded );
+                    transcode_video_ladder_encode( p_stream, id, p_in );
                     picture_Release( p_in );
                 }
             }
@@ -646,6 +900,7 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             transcode_encoder_close( id->encoder );
             if( b_eos )
                 tag_last_block_with_flag( out, BLOCK_FLAG_END_OF_SEQUENCE );
+            transcode_video_ladder_output( p_stream, id, true, true );
         }
 
         continue;
@@ -660,6 +915,7 @@ error:
         /* Pick up any return data the encoder thread wants to output. */
         block_ChainAppend( out, transcode_encoder_get_output_async( id->encoder ) );
     }
+    transcode_video_ladder_output( p_stream, id, false, false );
 
     /* Drain encoder */
     if( unlikely( !id->b_error && in == NULL ) && transcode_encoder_opened( id->encoder ) )
@@ -670,6 +926,8 @@ error:
         else
             msg_Warn( p_stream, "Flushing failed");
     }
+    if( in == NULL )
+        transcode_video_ladder_output( p_stream, id, true, false );
 
     if( b_eos )
         tag_last_block_with_flag( out, BLOCK_FLAG_END_OF_SEQUENCE );
@@ -37,6 +37,14 @@
 
 #include <libswscale/swscale.h>
 #include <libswscale/version.h>
+#include <libavutil/avutil.h>
+
+/* Slice threading is only available through the frame based API */
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT( 6, 4, 100 )
+# define SWSCALE_HAS_THREADS 1
+# include <libavutil/frame.h>
+# include <libavutil/opt.h>
+#endif
 
 #ifdef __APPLE__
 # include <TargetConditionals.h>
@@ -57,6 +65,11 @@ static void CloseScaler( vlc_object_t * );
 #define SCALEMODE_TEXT N_("Scaling mode")
 #define SCALEMODE_LONGTEXT N_("Scaling mode to use.")
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_( \
+    "Number of threads used to scale each picture in slices " \
+    "(0 = number of CPUs, 1 = no threading).")
+
 static const int pi_mode_values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 static const char *const ppsz_mode_descriptions[] =
 { N_("Fast bilinear"), N_("Bilinear"), N_("Bicubic (good quality)"),
@@ -73,6 +86,8 @@ vlc_module_begin ()
     set_callbacks( OpenScaler, CloseScaler )
     add_integer( "swscale-mode", 2, SCALEMODE_TEXT, SCALEMODE_LONGTEXT, true )
         change_integer_list( pi_mode_values, ppsz_mode_descriptions )
+    add_integer_with_range( "swscale-threads", 1, 0, 64,
+                            THREADS_TEXT, THREADS_LONGTEXT, true )
 vlc_module_end ()
 
 /* Version checking */
@@ -81,18 +96,22 @@ vlc_module_end ()
  * Local prototypes
  ****************************************************************************/
 
+/* Number of scaler configurations kept alive, so that switching back and
+ * forth between a few formats (adaptive streaming, ...) does not rebuild the
+ * swscale contexts each time. */
+#define SCALER_CACHE_SIZE (4)
+
 /**
- * Internal swscale filter structure.
+ * Scaler state for one input/output format pair.
  */
 typedef struct
 {
-    SwsFilter *p_filter;
-    int i_cpu_mask, i_sws_flags;
-
     video_format_t fmt_in;
     video_format_t fmt_out;
     const vlc_chroma_description_t *desc_in;
     const vlc_chroma_description_t *desc_out;
+    int i_fmti;
+    int i_fmto;
 
     struct SwsContext *ctx;
     struct SwsContext *ctxA;
@@ -105,11 +124,31 @@ typedef struct
     bool b_copy;
     bool b_swap_uvi;
     bool b_swap_uvo;
+
+    unsigned i_last_use;
+} scaler_t;
+
+/**
+ * Internal swscale filter structure.
+ */
+typedef struct
+{
+    SwsFilter *p_filter;
+    int i_cpu_mask, i_sws_flags;
+    int i_threads;
+
+    scaler_t cache[SCALER_CACHE_SIZE];
+    scaler_t *p_scaler; /* current configuration, points into cache */
+    unsigned i_use_count;
+#ifdef SWSCALE_HAS_THREADS
+    AVFrame *p_frame_src;
+    AVFrame *p_frame_dst;
+#endif
 } filter_sys_t;
 
 static picture_t *Filter( filter_t *, picture_t * );
 static int  Init( filter_t * );
-static void Clean( filter_t * );
+static void Clean( scaler_t * );
 
 typedef struct
 {
@@ -179,14 +218,34 @@ static int OpenScaler( vlc_object_t *p_this )
     default: p_sys->i_sws_flags = SWS_BICUBIC; i_sws_mode = 2; break;
     }
 
-    /* Misc init */
-    memset( &p_sys->fmt_in,  0, sizeof(p_sys->fmt_in) );
-    memset( &p_sys->fmt_out, 0, sizeof(p_sys->fmt_out) );
+    p_sys->i_threads = var_InheritInteger( p_filter, "swscale-threads" );
+    if( p_sys->i_threads <= 0 )
+        p_sys->i_threads = vlc_GetCPUCount();
+#ifdef SWSCALE_HAS_THREADS
+    if( p_sys->i_threads > 1 )
+    {
+        p_sys->p_frame_src = av_frame_alloc();
+        p_sys->p_frame_dst = av_frame_alloc();
+        if( !p_sys->p_frame_src || !p_sys->p_frame_dst )
+        {
+            av_frame_free( &p_sys->p_frame_src );
+            av_frame_free( &p_sys->p_frame_dst );
+            free( p_sys );
+            return VLC_ENOMEM;
+        }
+    }
+#else
+    p_sys->i_threads = 1;
+#endif
 
     if( Init( p_filter ) )
     {
         if( p_sys->p_filter )
             sws_freeFilter( p_sys->p_filter );
+#ifdef SWSCALE_HAS_THREADS
+        av_frame_free( &p_sys->p_frame_src );
+        av_frame_free( &p_sys->p_frame_dst );
+#endif
         free( p_sys );
         return VLC_EGENERIC;
     }
@@ -202,6 +261,8 @@ static int OpenScaler( vlc_object_t *p_this )
              p_filter->fmt_out.video.i_width, p_filter->fmt_out.video.i_height,
              (char *)&p_filter->fmt_out.video.i_chroma,
              ppsz_mode_descriptions[i_sws_mode] );
+    if( p_sys->i_threads > 1 )
+        msg_Dbg( p_filter, "using %d slice threads", p_sys->i_threads );
 
     return VLC_SUCCESS;
 }
@@ -214,9 +275,14 @@ static void CloseScaler( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t*)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    Clean( p_filter );
+    for( unsigned i = 0; i < SCALER_CACHE_SIZE; i++ )
+        Clean( &p_sys->cache[i] );
     if( p_sys->p_filter )
         sws_freeFilter( p_sys->p_filter );
+#ifdef SWSCALE_HAS_THREADS
+    av_frame_free( &p_sys->p_frame_src );
+    av_frame_free( &p_sys->p_frame_dst );
+#endif
     free( p_sys );
 }
 
@@ -246,6 +312,12 @@ static int GetSwsCpuMask(void)
     return i_sws_cpu;
 }
 
+static bool IsPlanarA( vlc_fourcc_t i_chroma )
+{
+    return i_chroma != VLC_CODEC_RGBA && i_chroma != VLC_CODEC_BGRA &&
+           i_chroma != VLC_CODEC_ARGB;
+}
+
 static void FixParameters( int *pi_fmt, bool *pb_has_a, bool *pb_swap_uv, vlc_fourcc_t fmt )
 {
     switch( fmt )
@@ -349,6 +421,75 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     return VLC_SUCCESS;
 }
 
+static struct SwsContext *GetContext( filter_sys_t *p_sys,
+                                      int i_src_width, int i_src_height, int i_fmti,
+                                      int i_dst_width, int i_dst_height, int i_fmto,
+                                      int i_sws_flags )
+{
+#ifdef SWSCALE_HAS_THREADS
+    if( p_sys->i_threads > 1 )
+    {
+        struct SwsContext *ctx = sws_alloc_context();
+        if( !ctx )
+            return NULL;
+
+        av_opt_set_int( ctx, "srcw", i_src_width, 0 );
+        av_opt_set_int( ctx, "srch", i_src_height, 0 );
+        av_opt_set_int( ctx, "src_format", i_fmti, 0 );
+        av_opt_set_int( ctx, "dstw", i_dst_width, 0 );
+        av_opt_set_int( ctx, "dsth", i_dst_height, 0 );
+        av_opt_set_int( ctx, "dst_format", i_fmto, 0 );
+        av_opt_set_int( ctx, "sws_flags", i_sws_flags, 0 );
+        av_opt_set_int( ctx, "threads", p_sys->i_threads, 0 );
+
+        if( sws_init_context( ctx, p_sys->p_filter, NULL ) < 0 )
+        {
+            sws_freeContext( ctx );
+            return NULL;
+        }
+        return ctx;
+    }
+#endif
+    return sws_getContext( i_src_width, i_src_height, i_fmti,
+                           i_dst_width, i_dst_height, i_fmto,
+                           i_sws_flags, p_sys->p_filter, NULL, 0 );
+}
+
+static scaler_t *GetCachedScaler( filter_sys_t *p_sys,
+                                  const video_format_t *p_fmti,
+                                  const video_format_t *p_fmto )
+{
+    for( unsigned i = 0; i < SCALER_CACHE_SIZE; i++ )
+    {
+        scaler_t *p_scaler = &p_sys->cache[i];
+
+        if( p_scaler->ctx &&
+            video_format_IsSimilar( p_fmti, &p_scaler->fmt_in ) &&
+            video_format_IsSimilar( p_fmto, &p_scaler->fmt_out ) )
+            return p_scaler;
+    }
+    return NULL;
+}
+
+static scaler_t *GetFreeScaler( filter_sys_t *p_sys )
+{
+    scaler_t *p_oldest = &p_sys->cache[0];
+
+    for( unsigned i = 0; i < SCALER_CACHE_SIZE; i++ )
+    {
+        scaler_t *p_scaler = &p_sys->cache[i];
+
+        if( !p_scaler->ctx )
+            return p_scaler;
+        if( p_scaler->i_last_use < p_oldest->i_last_use )
+            p_oldest = p_scaler;
+    }
+
+    /* Evict the least recently used configuration */
+    Clean( p_oldest );
+    return p_oldest;
+}
+
 static int Init( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -358,14 +499,21 @@ static int Init( filter_t *p_filter )
     if( p_fmti->orientation != p_fmto->orientation )
         return VLC_EGENERIC;
 
-    if( video_format_IsSimilar( p_fmti, &p_sys->fmt_in ) &&
-        video_format_IsSimilar( p_fmto, &p_sys->fmt_out ) &&
-        p_sys->ctx )
+    scaler_t *p_scaler = p_sys->p_scaler;
+    if( p_scaler &&
+        video_format_IsSimilar( p_fmti, &p_scaler->fmt_in ) &&
+        video_format_IsSimilar( p_fmto, &p_scaler->fmt_out ) )
     {
         return VLC_SUCCESS;
     }
 
-    Clean( p_filter );
+    p_scaler = GetCachedScaler( p_sys, p_fmti, p_fmto );
+    if( p_scaler )
+    {
+        p_scaler->i_last_use = ++p_sys->i_use_count;
+        p_sys->p_scaler = p_scaler;
+        return VLC_SUCCESS;
+    }
 
     /* Init with new parameters */
     ScalerConfiguration cfg;
@@ -385,55 +533,69 @@ static int Init( filter_t *p_filter )
         return VLC_EGENERIC;
     }
 
-    p_sys->desc_in = vlc_fourcc_GetChromaDescription( p_fmti->i_chroma );
-    p_sys->desc_out = vlc_fourcc_GetChromaDescription( p_fmto->i_chroma );
-    if( p_sys->desc_in == NULL || p_sys->desc_out == NULL )
+    const vlc_chroma_description_t *desc_in =
+        vlc_fourcc_GetChromaDescription( p_fmti->i_chroma );
+    const vlc_chroma_description_t *desc_out =
+        vlc_fourcc_GetChromaDescription( p_fmto->i_chroma );
+    if( desc_in == NULL || desc_out == NULL )
         return VLC_EGENERIC;
 
+    p_scaler = GetFreeScaler( p_sys );
+    if( p_sys->p_scaler == p_scaler )
+        p_sys->p_scaler = NULL;
+    p_scaler->desc_in = desc_in;
+    p_scaler->desc_out = desc_out;
+
     /* swscale does not like too small width */
-    p_sys->i_extend_factor = 1;
-    while( __MIN( p_fmti->i_visible_width, p_fmto->i_visible_width ) * p_sys->i_extend_factor < MINIMUM_WIDTH)
-        p_sys->i_extend_factor++;
+    p_scaler->i_extend_factor = 1;
+    while( __MIN( p_fmti->i_visible_width, p_fmto->i_visible_width ) * p_scaler->i_extend_factor < MINIMUM_WIDTH)
+        p_scaler->i_extend_factor++;
 
-    const unsigned i_fmti_visible_width = p_fmti->i_visible_width * p_sys->i_extend_factor;
-    const unsigned i_fmto_visible_width = p_fmto->i_visible_width * p_sys->i_extend_factor;
+    const unsigned i_fmti_visible_width = p_fmti->i_visible_width * p_scaler->i_extend_factor;
+    const unsigned i_fmto_visible_width = p_fmto->i_visible_width * p_scaler->i_extend_factor;
     for( int n = 0; n < (cfg.b_has_a ? 2 : 1); n++ )
     {
         const int i_fmti = n == 0 ? cfg.i_fmti : AV_PIX_FMT_GRAY8;
         const int i_fmto = n == 0 ? cfg.i_fmto : AV_PIX_FMT_GRAY8;
         struct SwsContext *ctx;
 
-        ctx = sws_getContext( i_fmti_visible_width, p_fmti->i_visible_height, i_fmti,
-                              i_fmto_visible_width, p_fmto->i_visible_height, i_fmto,
-                              cfg.i_sws_flags | p_sys->i_cpu_mask,
-                              p_sys->p_filter, NULL, 0 );
+        ctx = GetContext( p_sys,
+                          i_fmti_visible_width, p_fmti->i_visible_height, i_fmti,
+                          i_fmto_visible_width, p_fmto->i_visible_height, i_fmto,
+                          cfg.i_sws_flags | p_sys->i_cpu_mask );
         if( n == 0 )
-            p_sys->ctx = ctx;
+            p_scaler->ctx = ctx;
         else
-            p_sys->ctxA = ctx;
+            p_scaler->ctxA = ctx;
     }
-    if( p_sys->ctxA )
+    /* Planar alpha is scaled in place, packed alpha goes through grey
+     * intermediate pictures */
+    const bool b_packed_a = !IsPlanarA( p_fmti->i_chroma ) ||
+                            !IsPlanarA( p_fmto->i_chroma );
+    if( p_scaler->ctxA && ( b_packed_a || p_scaler->i_extend_factor != 1 ) )
     {
-        p_sys->p_src_a = picture_New( VLC_CODEC_GREY, i_fmti_visible_width, p_fmti->i_visible_height, 0, 1 );
-        p_sys->p_dst_a = picture_New( VLC_CODEC_GREY, i_fmto_visible_width, p_fmto->i_visible_height, 0, 1 );
+        p_scaler->p_src_a = picture_New( VLC_CODEC_GREY, i_fmti_visible_width, p_fmti->i_visible_height, 0, 1 );
+        p_scaler->p_dst_a = picture_New( VLC_CODEC_GREY, i_fmto_visible_width, p_fmto->i_visible_height, 0, 1 );
     }
-    if( p_sys->i_extend_factor != 1 )
+    if( p_scaler->i_extend_factor != 1 )
     {
-        p_sys->p_src_e = picture_New( p_fmti->i_chroma, i_fmti_visible_width, p_fmti->i_visible_height, 0, 1 );
-        p_sys->p_dst_e = picture_New( p_fmto->i_chroma, i_fmto_visible_width, p_fmto->i_visible_height, 0, 1 );
+        p_scaler->p_src_e = picture_New( p_fmti->i_chroma, i_fmti_visible_width, p_fmti->i_visible_height, 0, 1 );
+        p_scaler->p_dst_e = picture_New( p_fmto->i_chroma, i_fmto_visible_width, p_fmto->i_visible_height, 0, 1 );
 
-        if( p_sys->p_src_e )
-            memset( p_sys->p_src_e->p[0].p_pixels, 0, p_sys->p_src_e->p[0].i_pitch * p_sys->p_src_e->p[0].i_lines );
-        if( p_sys->p_dst_e )
-            memset( p_sys->p_dst_e->p[0].p_pixels, 0, p_sys->p_dst_e->p[0].i_pitch * p_sys->p_dst_e->p[0].i_lines );
+        if( p_scaler->p_src_e )
+            memset( p_scaler->p_src_e->p[0].p_pixels, 0, p_scaler->p_src_e->p[0].i_pitch * p_scaler->p_src_e->p[0].i_lines );
+        if( p_scaler->p_dst_e )
+            memset( p_scaler->p_dst_e->p[0].p_pixels, 0, p_scaler->p_dst_e->p[0].i_pitch * p_scaler->p_dst_e->p[0].i_lines );
     }
 
-    if( !p_sys->ctx ||
-        ( cfg.b_has_a && ( !p_sys->ctxA || !p_sys->p_src_a || !p_sys->p_dst_a ) ) ||
-        ( p_sys->i_extend_factor != 1 && ( !p_sys->p_src_e || !p_sys->p_dst_e ) ) )
+    if( !p_scaler->ctx ||
+        ( cfg.b_has_a && ( !p_scaler->ctxA ||
+          ( ( b_packed_a || p_scaler->i_extend_factor != 1 ) &&
+            ( !p_scaler->p_src_a || !p_scaler->p_dst_a ) ) ) ) ||
+        ( p_scaler->i_extend_factor != 1 && ( !p_scaler->p_src_e || !p_scaler->p_dst_e ) ) )
     {
         msg_Err( p_filter, "could not init SwScaler and/or allocate memory" );
-        Clean( p_filter );
+        Clean( p_scaler );
         return VLC_EGENERIC;
     }
 
@@ -457,43 +619,45 @@ static int Init( filter_t *p_filter )
         p_fmto->i_sar_den = i_sar_den;
     }
 
-    p_sys->b_add_a = cfg.b_add_a;
-    p_sys->b_copy = cfg.b_copy;
-    p_sys->fmt_in  = *p_fmti;
-    p_sys->fmt_out = *p_fmto;
-    p_sys->b_swap_uvi = cfg.b_swap_uvi;
-    p_sys->b_swap_uvo = cfg.b_swap_uvo;
-
+    p_scaler->i_fmti = cfg.i_fmti;
+    p_scaler->i_fmto = cfg.i_fmto;
+    p_scaler->b_add_a = cfg.b_add_a;
+    p_scaler->b_copy = cfg.b_copy;
+    p_scaler->fmt_in  = *p_fmti;
+    p_scaler->fmt_out = *p_fmto;
+    p_scaler->b_swap_uvi = cfg.b_swap_uvi;
+    p_scaler->b_swap_uvo = cfg.b_swap_uvo;
+    p_scaler->i_last_use = ++p_sys->i_use_count;
+
+    p_sys->p_scaler = p_scaler;
     return VLC_SUCCESS;
 }
 
-static void Clean( filter_t *p_filter )
+static void Clean( scaler_t *p_scaler )
 {
-    filter_sys_t *p_sys = p_filter->p_sys;
-
-    if( p_sys->p_src_e )
-        picture_Release( p_sys->p_src_e );
-    if( p_sys->p_dst_e )
-        picture_Release( p_sys->p_dst_e );
-
-    if( p_sys->p_src_a )
-        picture_Release( p_sys->p_src_a );
-    if( p_sys->p_dst_a )
-        picture_Release( p_sys->p_dst_a );
-
-    if( p_sys->ctxA )
-        sws_freeContext( p_sys->ctxA );
-
-    if( p_sys->ctx )
-        sws_freeContext( p_sys->ctx );
-
-    /* We have to set it to null has we call be called again :( */
-    p_sys->ctx = NULL;
-    p_sys->ctxA = NULL;
-    p_sys->p_src_a = NULL;
-    p_sys->p_dst_a = NULL;
-    p_sys->p_src_e = NULL;
-    p_sys->p_dst_e = NULL;
+    if( p_scaler->p_src_e )
+        picture_Release( p_scaler->p_src_e );
+    if( p_scaler->p_dst_e )
+        picture_Release( p_scaler->p_dst_e );
+
+    if( p_scaler->p_src_a )
+        picture_Release( p_scaler->p_src_a );
+    if( p_scaler->p_dst_a )
+        picture_Release( p_scaler->p_dst_a );
+
+    if( p_scaler->ctxA )
+        sws_freeContext( p_scaler->ctxA );
+
+    if( p_scaler->ctx )
+        sws_freeContext( p_scaler->ctx );
+
+    /* The slot may be reused for another configuration */
+    p_scaler->ctx = NULL;
+    p_scaler->ctxA = NULL;
+    p_scaler->p_src_a = NULL;
+    p_scaler->p_dst_a = NULL;
+    p_scaler->p_src_e = NULL;
+    p_scaler->p_dst_e = NULL;
 }
 
 static void GetPixels( uint8_t *pp_pixel[4], int pi_pitch[4],
@@ -574,6 +738,29 @@ static void CopyPad( picture_t *p_dst, const picture_t *p_src )
     }
 }
 
+/* Whether the extended picture fits in the planes of the destination, from
+ * the format offsets, so that the padding columns can be written past its
+ * visible pitch */
+static bool FitsExtended( const picture_t *p_dst, const picture_t *p_ext,
+                          const vlc_chroma_description_t *desc,
+                          const video_format_t *fmt )
+{
+    if( p_dst->i_planes != p_ext->i_planes )
+        return false;
+    for( int n = 0; n < p_ext->i_planes; n++ )
+    {
+        const plane_t *d = &p_dst->p[n];
+        const int i_x = (fmt->i_x_offset * desc->p[n].w.num) / desc->p[n].w.den
+                        * d->i_pixel_pitch;
+        const int i_y = (fmt->i_y_offset * desc->p[n].h.num) / desc->p[n].h.den;
+
+        if( d->i_pitch < i_x + p_ext->p[n].i_visible_pitch ||
+            d->i_lines < i_y + p_ext->p[n].i_visible_lines )
+            return false;
+    }
+    return true;
+}
+
 static void SwapUV( picture_t *p_dst, const picture_t *p_src )
 {
     picture_t tmp = *p_src;
@@ -583,17 +770,45 @@ static void SwapUV( picture_t *p_dst, const picture_t *p_src )
     picture_CopyPixels( p_dst, &tmp );
 }
 
+#ifdef SWSCALE_HAS_THREADS
+static void NoFree( void *opaque, uint8_t *data )
+{
+    VLC_UNUSED(opaque); VLC_UNUSED(data);
+}
+
+static int WrapFrame( AVFrame *p_frame, uint8_t *pp_pixel[4],
+                      const int pi_pitch[4], int i_fmt,
+                      int i_width, int i_height )
+{
+    for( unsigned i = 0; i < 4; i++ )
+    {
+        p_frame->data[i] = pp_pixel[i];
+        p_frame->linesize[i] = pi_pitch[i];
+    }
+    p_frame->format = i_fmt;
+    p_frame->width = i_width;
+    p_frame->height = i_height;
+
+    /* swscale only accepts reference counted frames, otherwise it would
+     * allocate and copy the pixels */
+    p_frame->buf[0] = av_buffer_create( pp_pixel[0], 1, NoFree, NULL, 0 );
+    return p_frame->buf[0] ? 0 : AVERROR(ENOMEM);
+}
+#endif
+
 static void Convert( filter_t *p_filter, struct SwsContext *ctx,
                      picture_t *p_dst, picture_t *p_src, int i_height,
-                     int i_plane_count, bool b_swap_uvi, bool b_swap_uvo )
+                     int i_plane_count, bool b_swap_uvi, bool b_swap_uvo,
+                     int i_fmti, int i_fmto )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
+    scaler_t *p_scaler = p_sys->p_scaler;
     uint8_t palette[AVPALETTE_SIZE];
     uint8_t *src[4], *dst[4];
     const uint8_t *csrc[4];
     int src_stride[4], dst_stride[4];
 
-    GetPixels( src, src_stride, p_sys->desc_in, &p_filter->fmt_in.video,
+    GetPixels( src, src_stride, p_scaler->desc_in, &p_filter->fmt_in.video,
                p_src, i_plane_count, b_swap_uvi );
     if( p_filter->fmt_in.video.i_chroma == VLC_CODEC_RGBP )
     {
@@ -605,9 +820,37 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
         src_stride[1] = 4;
     }
 
-    GetPixels( dst, dst_stride, p_sys->desc_out, &p_filter->fmt_out.video,
+    GetPixels( dst, dst_stride, p_scaler->desc_out, &p_filter->fmt_out.video,
                p_dst, i_plane_count, b_swap_uvo );
 
+#ifdef SWSCALE_HAS_THREADS
+    if( p_sys->i_threads > 1 )
+    {
+        /* The frame API splits the picture in slices handled by the
+         * context worker threads */
+        AVFrame *p_frame_src = p_sys->p_frame_src;
+        AVFrame *p_frame_dst = p_sys->p_frame_dst;
+        const int i_width_src = p_filter->fmt_in.video.i_visible_width *
+                                p_scaler->i_extend_factor;
+        const int i_width_dst = p_filter->fmt_out.video.i_visible_width *
+                                p_scaler->i_extend_factor;
+
+        if( WrapFrame( p_frame_src, src, src_stride, i_fmti,
+                       i_width_src, i_height ) == 0 &&
+            WrapFrame( p_frame_dst, dst, dst_stride, i_fmto, i_width_dst,
+                       p_filter->fmt_out.video.i_visible_height ) == 0 )
+        {
+            if( sws_scale_frame( ctx, p_frame_dst, p_frame_src ) < 0 )
+                msg_Warn( p_filter, "slice threaded scaling failed" );
+        }
+        av_frame_unref( p_frame_src );
+        av_frame_unref( p_frame_dst );
+        return;
+    }
+#else
+    VLC_UNUSED(i_fmti); VLC_UNUSED(i_fmto);
+#endif
+
     for (size_t i = 0; i < ARRAY_SIZE(src); i++)
         csrc[i] = src[i];
 
@@ -638,6 +881,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         picture_Release( p_pic );
         return NULL;
     }
+    scaler_t *p_scaler = p_sys->p_scaler;
 
     /* Request output picture */
     p_pic_dst = filter_NewPicture( p_filter );
@@ -650,46 +894,67 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     /* */
     picture_t *p_src = p_pic;
     picture_t *p_dst = p_pic_dst;
-    if( p_sys->i_extend_factor != 1 )
+    if( p_scaler->i_extend_factor != 1 )
     {
-        p_src = p_sys->p_src_e;
-        p_dst = p_sys->p_dst_e;
-
+        /* The source padding must repeat the last column, as the scaler
+         * filter taps read it: it cannot be read in place. */
+        p_src = p_scaler->p_src_e;
         CopyPad( p_src, p_pic );
+
+        /* The destination padding is discarded: scale in place when the
+         * pitch leaves room for it. */
+        if( !FitsExtended( p_pic_dst, p_scaler->p_dst_e, p_scaler->desc_out,
+                           p_fmto ) )
+            p_dst = p_scaler->p_dst_e;
     }
 
-    if( p_sys->b_copy && p_sys->b_swap_uvi == p_sys->b_swap_uvo )
+    if( p_scaler->b_copy && p_scaler->b_swap_uvi == p_scaler->b_swap_uvo )
         picture_CopyPixels( p_dst, p_src );
-    else if( p_sys->b_copy )
+    else if( p_scaler->b_copy )
         SwapUV( p_dst, p_src );
     else
     {
         /* Even if alpha is unused, swscale expects the pointer to be set */
-        const int n_planes = !p_sys->ctxA && (p_src->i_planes == 4 ||
+        const int n_planes = !p_scaler->ctxA && (p_src->i_planes == 4 ||
                              p_dst->i_planes == 4) ? 4 : 3;
-        Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_visible_height,
-                 n_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+        Convert( p_filter, p_scaler->ctx, p_dst, p_src, p_fmti->i_visible_height,
+                 n_planes, p_scaler->b_swap_uvi, p_scaler->b_swap_uvo,
+                 p_scaler->i_fmti, p_scaler->i_fmto );
+    }
+    if( p_scaler->ctxA && !p_scaler->p_src_a )
+    {
+        /* Both alpha planes are full resolution planes that can be scaled
+         * directly, without going through intermediate pictures. */
+        picture_t src_a = *p_src, dst_a = *p_dst;
+        src_a.p[0] = p_src->p[A_PLANE];
+        dst_a.p[0] = p_dst->p[A_PLANE];
+        src_a.i_planes = dst_a.i_planes = 1;
+
+        Convert( p_filter, p_scaler->ctxA, &dst_a, &src_a,
+                 p_fmti->i_visible_height, 1, false, false,
+                 AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY8 );
     }
-    if( p_sys->ctxA )
+    else if( p_scaler->ctxA )
     {
         /* We extract the A plane to rescale it, and then we reinject it. */
         if( p_fmti->i_chroma == VLC_CODEC_RGBA || p_fmti->i_chroma == VLC_CODEC_BGRA )
-            ExtractA( p_sys->p_src_a, p_src, OFFSET_A );
+            ExtractA( p_scaler->p_src_a, p_src, OFFSET_A );
         else if( p_fmti->i_chroma == VLC_CODEC_ARGB )
-            ExtractA( p_sys->p_src_a, p_src, 0 );
+            ExtractA( p_scaler->p_src_a, p_src, 0 );
         else
-            plane_CopyPixels( p_sys->p_src_a->p, p_src->p+A_PLANE );
+            plane_CopyPixels( p_scaler->p_src_a->p, p_src->p+A_PLANE );
 
-        Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a,
-                 p_fmti->i_visible_height, 1, false, false );
+        Convert( p_filter, p_scaler->ctxA, p_scaler->p_dst_a, p_scaler->p_src_a,
+                 p_fmti->i_visible_height, 1, false, false,
+                 AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY8 );
         if( p_fmto->i_chroma == VLC_CODEC_RGBA || p_fmto->i_chroma == VLC_CODEC_BGRA )
-            InjectA( p_dst, p_sys->p_dst_a, OFFSET_A );
+            InjectA( p_dst, p_scaler->p_dst_a, OFFSET_A );
         else if( p_fmto->i_chroma == VLC_CODEC_ARGB )
-            InjectA( p_dst, p_sys->p_dst_a, 0 );
+            InjectA( p_dst, p_scaler->p_dst_a, 0 );
         else
-            plane_CopyPixels( p_dst->p+A_PLANE, p_sys->p_dst_a->p );
+            plane_CopyPixels( p_dst->p+A_PLANE, p_scaler->p_dst_a->p );
     }
-    else if( p_sys->b_add_a )
+    else if( p_scaler->b_add_a )
     {
         /* We inject a complete opaque alpha plane */
         if( p_fmto->i_chroma == VLC_CODEC_RGBA || p_fmto->i_chroma == VLC_CODEC_BGRA )
@@ -700,10 +965,8 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             FillA( &p_dst->p[A_PLANE], 0 );
     }
 
-    if( p_sys->i_extend_factor != 1 )
-    {
+    if( p_dst != p_pic_dst )
         picture_CopyPixels( p_pic_dst, p_dst );
-    }
 
     picture_CopyProperties( p_pic_dst, p_pic );
     picture_Release( p_pic );
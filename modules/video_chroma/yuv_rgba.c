@@ -0,0 +1,638 @@
+/*****************************************************************************
+ * yuv_rgba.c : YUV 4:2:0 to RGBA/BGRA conversion module for vlc
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define YUV_RGBA_NEON 1
+#endif
+
+/*****************************************************************************
+ * Module descriptor.
+ *****************************************************************************/
+static int  Activate   ( vlc_object_t * );
+static void Deactivate ( vlc_object_t * );
+
+vlc_module_begin ()
+    set_description( N_("I420,YV12,NV12,NV21,P010 to RGBA,BGRA conversions") )
+    /* Preferred over swscale for the conversions it handles, only loaded
+     * when a vector version is available */
+    set_capability( "video converter", 160 )
+    set_callbacks( Activate, Deactivate )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Conversion
+ *****************************************************************************
+ * All kernels work on signed 16 bits samples, holding the 8 bits sample
+ * value scaled by 64 (or the 10 bits value scaled by 16), and coefficients
+ * in Q13. The rounded high multiply of SSSE3/AVX2 (pmulhrsw) and NEON
+ * (vqrdmulh) then yields results scaled by 16, and the C version mirrors
+ * that arithmetic so that all versions produce identical pictures.
+ *****************************************************************************/
+typedef struct
+{
+    int16_t y_offset;
+    int16_t c_offset;
+    int16_t y;
+    int16_t rv;
+    int16_t gu;
+    int16_t gv;
+    int16_t bu;
+} yuv_matrix_t;
+
+enum
+{
+    INPUT_PLANAR,    /* I420, YV12 */
+    INPUT_SEMIPLANAR, /* NV12, NV21 */
+    INPUT_P010,
+};
+
+typedef void (*row_fn)( uint8_t *, const uint8_t *, const uint8_t *,
+                        const uint8_t *, unsigned, unsigned,
+                        const yuv_matrix_t *, bool );
+
+typedef struct
+{
+    yuv_matrix_t matrix;
+    row_fn       convert;
+    bool         swap_uv;
+    bool         bgra;
+} filter_sys_t;
+
+static inline int MulHRS( int a, int b )
+{
+    return ( a * b + (1 << 14) ) >> 15;
+}
+
+static inline uint8_t Clip( int v )
+{
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static inline void ConvertPixel( uint8_t *dst, int y, int u, int v,
+                                 const yuv_matrix_t *m, bool bgra )
+{
+    const int luma = MulHRS( y - m->y_offset, m->y );
+    u -= m->c_offset;
+    v -= m->c_offset;
+
+    const uint8_t r = Clip( ( luma + MulHRS( v, m->rv ) + 8 ) >> 4 );
+    const uint8_t g = Clip( ( luma + MulHRS( u, m->gu ) + MulHRS( v, m->gv )
+                              + 8 ) >> 4 );
+    const uint8_t b = Clip( ( luma + MulHRS( u, m->bu ) + 8 ) >> 4 );
+
+    dst[0] = bgra ? b : r;
+    dst[1] = g;
+    dst[2] = bgra ? r : b;
+    dst[3] = 0xff;
+}
+
+#if defined(HAVE_AVX2_INTRINSICS) || defined(YUV_RGBA_NEON)
+/* The row functions convert the pixels from x to width. For planar input,
+ * u and v point to the chroma planes, otherwise u points to the interleaved
+ * chroma plane and v is unused. */
+static void ConvertPlanar_C( uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                             const uint8_t *v, unsigned x, unsigned width,
+                             const yuv_matrix_t *m, bool bgra )
+{
+    for( ; x < width; x++ )
+        ConvertPixel( &dst[4 * x], y[x] << 6, u[x / 2] << 6, v[x / 2] << 6,
+                      m, bgra );
+}
+
+static void ConvertSemiPlanar_C( uint8_t *dst, const uint8_t *y,
+                                 const uint8_t *uv, const uint8_t *unused,
+                                 unsigned x, unsigned width,
+                                 const yuv_matrix_t *m, bool bgra )
+{
+    VLC_UNUSED(unused);
+    for( ; x < width; x++ )
+        ConvertPixel( &dst[4 * x], y[x] << 6, uv[x / 2 * 2] << 6,
+                      uv[x / 2 * 2 + 1] << 6, m, bgra );
+}
+
+static void ConvertP010_C( uint8_t *dst, const uint8_t *y8,
+                           const uint8_t *uv8, const uint8_t *unused,
+                           unsigned x, unsigned width,
+                           const yuv_matrix_t *m, bool bgra )
+{
+    const uint16_t *y = (const uint16_t *)y8;
+    const uint16_t *uv = (const uint16_t *)uv8;
+
+    VLC_UNUSED(unused);
+    for( ; x < width; x++ )
+        ConvertPixel( &dst[4 * x], y[x] >> 2, uv[x / 2 * 2] >> 2,
+                      uv[x / 2 * 2 + 1] >> 2, m, bgra );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* Converts 16 pixels, from samples in natural order */
+__attribute__ ((__target__ ("avx2")))
+static inline void Convert16_AVX2( uint8_t *dst, __m256i y, __m256i u,
+                                   __m256i v, const yuv_matrix_t *m,
+                                   bool bgra )
+{
+    const __m256i round = _mm256_set1_epi16( 8 );
+    const __m256i luma = _mm256_mulhrs_epi16(
+        _mm256_sub_epi16( y, _mm256_set1_epi16( m->y_offset ) ),
+        _mm256_set1_epi16( m->y ) );
+
+    u = _mm256_sub_epi16( u, _mm256_set1_epi16( m->c_offset ) );
+    v = _mm256_sub_epi16( v, _mm256_set1_epi16( m->c_offset ) );
+
+    __m256i r = _mm256_add_epi16( luma,
+                    _mm256_mulhrs_epi16( v, _mm256_set1_epi16( m->rv ) ) );
+    __m256i g = _mm256_add_epi16( luma, _mm256_add_epi16(
+                    _mm256_mulhrs_epi16( u, _mm256_set1_epi16( m->gu ) ),
+                    _mm256_mulhrs_epi16( v, _mm256_set1_epi16( m->gv ) ) ) );
+    __m256i b = _mm256_add_epi16( luma,
+                    _mm256_mulhrs_epi16( u, _mm256_set1_epi16( m->bu ) ) );
+    r = _mm256_srai_epi16( _mm256_add_epi16( r, round ), 4 );
+    g = _mm256_srai_epi16( _mm256_add_epi16( g, round ), 4 );
+    b = _mm256_srai_epi16( _mm256_add_epi16( b, round ), 4 );
+    if( bgra )
+    {
+        __m256i tmp = r;
+        r = b;
+        b = tmp;
+    }
+
+    /* Packing works within 128-bits lanes: each lane holds 8 pixels */
+    const __m256i rb = _mm256_packus_epi16( r, b );
+    const __m256i ga = _mm256_packus_epi16( g, _mm256_set1_epi16( 0xff ) );
+    const __m256i rg = _mm256_unpacklo_epi8( rb, ga );
+    const __m256i ba = _mm256_unpackhi_epi8( rb, ga );
+    const __m256i lo = _mm256_unpacklo_epi16( rg, ba ); /* 0-3, 8-11 */
+    const __m256i hi = _mm256_unpackhi_epi16( rg, ba ); /* 4-7, 12-15 */
+
+    _mm256_storeu_si256( (__m256i *)dst,
+                         _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+    _mm256_storeu_si256( (__m256i *)(dst + 32),
+                         _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+}
+
+/* Duplicates 8 chroma samples to 16 pixels */
+__attribute__ ((__target__ ("avx2")))
+static inline __m256i UpsampleChroma_AVX2( __m128i c )
+{
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256( _mm_unpacklo_epi16( c, c ) ),
+        _mm_unpackhi_epi16( c, c ), 1 );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void ConvertPlanar_AVX2( uint8_t *dst, const uint8_t *y,
+                                const uint8_t *u, const uint8_t *v,
+                                unsigned x, unsigned width,
+                                const yuv_matrix_t *m, bool bgra )
+{
+    for( ; x + 16 <= width; x += 16 )
+    {
+        __m256i vy = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128( (const __m128i *)&y[x] ) );
+        __m128i vu = _mm_cvtepu8_epi16(
+            _mm_loadl_epi64( (const __m128i *)&u[x / 2] ) );
+        __m128i vv = _mm_cvtepu8_epi16(
+            _mm_loadl_epi64( (const __m128i *)&v[x / 2] ) );
+
+        Convert16_AVX2( &dst[4 * x], _mm256_slli_epi16( vy, 6 ),
+                        _mm256_slli_epi16( UpsampleChroma_AVX2( vu ), 6 ),
+                        _mm256_slli_epi16( UpsampleChroma_AVX2( vv ), 6 ),
+                        m, bgra );
+    }
+    ConvertPlanar_C( dst, y, u, v, x, width, m, bgra );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void ConvertSemiPlanar_AVX2( uint8_t *dst, const uint8_t *y,
+                                    const uint8_t *uv, const uint8_t *unused,
+                                    unsigned x, unsigned width,
+                                    const yuv_matrix_t *m, bool bgra )
+{
+    const __m128i mask = _mm_set1_epi16( 0xff );
+
+    for( ; x + 16 <= width; x += 16 )
+    {
+        __m256i vy = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128( (const __m128i *)&y[x] ) );
+        __m128i vuv = _mm_loadu_si128( (const __m128i *)&uv[x] );
+        __m128i vu = _mm_and_si128( vuv, mask );
+        __m128i vv = _mm_srli_epi16( vuv, 8 );
+
+        Convert16_AVX2( &dst[4 * x], _mm256_slli_epi16( vy, 6 ),
+                        _mm256_slli_epi16( UpsampleChroma_AVX2( vu ), 6 ),
+                        _mm256_slli_epi16( UpsampleChroma_AVX2( vv ), 6 ),
+                        m, bgra );
+    }
+    ConvertSemiPlanar_C( dst, y, uv, unused, x, width, m, bgra );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void ConvertP010_AVX2( uint8_t *dst, const uint8_t *y8,
+                              const uint8_t *uv8, const uint8_t *unused,
+                              unsigned x, unsigned width,
+                              const yuv_matrix_t *m, bool bgra )
+{
+    const uint16_t *y = (const uint16_t *)y8;
+    const uint16_t *uv = (const uint16_t *)uv8;
+    const __m128i mask = _mm_set1_epi32( 0xffff );
+
+    for( ; x + 16 <= width; x += 16 )
+    {
+        __m256i vy = _mm256_loadu_si256( (const __m256i *)&y[x] );
+        __m128i uv0 = _mm_loadu_si128( (const __m128i *)&uv[x] );
+        __m128i uv1 = _mm_loadu_si128( (const __m128i *)&uv[x + 8] );
+        __m128i vu = _mm_packus_epi32( _mm_and_si128( uv0, mask ),
+                                       _mm_and_si128( uv1, mask ) );
+        __m128i vv = _mm_packus_epi32( _mm_srli_epi32( uv0, 16 ),
+                                       _mm_srli_epi32( uv1, 16 ) );
+
+        Convert16_AVX2( &dst[4 * x], _mm256_srli_epi16( vy, 2 ),
+                        _mm256_srli_epi16( UpsampleChroma_AVX2( vu ), 2 ),
+                        _mm256_srli_epi16( UpsampleChroma_AVX2( vv ), 2 ),
+                        m, bgra );
+    }
+    ConvertP010_C( dst, y8, uv8, unused, x, width, m, bgra );
+}
+#endif
+
+#ifdef YUV_RGBA_NEON
+/* Converts 8 pixels */
+static inline uint8x8x3_t Convert8_NEON( int16x8_t y, int16x8_t u,
+                                         int16x8_t v, const yuv_matrix_t *m )
+{
+    const int16x8_t luma = vqrdmulhq_n_s16(
+        vsubq_s16( y, vdupq_n_s16( m->y_offset ) ), m->y );
+
+    u = vsubq_s16( u, vdupq_n_s16( m->c_offset ) );
+    v = vsubq_s16( v, vdupq_n_s16( m->c_offset ) );
+
+    int16x8_t r = vaddq_s16( luma, vqrdmulhq_n_s16( v, m->rv ) );
+    int16x8_t g = vaddq_s16( luma, vaddq_s16( vqrdmulhq_n_s16( u, m->gu ),
+                                              vqrdmulhq_n_s16( v, m->gv ) ) );
+    int16x8_t b = vaddq_s16( luma, vqrdmulhq_n_s16( u, m->bu ) );
+
+    /* Rounding shift by 4 and saturation to 8 bits */
+    uint8x8x3_t rgb = { {
+        vqrshrun_n_s16( r, 4 ), vqrshrun_n_s16( g, 4 ), vqrshrun_n_s16( b, 4 ),
+    } };
+    return rgb;
+}
+
+static inline void Store16_NEON( uint8_t *dst, uint8x8x3_t lo,
+                                 uint8x8x3_t hi, bool bgra )
+{
+    uint8x16x4_t rgba;
+
+    rgba.val[0] = vcombine_u8( lo.val[bgra ? 2 : 0], hi.val[bgra ? 2 : 0] );
+    rgba.val[1] = vcombine_u8( lo.val[1], hi.val[1] );
+    rgba.val[2] = vcombine_u8( lo.val[bgra ? 0 : 2], hi.val[bgra ? 0 : 2] );
+    rgba.val[3] = vdupq_n_u8( 0xff );
+    vst4q_u8( dst, rgba );
+}
+
+static inline int16x8_t Scale8_NEON( uint8x8_t v )
+{
+    return vreinterpretq_s16_u16( vshll_n_u8( v, 6 ) );
+}
+
+static void ConvertPlanar_NEON( uint8_t *dst, const uint8_t *y,
+                                const uint8_t *u, const uint8_t *v,
+                                unsigned x, unsigned width,
+                                const yuv_matrix_t *m, bool bgra )
+{
+    for( ; x + 16 <= width; x += 16 )
+    {
+        const uint8x16_t vy = vld1q_u8( &y[x] );
+        const uint8x8_t vu = vld1_u8( &u[x / 2] );
+        const uint8x8_t vv = vld1_u8( &v[x / 2] );
+        const uint8x8x2_t uu = vzip_u8( vu, vu );
+        const uint8x8x2_t vvv = vzip_u8( vv, vv );
+
+        Store16_NEON( &dst[4 * x],
+            Convert8_NEON( Scale8_NEON( vget_low_u8( vy ) ),
+                           Scale8_NEON( uu.val[0] ), Scale8_NEON( vvv.val[0] ),
+                           m ),
+            Convert8_NEON( Scale8_NEON( vget_high_u8( vy ) ),
+                           Scale8_NEON( uu.val[1] ), Scale8_NEON( vvv.val[1] ),
+                           m ), bgra );
+    }
+    ConvertPlanar_C( dst, y, u, v, x, width, m, bgra );
+}
+
+static void ConvertSemiPlanar_NEON( uint8_t *dst, const uint8_t *y,
+                                    const uint8_t *uv, const uint8_t *unused,
+                                    unsigned x, unsigned width,
+                                    const yuv_matrix_t *m, bool bgra )
+{
+    for( ; x + 16 <= width; x += 16 )
+    {
+        const uint8x16_t vy = vld1q_u8( &y[x] );
+        const uint8x8x2_t vuv = vld2_u8( &uv[x] );
+        const uint8x8x2_t uu = vzip_u8( vuv.val[0], vuv.val[0] );
+        const uint8x8x2_t vv = vzip_u8( vuv.val[1], vuv.val[1] );
+
+        Store16_NEON( &dst[4 * x],
+            Convert8_NEON( Scale8_NEON( vget_low_u8( vy ) ),
+                           Scale8_NEON( uu.val[0] ), Scale8_NEON( vv.val[0] ),
+                           m ),
+            Convert8_NEON( Scale8_NEON( vget_high_u8( vy ) ),
+                           Scale8_NEON( uu.val[1] ), Scale8_NEON( vv.val[1] ),
+                           m ), bgra );
+    }
+    ConvertSemiPlanar_C( dst, y, uv, unused, x, width, m, bgra );
+}
+
+static void ConvertP010_NEON( uint8_t *dst, const uint8_t *y8,
+                              const uint8_t *uv8, const uint8_t *unused,
+                              unsigned x, unsigned width,
+                              const yuv_matrix_t *m, bool bgra )
+{
+    const uint16_t *y = (const uint16_t *)y8;
+    const uint16_t *uv = (const uint16_t *)uv8;
+
+    for( ; x + 16 <= width; x += 16 )
+    {
+        const uint16x8x2_t vuv = vld2q_u16( &uv[x] );
+        const uint16x8x2_t uu = vzipq_u16( vuv.val[0], vuv.val[0] );
+        const uint16x8x2_t vv = vzipq_u16( vuv.val[1], vuv.val[1] );
+#define S(v) vreinterpretq_s16_u16( vshrq_n_u16( v, 2 ) )
+        Store16_NEON( &dst[4 * x],
+            Convert8_NEON( S( vld1q_u16( &y[x] ) ),
+                           S( uu.val[0] ), S( vv.val[0] ), m ),
+            Convert8_NEON( S( vld1q_u16( &y[x + 8] ) ),
+                           S( uu.val[1] ), S( vv.val[1] ), m ), bgra );
+#undef S
+    }
+    ConvertP010_C( dst, y8, uv8, unused, x, width, m, bgra );
+}
+#endif
+
+/*****************************************************************************
+ * Setup
+ *****************************************************************************/
+static void SetupMatrix( yuv_matrix_t *m, const video_format_t *fmt )
+{
+    float kr, kb;
+    video_color_space_t space = fmt->space;
+
+    if( space == COLOR_SPACE_UNDEF )
+        space = fmt->i_visible_height > 576 ? COLOR_SPACE_BT709
+                                            : COLOR_SPACE_BT601;
+    switch( space )
+    {
+        case COLOR_SPACE_BT709:
+            kr = 0.2126f; kb = 0.0722f;
+            break;
+        case COLOR_SPACE_BT2020:
+            kr = 0.2627f; kb = 0.0593f;
+            break;
+        default:
+            kr = 0.299f; kb = 0.114f;
+            break;
+    }
+
+    const bool full = fmt->color_range == COLOR_RANGE_FULL ||
+                      fmt->i_chroma == VLC_CODEC_J420;
+    const float kg = 1.f - kr - kb;
+    const float ys = full ? 1.f : 255.f / 219.f;
+    const float cs = full ? 1.f : 255.f / 224.f;
+
+#define Q13(f) ((int16_t)lroundf( (f) * 8192.f ))
+    m->y_offset = full ? 0 : 16 << 6;
+    m->c_offset = 128 << 6;
+    m->y  = Q13( ys );
+    m->rv = Q13( 2.f * (1.f - kr) * cs );
+    m->gu = Q13( -2.f * kb * (1.f - kb) / kg * cs );
+    m->gv = Q13( -2.f * kr * (1.f - kr) / kg * cs );
+    m->bu = Q13( 2.f * (1.f - kb) * cs );
+#undef Q13
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_src )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_dst = filter_NewPicture( p_filter );
+
+    if( p_dst == NULL )
+    {
+        picture_Release( p_src );
+        return NULL;
+    }
+
+    const video_format_t *fmt_in = &p_filter->fmt_in.video;
+    const video_format_t *fmt_out = &p_filter->fmt_out.video;
+    const unsigned width = fmt_out->i_visible_width;
+    const unsigned height = fmt_out->i_visible_height;
+    const plane_t *y = &p_src->p[0];
+    const plane_t *u = &p_src->p[p_sys->swap_uv ? 2 : 1];
+    const plane_t *v = &p_src->p[p_sys->swap_uv ? 1 : 2];
+    const bool planar = p_src->i_planes >= 3;
+    plane_t *d = &p_dst->p[0];
+
+    /* The horizontal offset is even (see Activate): the chroma samples are
+     * shared by the same pairs of pixels as without cropping */
+    const unsigned x_in = fmt_in->i_x_offset;
+    const uint8_t *y_pixels = y->p_pixels + x_in * y->i_pixel_pitch;
+    const uint8_t *u_pixels = u->p_pixels + x_in / 2 * u->i_pixel_pitch;
+    const uint8_t *v_pixels = v->p_pixels + x_in / 2 * v->i_pixel_pitch;
+    uint8_t *d_pixels = d->p_pixels + fmt_out->i_x_offset * d->i_pixel_pitch;
+
+    for( unsigned line = 0; line < height; line++ )
+    {
+        const unsigned y_in = fmt_in->i_y_offset + line;
+        const unsigned y_out = fmt_out->i_y_offset + line;
+
+        p_sys->convert( &d_pixels[y_out * d->i_pitch],
+                        &y_pixels[y_in * y->i_pitch],
+                        &u_pixels[y_in / 2 * u->i_pitch],
+                        planar ? &v_pixels[y_in / 2 * v->i_pitch] : NULL,
+                        0, width, &p_sys->matrix, p_sys->bgra );
+    }
+
+    picture_CopyProperties( p_dst, p_src );
+    picture_Release( p_src );
+    return p_dst;
+}
+
+static int Activate( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const video_format_t *fmt_in = &p_filter->fmt_in.video;
+    const video_format_t *fmt_out = &p_filter->fmt_out.video;
+    bool bgra, swap_uv = false;
+    unsigned input;
+
+    if( fmt_in->orientation != fmt_out->orientation
+     || fmt_in->i_visible_width != fmt_out->i_visible_width
+     || fmt_in->i_visible_height != fmt_out->i_visible_height )
+        return VLC_EGENERIC;
+
+    /* The kernels start on a pair of pixels sharing their chroma */
+    if( fmt_in->i_x_offset & 1 )
+        return VLC_EGENERIC;
+
+    switch( fmt_in->i_chroma )
+    {
+        case VLC_CODEC_YV12:
+            swap_uv = true;
+            /* fall through */
+        case VLC_CODEC_I420:
+        case VLC_CODEC_J420:
+            input = INPUT_PLANAR;
+            break;
+        case VLC_CODEC_NV21: /* V and U are swapped through the matrix */
+        case VLC_CODEC_NV12:
+            input = INPUT_SEMIPLANAR;
+            break;
+        case VLC_CODEC_P010:
+            input = INPUT_P010;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    switch( fmt_out->i_chroma )
+    {
+        case VLC_CODEC_RGBA:
+            bgra = false;
+            break;
+        case VLC_CODEC_BGRA:
+            bgra = true;
+            break;
+#ifndef WORDS_BIGENDIAN
+        case VLC_CODEC_RGB32:
+            /* Only the masks matching the byte order of RGBA or BGRA */
+            if( fmt_out->i_rmask == 0x00ff0000
+             && fmt_out->i_gmask == 0x0000ff00
+             && fmt_out->i_bmask == 0x000000ff )
+                bgra = true;
+            else if( fmt_out->i_rmask == 0x000000ff
+                  && fmt_out->i_gmask == 0x0000ff00
+                  && fmt_out->i_bmask == 0x00ff0000 )
+                bgra = false;
+            else
+                return VLC_EGENERIC;
+            break;
+#endif
+        default:
+            return VLC_EGENERIC;
+    }
+
+    filter_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    SetupMatrix( &p_sys->matrix, fmt_in );
+    if( fmt_in->i_chroma == VLC_CODEC_NV21 )
+    {
+        /* Exchange the U and V coefficients */
+        int16_t gu = p_sys->matrix.gu;
+        p_sys->matrix.gu = p_sys->matrix.gv;
+        p_sys->matrix.gv = gu;
+        /* R depends on V only and B on U only: swap the outputs */
+        bgra = !bgra;
+        int16_t rv = p_sys->matrix.rv;
+        p_sys->matrix.rv = p_sys->matrix.bu;
+        p_sys->matrix.bu = rv;
+    }
+    p_sys->swap_uv = swap_uv;
+    p_sys->bgra = bgra;
+
+    switch( input )
+    {
+        case INPUT_PLANAR:
+            p_sys->convert = NULL;
+#ifdef HAVE_AVX2_INTRINSICS
+            if( vlc_CPU_AVX2() )
+                p_sys->convert = ConvertPlanar_AVX2;
+#endif
+#ifdef YUV_RGBA_NEON
+            if( vlc_CPU_ARM_NEON() )
+                p_sys->convert = ConvertPlanar_NEON;
+#endif
+            break;
+        case INPUT_SEMIPLANAR:
+            p_sys->convert = NULL;
+#ifdef HAVE_AVX2_INTRINSICS
+            if( vlc_CPU_AVX2() )
+                p_sys->convert = ConvertSemiPlanar_AVX2;
+#endif
+#ifdef YUV_RGBA_NEON
+            if( vlc_CPU_ARM_NEON() )
+                p_sys->convert = ConvertSemiPlanar_NEON;
+#endif
+            break;
+        case INPUT_P010:
+            p_sys->convert = NULL;
+#ifdef HAVE_AVX2_INTRINSICS
+            if( vlc_CPU_AVX2() )
+                p_sys->convert = ConvertP010_AVX2;
+#endif
+#ifdef YUV_RGBA_NEON
+            if( vlc_CPU_ARM_NEON() )
+                p_sys->convert = ConvertP010_NEON;
+#endif
+            break;
+    }
+
+    /* The C version only converts the ends of the lines: without vectors,
+     * i420_rgb and swscale are faster. */
+    if( p_sys->convert == NULL )
+    {
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_filter, "%4.4s to %4.4s, %s range, space %d",
+             (const char *)&fmt_in->i_chroma, (const char *)&fmt_out->i_chroma,
+             p_sys->matrix.y_offset ? "limited" : "full", fmt_in->space );
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_video_filter = Filter;
+    return VLC_SUCCESS;
+}
+
+static void Deactivate( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
@@ -32,6 +32,9 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+#include "fps_mci.h"
 
 static int Open( vlc_object_t *p_this);
 static void Close( vlc_object_t *p_this);
@@ -41,6 +44,21 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture);
 
 #define FPS_TEXT N_( "Frame rate" )
 
+#define MODE_TEXT N_( "Conversion mode" )
+#define MODE_LONGTEXT N_( "Frame rate increase method. Motion compensation " \
+    "interpolates the missing pictures, and falls back to duplication on " \
+    "scene changes." )
+
+enum
+{
+    MODE_DUPLICATE,
+    MODE_MOTION,
+};
+
+static const int pi_mode_values[] = { MODE_DUPLICATE, MODE_MOTION };
+static const char *const ppsz_mode_descriptions[] = {
+    N_("Drop and duplicate"), N_("Motion compensated interpolation") };
+
 vlc_module_begin ()
     set_description( N_("FPS conversion video filter") )
     set_shortname( N_("FPS Converter" ))
@@ -50,11 +68,14 @@ vlc_module_begin ()
 
     add_shortcut( "fps" )
     add_string( CFG_PREFIX "fps", NULL, FPS_TEXT, FPS_TEXT, false )
+    add_integer( CFG_PREFIX "mode", MODE_DUPLICATE, MODE_TEXT, MODE_LONGTEXT,
+                 false )
+        change_integer_list( pi_mode_values, ppsz_mode_descriptions )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "fps",
+    "fps", "mode",
     NULL
 };
 
@@ -65,8 +86,85 @@ typedef struct
     date_t          next_output_pts; /**< output calculated PTS */
     picture_t       *p_previous_pic;
     vlc_tick_t      i_output_frame_interval;
+    fps_mci_t       *p_mci; /**< motion compensation, or NULL */
 } filter_sys_t;
 
+/* Below this distance (in 1/256 of the input interval) to an input picture,
+ * the input picture is used as is */
+#define PHASE_EPSILON 8
+
+static picture_t *CopyPicture( filter_t *p_filter, picture_t *p_src )
+{
+    picture_t *p_dst = picture_NewFromFormat( &p_filter->fmt_out.video );
+
+    if( likely( p_dst != NULL ) )
+        picture_Copy( p_dst, p_src );
+    return p_dst;
+}
+
+/* Outputs the pictures between the previous and the current input pictures,
+ * interpolating those which are not close to any input picture */
+static picture_t *Interpolate( filter_t *p_filter, picture_t *p_picture )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_prev = p_sys->p_previous_pic;
+    const vlc_tick_t i_prev_date = p_prev->date;
+    const vlc_tick_t i_span = p_picture->date - i_prev_date;
+    bool b_estimated = false, b_motion = false;
+    picture_t *p_list = NULL, **pp_last = &p_list;
+
+    do
+    {
+        const vlc_tick_t i_date = date_Get( &p_sys->next_output_pts );
+        const unsigned i_phase = i_span <= 0 ? 0 :
+            VLC_CLIP( ( i_date - i_prev_date ) * 256 / i_span, 0, 256 );
+        picture_t *p_out;
+
+        if( i_phase >= PHASE_EPSILON && i_phase <= 256 - PHASE_EPSILON &&
+            !b_estimated )
+        {
+            /* Estimate lazily, when an output lies between two inputs */
+            b_motion = fps_mci_Estimate( p_sys->p_mci, p_prev,
+                                         p_picture ) == VLC_SUCCESS;
+            b_estimated = true;
+            if( !b_motion )
+                msg_Dbg( p_filter, "scene change, duplicating pictures" );
+        }
+
+        if( b_motion && i_phase >= PHASE_EPSILON &&
+            i_phase <= 256 - PHASE_EPSILON )
+        {
+            p_out = picture_NewFromFormat( &p_filter->fmt_out.video );
+            if( likely( p_out != NULL ) )
+            {
+                fps_mci_Interpolate( p_sys->p_mci, p_out, p_prev, p_picture,
+                                     i_phase );
+                picture_CopyProperties( p_out, p_prev );
+            }
+        }
+        else if( i_phase >= 128 )
+            p_out = CopyPicture( p_filter, p_picture );
+        else if( p_list == NULL )
+            p_out = picture_Hold( p_prev );
+        else
+            p_out = CopyPicture( p_filter, p_prev );
+
+        if( unlikely( p_out == NULL ) )
+            break;
+
+        p_out->date = i_date;
+        p_out->p_next = NULL;
+        *pp_last = p_out;
+        pp_last = &p_out->p_next;
+        date_Increment( &p_sys->next_output_pts, 1 );
+    }
+    while( ( date_Get( &p_sys->next_output_pts ) + p_sys->i_output_frame_interval ) < p_picture->date );
+
+    picture_Release( p_prev );
+    p_sys->p_previous_pic = p_picture;
+    return p_list;
+}
+
 static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -108,6 +206,9 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
         return NULL;
     }
 
+    if( p_sys->p_mci != NULL )
+        return Interpolate( p_filter, p_picture );
+
     p_sys->p_previous_pic->date = date_Get( &p_sys->next_output_pts );
     date_Increment( &p_sys->next_output_pts, 1 );
 
@@ -171,6 +272,17 @@ static int Open( vlc_object_t *p_this)
                p_filter->fmt_out.video.i_frame_rate, p_filter->fmt_out.video.i_frame_rate_base );
 
     p_sys->p_previous_pic = NULL;
+    p_sys->p_mci = NULL;
+
+    if( var_InheritInteger( p_filter, CFG_PREFIX "mode" ) == MODE_MOTION )
+    {
+        p_sys->p_mci = fps_mci_New( p_this, &p_filter->fmt_in.video,
+                                    vlc_GetCPUCount() );
+        if( p_sys->p_mci == NULL )
+            msg_Warn( p_filter, "motion compensation not available for "
+                      "%4.4s, duplicating pictures",
+                      (const char *)&p_filter->fmt_in.video.i_chroma );
+    }
 
     p_filter->pf_video_filter = Filter;
     return VLC_SUCCESS;
@@ -182,5 +294,7 @@ static void Close( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
     if( p_sys->p_previous_pic )
         picture_Release( p_sys->p_previous_pic );
+    if( p_sys->p_mci )
+        fps_mci_Delete( p_sys->p_mci );
     free( p_sys );
 }
@@ -0,0 +1,717 @@
+/*****************************************************************************
+ * fps_mci.c : motion compensated frame interpolation for the fps filter
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The motion is estimated on the luma plane with 16x16 blocks. Each block
+ * of the current picture is matched against the previous picture, starting
+ * from a few predictors (zero, spatial neighbours and the previous vector
+ * field) refined with a diamond search.
+ *
+ * Interpolated pictures are built by fetching both source pictures along
+ * the vectors, scaled to the output phase. To avoid blocking artifacts, the
+ * predictions of the four nearest blocks are blended with bilinear weights
+ * (overlapped block motion compensation).
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define FPS_MCI_NEON 1
+#endif
+
+#include "fps_mci.h"
+
+#define BLOCK_SIZE 16
+/* Maximum vector component in luma pixels */
+#define SEARCH_RANGE 48
+/* Cost added per pixel of vector length, favours null vectors in flat areas */
+#define VECTOR_PENALTY 2
+/* Average difference per pixel above which a block is considered unmatched */
+#define BAD_BLOCK_SAD (20 * BLOCK_SIZE * BLOCK_SIZE)
+/* Percentage of unmatched blocks above which the scene is deemed changed */
+#define SCENE_CHANGE_RATIO 40
+
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+} mv_t;
+
+typedef unsigned (*sad_fn)( const uint8_t *, ptrdiff_t,
+                            const uint8_t *, ptrdiff_t );
+typedef void (*blend_fn)( uint8_t *, const uint8_t *, const uint8_t *,
+                          unsigned, unsigned );
+
+struct fps_mci_worker
+{
+    fps_mci_t   *mci;
+    unsigned     index;
+    vlc_thread_t thread;
+};
+
+struct fps_mci_t
+{
+    vlc_object_t *obj;
+    const vlc_chroma_description_t *desc;
+    unsigned width;
+    unsigned height;
+    unsigned blocks_x;
+    unsigned blocks_y;
+
+    mv_t     *mv;
+    mv_t     *mv_prev;
+    unsigned *sad;
+
+    sad_fn    sad16x16;
+    blend_fn  blend;
+
+    /* Current job */
+    void    (*job)( fps_mci_t *, unsigned, unsigned );
+    const picture_t *prev;
+    const picture_t *cur;
+    picture_t *dst;
+    unsigned phase;
+
+    /* Workers */
+    unsigned thread_count;
+    struct fps_mci_worker *workers;
+    vlc_mutex_t lock;
+    vlc_cond_t  wait_job;
+    vlc_cond_t  wait_done;
+    unsigned    generation;
+    unsigned    pending;
+    bool        quit;
+};
+
+/*****************************************************************************
+ * Kernels
+ *****************************************************************************/
+static unsigned SAD16x16_C( const uint8_t *a, ptrdiff_t a_pitch,
+                            const uint8_t *b, ptrdiff_t b_pitch )
+{
+    unsigned sad = 0;
+
+    for( unsigned y = 0; y < 16; y++ )
+    {
+        for( unsigned x = 0; x < 16; x++ )
+            sad += abs( a[x] - b[x] );
+        a += a_pitch;
+        b += b_pitch;
+    }
+    return sad;
+}
+
+static void Blend_C( uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                     unsigned count, unsigned phase )
+{
+    const unsigned inv = 256 - phase;
+
+    for( unsigned x = 0; x < count; x++ )
+        dst[x] = ( a[x] * inv + b[x] * phase + 128 ) >> 8;
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static unsigned SAD16x16_SSE2( const uint8_t *a, ptrdiff_t a_pitch,
+                               const uint8_t *b, ptrdiff_t b_pitch )
+{
+    __m128i acc = _mm_setzero_si128();
+
+    for( unsigned y = 0; y < 16; y++ )
+    {
+        __m128i va = _mm_loadu_si128( (const __m128i *)a );
+        __m128i vb = _mm_loadu_si128( (const __m128i *)b );
+        acc = _mm_add_epi64( acc, _mm_sad_epu8( va, vb ) );
+        a += a_pitch;
+        b += b_pitch;
+    }
+    return _mm_cvtsi128_si32( acc ) + _mm_extract_epi16( acc, 4 );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Blend_SSE2( uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                        unsigned count, unsigned phase )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wa = _mm_set1_epi16( 256 - phase );
+    const __m128i wb = _mm_set1_epi16( phase );
+    const __m128i round = _mm_set1_epi16( 128 );
+    unsigned x = 0;
+
+    for( ; x + 8 <= count; x += 8 )
+    {
+        __m128i va = _mm_loadl_epi64( (const __m128i *)&a[x] );
+        __m128i vb = _mm_loadl_epi64( (const __m128i *)&b[x] );
+        va = _mm_mullo_epi16( _mm_unpacklo_epi8( va, zero ), wa );
+        vb = _mm_mullo_epi16( _mm_unpacklo_epi8( vb, zero ), wb );
+        /* At most 255 * 256 + 128, no overflow of the unsigned words */
+        __m128i v = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( va, vb ),
+                                                   round ), 8 );
+        _mm_storel_epi64( (__m128i *)&dst[x], _mm_packus_epi16( v, zero ) );
+    }
+    Blend_C( &dst[x], &a[x], &b[x], count - x, phase );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static unsigned SAD16x16_AVX2( const uint8_t *a, ptrdiff_t a_pitch,
+                               const uint8_t *b, ptrdiff_t b_pitch )
+{
+    __m256i acc = _mm256_setzero_si256();
+
+    /* Two rows per iteration */
+    for( unsigned y = 0; y < 16; y += 2 )
+    {
+        __m256i va = _mm256_inserti128_si256(
+            _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i *)a ) ),
+            _mm_loadu_si128( (const __m128i *)(a + a_pitch) ), 1 );
+        __m256i vb = _mm256_inserti128_si256(
+            _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i *)b ) ),
+            _mm_loadu_si128( (const __m128i *)(b + b_pitch) ), 1 );
+        acc = _mm256_add_epi64( acc, _mm256_sad_epu8( va, vb ) );
+        a += 2 * a_pitch;
+        b += 2 * b_pitch;
+    }
+
+    __m128i sum = _mm_add_epi64( _mm256_castsi256_si128( acc ),
+                                 _mm256_extracti128_si256( acc, 1 ) );
+    return _mm_cvtsi128_si32( sum ) + _mm_extract_epi16( sum, 4 );
+}
+#endif
+
+#ifdef FPS_MCI_NEON
+static unsigned SAD16x16_NEON( const uint8_t *a, ptrdiff_t a_pitch,
+                               const uint8_t *b, ptrdiff_t b_pitch )
+{
+    uint16x8_t acc = vdupq_n_u16( 0 );
+
+    for( unsigned y = 0; y < 16; y++ )
+    {
+        uint8x16_t va = vld1q_u8( a );
+        uint8x16_t vb = vld1q_u8( b );
+        acc = vabal_u8( acc, vget_low_u8( va ), vget_low_u8( vb ) );
+        acc = vabal_u8( acc, vget_high_u8( va ), vget_high_u8( vb ) );
+        a += a_pitch;
+        b += b_pitch;
+    }
+
+    uint64x2_t sum = vpaddlq_u32( vpaddlq_u16( acc ) );
+    return vgetq_lane_u64( sum, 0 ) + vgetq_lane_u64( sum, 1 );
+}
+
+static void Blend_NEON( uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                        unsigned count, unsigned phase )
+{
+    const uint16x8_t wa = vdupq_n_u16( 256 - phase );
+    const uint16x8_t wb = vdupq_n_u16( phase );
+    unsigned x = 0;
+
+    for( ; x + 8 <= count; x += 8 )
+    {
+        uint16x8_t v = vmulq_u16( vmovl_u8( vld1_u8( &a[x] ) ), wa );
+        v = vmlaq_u16( v, vmovl_u8( vld1_u8( &b[x] ) ), wb );
+        vst1_u8( &dst[x], vrshrn_n_u16( v, 8 ) );
+    }
+    Blend_C( &dst[x], &a[x], &b[x], count - x, phase );
+}
+#endif
+
+/*****************************************************************************
+ * Workers
+ *****************************************************************************/
+static void RunSlice( fps_mci_t *mci, unsigned index )
+{
+    unsigned start = mci->blocks_y * index / mci->thread_count;
+    unsigned end = mci->blocks_y * (index + 1) / mci->thread_count;
+
+    if( start < end )
+        mci->job( mci, start, end );
+}
+
+static void *Worker( void *data )
+{
+    struct fps_mci_worker *worker = data;
+    fps_mci_t *mci = worker->mci;
+    unsigned generation = 0;
+
+    vlc_mutex_lock( &mci->lock );
+    for( ;; )
+    {
+        while( !mci->quit && mci->generation == generation )
+            vlc_cond_wait( &mci->wait_job, &mci->lock );
+        if( mci->quit )
+            break;
+        generation = mci->generation;
+        vlc_mutex_unlock( &mci->lock );
+
+        RunSlice( mci, worker->index );
+
+        vlc_mutex_lock( &mci->lock );
+        assert( mci->pending > 0 );
+        if( --mci->pending == 0 )
+            vlc_cond_signal( &mci->wait_done );
+    }
+    vlc_mutex_unlock( &mci->lock );
+    return NULL;
+}
+
+/* Runs a job over all block rows, split among the threads */
+static void Run( fps_mci_t *mci, void (*job)( fps_mci_t *, unsigned, unsigned ) )
+{
+    mci->job = job;
+
+    if( mci->thread_count > 1 )
+    {
+        vlc_mutex_lock( &mci->lock );
+        mci->generation++;
+        mci->pending = mci->thread_count - 1;
+        vlc_cond_broadcast( &mci->wait_job );
+        vlc_mutex_unlock( &mci->lock );
+    }
+
+    RunSlice( mci, 0 );
+
+    if( mci->thread_count > 1 )
+    {
+        vlc_mutex_lock( &mci->lock );
+        while( mci->pending > 0 )
+            vlc_cond_wait( &mci->wait_done, &mci->lock );
+        vlc_mutex_unlock( &mci->lock );
+    }
+}
+
+/*****************************************************************************
+ * Motion estimation
+ *****************************************************************************/
+static inline unsigned VectorCost( fps_mci_t *mci, const uint8_t *block,
+                                   const plane_t *ref, int ox, int oy,
+                                   mv_t *mv, unsigned *sad )
+{
+    /* Keep the reference block within the picture */
+    mv->x = VLC_CLIP( mv->x, __MAX( -SEARCH_RANGE, -ox ),
+                      __MIN( SEARCH_RANGE, (int)mci->width - BLOCK_SIZE - ox ) );
+    mv->y = VLC_CLIP( mv->y, __MAX( -SEARCH_RANGE, -oy ),
+                      __MIN( SEARCH_RANGE, (int)mci->height - BLOCK_SIZE - oy ) );
+
+    const uint8_t *refblock = &ref->p_pixels[(oy + mv->y) * ref->i_pitch
+                                             + ox + mv->x];
+    *sad = mci->sad16x16( block, ref->i_pitch, refblock, ref->i_pitch );
+    return *sad + VECTOR_PENALTY * ( abs( mv->x ) + abs( mv->y ) );
+}
+
+static void EstimateRows( fps_mci_t *mci, unsigned start, unsigned end )
+{
+    const plane_t *cur = &mci->cur->p[0];
+    const plane_t *ref = &mci->prev->p[0];
+
+    for( unsigned by = start; by < end; by++ )
+    {
+        for( unsigned bx = 0; bx < mci->blocks_x; bx++ )
+        {
+            const unsigned index = by * mci->blocks_x + bx;
+            const int ox = __MIN( bx * BLOCK_SIZE, mci->width - BLOCK_SIZE );
+            const int oy = __MIN( by * BLOCK_SIZE, mci->height - BLOCK_SIZE );
+            const uint8_t *block = &cur->p_pixels[oy * cur->i_pitch + ox];
+
+            /* Predictors from this slice only, so that the result does not
+             * depend on the threads scheduling */
+            mv_t candidates[5];
+            unsigned count = 0;
+
+            candidates[count++] = (mv_t){ 0, 0 };
+            candidates[count++] = mci->mv_prev[index];
+            if( bx > 0 )
+                candidates[count++] = mci->mv[index - 1];
+            if( by > start )
+            {
+                candidates[count++] = mci->mv[index - mci->blocks_x];
+                if( bx + 1 < mci->blocks_x )
+                    candidates[count++] = mci->mv[index - mci->blocks_x + 1];
+            }
+
+            mv_t best = { 0, 0 };
+            unsigned best_sad = 0, best_cost = UINT_MAX;
+
+            for( unsigned i = 0; i < count; i++ )
+            {
+                mv_t mv = candidates[i];
+                unsigned sad;
+                unsigned cost = VectorCost( mci, block, ref, ox, oy, &mv, &sad );
+
+                if( cost < best_cost )
+                {
+                    best = mv;
+                    best_cost = cost;
+                    best_sad = sad;
+                }
+            }
+
+            /* Diamond refinement, with a decreasing step */
+            for( int step = 4; step > 0; step /= 2 )
+            {
+                for( unsigned iter = 0; iter < 8; iter++ )
+                {
+                    static const int8_t dirs[4][2] = {
+                        { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 },
+                    };
+                    mv_t center = best;
+
+                    for( unsigned i = 0; i < 4; i++ )
+                    {
+                        mv_t mv = { center.x + dirs[i][0] * step,
+                                    center.y + dirs[i][1] * step };
+                        unsigned sad;
+                        unsigned cost = VectorCost( mci, block, ref, ox, oy,
+                                                    &mv, &sad );
+
+                        if( cost < best_cost )
+                        {
+                            best = mv;
+                            best_cost = cost;
+                            best_sad = sad;
+                        }
+                    }
+                    if( best.x == center.x && best.y == center.y )
+                        break;
+                }
+            }
+
+            mci->mv[index] = best;
+            mci->sad[index] = best_sad;
+        }
+    }
+}
+
+int fps_mci_Estimate( fps_mci_t *mci, const picture_t *prev,
+                      const picture_t *cur )
+{
+    const unsigned total = mci->blocks_x * mci->blocks_y;
+
+    /* The current vectors become the temporal predictors */
+    mv_t *tmp = mci->mv_prev;
+    mci->mv_prev = mci->mv;
+    mci->mv = tmp;
+
+    mci->prev = prev;
+    mci->cur = cur;
+    Run( mci, EstimateRows );
+
+    unsigned bad = 0;
+    for( unsigned i = 0; i < total; i++ )
+        if( mci->sad[i] > BAD_BLOCK_SAD )
+            bad++;
+
+    if( bad * 100 > total * SCENE_CHANGE_RATIO )
+    {
+        /* Do not predict from unrelated content */
+        memset( mci->mv, 0, total * sizeof (*mci->mv) );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Interpolation
+ *****************************************************************************/
+static inline int ScaleVector( int v, unsigned phase )
+{
+    return ( v * (int)phase + 128 ) >> 8;
+}
+
+static inline uint8_t Compensate( const plane_t *prev, const plane_t *cur,
+                                  int width, int height, int x, int y,
+                                  int dx, int dy, unsigned phase )
+{
+    /* The object seen at (x,y) in the current picture was at (x,y)+d
+     * in the previous one */
+    const int px = ScaleVector( dx, phase ), py = ScaleVector( dy, phase );
+    const int ax = VLC_CLIP( x + px, 0, width - 1 );
+    const int ay = VLC_CLIP( y + py, 0, height - 1 );
+    const int bx = VLC_CLIP( x + px - dx, 0, width - 1 );
+    const int by = VLC_CLIP( y + py - dy, 0, height - 1 );
+
+    return ( prev->p_pixels[ay * prev->i_pitch + ax] * (256 - phase)
+           + cur->p_pixels[by * cur->i_pitch + bx] * phase + 128 ) >> 8;
+}
+
+/* Finds the two blocks surrounding a pixel position, and the weight of the
+ * second one */
+static inline void GetNeighbours( int pos, int size, unsigned count,
+                                  unsigned *b0, unsigned *b1, unsigned *w )
+{
+    const int rel = pos - size / 2;
+
+    if( rel < 0 )
+    {
+        *b0 = *b1 = 0;
+        *w = 0;
+        return;
+    }
+
+    *b0 = rel / size;
+    *b1 = *b0 + 1;
+    *w = ( rel - (int)*b0 * size ) * 256 / size;
+    if( *b1 >= count )
+    {
+        *b0 = *b1 = count - 1;
+        *w = 0;
+    }
+}
+
+static void InterpolatePlane( fps_mci_t *mci, unsigned plane,
+                              unsigned start, unsigned end )
+{
+    const plane_t *prev = &mci->prev->p[plane];
+    const plane_t *cur = &mci->cur->p[plane];
+    plane_t *dst = &mci->dst->p[plane];
+    const vlc_rational_t w = mci->desc->p[plane].w;
+    const vlc_rational_t h = mci->desc->p[plane].h;
+    const int width = dst->i_visible_pitch;
+    const int height = dst->i_visible_lines;
+    const int bw = BLOCK_SIZE * w.num / w.den;
+    const int bh = BLOCK_SIZE * h.num / h.den;
+    const unsigned phase = mci->phase;
+
+    const int y_end = __MIN( (int)end * bh, height );
+    for( int y = start * bh; y < y_end; y++ )
+    {
+        unsigned by0, by1, wy;
+        GetNeighbours( y, bh, mci->blocks_y, &by0, &by1, &wy );
+
+        const mv_t *row0 = &mci->mv[by0 * mci->blocks_x];
+        const mv_t *row1 = &mci->mv[by1 * mci->blocks_x];
+        uint8_t *out = &dst->p_pixels[y * dst->i_pitch];
+
+        /* Each cell spans the pixels between two block centers */
+        for( unsigned c = 0; c <= mci->blocks_x; c++ )
+        {
+            const int x0 = c == 0 ? 0 : (int)(c - 1) * bw + bw / 2;
+            const int x1 = c == mci->blocks_x ? width
+                         : __MIN( (int)c * bw + bw / 2, width );
+            const unsigned bx0 = c == 0 ? 0 : c - 1;
+            const unsigned bx1 = __MIN( c, mci->blocks_x - 1 );
+
+            if( x0 >= x1 )
+                continue;
+
+            const mv_t v[4] = { row0[bx0], row0[bx1], row1[bx0], row1[bx1] };
+            int dx[4], dy[4];
+            for( unsigned i = 0; i < 4; i++ )
+            {
+                dx[i] = v[i].x * w.num / (int)w.den;
+                dy[i] = v[i].y * h.num / (int)h.den;
+            }
+
+            if( dx[0] == dx[1] && dx[0] == dx[2] && dx[0] == dx[3] &&
+                dy[0] == dy[1] && dy[0] == dy[2] && dy[0] == dy[3] )
+            {
+                /* Uniform motion: blend whole spans if they are inside */
+                const int px = ScaleVector( dx[0], phase );
+                const int py = ScaleVector( dy[0], phase );
+                const int ya = y + py, yb = y + py - dy[0];
+
+                if( x0 + __MIN( px, px - dx[0] ) >= 0 &&
+                    x1 + __MAX( px, px - dx[0] ) <= width &&
+                    ya >= 0 && ya < height && yb >= 0 && yb < height )
+                {
+                    mci->blend( &out[x0],
+                                &prev->p_pixels[ya * prev->i_pitch + x0 + px],
+                                &cur->p_pixels[yb * cur->i_pitch + x0 + px - dx[0]],
+                                x1 - x0, phase );
+                    continue;
+                }
+
+                for( int x = x0; x < x1; x++ )
+                    out[x] = Compensate( prev, cur, width, height, x, y,
+                                         dx[0], dy[0], phase );
+                continue;
+            }
+
+            for( int x = x0; x < x1; x++ )
+            {
+                const unsigned wx = c == 0 || c == mci->blocks_x
+                                  ? 0 : ( x - x0 ) * 256 / bw;
+                const unsigned weights[4] = {
+                    (256 - wx) * (256 - wy), wx * (256 - wy),
+                    (256 - wx) * wy,         wx * wy,
+                };
+                unsigned sum = 0;
+
+                for( unsigned i = 0; i < 4; i++ )
+                    if( weights[i] != 0 )
+                        sum += weights[i] * Compensate( prev, cur, width,
+                                                        height, x, y, dx[i],
+                                                        dy[i], phase );
+                out[x] = ( sum + (1 << 15) ) >> 16;
+            }
+        }
+    }
+}
+
+static void InterpolateRows( fps_mci_t *mci, unsigned start, unsigned end )
+{
+    for( int i = 0; i < mci->dst->i_planes; i++ )
+        InterpolatePlane( mci, i, start, end );
+}
+
+void fps_mci_Interpolate( fps_mci_t *mci, picture_t *dst,
+                          const picture_t *prev, const picture_t *cur,
+                          unsigned phase )
+{
+    assert( phase <= 256 );
+    mci->prev = prev;
+    mci->cur = cur;
+    mci->dst = dst;
+    mci->phase = phase;
+    Run( mci, InterpolateRows );
+}
+
+/*****************************************************************************
+ * Creation
+ *****************************************************************************/
+fps_mci_t *fps_mci_New( vlc_object_t *obj, const video_format_t *fmt,
+                        unsigned threads )
+{
+    const vlc_chroma_description_t *desc =
+        vlc_fourcc_GetChromaDescription( fmt->i_chroma );
+
+    /* Planar only, semi-planar chroma samples are interleaved */
+    if( desc == NULL || desc->pixel_size != 1 || desc->plane_count == 2 ||
+        !vlc_fourcc_IsYUV( fmt->i_chroma ) )
+        return NULL;
+    if( fmt->i_visible_width < BLOCK_SIZE ||
+        fmt->i_visible_height < BLOCK_SIZE )
+        return NULL;
+
+    fps_mci_t *mci = calloc( 1, sizeof (*mci) );
+    if( unlikely(mci == NULL) )
+        return NULL;
+
+    mci->obj = obj;
+    mci->desc = desc;
+    mci->width = fmt->i_visible_width;
+    mci->height = fmt->i_visible_height;
+    mci->blocks_x = ( mci->width + BLOCK_SIZE - 1 ) / BLOCK_SIZE;
+    mci->blocks_y = ( mci->height + BLOCK_SIZE - 1 ) / BLOCK_SIZE;
+
+    const size_t total = mci->blocks_x * mci->blocks_y;
+    mci->mv = calloc( total, sizeof (*mci->mv) );
+    mci->mv_prev = calloc( total, sizeof (*mci->mv_prev) );
+    mci->sad = calloc( total, sizeof (*mci->sad) );
+    if( unlikely(mci->mv == NULL || mci->mv_prev == NULL || mci->sad == NULL) )
+        goto error;
+
+    mci->sad16x16 = SAD16x16_C;
+    mci->blend = Blend_C;
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+    {
+        mci->sad16x16 = SAD16x16_SSE2;
+        mci->blend = Blend_SSE2;
+    }
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        mci->sad16x16 = SAD16x16_AVX2;
+#endif
+#ifdef FPS_MCI_NEON
+    if( vlc_CPU_ARM_NEON() )
+    {
+        mci->sad16x16 = SAD16x16_NEON;
+        mci->blend = Blend_NEON;
+    }
+#endif
+
+    vlc_mutex_init( &mci->lock );
+    vlc_cond_init( &mci->wait_job );
+    vlc_cond_init( &mci->wait_done );
+
+    /* No need for more threads than rows of blocks */
+    threads = VLC_CLIP( threads, 1, mci->blocks_y );
+    mci->workers = vlc_alloc( threads, sizeof (*mci->workers) );
+    if( unlikely(mci->workers == NULL) )
+        goto error_threads;
+
+    mci->thread_count = 1;
+    for( unsigned i = 1; i < threads; i++ )
+    {
+        struct fps_mci_worker *worker = &mci->workers[i];
+
+        worker->mci = mci;
+        worker->index = i;
+        if( vlc_clone( &worker->thread, Worker, worker,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+            break;
+        mci->thread_count++;
+    }
+
+    msg_Dbg( obj, "motion compensation with %ux%u blocks, %u thread(s)",
+             mci->blocks_x, mci->blocks_y, mci->thread_count );
+    return mci;
+
+error_threads:
+    vlc_cond_destroy( &mci->wait_done );
+    vlc_cond_destroy( &mci->wait_job );
+    vlc_mutex_destroy( &mci->lock );
+error:
+    free( mci->sad );
+    free( mci->mv_prev );
+    free( mci->mv );
+    free( mci );
+    return NULL;
+}
+
+void fps_mci_Delete( fps_mci_t *mci )
+{
+    vlc_mutex_lock( &mci->lock );
+    mci->quit = true;
+    vlc_cond_broadcast( &mci->wait_job );
+    vlc_mutex_unlock( &mci->lock );
+
+    for( unsigned i = 1; i < mci->thread_count; i++ )
+        vlc_join( mci->workers[i].thread, NULL );
+
+    vlc_cond_destroy( &mci->wait_done );
+    vlc_cond_destroy( &mci->wait_job );
+    vlc_mutex_destroy( &mci->lock );
+    free( mci->workers );
+    free( mci->sad );
+    free( mci->mv_prev );
+    free( mci->mv );
+    free( mci );
+}
@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * fps_mci.h : motion compensated frame interpolation for the fps filter
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FPS_MCI_H
+#define VLC_FPS_MCI_H 1
+
+typedef struct fps_mci_t fps_mci_t;
+
+/**
+ * Creates a motion compensated interpolator for 8-bits planar YUV pictures.
+ *
+ * \param threads number of threads sharing the work (including the caller)
+ * \return NULL if the chroma is not supported or on error
+ */
+fps_mci_t *fps_mci_New( vlc_object_t *, const video_format_t *,
+                        unsigned threads );
+void fps_mci_Delete( fps_mci_t * );
+
+/**
+ * Estimates the motion between two consecutive pictures.
+ *
+ * \return VLC_SUCCESS, or VLC_EGENERIC if the pictures are too different
+ * (scene change) to be interpolated
+ */
+int fps_mci_Estimate( fps_mci_t *, const picture_t *prev,
+                      const picture_t *cur );
+
+/**
+ * Interpolates a picture between the pictures given to the last successful
+ * fps_mci_Estimate() call.
+ *
+ * \param phase position of the output picture, from 0 (prev) to 256 (cur)
+ */
+void fps_mci_Interpolate( fps_mci_t *, picture_t *dst, const picture_t *prev,
+                          const picture_t *cur, unsigned phase );
+
+#endif
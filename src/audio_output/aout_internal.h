@@ -68,6 +68,7 @@ typedef struct
         vlc_tick_t resamp_start_drift; /**< Resampler drift absolute value */
         int resamp_type; /**< Resampler mode (FIXME: redundant / resampling) */
         bool discontinuity;
+        bool offline; /**< Not rendering in real time */
         vlc_tick_t request_delay;
         vlc_tick_t delay;
         vlc_tick_t first_pts;
@@ -90,10 +91,15 @@ typedef struct
     /* Output format used and modified by the module. */
     audio_sample_format_t mixer_format;
 
+    /* Format of the filters output, given to the software amplifier. It is
+     * the mixer_format, unless the amplifier also converts the samples. */
+    audio_sample_format_t volume_format;
+
     aout_filters_cfg_t filters_cfg;
 
     atomic_uint buffers_lost;
     atomic_uint buffers_played;
+    atomic_bool loudness_update; /**< New measurements from the filters */
     atomic_uchar restart;
 
     atomic_uintptr_t refs;
@@ -117,7 +123,7 @@ static inline aout_owner_t *aout_owner (audio_output_t *aout)
 /* From mixer.c : */
 aout_volume_t *aout_volume_New(vlc_object_t *, const audio_replay_gain_t *);
 #define aout_volume_New(o, g) aout_volume_New(VLC_OBJECT(o), g)
-int aout_volume_SetFormat(aout_volume_t *, vlc_fourcc_t);
+int aout_volume_SetFormat(aout_volume_t *, vlc_fourcc_t, vlc_fourcc_t);
 void aout_volume_SetVolume(aout_volume_t *, float);
 int aout_volume_Amplify(aout_volume_t *, block_t *);
 void aout_volume_Delete(aout_volume_t *);
@@ -145,10 +151,12 @@ void aout_FormatsPrint(vlc_object_t *, const char *,
 #define AOUT_DEC_FAILED VLC_EGENERIC
 
 int aout_DecNew(audio_output_t *, const audio_sample_format_t *, int profile,
-                struct vlc_clock_t *clock, const audio_replay_gain_t *);
+                struct vlc_clock_t *clock, const audio_replay_gain_t *,
+                bool offline);
 void aout_DecDelete(audio_output_t *);
 int aout_DecPlay(audio_output_t *aout, block_t *block);
 void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *);
+bool aout_DecGetLoudness(audio_output_t *, struct vlc_audio_loudness *);
 void aout_DecChangePause(audio_output_t *, bool b_paused, vlc_tick_t i_date);
 void aout_DecChangeRate(audio_output_t *aout, float rate);
 void aout_DecChangeDelay(audio_output_t *aout, vlc_tick_t delay);
@@ -29,8 +29,17 @@
 
 #include <vlc_common.h>
 #include <vlc_aout.h>
+#include <vlc_cpu.h>
 #include "aout_internal.h"
 
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define AOUT_NEON 1
+#endif
+
 /*
  * Formats management (internal and external)
  */
@@ -353,6 +362,199 @@ do { \
     }
 }
 
+/*
+ * Stereo (de)interleaving fast paths, for 16-bits and 32-bits samples.
+ * They return how many samples were processed; the caller handles the rest.
+ */
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static size_t Interleave2x16_SSE2( int16_t *d, const int16_t *l,
+                                   const int16_t *r, size_t samples )
+{
+    size_t i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i *)&l[i] );
+        __m128i b = _mm_loadu_si128( (const __m128i *)&r[i] );
+        _mm_storeu_si128( (__m128i *)&d[2 * i], _mm_unpacklo_epi16( a, b ) );
+        _mm_storeu_si128( (__m128i *)&d[2 * i + 8],
+                          _mm_unpackhi_epi16( a, b ) );
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t Interleave2x32_SSE2( int32_t *d, const int32_t *l,
+                                   const int32_t *r, size_t samples )
+{
+    size_t i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i *)&l[i] );
+        __m128i b = _mm_loadu_si128( (const __m128i *)&r[i] );
+        _mm_storeu_si128( (__m128i *)&d[2 * i], _mm_unpacklo_epi32( a, b ) );
+        _mm_storeu_si128( (__m128i *)&d[2 * i + 4],
+                          _mm_unpackhi_epi32( a, b ) );
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t Deinterleave2x16_SSE2( int16_t *l, int16_t *r,
+                                     const int16_t *s, size_t samples )
+{
+    size_t i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i *)&s[2 * i] );
+        __m128i b = _mm_loadu_si128( (const __m128i *)&s[2 * i + 8] );
+        /* Sign-extend each channel to 32-bits, so that packing is exact */
+        __m128i la = _mm_srai_epi32( _mm_slli_epi32( a, 16 ), 16 );
+        __m128i lb = _mm_srai_epi32( _mm_slli_epi32( b, 16 ), 16 );
+        _mm_storeu_si128( (__m128i *)&l[i], _mm_packs_epi32( la, lb ) );
+        _mm_storeu_si128( (__m128i *)&r[i],
+                          _mm_packs_epi32( _mm_srai_epi32( a, 16 ),
+                                           _mm_srai_epi32( b, 16 ) ) );
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t Deinterleave2x32_SSE2( int32_t *l, int32_t *r,
+                                     const int32_t *s, size_t samples )
+{
+    size_t i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        __m128 a = _mm_loadu_ps( (const float *)&s[2 * i] );
+        __m128 b = _mm_loadu_ps( (const float *)&s[2 * i + 4] );
+        _mm_storeu_ps( (float *)&l[i], _mm_shuffle_ps( a, b, 0x88 ) );
+        _mm_storeu_ps( (float *)&r[i], _mm_shuffle_ps( a, b, 0xdd ) );
+    }
+    return i;
+}
+#endif
+
+#ifdef AOUT_NEON
+static size_t Interleave2x16_NEON( int16_t *d, const int16_t *l,
+                                   const int16_t *r, size_t samples )
+{
+    size_t i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        int16x8x2_t v = { { vld1q_s16( &l[i] ), vld1q_s16( &r[i] ) } };
+        vst2q_s16( &d[2 * i], v );
+    }
+    return i;
+}
+
+static size_t Interleave2x32_NEON( int32_t *d, const int32_t *l,
+                                   const int32_t *r, size_t samples )
+{
+    size_t i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        int32x4x2_t v = { { vld1q_s32( &l[i] ), vld1q_s32( &r[i] ) } };
+        vst2q_s32( &d[2 * i], v );
+    }
+    return i;
+}
+
+static size_t Deinterleave2x16_NEON( int16_t *l, int16_t *r,
+                                     const int16_t *s, size_t samples )
+{
+    size_t i = 0;
+
+    for( ; i + 8 <= samples; i += 8 )
+    {
+        int16x8x2_t v = vld2q_s16( &s[2 * i] );
+        vst1q_s16( &l[i], v.val[0] );
+        vst1q_s16( &r[i], v.val[1] );
+    }
+    return i;
+}
+
+static size_t Deinterleave2x32_NEON( int32_t *l, int32_t *r,
+                                     const int32_t *s, size_t samples )
+{
+    size_t i = 0;
+
+    for( ; i + 4 <= samples; i += 4 )
+    {
+        int32x4x2_t v = vld2q_s32( &s[2 * i] );
+        vst1q_s32( &l[i], v.val[0] );
+        vst1q_s32( &r[i], v.val[1] );
+    }
+    return i;
+}
+#endif
+
+static size_t Interleave2x16( int16_t *d, const int16_t *l, const int16_t *r,
+                              size_t samples )
+{
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+        return Interleave2x16_SSE2( d, l, r, samples );
+#endif
+#ifdef AOUT_NEON
+    if( vlc_CPU_ARM_NEON() )
+        return Interleave2x16_NEON( d, l, r, samples );
+#endif
+    VLC_UNUSED(d); VLC_UNUSED(l); VLC_UNUSED(r); VLC_UNUSED(samples);
+    return 0;
+}
+
+static size_t Interleave2x32( int32_t *d, const int32_t *l, const int32_t *r,
+                              size_t samples )
+{
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+        return Interleave2x32_SSE2( d, l, r, samples );
+#endif
+#ifdef AOUT_NEON
+    if( vlc_CPU_ARM_NEON() )
+        return Interleave2x32_NEON( d, l, r, samples );
+#endif
+    VLC_UNUSED(d); VLC_UNUSED(l); VLC_UNUSED(r); VLC_UNUSED(samples);
+    return 0;
+}
+
+static size_t Deinterleave2x16( int16_t *l, int16_t *r, const int16_t *s,
+                                size_t samples )
+{
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+        return Deinterleave2x16_SSE2( l, r, s, samples );
+#endif
+#ifdef AOUT_NEON
+    if( vlc_CPU_ARM_NEON() )
+        return Deinterleave2x16_NEON( l, r, s, samples );
+#endif
+    VLC_UNUSED(l); VLC_UNUSED(r); VLC_UNUSED(s); VLC_UNUSED(samples);
+    return 0;
+}
+
+static size_t Deinterleave2x32( int32_t *l, int32_t *r, const int32_t *s,
+                                size_t samples )
+{
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+        return Deinterleave2x32_SSE2( l, r, s, samples );
+#endif
+#ifdef AOUT_NEON
+    if( vlc_CPU_ARM_NEON() )
+        return Deinterleave2x32_NEON( l, r, s, samples );
+#endif
+    VLC_UNUSED(l); VLC_UNUSED(r); VLC_UNUSED(s); VLC_UNUSED(samples);
+    return 0;
+}
+
 /**
  * Interleaves audio samples within a block of samples.
  * \param dst destination buffer for interleaved samples
@@ -366,26 +568,31 @@ do { \
 void aout_Interleave( void *restrict dst, const void *const *srcv,
                       unsigned samples, unsigned chans, vlc_fourcc_t fourcc )
 {
-#define INTERLEAVE_TYPE(type) \
+#define INTERLEAVE_TYPE(type, stereo) \
 do { \
     type *d = dst; \
+    size_t done = 0; \
+    if( chans == 2 ) \
+        done = stereo( dst, srcv[0], srcv[1], samples ); \
     for( size_t i = 0; i < chans; i++ ) { \
-        const type *s = srcv[i]; \
-        for( size_t j = 0, k = 0; j < samples; j++, k += chans ) \
+        const type *s = (const type *)srcv[i] + done; \
+        for( size_t j = done, k = done * chans; j < samples; j++, k += chans ) \
             d[k] = *(s++); \
         d++; \
     } \
 } while(0)
+#define NO_STEREO(d, l, r, n) 0
 
     switch( fourcc )
     {
-        case VLC_CODEC_U8:   INTERLEAVE_TYPE(uint8_t);  break;
-        case VLC_CODEC_S16N: INTERLEAVE_TYPE(int16_t);  break;
-        case VLC_CODEC_FL32: INTERLEAVE_TYPE(float);    break;
-        case VLC_CODEC_S32N: INTERLEAVE_TYPE(int32_t);  break;
-        case VLC_CODEC_FL64: INTERLEAVE_TYPE(double);   break;
+        case VLC_CODEC_U8:   INTERLEAVE_TYPE(uint8_t, NO_STEREO);       break;
+        case VLC_CODEC_S16N: INTERLEAVE_TYPE(int16_t, Interleave2x16);  break;
+        case VLC_CODEC_FL32: INTERLEAVE_TYPE(float, Interleave2x32);    break;
+        case VLC_CODEC_S32N: INTERLEAVE_TYPE(int32_t, Interleave2x32);  break;
+        case VLC_CODEC_FL64: INTERLEAVE_TYPE(double, NO_STEREO);        break;
         default:             vlc_assert_unreachable();
     }
+#undef NO_STEREO
 #undef INTERLEAVE_TYPE
 }
 
@@ -402,26 +609,32 @@ do { \
 void aout_Deinterleave( void *restrict dst, const void *restrict src,
                       unsigned samples, unsigned chans, vlc_fourcc_t fourcc )
 {
-#define DEINTERLEAVE_TYPE(type) \
+#define DEINTERLEAVE_TYPE(type, stereo) \
 do { \
     type *d = dst; \
     const type *s = src; \
+    size_t done = 0; \
+    if( chans == 2 ) \
+        done = stereo( dst, (void *)(d + samples), src, samples ); \
     for( size_t i = 0; i < chans; i++ ) { \
-        for( size_t j = 0, k = 0; j < samples; j++, k += chans ) \
+        d += done; \
+        for( size_t j = done, k = done * chans; j < samples; j++, k += chans ) \
             *(d++) = s[k]; \
         s++; \
     } \
 } while(0)
+#define NO_STEREO(l, r, s, n) 0
 
     switch( fourcc )
     {
-        case VLC_CODEC_U8:   DEINTERLEAVE_TYPE(uint8_t);  break;
-        case VLC_CODEC_S16N: DEINTERLEAVE_TYPE(int16_t);  break;
-        case VLC_CODEC_FL32: DEINTERLEAVE_TYPE(float);    break;
-        case VLC_CODEC_S32N: DEINTERLEAVE_TYPE(int32_t);  break;
-        case VLC_CODEC_FL64: DEINTERLEAVE_TYPE(double);   break;
+        case VLC_CODEC_U8:   DEINTERLEAVE_TYPE(uint8_t, NO_STEREO);         break;
+        case VLC_CODEC_S16N: DEINTERLEAVE_TYPE(int16_t, Deinterleave2x16);  break;
+        case VLC_CODEC_FL32: DEINTERLEAVE_TYPE(float, Deinterleave2x32);    break;
+        case VLC_CODEC_S32N: DEINTERLEAVE_TYPE(int32_t, Deinterleave2x32);  break;
+        case VLC_CODEC_FL64: DEINTERLEAVE_TYPE(double, NO_STEREO);          break;
         default:             vlc_assert_unreachable();
     }
+#undef NO_STEREO
 #undef DEINTERLEAVE_TYPE
 }
 
@@ -50,12 +50,40 @@ static void aout_Drain(audio_output_t *aout)
     }
 }
 
+/**
+ * Configures the software amplifier for the mixer format.
+ *
+ * If the output requires 16-bits integers while the decoder produces floats,
+ * the filters keep the floats and the amplifier converts them while applying
+ * the gain, which saves one pass over the samples (and a lossy integer gain).
+ */
+static void aout_DecSetupVolume(audio_output_t *aout)
+{
+    aout_owner_t *owner = aout_owner (aout);
+    const vlc_fourcc_t format = owner->mixer_format.i_format;
+
+    owner->volume_format = owner->mixer_format;
+
+    if (format == VLC_CODEC_S16N
+     && owner->input_format.i_format == VLC_CODEC_FL32
+     && aout_volume_SetFormat (owner->volume, VLC_CODEC_FL32, format) == 0)
+    {
+        owner->volume_format.i_format = VLC_CODEC_FL32;
+        aout_FormatPrepare (&owner->volume_format);
+        return;
+    }
+    aout_volume_SetFormat (owner->volume, format, format);
+}
+
 /**
  * Creates an audio output
+ *
+ * \param offline true if the output does not render in real time, in which
+ *                case the playback is not synchronized to the clock
  */
 int aout_DecNew(audio_output_t *p_aout, const audio_sample_format_t *p_format,
                 int profile, vlc_clock_t *clock,
-                const audio_replay_gain_t *p_replay_gain)
+                const audio_replay_gain_t *p_replay_gain, bool offline)
 {
     assert(p_aout);
     assert(p_format);
@@ -100,12 +128,12 @@ int aout_DecNew(audio_output_t *p_aout, const audio_sample_format_t *p_format,
     owner->filters_cfg = AOUT_FILTERS_CFG_INIT;
     if (aout_OutputNew (p_aout))
         goto error;
-    aout_volume_SetFormat (owner->volume, owner->mixer_format.i_format);
+    aout_DecSetupVolume (p_aout);
 
     /* Create the audio filtering "input" pipeline */
     owner->filters = aout_FiltersNewWithClock(VLC_OBJECT(p_aout), clock,
                                               &owner->filter_format,
-                                              &owner->mixer_format,
+                                              &owner->volume_format,
                                               &owner->filters_cfg);
     if (owner->filters == NULL)
     {
@@ -119,6 +147,7 @@ error:
     owner->sync.rate = 1.f;
     owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
     owner->sync.discontinuity = true;
+    owner->sync.offline = offline;
     owner->original_pts = VLC_TICK_INVALID;
     owner->sync.delay = owner->sync.request_delay = 0;
 
@@ -166,8 +195,7 @@ static int aout_CheckReady (audio_output_t *aout)
             owner->filters_cfg = AOUT_FILTERS_CFG_INIT;
             if (aout_OutputNew (aout))
                 owner->mixer_format.i_format = 0;
-            aout_volume_SetFormat (owner->volume,
-                                   owner->mixer_format.i_format);
+            aout_DecSetupVolume (aout);
 
             /* Notify the decoder that the aout changed in order to try a new
              * suitable codec (like an HDMI audio format). However, keep the
@@ -185,7 +213,7 @@ static int aout_CheckReady (audio_output_t *aout)
             owner->filters = aout_FiltersNewWithClock(VLC_OBJECT(aout),
                                                       owner->sync.clock,
                                                       &owner->filter_format,
-                                                      &owner->mixer_format,
+                                                      &owner->volume_format,
                                                       &owner->filters_cfg);
             if (owner->filters == NULL)
             {
@@ -460,7 +488,13 @@ int aout_DecPlay(audio_output_t *aout, block_t *block)
 
     /* Drift correction */
     vlc_tick_t system_now = vlc_tick_now();
-    aout_DecSynchronize(aout, system_now, original_pts);
+    if (owner->sync.offline)
+        /* The samples are consumed as fast as they are decoded: there is no
+         * drift to correct, only the progress to report. */
+        vlc_clock_Update(owner->sync.clock, system_now, original_pts,
+                         owner->sync.rate);
+    else
+        aout_DecSynchronize(aout, system_now, original_pts);
 
     vlc_tick_t play_date =
         vlc_clock_ConvertToSystem(owner->sync.clock, system_now, original_pts,
@@ -497,6 +531,26 @@ void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
                                        memory_order_relaxed);
 }
 
+/**
+ * Reads the loudness measured by the filters, if updated since the last call.
+ */
+bool aout_DecGetLoudness(audio_output_t *aout,
+                         struct vlc_audio_loudness *restrict loudness)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    if (!atomic_exchange_explicit(&owner->loudness_update, false,
+                                  memory_order_acquire))
+        return false;
+
+    loudness->momentary = var_GetFloat(aout, "loudness-momentary");
+    loudness->short_term = var_GetFloat(aout, "loudness-short-term");
+    loudness->integrated = var_GetFloat(aout, "loudness-integrated");
+    loudness->range = var_GetFloat(aout, "loudness-range");
+    loudness->true_peak = var_GetFloat(aout, "loudness-peak");
+    return true;
+}
+
 void aout_DecChangePause (audio_output_t *aout, bool paused, vlc_tick_t date)
 {
     aout_owner_t *owner = aout_owner (aout);
@@ -563,7 +617,10 @@ void aout_DecDrain(audio_output_t *aout)
 
     block_t *block = aout_FiltersDrain (owner->filters);
     if (block)
+    {
+        aout_volume_Amplify (owner->volume, block);
         aout->play(aout, block, vlc_tick_now());
+    }
 
     aout_Drain(aout);
 
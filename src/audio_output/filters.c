@@ -40,7 +40,235 @@
 #include "aout_internal.h"
 #include "../video_output/vout_internal.h" /* for vout_Request */
 
-static filter_t *CreateFilter(vlc_object_t *obj, vlc_clock_t *clock,
+#define AOUT_MAX_FILTERS 10
+
+struct aout_filters
+{
+    filter_t *rate_filter; /**< The filter adjusting samples count
+        (either the scaletempo filter or a resampler) */
+    filter_t *resampler; /**< The resampler */
+    int resampling; /**< Current resampling (Hz) */
+    vlc_clock_t *clock;
+    struct aout_buffer_pool *pool; /**< Output buffers of the filters */
+
+    unsigned count; /**< Number of filters */
+    filter_t *tab[AOUT_MAX_FILTERS]; /**< Configured user filters
+        (e.g. equalization) and their conversions */
+};
+
+/**
+ * Output buffers of a chain of audio filters
+ *
+ * Filters get their output buffers from filter_NewAudioBuffer(). Those
+ * buffers are recycled when released, rather than freed. The output buffer
+ * of a filter is released by the next filter that does not work in place,
+ * once it has written its own output, and then serves as output buffer for
+ * the following one. In steady state, the filters thus ping-pong between a
+ * couple of buffers, without allocating memory.
+ *
+ * The pool outlives the chain as long as some of its buffers are in use
+ * (e.g. by the audio output).
+ */
+typedef struct aout_buffer_pool
+{
+    vlc_mutex_t lock;
+    block_t *free; /**< Recycled buffers */
+    size_t size; /**< Minimum capacity of the buffers */
+    unsigned outstanding; /**< Buffers in use */
+    bool alive; /**< False once the chain is destroyed */
+    aout_filters_stats_t stats;
+} aout_buffer_pool_t;
+
+struct aout_buffer
+{
+    block_t self;
+    aout_buffer_pool_t *pool;
+    size_t capacity;
+};
+
+#define AOUT_BUFFER_ALIGN 32
+
+static void aout_BufferRecycle(block_t *block)
+{
+    struct aout_buffer *buf = container_of(block, struct aout_buffer, self);
+    aout_buffer_pool_t *pool = buf->pool;
+
+    vlc_mutex_lock(&pool->lock);
+    bool keep = pool->alive && buf->capacity >= pool->size;
+    if (keep)
+    {
+        block->p_next = pool->free;
+        pool->free = block;
+    }
+    assert(pool->outstanding > 0);
+    pool->outstanding--;
+    bool last = !pool->alive && pool->outstanding == 0;
+    vlc_mutex_unlock(&pool->lock);
+
+    if (!keep)
+        free(buf);
+    if (last)
+    {
+        vlc_mutex_destroy(&pool->lock);
+        free(pool);
+    }
+}
+
+static const struct vlc_block_callbacks aout_buffer_cbs =
+{
+    aout_BufferRecycle,
+};
+
+static block_t *aout_BufferInit(struct aout_buffer *buf, size_t size)
+{
+    block_t *block = &buf->self;
+    /* Same padding and alignment as block_Alloc() */
+    block_Init(block, &aout_buffer_cbs, buf + 1,
+               buf->capacity + 3 * AOUT_BUFFER_ALIGN);
+    block->p_buffer += 2 * AOUT_BUFFER_ALIGN - 1;
+    block->p_buffer = (void *)(((uintptr_t)block->p_buffer)
+                               & ~(uintptr_t)(AOUT_BUFFER_ALIGN - 1));
+    block->i_buffer = size;
+    return block;
+}
+
+static struct aout_buffer *aout_BufferAlloc(aout_buffer_pool_t *pool,
+                                            size_t capacity)
+{
+    if (unlikely(capacity >> 27))
+        return NULL;
+
+    struct aout_buffer *buf = malloc(sizeof (*buf) + capacity
+                                     + 3 * AOUT_BUFFER_ALIGN);
+    if (unlikely(buf == NULL))
+        return NULL;
+
+    buf->pool = pool;
+    buf->capacity = capacity;
+    return buf;
+}
+
+static aout_buffer_pool_t *aout_BufferPoolNew(void)
+{
+    aout_buffer_pool_t *pool = malloc(sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init(&pool->lock);
+    pool->free = NULL;
+    pool->size = 0;
+    pool->outstanding = 0;
+    pool->alive = true;
+    pool->stats.buffers = 0;
+    pool->stats.allocations = 0;
+    return pool;
+}
+
+/**
+ * Allocates buffers ahead of time, so that the first buffers do not need
+ * allocations either.
+ */
+static void aout_BufferPoolReserve(aout_buffer_pool_t *pool, size_t size,
+                                   unsigned count)
+{
+    vlc_mutex_lock(&pool->lock);
+    if (size > pool->size)
+        pool->size = size;
+    while (count-- > 0)
+    {
+        struct aout_buffer *buf = aout_BufferAlloc(pool, pool->size);
+        if (buf == NULL)
+            break;
+        buf->self.p_next = pool->free;
+        pool->free = &buf->self;
+        pool->stats.allocations++;
+    }
+    vlc_mutex_unlock(&pool->lock);
+}
+
+static block_t *aout_BufferPoolGet(aout_buffer_pool_t *pool, size_t size)
+{
+    block_t *stale = NULL;
+    struct aout_buffer *buf = NULL;
+
+    vlc_mutex_lock(&pool->lock);
+    pool->stats.buffers++;
+    if (size > pool->size)
+        pool->size = size;
+
+    while (pool->free != NULL)
+    {
+        block_t *block = pool->free;
+        pool->free = block->p_next;
+
+        struct aout_buffer *cand = container_of(block, struct aout_buffer,
+                                                self);
+        if (cand->capacity >= size)
+        {
+            buf = cand;
+            break;
+        }
+        /* Too small for the current chain, drop it */
+        block->p_next = stale;
+        stale = block;
+    }
+
+    if (buf == NULL)
+    {
+        buf = aout_BufferAlloc(pool, pool->size);
+        if (buf != NULL)
+            pool->stats.allocations++;
+    }
+    if (buf != NULL)
+        pool->outstanding++;
+    vlc_mutex_unlock(&pool->lock);
+
+    while (stale != NULL)
+    {
+        block_t *next = stale->p_next;
+        free(container_of(stale, struct aout_buffer, self));
+        stale = next;
+    }
+
+    return buf != NULL ? aout_BufferInit(buf, size) : NULL;
+}
+
+static void aout_BufferPoolDelete(aout_buffer_pool_t *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    block_t *list = pool->free;
+    pool->free = NULL;
+    pool->alive = false;
+    bool last = pool->outstanding == 0;
+    vlc_mutex_unlock(&pool->lock);
+
+    while (list != NULL)
+    {
+        block_t *next = list->p_next;
+        free(container_of(list, struct aout_buffer, self));
+        list = next;
+    }
+
+    if (last)
+    {
+        vlc_mutex_destroy(&pool->lock);
+        free(pool);
+    }
+}
+
+static block_t *aout_FilterBufferNew(filter_t *filter, size_t size)
+{
+    aout_filters_t *filters = filter->owner.sys;
+
+    return filters != NULL ? aout_BufferPoolGet(filters->pool, size) : NULL;
+}
+
+static const struct filter_audio_callbacks aout_filter_cbs =
+{
+    aout_FilterBufferNew,
+};
+
+static filter_t *CreateFilter(vlc_object_t *obj, aout_filters_t *owner,
                               const char *type, const char *name,
                               const audio_sample_format_t *infmt,
                               const audio_sample_format_t *outfmt,
@@ -50,7 +278,8 @@ static filter_t *CreateFilter(vlc_object_t *obj, vlc_clock_t *clock,
     if (unlikely(filter == NULL))
         return NULL;
 
-    filter->owner.sys = clock;
+    filter->owner.audio = &aout_filter_cbs;
+    filter->owner.sys = owner;
     filter->p_cfg = cfg;
     filter->fmt_in.audio = *infmt;
     filter->fmt_in.i_codec = infmt->i_format;
@@ -87,20 +316,20 @@ static filter_t *CreateFilter(vlc_object_t *obj, vlc_clock_t *clock,
     return filter;
 }
 
-static filter_t *FindConverter (vlc_object_t *obj,
+static filter_t *FindConverter (vlc_object_t *obj, aout_filters_t *owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
-    return CreateFilter(obj, NULL, "audio converter", NULL, infmt, outfmt,
+    return CreateFilter(obj, owner, "audio converter", NULL, infmt, outfmt,
                         NULL, true);
 }
 
-static filter_t *FindResampler (vlc_object_t *obj,
+static filter_t *FindResampler (vlc_object_t *obj, aout_filters_t *owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
     char *modlist = var_InheritString(obj, "audio-resampler");
-    filter_t *filter = CreateFilter(obj, NULL, "audio resampler", modlist,
+    filter_t *filter = CreateFilter(obj, owner, "audio resampler", modlist,
                                     infmt, outfmt, NULL, true);
     free(modlist);
     return filter;
@@ -120,7 +349,8 @@ static void aout_FiltersPipelineDestroy(filter_t *const *filters, unsigned n)
     }
 }
 
-static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
+static filter_t *TryFormat (vlc_object_t *obj, aout_filters_t *owner,
+                            vlc_fourcc_t codec,
                             audio_sample_format_t *restrict fmt)
 {
     audio_sample_format_t output = *fmt;
@@ -129,7 +359,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
     output.i_format = codec;
     aout_FormatPrepare (&output);
 
-    filter_t *filter = FindConverter (obj, fmt, &output);
+    filter_t *filter = FindConverter (obj, owner, fmt, &output);
     if (filter != NULL)
         *fmt = output;
     return filter;
@@ -138,6 +368,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
 /**
  * Allocates audio format conversion filters
  * @param obj parent VLC object for new filters
+ * @param owner filters chain providing the output buffers
  * @param filters table of filters [IN/OUT]
  * @param count pointer to the number of filters in the table [IN/OUT]
  * @param max size of filters table [IN]
@@ -145,7 +376,8 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
  * @param outfmt output audio format
  * @return 0 on success, -1 on failure
  */
-static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
+static int aout_FiltersPipelineCreate(vlc_object_t *obj, aout_filters_t *owner,
+                                      filter_t **filters,
                                       unsigned *count, unsigned max,
                                  const audio_sample_format_t *restrict infmt,
                                  const audio_sample_format_t *restrict outfmt,
@@ -177,7 +409,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
             if (n == max)
                 goto overflow;
 
-            filter_t *f = TryFormat (obj, VLC_CODEC_FL32, &input);
+            filter_t *f = TryFormat (obj, owner, VLC_CODEC_FL32, &input);
             if (f == NULL)
             {
                 msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -206,7 +438,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         config_chain_t *cfg = NULL;
         if (headphones)
             config_ChainParseOptions(&cfg, "{headphones=true}");
-        filter_t *f = CreateFilter(obj, NULL, filter_type, NULL,
+        filter_t *f = CreateFilter(obj, owner, filter_type, NULL,
                                    &input, &output, cfg, true);
         if (cfg)
             config_ChainDestroy(cfg);
@@ -231,7 +463,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         audio_sample_format_t output = input;
         output.i_rate = outfmt->i_rate;
 
-        filter_t *f = FindConverter (obj, &input, &output);
+        filter_t *f = FindConverter (obj, owner, &input, &output);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -249,7 +481,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         if (max == 0)
             goto overflow;
 
-        filter_t *f = TryFormat (obj, outfmt->i_format, &input);
+        filter_t *f = TryFormat (obj, owner, outfmt->i_format, &input);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -340,20 +572,6 @@ static void aout_FiltersPipelineChangeViewpoint(filter_t *const *filters,
         filter_ChangeViewpoint (filters[i], vp);
 }
 
-#define AOUT_MAX_FILTERS 10
-
-struct aout_filters
-{
-    filter_t *rate_filter; /**< The filter adjusting samples count
-        (either the scaletempo filter or a resampler) */
-    filter_t *resampler; /**< The resampler */
-    int resampling; /**< Current resampling (Hz) */
-    vlc_clock_t *clock;
-
-    unsigned count; /**< Number of filters */
-    filter_t *tab[AOUT_MAX_FILTERS]; /**< Configured user filters
-        (e.g. equalization) and their conversions */
-};
 
 /** Callback for visualization selection */
 static int VisualizationCallback (vlc_object_t *obj, const char *var,
@@ -388,9 +606,11 @@ vout_thread_t *aout_filter_GetVout(filter_t *filter, const video_format_t *fmt)
     if (unlikely(vout == NULL))
         return NULL;
 
+    aout_filters_t *filters = filter->owner.sys;
     video_format_t adj_fmt = *fmt;
     vout_configuration_t cfg = {
-        .vout = vout, .clock = filter->owner.sys, .fmt = &adj_fmt, .dpb_size = 1,
+        .clock = filters != NULL ? filters->clock : NULL,
+        .vout = vout, .fmt = &adj_fmt, .dpb_size = 1,
     };
 
     video_format_AdjustColorSpace(&adj_fmt);
@@ -415,7 +635,7 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
         return -1;
     }
 
-    filter_t *filter = CreateFilter(obj, filters->clock, type, name,
+    filter_t *filter = CreateFilter(obj, filters, type, name,
                                     infmt, outfmt, cfg, false);
     if (filter == NULL)
     {
@@ -424,7 +644,7 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
     }
 
     /* convert to the filter input format if necessary */
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
+    if (aout_FiltersPipelineCreate (obj, filters, filters->tab, &filters->count,
                                     max - 1, infmt, &filter->fmt_in.audio, false))
     {
         msg_Err (filter, "cannot add user %s \"%s\" (skipped)", type, name);
@@ -486,6 +706,35 @@ static int AppendRemapFilter(vlc_object_t *obj, aout_filters_t *restrict filters
     return ret;
 }
 
+/**
+ * Reserves a pair of output buffers large enough for 100 ms at the largest
+ * frame size of the chain.
+ */
+static void aout_FiltersSetupBuffers(aout_filters_t *filters)
+{
+    size_t size = 0;
+
+    for (unsigned i = 0; i <= filters->count; i++)
+    {
+        filter_t *filter = (i < filters->count) ? filters->tab[i]
+                                                : filters->resampler;
+        if (filter == NULL)
+            continue;
+
+        const audio_format_t *fmt = &filter->fmt_out.audio;
+        size_t frame_size = fmt->i_bytes_per_frame;
+
+        if (fmt->i_frame_length > 1)
+            frame_size = (frame_size + fmt->i_frame_length - 1)
+                       / fmt->i_frame_length;
+        if (frame_size * (fmt->i_rate / 10) > size)
+            size = frame_size * (fmt->i_rate / 10);
+    }
+
+    if (size > 0)
+        aout_BufferPoolReserve(filters->pool, size, 2);
+}
+
 aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *clock,
                                          const audio_sample_format_t *restrict infmt,
                                          const audio_sample_format_t *restrict outfmt,
@@ -499,6 +748,12 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
     filters->resampler = NULL;
     filters->resampling = 0;
     filters->count = 0;
+    filters->pool = aout_BufferPoolNew();
+    if (unlikely(filters->pool == NULL))
+    {
+        free(filters);
+        return NULL;
+    }
     if (clock)
     {
         filters->clock = vlc_clock_CreateSlave(clock);
@@ -521,7 +776,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
         if (!AOUT_FMTS_IDENTICAL(infmt, outfmt))
         {
             aout_FormatsPrint (obj, "pass-through:", infmt, outfmt);
-            filters->tab[0] = FindConverter(obj, infmt, outfmt);
+            filters->tab[0] = FindConverter(obj, filters, infmt, outfmt);
             if (filters->tab[0] == NULL)
             {
                 msg_Err (obj, "cannot setup pass-through");
@@ -529,6 +784,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
             }
             filters->count++;
         }
+        aout_FiltersSetupBuffers(filters);
         return filters;
     }
     if (aout_FormatNbChannels(outfmt) == 0)
@@ -545,7 +801,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
 
         /* convert to the output format (minus resampling) if necessary */
         output_format.i_rate = input_format.i_rate;
-        if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
+        if (aout_FiltersPipelineCreate (obj, filters, filters->tab, &filters->count,
                                   AOUT_MAX_FILTERS, &input_format, &output_format,
                                   cfg->headphones))
         {
@@ -569,7 +825,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
         audio_sample_format_t input_phys_format = input_format;
         aout_SetWavePhysicalChannels(&input_phys_format);
 
-        filter_t *f = FindConverter (obj, &input_format, &input_phys_format);
+        filter_t *f = FindConverter (obj, filters, &input_format, &input_phys_format);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find channel converter");
@@ -621,7 +877,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
 
     /* convert to the output format (minus resampling) if necessary */
     output_format.i_rate = input_format.i_rate;
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
+    if (aout_FiltersPipelineCreate (obj, filters, filters->tab, &filters->count,
                               AOUT_MAX_FILTERS, &input_format, &output_format, false))
     {
         msg_Err (obj, "cannot setup filtering pipeline");
@@ -632,7 +888,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
     /* insert the resampler */
     output_format.i_rate = outfmt->i_rate;
     assert (AOUT_FMTS_IDENTICAL(&output_format, outfmt));
-    filters->resampler = FindResampler (obj, &input_format,
+    filters->resampler = FindResampler (obj, filters, &input_format,
                                         &output_format);
     if (filters->resampler == NULL && input_format.i_rate != outfmt->i_rate)
     {
@@ -642,6 +898,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
     if (filters->rate_filter == NULL)
         filters->rate_filter = filters->resampler;
 
+    aout_FiltersSetupBuffers(filters);
     return filters;
 
 error:
@@ -649,6 +906,7 @@ error:
     var_DelCallback(obj, "visual", VisualizationCallback, NULL);
     if (filters->clock)
         vlc_clock_Delete(filters->clock);
+    aout_BufferPoolDelete(filters->pool);
     free (filters);
     return NULL;
 }
@@ -696,9 +954,25 @@ void aout_FiltersDelete (vlc_object_t *obj, aout_filters_t *filters)
     var_DelCallback(obj, "visual", VisualizationCallback, NULL);
     if (filters->clock)
         vlc_clock_Delete(filters->clock);
+
+    aout_filters_stats_t stats;
+    aout_FiltersGetStats(filters, &stats);
+    msg_Dbg(obj, "filters output buffers: %"PRIu64" used, %"PRIu64
+            " allocated", stats.buffers, stats.allocations);
+    aout_BufferPoolDelete(filters->pool);
     free (filters);
 }
 
+void aout_FiltersGetStats(aout_filters_t *filters,
+                          aout_filters_stats_t *stats)
+{
+    aout_buffer_pool_t *pool = filters->pool;
+
+    vlc_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    vlc_mutex_unlock(&pool->lock);
+}
+
 bool aout_FiltersCanResample (aout_filters_t *filters)
 {
     return (filters->resampler != NULL);
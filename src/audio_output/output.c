@@ -25,6 +25,7 @@
 #endif
 
 #include <stdlib.h>
+#include <math.h>
 #include <assert.h>
 
 #include <vlc_common.h>
@@ -202,6 +203,17 @@ static int ViewpointCallback (vlc_object_t *obj, const char *var,
     return VLC_SUCCESS;
 }
 
+static int LoudnessCallback (vlc_object_t *obj, const char *var,
+                             vlc_value_t prev, vlc_value_t cur, void *data)
+{
+    aout_owner_t *owner = aout_owner ((audio_output_t *)obj);
+
+    atomic_store_explicit(&owner->loudness_update, true,
+                          memory_order_release);
+    (void) var; (void) prev; (void) cur; (void) data;
+    return VLC_SUCCESS;
+}
+
 #undef aout_New
 /**
  * Creates an audio output object and initializes an output module.
@@ -222,6 +234,7 @@ audio_output_t *aout_New (vlc_object_t *parent)
     vlc_mutex_init (&owner->vp.lock);
     vlc_viewpoint_init (&owner->vp.value);
     atomic_init (&owner->vp.update, false);
+    atomic_init(&owner->loudness_update, false);
     atomic_init(&owner->refs, 0);
 
     /* Audio output module callbacks */
@@ -338,6 +351,18 @@ audio_output_t *aout_New (vlc_object_t *parent)
     var_Create (aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
     var_Create (aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
 
+    /* Loudness measurements, set by the filters */
+    static const char *const loudness_vars[] = {
+        "loudness-momentary", "loudness-short-term", "loudness-integrated",
+        "loudness-range", "loudness-peak",
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(loudness_vars); i++)
+    {
+        var_Create (aout, loudness_vars[i], VLC_VAR_FLOAT);
+        var_SetFloat (aout, loudness_vars[i], NAN);
+    }
+    var_AddCallback (aout, "loudness-peak", LoudnessCallback, NULL);
+
     return aout;
 }
 
@@ -371,6 +396,7 @@ void aout_Destroy (audio_output_t *aout)
     var_SetFloat (aout, "volume", -1.f);
     var_DelCallback(aout, "volume", var_Copy, vlc_object_parent(aout));
     var_DelCallback (aout, "stereo-mode", StereoModeCallback, NULL);
+    var_DelCallback (aout, "loudness-peak", LoudnessCallback, NULL);
     aout_Release(aout);
 }
 
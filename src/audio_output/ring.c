@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * ring.c : lock-free audio output ring buffer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+
+#define NO_FLUSH SIZE_MAX
+
+/*
+ * The read and write positions are frame counters, which only ever increase.
+ * The queued frames are [read, write), stored at (position & mask).
+ * Each counter is written by one side only, and lives in its own cache line.
+ */
+struct vlc_aout_ring
+{
+    unsigned char *buf;
+    size_t frame_size;
+    size_t mask;
+    unsigned rate;
+
+    /* Written by the producer */
+    alignas (64) atomic_size_t write;
+    atomic_size_t flush; /**< position to skip to, or NO_FLUSH */
+
+    /* Written by the consumer */
+    alignas (64) atomic_size_t read;
+    atomic_int_least64_t end; /**< end of rendering of the consumed frames */
+};
+
+vlc_aout_ring_t *vlc_aout_ring_New(size_t frame_size, unsigned rate,
+                                   vlc_tick_t duration)
+{
+    assert(frame_size > 0 && rate > 0);
+
+    size_t frames = samples_from_vlc_tick(duration, rate);
+    size_t capacity = 1;
+
+    while (capacity < frames)
+    {
+        if (capacity > SIZE_MAX / 2 / frame_size)
+            return NULL;
+        capacity *= 2;
+    }
+
+    vlc_aout_ring_t *ring = aligned_alloc(64, sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    ring->buf = malloc(capacity * frame_size);
+    if (unlikely(ring->buf == NULL))
+    {
+        aligned_free(ring);
+        return NULL;
+    }
+
+    ring->frame_size = frame_size;
+    ring->mask = capacity - 1;
+    ring->rate = rate;
+    atomic_init(&ring->write, 0);
+    atomic_init(&ring->flush, NO_FLUSH);
+    atomic_init(&ring->read, 0);
+    atomic_init(&ring->end, VLC_TICK_INVALID);
+    return ring;
+}
+
+void vlc_aout_ring_Delete(vlc_aout_ring_t *ring)
+{
+    free(ring->buf);
+    aligned_free(ring);
+}
+
+size_t vlc_aout_ring_Write(vlc_aout_ring_t *ring, const void *buf,
+                           size_t frames)
+{
+    size_t write = atomic_load_explicit(&ring->write, memory_order_relaxed);
+    size_t read = atomic_load_explicit(&ring->read, memory_order_acquire);
+    size_t space = ring->mask + 1 - (write - read);
+
+    if (frames > space)
+        frames = space;
+
+    size_t offset = write & ring->mask;
+    size_t first = ring->mask + 1 - offset;
+    if (first > frames)
+        first = frames;
+
+    memcpy(ring->buf + offset * ring->frame_size, buf,
+           first * ring->frame_size);
+    memcpy(ring->buf, (const unsigned char *)buf + first * ring->frame_size,
+           (frames - first) * ring->frame_size);
+
+    atomic_store_explicit(&ring->write, write + frames, memory_order_release);
+    return frames;
+}
+
+void vlc_aout_ring_Flush(vlc_aout_ring_t *ring)
+{
+    size_t write = atomic_load_explicit(&ring->write, memory_order_relaxed);
+
+    /* The consumer may be reading: it moves its own position when it can.
+     * Release, so that it sees the writes up to the flush position. */
+    atomic_store_explicit(&ring->flush, write, memory_order_release);
+}
+
+vlc_tick_t vlc_aout_ring_GetDelay(vlc_aout_ring_t *ring, vlc_tick_t now)
+{
+    size_t write = atomic_load_explicit(&ring->write, memory_order_relaxed);
+    size_t flush = atomic_load_explicit(&ring->flush, memory_order_relaxed);
+    vlc_tick_t end = atomic_load_explicit(&ring->end, memory_order_relaxed);
+    size_t read;
+
+    /* The end time is stored before the read position: retry if it changed,
+     * so that both describe the same point of the stream. */
+    for (;;)
+    {
+        read = atomic_load_explicit(&ring->read, memory_order_acquire);
+
+        vlc_tick_t end2 = atomic_load_explicit(&ring->end,
+                                               memory_order_relaxed);
+        if (likely(end2 == end))
+            break;
+        end = end2;
+    }
+
+    if (flush != NO_FLUSH && flush - read <= write - read)
+        read = flush;
+
+    vlc_tick_t delay = vlc_tick_from_samples(write - read, ring->rate);
+    if (end != VLC_TICK_INVALID && end > now)
+        delay += end - now;
+    return delay;
+}
+
+/* Applies the pending flush, if any */
+static size_t GetReadPosition(vlc_aout_ring_t *ring)
+{
+    size_t read = atomic_load_explicit(&ring->read, memory_order_relaxed);
+    size_t flush = atomic_exchange_explicit(&ring->flush, NO_FLUSH,
+                                            memory_order_acquire);
+
+    if (flush != NO_FLUSH)
+    {
+        read = flush;
+        atomic_store_explicit(&ring->read, read, memory_order_release);
+    }
+    return read;
+}
+
+size_t vlc_aout_ring_Peek(vlc_aout_ring_t *ring, const void **buf)
+{
+    size_t read = GetReadPosition(ring);
+    size_t write = atomic_load_explicit(&ring->write, memory_order_acquire);
+    size_t offset = read & ring->mask;
+    size_t frames = write - read;
+
+    if (frames > ring->mask + 1 - offset)
+        frames = ring->mask + 1 - offset;
+
+    *buf = ring->buf + offset * ring->frame_size;
+    return frames;
+}
+
+void vlc_aout_ring_Consume(vlc_aout_ring_t *ring, size_t frames,
+                           vlc_tick_t date)
+{
+    size_t read = atomic_load_explicit(&ring->read, memory_order_relaxed);
+
+    assert(frames <= atomic_load_explicit(&ring->write,
+                                          memory_order_relaxed) - read);
+
+    if (date != VLC_TICK_INVALID)
+        date += vlc_tick_from_samples(frames, ring->rate);
+    atomic_store_explicit(&ring->end, date, memory_order_relaxed);
+    atomic_store_explicit(&ring->read, read + frames, memory_order_release);
+}
+
+size_t vlc_aout_ring_Read(vlc_aout_ring_t *ring, void *buf, size_t frames,
+                          vlc_tick_t date)
+{
+    size_t read = GetReadPosition(ring);
+    size_t write = atomic_load_explicit(&ring->write, memory_order_acquire);
+
+    if (frames > write - read)
+        frames = write - read;
+
+    size_t offset = read & ring->mask;
+    size_t first = ring->mask + 1 - offset;
+    if (first > frames)
+        first = frames;
+
+    memcpy(buf, ring->buf + offset * ring->frame_size,
+           first * ring->frame_size);
+    memcpy((unsigned char *)buf + first * ring->frame_size, ring->buf,
+           (frames - first) * ring->frame_size);
+
+    vlc_aout_ring_Consume(ring, frames, date);
+    return frames;
+}
@@ -76,9 +76,14 @@ aout_volume_t *aout_volume_New(vlc_object_t *parent,
 }
 
 /**
- * Selects the current sample format for software amplification.
+ * Selects the current sample formats for software amplification.
+ *
+ * \param format format of the samples to amplify
+ * \param output format of the amplified samples, if the amplifier shall
+ * also convert them (otherwise, same as format)
  */
-int aout_volume_SetFormat(aout_volume_t *vol, vlc_fourcc_t format)
+int aout_volume_SetFormat(aout_volume_t *vol, vlc_fourcc_t format,
+                          vlc_fourcc_t output)
 {
     if (unlikely(vol == NULL))
         return -1;
@@ -86,7 +91,7 @@ int aout_volume_SetFormat(aout_volume_t *vol, vlc_fourcc_t format)
     audio_volume_t *obj = &vol->object;
     if (vol->module != NULL)
     {
-        if (obj->format == format)
+        if (obj->format == format && obj->output_format == output)
         {
             msg_Dbg (obj, "retaining sample format");
             return 0;
@@ -96,6 +101,7 @@ int aout_volume_SetFormat(aout_volume_t *vol, vlc_fourcc_t format)
     }
 
     obj->format = format;
+    obj->output_format = output;
     vol->module = module_need(obj, "audio volume", NULL, false);
     if (vol->module == NULL)
         return -1;
@@ -75,6 +75,9 @@ struct decoder_owner
 
     sout_instance_t         *p_sout;
     sout_packetizer_input_t *p_sout_input;
+    /* Blocks are sent to p_sout_input from the input thread */
+    bool                     b_passthrough;
+    block_t                 *p_passthrough; /* held until the next one */
 
     vlc_thread_t     thread;
 
@@ -151,6 +154,29 @@ struct decoder_owner
     atomic_bool drained;
     bool b_idle;
 
+    /* Low delay: latency measurement, protected by the FIFO lock */
+    bool b_low_delay;
+#define DECODER_LATENCY_SLOTS 64
+    struct
+    {
+        /* Arrival dates of the queued blocks, in FIFO order */
+        vlc_tick_t arrival[DECODER_LATENCY_SLOTS];
+        uint64_t queued, dequeued;
+        /* Decoding start dates, by block timestamp */
+        struct
+        {
+            vlc_tick_t ts;
+            vlc_tick_t start;
+        } pending[DECODER_LATENCY_SLOTS];
+        unsigned next_pending;
+        /* Since the last report */
+        vlc_tick_t queue_sum, queue_max;
+        vlc_tick_t decode_sum, decode_max;
+        vlc_tick_t ahead_sum, ahead_min;
+        unsigned queue_count, decode_count, ahead_count;
+        vlc_tick_t last_report;
+    } latency;
+
     /* CC */
 #define MAX_CC_DECODERS 64 /* The es_out only creates one type of es */
     struct
@@ -174,6 +200,14 @@ struct decoder_owner
 
 /* */
 #define DECODER_SPU_VOUT_WAIT_DURATION   VLC_TICK_FROM_MS(200)
+
+/* Number of queued blocks above which a paced input waits */
+#define DECODER_FIFO_DEPTH               10
+#define DECODER_FIFO_DEPTH_LOW_DELAY     2
+/* Queuing time above which the FIFO of a live input is reset, in low delay
+ * mode (at most DECODER_LATENCY_SLOTS blocks are queued) */
+#define DECODER_FIFO_MAX_WAIT_LOW_DELAY  VLC_TICK_FROM_MS(500)
+#define DECODER_LATENCY_REPORT_PERIOD    VLC_TICK_FROM_SEC(1)
 #define BLOCK_FLAG_CORE_PRIVATE_RELOADED (1 << BLOCK_FLAG_CORE_PRIVATE_SHIFT)
 
 #define decoder_Notify(decoder_priv, event, ...) \
@@ -363,7 +397,8 @@ static int ModuleThread_UpdateAudioFormat( decoder_t *p_dec )
         {
             if( aout_DecNew( p_aout, &format, p_dec->fmt_out.i_profile,
                              p_owner->p_clock,
-                             &p_dec->fmt_out.audio_replay_gain ) )
+                             &p_dec->fmt_out.audio_replay_gain,
+                             var_InheritBool( p_dec, "clock-offline" ) ) )
             {
                 input_resource_PutAout( p_owner->p_resource, p_aout );
                 p_aout = NULL;
@@ -737,6 +772,150 @@ static float ModuleThread_GetDisplayRate( decoder_t *p_dec )
     return rate;
 }
 
+/*****************************************************************************
+ * Latency measurement, in low delay mode
+ *****************************************************************************/
+/* Called with the FIFO locked, once the queued blocks are dropped */
+static void DecoderLatencyReset( struct decoder_owner *p_owner )
+{
+    p_owner->latency.dequeued = p_owner->latency.queued;
+    for( unsigned i = 0; i < DECODER_LATENCY_SLOTS; i++ )
+        p_owner->latency.pending[i].ts = VLC_TICK_INVALID;
+}
+
+/* Called with the FIFO locked */
+static void DecoderLatencyQueue( struct decoder_owner *p_owner,
+                                 const block_t *p_block )
+{
+    vlc_tick_t now = vlc_tick_now();
+
+    for( ; p_block != NULL; p_block = p_block->p_next )
+        p_owner->latency.arrival[p_owner->latency.queued++
+                                 % DECODER_LATENCY_SLOTS] = now;
+}
+
+/* Called with the FIFO locked: whether the oldest queued block waited too
+ * long, i.e. the decoder does not keep up with the input */
+static bool DecoderLatencyIsLate( struct decoder_owner *p_owner )
+{
+    uint64_t count = p_owner->latency.queued - p_owner->latency.dequeued;
+
+    if( count == 0 )
+        return false;
+    if( count > DECODER_LATENCY_SLOTS )
+        return true;
+
+    vlc_tick_t arrival = p_owner->latency.arrival[p_owner->latency.dequeued
+                                                  % DECODER_LATENCY_SLOTS];
+    return vlc_tick_now() - arrival > DECODER_FIFO_MAX_WAIT_LOW_DELAY;
+}
+
+/* Called with the FIFO locked */
+static void DecoderLatencyDequeue( struct decoder_owner *p_owner,
+                                   const block_t *p_block )
+{
+    vlc_tick_t now = vlc_tick_now();
+    uint64_t index = p_owner->latency.dequeued++;
+
+    /* The arrival date is lost if too many blocks were queued since */
+    if( p_owner->latency.queued - index <= DECODER_LATENCY_SLOTS )
+    {
+        vlc_tick_t queue = now - p_owner->latency.arrival[index
+                                                % DECODER_LATENCY_SLOTS];
+
+        p_owner->latency.queue_sum += queue;
+        p_owner->latency.queue_max = __MAX( p_owner->latency.queue_max,
+                                            queue );
+        p_owner->latency.queue_count++;
+    }
+
+    vlc_tick_t ts = p_block->i_pts != VLC_TICK_INVALID ? p_block->i_pts
+                                                       : p_block->i_dts;
+    if( ts != VLC_TICK_INVALID )
+    {
+        unsigned i = p_owner->latency.next_pending;
+
+        p_owner->latency.pending[i].ts = ts;
+        p_owner->latency.pending[i].start = now;
+        p_owner->latency.next_pending = (i + 1) % DECODER_LATENCY_SLOTS;
+    }
+}
+
+/**
+ * Accounts an output buffer of date i_ts, before it is sent to the output.
+ *
+ * Three stages are measured: the time spent by the input blocks in the FIFO,
+ * the time from the start of decoding a block to the output of the buffer
+ * with the same timestamp (including any reordering), and how long before
+ * its display the buffer is handed to the output. They are reported every
+ * second.
+ */
+static void ModuleThread_UpdateLatency( struct decoder_owner *p_owner,
+                                        vlc_tick_t i_ts )
+{
+    decoder_t *p_dec = &p_owner->dec;
+    vlc_tick_t now = vlc_tick_now();
+    vlc_tick_t display = VLC_TICK_INVALID;
+
+    if( p_owner->p_clock != NULL )
+        display = ModuleThread_GetDisplayDate( p_dec, now, i_ts );
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    for( unsigned i = 0; i < DECODER_LATENCY_SLOTS; i++ )
+    {
+        if( p_owner->latency.pending[i].ts != i_ts )
+            continue;
+
+        vlc_tick_t decode = now - p_owner->latency.pending[i].start;
+
+        p_owner->latency.decode_sum += decode;
+        p_owner->latency.decode_max = __MAX( p_owner->latency.decode_max,
+                                             decode );
+        p_owner->latency.decode_count++;
+        p_owner->latency.pending[i].ts = VLC_TICK_INVALID;
+        break;
+    }
+
+    /* Invalid while buffering or paused, INT64_MAX if the clock is paused */
+    if( display != VLC_TICK_INVALID && display != INT64_MAX )
+    {
+        vlc_tick_t ahead = display - now;
+
+        p_owner->latency.ahead_sum += ahead;
+        p_owner->latency.ahead_min = p_owner->latency.ahead_count > 0
+            ? __MIN( p_owner->latency.ahead_min, ahead ) : ahead;
+        p_owner->latency.ahead_count++;
+    }
+
+    if( now - p_owner->latency.last_report < DECODER_LATENCY_REPORT_PERIOD )
+    {
+        vlc_fifo_Unlock( p_owner->p_fifo );
+        return;
+    }
+
+    unsigned queue_count = __MAX( p_owner->latency.queue_count, 1 );
+    unsigned decode_count = __MAX( p_owner->latency.decode_count, 1 );
+    unsigned ahead_count = __MAX( p_owner->latency.ahead_count, 1 );
+    int queue = MS_FROM_VLC_TICK( p_owner->latency.queue_sum / queue_count );
+    int queue_max = MS_FROM_VLC_TICK( p_owner->latency.queue_max );
+    int decode = MS_FROM_VLC_TICK( p_owner->latency.decode_sum / decode_count );
+    int decode_max = MS_FROM_VLC_TICK( p_owner->latency.decode_max );
+    int ahead = MS_FROM_VLC_TICK( p_owner->latency.ahead_sum / ahead_count );
+    int ahead_min = MS_FROM_VLC_TICK( p_owner->latency.ahead_min );
+
+    p_owner->latency.queue_sum = p_owner->latency.queue_max = 0;
+    p_owner->latency.decode_sum = p_owner->latency.decode_max = 0;
+    p_owner->latency.ahead_sum = p_owner->latency.ahead_min = 0;
+    p_owner->latency.queue_count = p_owner->latency.decode_count = 0;
+    p_owner->latency.ahead_count = 0;
+    p_owner->latency.last_report = now;
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    msg_Dbg( p_dec, "latency: queue %d ms (max %d ms), decode %d ms "
+             "(max %d ms), ahead of display %d ms (min %d ms)",
+             queue, queue_max, decode, decode_max, ahead, ahead_min );
+}
+
 /*****************************************************************************
  * Public functions
  *****************************************************************************/
@@ -820,6 +999,92 @@ static int DecoderThread_PlaySout( struct decoder_owner *p_owner, block_t *p_sou
     return sout_InputSendBuffer( p_owner->p_sout_input, p_sout_block );
 }
 
+/* Whether the demuxed blocks can be sent to the stream output unchanged */
+static bool DecoderCanPassthrough( vlc_object_t *p_parent, const es_format_t *fmt )
+{
+    if( !fmt->b_packetized || !var_InheritBool( p_parent, "sout-passthrough" ) )
+        return false;
+
+    /* Only the codecs that the copy packetizer handles, without reordering,
+     * and that the muxers take as stored by the demuxers. The others need
+     * their packetizer for the framing (e.g. Annex B for H.264), the headers
+     * or the timestamps. VP9 goes through avparser, which splits the
+     * superframes and flags the key frames. */
+    switch( fmt->i_codec )
+    {
+        case VLC_CODEC_VP8:
+        case VLC_CODEC_OPUS:
+        case VLC_CODEC_SUBT:
+        case VLC_CODEC_TX3G:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * Sends a demuxed block to the stream output, from the input thread.
+ *
+ * The blocks are output as the copy packetizer would: audio and video blocks
+ * are held until the next one, which gives their length (but for Opus),
+ * subtitles are sent as is.
+ *
+ * Unlike DecoderThread_PlaySout(), this does not wait in DecoderWaitUnblock():
+ * pause and buffering do not hold the block back, the stream output buffers
+ * it instead. Closed captions are not extracted either, as no packetizer
+ * parses the stream.
+ */
+static void DecoderPassthrough( struct decoder_owner *p_owner, block_t *p_block )
+{
+    decoder_t *p_dec = &p_owner->dec;
+
+    /* Same checks as the copy packetizer */
+    if( p_block->i_dts == VLC_TICK_INVALID )
+        p_block->i_dts = p_block->i_pts;
+    if( p_block->i_dts == VLC_TICK_INVALID
+     || (p_block->i_flags & BLOCK_FLAG_CORRUPTED) )
+    {
+        msg_Dbg( p_dec, "dropping undated or corrupted block" );
+        block_Release( p_block );
+        return;
+    }
+
+    if( p_dec->fmt_in.i_cat != SPU_ES )
+    {
+        block_t *p_held = p_owner->p_passthrough;
+
+        p_owner->p_passthrough = p_block;
+        if( p_held == NULL )
+            return;
+        if( p_block->i_pts > p_held->i_pts
+         && p_dec->fmt_in.i_codec != VLC_CODEC_OPUS )
+            p_held->i_length = p_block->i_pts - p_held->i_pts;
+        p_block = p_held;
+    }
+
+    vlc_mutex_lock( &p_owner->lock );
+    if( p_owner->b_waiting )
+    {
+        /* Do not block the input thread: the stream output buffers anyway */
+        p_owner->b_has_data = true;
+        vlc_cond_signal( &p_owner->wait_acknowledge );
+    }
+    vlc_mutex_unlock( &p_owner->lock );
+
+    if( p_owner->error || p_owner->p_sout_input == NULL )
+    {
+        block_Release( p_block );
+        return;
+    }
+
+    if( sout_InputSendBuffer( p_owner->p_sout_input, p_block ) == VLC_EGENERIC )
+    {
+        msg_Err( p_dec, "cannot continue streaming due to errors "
+                 "with codec %4.4s", (char *)&p_dec->fmt_in.i_codec );
+        p_owner->error = true;
+    }
+}
+
 /* This function process a block for sout
  */
 static void DecoderThread_ProcessSout( struct decoder_owner *p_owner, block_t *p_block )
@@ -1057,6 +1322,8 @@ static int ModuleThread_PlayVideo( struct decoder_owner *p_owner, picture_t *p_p
         /* Ensure no earlier higher pts breaks still state */
         vout_Flush( p_vout, p_picture->date );
     }
+    if( p_owner->b_low_delay )
+        ModuleThread_UpdateLatency( p_owner, p_picture->date );
     vout_PutPicture( p_vout, p_picture );
 
     return VLC_SUCCESS;
@@ -1178,6 +1445,9 @@ static int ModuleThread_PlayAudio( struct decoder_owner *p_owner, block_t *p_aud
         return VLC_EGENERIC;
     }
 
+    if( p_owner->b_low_delay )
+        ModuleThread_UpdateLatency( p_owner, p_audio->i_pts );
+
     int status = aout_DecPlay( p_aout, p_audio );
     if( status == AOUT_DEC_CHANGED )
     {
@@ -1199,13 +1469,17 @@ static void ModuleThread_UpdateStatAudio( struct decoder_owner *p_owner,
 {
     unsigned played = 0;
     unsigned aout_lost = 0;
+    struct vlc_audio_loudness loudness;
+    bool measured = false;
     if( p_owner->p_aout != NULL )
     {
         aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played );
+        measured = aout_DecGetLoudness( p_owner->p_aout, &loudness );
     }
     if (lost) aout_lost++;
 
-    decoder_Notify(p_owner, on_new_audio_stats, 1, aout_lost, played);
+    decoder_Notify(p_owner, on_new_audio_stats, 1, aout_lost, played,
+                   measured ? &loudness : NULL);
 }
 
 static void ModuleThread_QueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
@@ -1451,6 +1725,9 @@ static void DecoderThread_Flush( struct decoder_owner *p_owner )
     {
         if( p_owner->p_vout )
             vout_FlushAll( p_owner->p_vout );
+        /* The first picture after a seek is a new thumbnail */
+        if( p_dec->cbs->video.queue == ModuleThread_QueueThumbnail )
+            p_owner->b_first = true;
     }
     else if( p_dec->fmt_out.i_cat == SPU_ES )
     {
@@ -1674,6 +1951,8 @@ static void *DecoderThread( void *p_data )
             /* We have emptied the FIFO and there is a pending request to
              * drain. Pass p_block = NULL to decoder just once. */
         }
+        else if( p_owner->b_low_delay )
+            DecoderLatencyDequeue( p_owner, p_block );
 
         vlc_fifo_Unlock( p_owner->p_fifo );
 
@@ -1778,6 +2057,8 @@ static struct decoder_owner * CreateDecoder( vlc_object_t *p_parent,
     p_owner->i_spu_order = 0;
     p_owner->p_sout = p_sout;
     p_owner->p_sout_input = NULL;
+    p_owner->b_passthrough = false;
+    p_owner->p_passthrough = NULL;
     p_owner->p_packetizer = NULL;
 
     atomic_init( &p_owner->b_fmt_description, false );
@@ -1802,6 +2083,17 @@ static struct decoder_owner * CreateDecoder( vlc_object_t *p_parent,
     atomic_init( &p_owner->reload, RELOAD_NO_REQUEST );
     p_owner->b_idle = false;
 
+    p_owner->b_low_delay = var_InheritBool( p_dec, "low-delay" );
+    p_owner->latency.queued = 0;
+    p_owner->latency.next_pending = 0;
+    p_owner->latency.queue_sum = p_owner->latency.queue_max = 0;
+    p_owner->latency.decode_sum = p_owner->latency.decode_max = 0;
+    p_owner->latency.ahead_sum = p_owner->latency.ahead_min = 0;
+    p_owner->latency.queue_count = p_owner->latency.decode_count = 0;
+    p_owner->latency.ahead_count = 0;
+    p_owner->latency.last_report = vlc_tick_now();
+    DecoderLatencyReset( p_owner );
+
     p_owner->mouse_event = NULL;
     p_owner->mouse_opaque = NULL;
 
@@ -1821,6 +2113,11 @@ static struct decoder_owner * CreateDecoder( vlc_object_t *p_parent,
     vlc_cond_init( &p_owner->wait_acknowledge );
     vlc_cond_init( &p_owner->wait_fifo );
 
+#ifdef ENABLE_SOUT
+    if( p_sout != NULL )
+        p_owner->b_passthrough = DecoderCanPassthrough( p_parent, fmt );
+#endif
+
     /* Load a packetizer module if the input is not already packetized */
     if( p_sout == NULL && !fmt->b_packetized )
     {
@@ -1861,7 +2158,14 @@ static struct decoder_owner * CreateDecoder( vlc_object_t *p_parent,
     }
 
     /* Find a suitable decoder/packetizer module */
-    if( LoadDecoder( p_dec, p_sout != NULL, fmt ) )
+    if( p_owner->b_passthrough )
+    {
+        /* Output the input format, as the copy packetizer does */
+        decoder_Init( p_dec, fmt );
+        es_format_Clean( &p_dec->fmt_out );
+        es_format_Copy( &p_dec->fmt_out, fmt );
+    }
+    else if( LoadDecoder( p_dec, p_sout != NULL, fmt ) )
         return p_owner;
 
     assert( p_dec->fmt_in.i_cat == p_dec->fmt_out.i_cat && fmt->i_cat == p_dec->fmt_in.i_cat);
@@ -1914,6 +2218,8 @@ static void DeleteDecoder( decoder_t * p_dec )
 
     /* Free all packets still in the decoder fifo. */
     block_FifoRelease( p_owner->p_fifo );
+    if( p_owner->p_passthrough != NULL )
+        block_Release( p_owner->p_passthrough );
 
     /* Cleanup */
 #ifdef ENABLE_SOUT
@@ -2024,7 +2330,7 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, const es_format_t *fmt,
     }
 
     decoder_t *p_dec = &p_owner->dec;
-    if( !p_dec->p_module )
+    if( !p_dec->p_module && !p_owner->b_passthrough )
     {
         DecoderUnsupportedCodec( p_dec, fmt, !p_sout );
 
@@ -2040,9 +2346,10 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, const es_format_t *fmt,
         i_priority = VLC_THREAD_PRIORITY_VIDEO;
 
 #ifdef ENABLE_SOUT
-    /* Do not delay sout creation for SPU or DATA. */
+    /* Do not delay sout creation for SPU or DATA, nor without packetizer. */
     if( p_sout && fmt->b_packetized &&
-        (fmt->i_cat != VIDEO_ES && fmt->i_cat != AUDIO_ES) )
+        (p_owner->b_passthrough ||
+         (fmt->i_cat != VIDEO_ES && fmt->i_cat != AUDIO_ES)) )
     {
         p_owner->p_sout_input = sout_InputNew( p_owner->p_sout, fmt );
         if( p_owner->p_sout_input == NULL )
@@ -2052,6 +2359,17 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, const es_format_t *fmt,
             p_owner->error = true;
         }
     }
+
+    if( p_owner->b_passthrough )
+    {
+        vlc_mutex_lock( &p_owner->lock );
+        DecoderUpdateFormatLocked( p_owner );
+        vlc_mutex_unlock( &p_owner->lock );
+
+        msg_Dbg( p_dec, "passing packetized %4.4s through",
+                 (char *)&fmt->i_codec );
+        return p_dec;
+    }
 #endif
 
     /* Spawn the decoder thread */
@@ -2105,6 +2423,12 @@ void input_DecoderDelete( decoder_t *p_dec )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
+    if( p_owner->b_passthrough )
+    {   /* No thread, nor CC sub-decoders */
+        DeleteDecoder( p_dec );
+        return;
+    }
+
     vlc_cancel( p_owner->thread );
 
     vlc_fifo_Lock( p_owner->p_fifo );
@@ -2151,6 +2475,14 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
+#ifdef ENABLE_SOUT
+    if( p_owner->b_passthrough )
+    {
+        DecoderPassthrough( p_owner, p_block );
+        return;
+    }
+#endif
+
     vlc_fifo_Lock( p_owner->p_fifo );
     if( !b_do_pace )
     {
@@ -2162,6 +2494,20 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
             msg_Warn( p_dec, "decoder/packetizer fifo full (data not "
                       "consumed quickly enough), resetting fifo!" );
             block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            DecoderLatencyReset( p_owner );
+            p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+        }
+        /* A live input cannot wait: in low delay mode, drop the late blocks
+         * rather than let the delay grow. Not while buffering or paused, as
+         * the FIFO is not consumed then (both are only written by the input
+         * thread). */
+        else if( p_owner->b_low_delay && !p_owner->b_waiting
+              && !p_owner->paused && DecoderLatencyIsLate( p_owner ) )
+        {
+            msg_Warn( p_dec, "decoder late in low delay mode, dropping %zu "
+                      "queued blocks", vlc_fifo_GetCount( p_owner->p_fifo ) );
+            block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            DecoderLatencyReset( p_owner );
             p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
         }
     }
@@ -2170,10 +2516,15 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
     {   /* The FIFO is not consumed when waiting, so pacing would deadlock VLC.
          * Locking is not necessary as b_waiting is only read, not written by
          * the decoder thread. */
-        while( vlc_fifo_GetCount( p_owner->p_fifo ) >= 10 )
+        size_t depth = p_owner->b_low_delay ? DECODER_FIFO_DEPTH_LOW_DELAY
+                                            : DECODER_FIFO_DEPTH;
+
+        while( vlc_fifo_GetCount( p_owner->p_fifo ) >= depth )
             vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
     }
 
+    if( p_owner->b_low_delay )
+        DecoderLatencyQueue( p_owner, p_block );
     vlc_fifo_QueueUnlocked( p_owner->p_fifo, p_block );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
@@ -2223,6 +2574,9 @@ void input_DecoderDrain( decoder_t *p_dec )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
+    if( p_owner->b_passthrough )
+        return; /* like the copy packetizer, the held block stays held */
+
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->b_draining = true;
     vlc_fifo_Signal( p_owner->p_fifo );
@@ -2237,10 +2591,25 @@ void input_DecoderFlush( decoder_t *p_dec )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
+#ifdef ENABLE_SOUT
+    if( p_owner->b_passthrough )
+    {
+        if( p_owner->p_passthrough != NULL )
+        {
+            block_Release( p_owner->p_passthrough );
+            p_owner->p_passthrough = NULL;
+        }
+        if( p_owner->p_sout_input != NULL )
+            sout_InputFlush( p_owner->p_sout_input );
+        return;
+    }
+#endif
+
     vlc_fifo_Lock( p_owner->p_fifo );
 
     /* Empty the fifo */
     block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    DecoderLatencyReset( p_owner );
 
     /* Don't need to wait for the DecoderThread to flush. Indeed, if called a
      * second time, this function will clear the FIFO again before anything was
@@ -2425,6 +2794,8 @@ void input_DecoderWait( decoder_t *p_dec )
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
     assert( p_owner->b_waiting );
+    if( p_owner->b_passthrough )
+        return; /* the blocks were sent as they came */
 
     vlc_mutex_lock( &p_owner->lock );
     while( !p_owner->b_has_data )
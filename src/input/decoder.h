@@ -28,6 +28,8 @@
 #include <vlc_codec.h>
 #include <vlc_mouse.h>
 
+struct vlc_audio_loudness;
+
 struct input_decoder_callbacks {
     /* notifications */
     void (*on_vout_added)(decoder_t *decoder, vout_thread_t *vout,
@@ -42,7 +44,9 @@ struct input_decoder_callbacks {
                                unsigned lost, unsigned displayed,
                                void *userdata);
     void (*on_new_audio_stats)(decoder_t *decoder, unsigned decoded,
-                               unsigned lost, unsigned played, void *userdata);
+                               unsigned lost, unsigned played,
+                               const struct vlc_audio_loudness *loudness,
+                               void *userdata);
 
     /* requests */
     int (*get_attachments)(decoder_t *decoder,
@@ -361,7 +361,9 @@ decoder_on_new_video_stats(decoder_t *decoder, unsigned decoded, unsigned lost,
 
 static void
 decoder_on_new_audio_stats(decoder_t *decoder, unsigned decoded, unsigned lost,
-                           unsigned played, void *userdata)
+                           unsigned played,
+                           const struct vlc_audio_loudness *loudness,
+                           void *userdata)
 {
     (void) decoder;
 
@@ -382,6 +384,13 @@ decoder_on_new_audio_stats(decoder_t *decoder, unsigned decoded, unsigned lost,
                               memory_order_relaxed);
     atomic_fetch_add_explicit(&stats->played_abuffers, played,
                               memory_order_relaxed);
+
+    if (loudness != NULL)
+    {
+        vlc_mutex_lock(&stats->loudness_lock);
+        stats->loudness = *loudness;
+        vlc_mutex_unlock(&stats->loudness_lock);
+    }
 }
 
 static int
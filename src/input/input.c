@@ -309,7 +309,8 @@ static input_thread_t *Create( vlc_object_t *p_parent,
     TAB_INIT( priv->i_attachment, priv->attachment );
     priv->attachment_demux = NULL;
     priv->p_sout   = NULL;
-    priv->b_out_pace_control = priv->b_thumbnailing;
+    priv->b_out_pace_control = priv->b_thumbnailing
+                            || var_InheritBool( p_input, "clock-offline" );
     priv->p_renderer = p_renderer && priv->b_preparsing == false ?
                 vlc_renderer_item_hold( p_renderer ) : NULL;
 
@@ -27,6 +27,7 @@
 #include <stdatomic.h>
 
 #include <vlc_access.h>
+#include <vlc_aout.h>
 #include <vlc_demux.h>
 #include <vlc_input.h>
 #include <vlc_viewpoint.h>
@@ -683,6 +684,8 @@ struct input_stats {
     atomic_uintmax_t decoded_video;
     atomic_uintmax_t played_abuffers;
     atomic_uintmax_t lost_abuffers;
+    vlc_mutex_t loudness_lock;
+    struct vlc_audio_loudness loudness;
     atomic_uintmax_t displayed_pictures;
     atomic_uintmax_t lost_pictures;
 };
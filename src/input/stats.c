@@ -24,6 +24,7 @@
 # include "config.h"
 #endif
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -65,6 +66,10 @@ struct input_stats *input_stats_Create(void)
     atomic_init(&stats->decoded_video, 0);
     atomic_init(&stats->played_abuffers, 0);
     atomic_init(&stats->lost_abuffers, 0);
+    vlc_mutex_init(&stats->loudness_lock);
+    stats->loudness.momentary = stats->loudness.short_term = NAN;
+    stats->loudness.integrated = stats->loudness.range = NAN;
+    stats->loudness.true_peak = NAN;
     atomic_init(&stats->displayed_pictures, 0);
     atomic_init(&stats->lost_pictures, 0);
     return stats;
@@ -72,6 +77,7 @@ struct input_stats *input_stats_Create(void)
 
 void input_stats_Destroy(struct input_stats *stats)
 {
+    vlc_mutex_destroy(&stats->loudness_lock);
     vlc_mutex_destroy(&stats->demux_bitrate.lock);
     vlc_mutex_destroy(&stats->input_bitrate.lock);
     free(stats);
@@ -102,6 +108,13 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                  memory_order_relaxed);
     st->i_lost_abuffers = atomic_load_explicit(&stats->lost_abuffers,
                                                memory_order_relaxed);
+    vlc_mutex_lock(&stats->loudness_lock);
+    st->f_loudness_momentary = stats->loudness.momentary;
+    st->f_loudness_short_term = stats->loudness.short_term;
+    st->f_loudness_integrated = stats->loudness.integrated;
+    st->f_loudness_range = stats->loudness.range;
+    st->f_true_peak = stats->loudness.true_peak;
+    vlc_mutex_unlock(&stats->loudness_lock);
 
     /* Vouts */
     st->i_decoded_video = atomic_load_explicit(&stats->decoded_video,
@@ -24,14 +24,32 @@
 # include "config.h"
 #endif
 
+#include <errno.h>
+#include <sys/stat.h>
+
 #include <vlc_thumbnailer.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_image.h>
+#include <vlc_md5.h>
+#include <vlc_stream.h>
+#include <vlc_vector.h>
 #include "input_internal.h"
 #include "misc/background_worker.h"
+#include "misc/picture.h"
+
+/* Size of the head and tail of the content identifying a thumbnail file */
+#define THUMBNAILER_HASH_SIZE (64 * 1024)
 
 struct vlc_thumbnailer_t
 {
     vlc_object_t* parent;
     struct background_worker* worker;
+
+    /* Image writers of the finished requests, with their encoder and
+     * scaler still open for the next picture of the same format */
+    vlc_mutex_t lock;
+    struct VLC_VECTOR(image_handler_t *) writers;
 };
 
 typedef struct vlc_thumbnailer_params_t
@@ -47,6 +65,7 @@ typedef struct vlc_thumbnailer_params_t
         VLC_THUMBNAILER_SEEK_POS,
     } type;
     bool fast_seek;
+    bool keyframe_only;
     input_item_t* input_item;
     /**
      * A positive value will be used as the timeout duration
@@ -54,6 +73,19 @@ typedef struct vlc_thumbnailer_params_t
      */
     vlc_tick_t timeout;
     vlc_thumbnailer_cb cb;
+    /* Batch requests: one input, seeked from one time to the next */
+    vlc_tick_t *times;
+    size_t count;
+    size_t index;
+    vlc_thumbnailer_batch_cb batch_cb;
+    /* File requests: the thumbnail is encoded to the cache directory */
+    vlc_fourcc_t format;
+    int width;
+    int height;
+    bool crop;
+    char *cache_dir;
+    char *path;
+    vlc_thumbnailer_file_cb file_cb;
     void* user_data;
 } vlc_thumbnailer_params_t;
 
@@ -66,8 +98,125 @@ struct vlc_thumbnailer_request_t
 
     vlc_mutex_t lock;
     bool done;
+    bool writing; /**< A file is being written, without the lock */
 };
 
+static image_handler_t* thumbnailer_GetWriter( vlc_thumbnailer_t* thumbnailer )
+{
+    image_handler_t *writer = NULL;
+
+    vlc_mutex_lock( &thumbnailer->lock );
+    if ( thumbnailer->writers.size > 0 )
+    {
+        size_t last = thumbnailer->writers.size - 1;
+        writer = thumbnailer->writers.data[last];
+        vlc_vector_remove( &thumbnailer->writers, last );
+    }
+    vlc_mutex_unlock( &thumbnailer->lock );
+
+    if ( writer == NULL )
+        writer = image_HandlerCreate( thumbnailer->parent );
+    return writer;
+}
+
+static void thumbnailer_PutWriter( vlc_thumbnailer_t* thumbnailer,
+                                   image_handler_t* writer )
+{
+    vlc_mutex_lock( &thumbnailer->lock );
+    if ( !vlc_vector_push( &thumbnailer->writers, writer ) )
+        image_HandlerDelete( writer );
+    vlc_mutex_unlock( &thumbnailer->lock );
+}
+
+static int thumbnailer_WriteFile( vlc_thumbnailer_request_t* request,
+                                  picture_t* pic )
+{
+    vlc_thumbnailer_params_t *params = &request->params;
+    image_handler_t *writer = thumbnailer_GetWriter( request->thumbnailer );
+    if ( unlikely( writer == NULL ) )
+        return VLC_ENOMEM;
+
+    block_t *image;
+    int ret = picture_ExportWith( writer, &image, NULL, pic, params->format,
+                                  params->width, params->height,
+                                  params->crop );
+    thumbnailer_PutWriter( request->thumbnailer, writer );
+    if ( ret != VLC_SUCCESS )
+        return ret;
+
+    /* Written aside, then renamed: readers never see a partial file. The
+     * temporary name is unique, as other workers or processes may write
+     * the same thumbnail at the same time. */
+    char *tmp;
+    if ( asprintf( &tmp, "%s.XXXXXX", params->path ) < 0 )
+    {
+        block_Release( image );
+        return VLC_ENOMEM;
+    }
+
+    ret = VLC_EGENERIC;
+    int fd = vlc_mkstemp( tmp );
+    if ( fd != -1 )
+    {
+        size_t len = 0;
+        while ( len < image->i_buffer )
+        {
+            ssize_t val = vlc_write( fd, image->p_buffer + len,
+                                     image->i_buffer - len );
+            if ( val <= 0 )
+                break;
+            len += val;
+        }
+        if ( vlc_close( fd ) == 0 && len == image->i_buffer
+          && vlc_rename( tmp, params->path ) == 0 )
+            ret = VLC_SUCCESS;
+        else
+            vlc_unlink( tmp );
+    }
+    free( tmp );
+    block_Release( image );
+    return ret;
+}
+
+/*
+ * Invokes the user callback, if the request has not been cancelled.
+ * Returns true if the request expects more thumbnails from the input.
+ * For file requests, the picture must already be written (NULL on failure).
+ * Must be called with the request lock held.
+ */
+static bool thumbnailer_request_Notify( vlc_thumbnailer_request_t* request,
+                                        picture_t* pic )
+{
+    vlc_thumbnailer_params_t *params = &request->params;
+
+    if ( params->file_cb != NULL )
+    {
+        params->file_cb( params->user_data, pic != NULL ? params->path : NULL );
+        params->file_cb = NULL;
+        return false;
+    }
+
+    if ( params->batch_cb == NULL )
+    {
+        if ( params->cb )
+        {
+            params->cb( params->user_data, pic );
+            params->cb = NULL;
+        }
+        return false;
+    }
+
+    while ( params->index < params->count )
+    {
+        params->batch_cb( params->user_data, params->index++, pic );
+        if ( pic != NULL )
+            return params->index < params->count;
+        /* Failure: none of the remaining thumbnails will come */
+    }
+    params->batch_cb = NULL;
+    return false;
+}
+
 static void
 on_thumbnailer_input_event( input_thread_t *input,
                             const struct vlc_input_event *event, void *userdata )
@@ -82,26 +231,50 @@ on_thumbnailer_input_event( input_thread_t *input,
     picture_t *pic = NULL;
 
     if ( event->type == INPUT_EVENT_THUMBNAIL_READY )
-    {
-        /*
-         * Stop the input thread ASAP, delegate its release to
-         * thumbnailer_request_Release
-         */
-        input_Stop( request->input_thread );
         pic = event->thumbnail;
-    }
+
     vlc_mutex_lock( &request->lock );
-    request->done = true;
-    /*
-     * If the request has not been cancelled, we can invoke the completion
-     * callback.
-     */
-    if ( request->params.cb )
+    if ( request->done || request->writing )
+    {
+        /* The writer notifies the end of the request */
+        vlc_mutex_unlock( &request->lock );
+        return;
+    }
+    if ( request->params.file_cb != NULL && pic != NULL )
+    {
+        /* Encode and write without blocking Cancel() nor the timeout */
+        request->writing = true;
+        vlc_mutex_unlock( &request->lock );
+        bool written = thumbnailer_WriteFile( request, pic ) == VLC_SUCCESS;
+        vlc_mutex_lock( &request->lock );
+        request->writing = false;
+        if ( request->done )
+        {
+            /* Timed out meanwhile: the failure was already notified */
+            vlc_mutex_unlock( &request->lock );
+            return;
+        }
+        if ( !written )
+            pic = NULL;
+    }
+    if ( thumbnailer_request_Notify( request, pic ) )
     {
-        request->params.cb( request->params.user_data, pic );
-        request->params.cb = NULL;
+        /* The decoder takes the first picture after the seek */
+        input_SetTime( request->input_thread,
+                       request->params.times[request->params.index],
+                       request->params.fast_seek );
+        vlc_mutex_unlock( &request->lock );
+        return;
     }
+    request->done = true;
     vlc_mutex_unlock( &request->lock );
+
+    /*
+     * Stop the input thread ASAP, delegate its release to
+     * thumbnailer_request_Release
+     */
+    if ( pic != NULL )
+        input_Stop( request->input_thread );
     background_worker_RequestProbe( request->thumbnailer->worker );
 }
 
@@ -118,23 +291,174 @@ static void thumbnailer_request_Release( void* data )
 
     input_item_Release( request->params.input_item );
     vlc_mutex_destroy( &request->lock );
+    free( request->params.times );
+    free( request->params.cache_dir );
+    free( request->params.path );
     free( request );
 }
 
+static void thumbnailer_SetKeyframeOnly( input_thread_t* input )
+{
+    vlc_object_t *obj = VLC_OBJECT( input );
+
+    /* Inherited by the decoders: skip the frames depending on others, and
+     * decode at reduced resolution where the codec supports it. */
+    var_Create( obj, "avcodec-skip-frame", VLC_VAR_INTEGER );
+    var_SetInteger( obj, "avcodec-skip-frame", 3 /* non-key */ );
+
+    char *opts = var_InheritString( obj, "avcodec-options" );
+    if ( opts == NULL )
+    {
+        var_Create( obj, "avcodec-options", VLC_VAR_STRING );
+        var_SetString( obj, "avcodec-options", "{lowres=1}" );
+    }
+    free( opts );
+}
+
+/*
+ * Hashes the size, the head and the tail of the content: this identifies the
+ * media without reading it whole. Falls back to the URI if the content cannot
+ * be read as a stream.
+ */
+static char* thumbnailer_HashContent( vlc_object_t* obj, input_item_t* item )
+{
+    char *uri = input_item_GetURI( item );
+    if ( uri == NULL )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+
+    stream_t *s = vlc_stream_NewURL( obj, uri );
+    uint8_t *buf = s != NULL ? malloc( THUMBNAILER_HASH_SIZE ) : NULL;
+    if ( buf != NULL )
+    {
+        uint64_t size;
+        if ( vlc_stream_GetSize( s, &size ) != VLC_SUCCESS )
+            size = 0;
+        AddMD5( &md5, &size, sizeof( size ) );
+
+        ssize_t len = vlc_stream_Read( s, buf, THUMBNAILER_HASH_SIZE );
+        if ( len > 0 )
+            AddMD5( &md5, buf, len );
+        if ( size > 2 * THUMBNAILER_HASH_SIZE
+          && vlc_stream_Seek( s, size - THUMBNAILER_HASH_SIZE ) == VLC_SUCCESS )
+        {
+            len = vlc_stream_Read( s, buf, THUMBNAILER_HASH_SIZE );
+            if ( len > 0 )
+                AddMD5( &md5, buf, len );
+        }
+        free( buf );
+    }
+    else
+        AddMD5( &md5, uri, strlen( uri ) );
+    if ( s != NULL )
+        vlc_stream_Delete( s );
+    free( uri );
+
+    EndMD5( &md5 );
+    return psz_md5_hash( &md5 );
+}
+
+static const char* thumbnailer_GetExtension( vlc_fourcc_t format )
+{
+    switch ( format )
+    {
+        case VLC_CODEC_JPEG:
+            return "jpg";
+        case VLC_CODEC_PNG:
+            return "png";
+        case VLC_CODEC_WEBP:
+            return "webp";
+        default:
+            return NULL;
+    }
+}
+
+static char* thumbnailer_GetCachePath( vlc_thumbnailer_t* thumbnailer,
+                                       const vlc_thumbnailer_params_t* params )
+{
+    char *dir = NULL;
+    if ( params->cache_dir == NULL )
+    {
+        char *cache = config_GetUserDir( VLC_CACHE_DIR );
+        if ( cache == NULL )
+            return NULL;
+        if ( vlc_mkdir( cache, 0700 ) == 0 || errno == EEXIST )
+        {
+            if ( asprintf( &dir, "%s"DIR_SEP"thumbnails", cache ) < 0 )
+                dir = NULL;
+        }
+        free( cache );
+        if ( dir == NULL )
+            return NULL;
+        if ( vlc_mkdir( dir, 0700 ) != 0 && errno != EEXIST )
+        {
+            free( dir );
+            return NULL;
+        }
+    }
+
+    char *hash = thumbnailer_HashContent( thumbnailer->parent,
+                                          params->input_item );
+    char *path = NULL;
+    if ( hash != NULL &&
+         asprintf( &path, "%s"DIR_SEP"%s-%"PRId64"-%dx%d%s.%s",
+                   dir != NULL ? dir : params->cache_dir, hash,
+                   MS_FROM_VLC_TICK( params->time ), params->width,
+                   params->height, params->crop ? "c" : "",
+                   thumbnailer_GetExtension( params->format ) ) < 0 )
+        path = NULL;
+    free( hash );
+    free( dir );
+    return path;
+}
+
 static int thumbnailer_request_Start( void* owner, void* entity, void** out )
 {
     vlc_thumbnailer_t* thumbnailer = owner;
     vlc_thumbnailer_request_t* request = entity;
+
+    if ( request->params.file_cb != NULL )
+    {
+        char *path = thumbnailer_GetCachePath( thumbnailer, &request->params );
+        struct stat st;
+        bool cached = path != NULL && vlc_stat( path, &st ) == 0;
+
+        vlc_mutex_lock( &request->lock );
+        request->params.path = path;
+        if ( path == NULL || cached )
+        {
+            /* Nothing to decode: the worker releases the request */
+            if ( request->params.file_cb != NULL )
+                request->params.file_cb( request->params.user_data, path );
+            request->params.file_cb = NULL;
+            request->done = true;
+            vlc_mutex_unlock( &request->lock );
+            return VLC_EGENERIC;
+        }
+        vlc_mutex_unlock( &request->lock );
+    }
+
     input_thread_t* input = request->input_thread =
             input_CreateThumbnailer( thumbnailer->parent,
                                      on_thumbnailer_input_event, request,
                                      request->params.input_item );
     if ( unlikely( input == NULL ) )
     {
-        request->params.cb( request->params.user_data, NULL );
+        vlc_mutex_lock( &request->lock );
+        thumbnailer_request_Notify( request, NULL );
+        vlc_mutex_unlock( &request->lock );
         return VLC_EGENERIC;
     }
-    if ( request->params.type == VLC_THUMBNAILER_SEEK_TIME )
+    if ( request->params.keyframe_only )
+        thumbnailer_SetKeyframeOnly( input );
+    if ( request->params.batch_cb != NULL )
+    {
+        input_SetTime( input, request->params.times[0],
+                       request->params.fast_seek );
+    }
+    else if ( request->params.type == VLC_THUMBNAILER_SEEK_TIME )
     {
         input_SetTime( input, request->params.time,
                        request->params.fast_seek );
@@ -147,7 +471,9 @@ static int thumbnailer_request_Start( void* owner, void* entity, void** out )
     }
     if ( input_Start( input ) != VLC_SUCCESS )
     {
-        request->params.cb( request->params.user_data, NULL );
+        vlc_mutex_lock( &request->lock );
+        thumbnailer_request_Notify( request, NULL );
+        vlc_mutex_unlock( &request->lock );
         return VLC_EGENERIC;
     }
     *out = request;
@@ -164,11 +490,8 @@ static void thumbnailer_request_Stop( void* owner, void* handle )
      * If the callback hasn't been invoked yet, we assume a timeout and
      * signal it back to the user
      */
-    if ( request->params.cb != NULL )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        request->params.cb = NULL;
-    }
+    thumbnailer_request_Notify( request, NULL );
+    request->done = true;
     vlc_mutex_unlock( &request->lock );
     assert( request->input_thread != NULL );
     input_Stop( request->input_thread );
@@ -194,7 +517,31 @@ thumbnailer_RequestCommon( vlc_thumbnailer_t* thumbnailer,
     request->thumbnailer = thumbnailer;
     request->input_thread = NULL;
     request->params = *(vlc_thumbnailer_params_t*)params;
+    request->params.cache_dir = NULL;
     request->done = false;
+    request->writing = false;
+    if ( params->cache_dir != NULL )
+    {
+        request->params.cache_dir = strdup( params->cache_dir );
+        if ( unlikely( request->params.cache_dir == NULL ) )
+        {
+            free( request );
+            return NULL;
+        }
+    }
+    if ( params->times != NULL )
+    {
+        request->params.times = vlc_alloc( params->count,
+                                           sizeof( *params->times ) );
+        if ( unlikely( request->params.times == NULL ) )
+        {
+            free( request->params.cache_dir );
+            free( request );
+            return NULL;
+        }
+        memcpy( request->params.times, params->times,
+                params->count * sizeof( *params->times ) );
+    }
     input_item_Hold( request->params.input_item );
     vlc_mutex_init( &request->lock );
 
@@ -220,7 +567,8 @@ vlc_thumbnailer_RequestByTime( vlc_thumbnailer_t *thumbnailer,
             &(const vlc_thumbnailer_params_t){
                 .time = time,
                 .type = VLC_THUMBNAILER_SEEK_TIME,
-                .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
+                .fast_seek = speed != VLC_THUMBNAILER_SEEK_PRECISE,
+                .keyframe_only = speed == VLC_THUMBNAILER_SEEK_KEYFRAME,
                 .input_item = input_item,
                 .timeout = timeout,
                 .cb = cb,
@@ -238,7 +586,8 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
             &(const vlc_thumbnailer_params_t){
                 .pos = pos,
                 .type = VLC_THUMBNAILER_SEEK_POS,
-                .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
+                .fast_seek = speed != VLC_THUMBNAILER_SEEK_PRECISE,
+                .keyframe_only = speed == VLC_THUMBNAILER_SEEK_KEYFRAME,
                 .input_item = input_item,
                 .timeout = timeout,
                 .cb = cb,
@@ -246,12 +595,69 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
         });
 }
 
+vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data )
+{
+    if ( count == 0 )
+        return NULL;
+    return thumbnailer_RequestCommon( thumbnailer,
+            &(const vlc_thumbnailer_params_t){
+                .type = VLC_THUMBNAILER_SEEK_TIME,
+                .fast_seek = speed != VLC_THUMBNAILER_SEEK_PRECISE,
+                .keyframe_only = speed == VLC_THUMBNAILER_SEEK_KEYFRAME,
+                .input_item = input_item,
+                .timeout = timeout,
+                .times = (vlc_tick_t *)times,
+                .count = count,
+                .batch_cb = cb,
+                .user_data = user_data,
+        });
+}
+
+vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestToFile( vlc_thumbnailer_t *thumbnailer,
+                               vlc_tick_t time,
+                               enum vlc_thumbnailer_seek_speed speed,
+                               input_item_t *input_item, vlc_tick_t timeout,
+                               vlc_fourcc_t format,
+                               unsigned width, unsigned height, bool crop,
+                               const char *cache_dir,
+                               vlc_thumbnailer_file_cb cb, void* user_data )
+{
+    if ( thumbnailer_GetExtension( format ) == NULL )
+        return NULL;
+    /* As picture_Export(): -1 keeps the picture size */
+    bool keep_size = width == 0 && height == 0;
+    return thumbnailer_RequestCommon( thumbnailer,
+            &(const vlc_thumbnailer_params_t){
+                .time = time,
+                .type = VLC_THUMBNAILER_SEEK_TIME,
+                .fast_seek = speed != VLC_THUMBNAILER_SEEK_PRECISE,
+                .keyframe_only = speed == VLC_THUMBNAILER_SEEK_KEYFRAME,
+                .input_item = input_item,
+                .timeout = timeout,
+                .format = format,
+                .width = keep_size ? -1 : (int)width,
+                .height = keep_size ? -1 : (int)height,
+                .crop = crop,
+                .cache_dir = (char *)cache_dir,
+                .file_cb = cb,
+                .user_data = user_data,
+        });
+}
+
 void vlc_thumbnailer_Cancel( vlc_thumbnailer_t* thumbnailer,
                              vlc_thumbnailer_request_t* req )
 {
     vlc_mutex_lock( &req->lock );
     /* Ensure we won't invoke the callback if the input was running. */
     req->params.cb = NULL;
+    req->params.batch_cb = NULL;
+    req->params.file_cb = NULL;
     vlc_mutex_unlock( &req->lock );
     background_worker_Cancel( thumbnailer->worker, req );
 }
@@ -262,9 +668,11 @@ vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t* parent)
     if ( unlikely( thumbnailer == NULL ) )
         return NULL;
     thumbnailer->parent = parent;
+    vlc_mutex_init( &thumbnailer->lock );
+    vlc_vector_init( &thumbnailer->writers );
     struct background_worker_config cfg = {
         .default_timeout = -1,
-        .max_threads = 1,
+        .max_threads = var_InheritInteger( parent, "thumbnailer-threads" ),
         .pf_release = thumbnailer_request_Release,
         .pf_hold = thumbnailer_request_Hold,
         .pf_start = thumbnailer_request_Start,
@@ -274,6 +682,7 @@ vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t* parent)
     thumbnailer->worker = background_worker_New( thumbnailer, &cfg );
     if ( unlikely( thumbnailer->worker == NULL ) )
     {
+        vlc_mutex_destroy( &thumbnailer->lock );
         free( thumbnailer );
         return NULL;
     }
@@ -283,5 +692,11 @@ vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t* parent)
 void vlc_thumbnailer_Release( vlc_thumbnailer_t *thumbnailer )
 {
     background_worker_Delete( thumbnailer->worker );
+
+    image_handler_t *writer;
+    vlc_vector_foreach( writer, &thumbnailer->writers )
+        image_HandlerDelete( writer );
+    vlc_vector_destroy( &thumbnailer->writers );
+    vlc_mutex_destroy( &thumbnailer->lock );
     free( thumbnailer );
 }
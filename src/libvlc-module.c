@@ -540,6 +540,12 @@ static const char *const screensaver_texts[] = {
 
 #define CLOCK_MASTER_TEXT N_("Clock master source")
 
+#define CLOCK_OFFLINE_TEXT N_("Offline processing")
+#define CLOCK_OFFLINE_LONGTEXT N_( \
+    "Decode as fast as possible instead of synchronizing the playback to the " \
+    "system clock. This is meant for outputs that do not render in real " \
+    "time, such as the file audio output, e.g. to analyze audio files.")
+
 static const int pi_clock_master_values[] = {
     VLC_CLOCK_MASTER_AUDIO,
     VLC_CLOCK_MASTER_MONOTONIC,
@@ -657,7 +663,11 @@ static const char *const ppsz_prefres[] = {
 
 #define INPUT_LOWDELAY_TEXT N_("Low delay mode")
 #define INPUT_LOWDELAY_LONGTEXT N_(\
-    "Try to minimize delay along decoding chain."\
+    "Try to minimize delay along decoding chain: decode with slice " \
+    "threads only, output pictures without waiting for reordering when " \
+    "the stream allows it, queue fewer blocks before the decoder, drop " \
+    "the queued blocks of a live input once the decoder is late by more " \
+    "than half a second, and log the measured latency of each stage. " \
     "Might break with non compliant streams.")
 
 #define INPUT_REPEAT_TEXT N_("Input repetitions")
@@ -1018,6 +1028,14 @@ static const char *const ppsz_prefres[] = {
     "This allow you to configure the initial caching amount for stream output " \
     "muxer. This value should be set in milliseconds." )
 
+#define SOUT_PASSTHROUGH_TEXT N_("Pass packetized streams through")
+#define SOUT_PASSTHROUGH_LONGTEXT N_( \
+    "Send the elementary streams that the demuxer already splits into " \
+    "access units and that need no packetizer (VP8, Opus and text " \
+    "subtitles) straight to the stream output, without decoder thread. " \
+    "This speeds up remuxing, but closed captions are not extracted from " \
+    "such streams." )
+
 #define PACKETIZER_TEXT N_("Preferred packetizer list")
 #define PACKETIZER_LONGTEXT N_( \
     "This allows you to select the order in which VLC will choose its " \
@@ -1084,6 +1102,12 @@ static const char *const ppsz_prefres[] = {
     "slow. You should only activate this if you know what you're " \
     "doing.")
 
+#define CPU_THREADS_TEXT N_("Worker threads budget")
+#define CPU_THREADS_LONGTEXT N_( \
+    "Maximum number of worker threads shared by all the multi-threaded " \
+    "decoders and encoders of the process, unless configured otherwise " \
+    "individually. 0 means the number of CPUs.")
+
 #define RT_OFFSET_TEXT N_("Adjust VLC priority")
 #define RT_OFFSET_LONGTEXT N_( \
     "This option adds an offset (positive or negative) to VLC default " \
@@ -1198,6 +1222,10 @@ static const char *const clock_sources_text[] = {
 #define PREPARSE_THREADS_LONGTEXT N_( \
     "Maximum number of threads used to preparse items" )
 
+#define THUMBNAILER_THREADS_TEXT N_( "Thumbnailer threads" )
+#define THUMBNAILER_THREADS_LONGTEXT N_( \
+    "Maximum number of threads used to generate thumbnails" )
+
 #define FETCH_ART_THREADS_TEXT N_( "Fetch-art threads" )
 #define FETCH_ART_THREADS_LONGTEXT N_( \
     "Maximum number of threads used to fetch art" )
@@ -2012,6 +2040,8 @@ vlc_module_begin ()
     add_integer( "clock-master", VLC_CLOCK_MASTER_DEFAULT,
                  CLOCK_MASTER_TEXT, NULL, true )
         change_integer_list( pi_clock_master_values, ppsz_clock_master_descriptions )
+    add_bool( "clock-offline", false, CLOCK_OFFLINE_TEXT,
+              CLOCK_OFFLINE_LONGTEXT, true )
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
@@ -2075,6 +2105,8 @@ vlc_module_begin ()
                                 SOUT_SPU_LONGTEXT, true )
     add_integer( "sout-mux-caching", 1500, SOUT_MUX_CACHING_TEXT,
                                 SOUT_MUX_CACHING_LONGTEXT, true )
+    add_bool( "sout-passthrough", false, SOUT_PASSTHROUGH_TEXT,
+                                SOUT_PASSTHROUGH_LONGTEXT, true )
 
     set_section( N_("VLM"), NULL )
     add_loadfile("vlm-conf", NULL, VLM_CONF_TEXT, VLM_CONF_LONGTEXT)
@@ -2141,6 +2173,10 @@ vlc_module_begin ()
 
     set_section( N_("Performance options"), NULL )
 
+    add_integer( "cpu-threads", 0, CPU_THREADS_TEXT,
+                 CPU_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 1024 )
+
 #if defined (LIBVLC_USE_PTHREAD)
     add_bool( "rt-priority", false, RT_PRIORITY_TEXT,
               RT_PRIORITY_LONGTEXT, true )
@@ -2216,6 +2252,9 @@ vlc_module_begin ()
     add_integer( "fetch-art-threads", 1, FETCH_ART_THREADS_TEXT,
                  FETCH_ART_THREADS_LONGTEXT, false )
 
+    add_integer( "thumbnailer-threads", 1, THUMBNAILER_THREADS_TEXT,
+                 THUMBNAILER_THREADS_LONGTEXT, false )
+
     add_obsolete_integer( "album-art" )
     add_bool( "metadata-network-access", false, METADATA_NETWORK_TEXT,
                  METADATA_NETWORK_TEXT, false )
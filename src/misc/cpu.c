@@ -318,3 +318,48 @@ void vlc_CPU_dump (vlc_object_t *obj)
         free(stream.ptr);
     }
 }
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned users; /**< number of vlc_CPU_AcquireThreads() callers */
+    unsigned threads; /**< threads allotted to them */
+} budget = { VLC_STATIC_MUTEX, 0, 0 };
+
+#undef vlc_CPU_AcquireThreads
+unsigned vlc_CPU_AcquireThreads(vlc_object_t *obj, unsigned wanted)
+{
+    int64_t total = var_InheritInteger(obj, "cpu-threads");
+    if (total <= 0)
+        total = vlc_GetCPUCount();
+
+    vlc_mutex_lock(&budget.lock);
+
+    /* The users already running keep their threads: the new one gets a fair
+     * share of the budget, even if that oversubscribes the CPUs, up to twice
+     * the budget in total. */
+    unsigned share = total / (budget.users + 1);
+    unsigned left = 2 * total > budget.threads ? 2 * total - budget.threads
+                                               : 0;
+    unsigned count = __MIN(wanted, __MIN(share, left));
+
+    if (count == 0)
+        count = 1;
+    budget.users++;
+    budget.threads += count;
+
+    msg_Dbg(obj, "allotting %u of %u thread(s) (%u of %"PRId64" in use, "
+            "%u user(s))", count, wanted, budget.threads, total,
+            budget.users);
+    vlc_mutex_unlock(&budget.lock);
+    return count;
+}
+
+void vlc_CPU_ReleaseThreads(unsigned count)
+{
+    vlc_mutex_lock(&budget.lock);
+    assert(budget.users > 0 && budget.threads >= count);
+    budget.users--;
+    budget.threads -= count;
+    vlc_mutex_unlock(&budget.lock);
+}
@@ -433,13 +433,13 @@ picture_t *picture_Clone(picture_t *picture)
 /*****************************************************************************
  *
  *****************************************************************************/
-int picture_Export( vlc_object_t *p_obj,
-                    block_t **pp_image,
-                    video_format_t *p_fmt,
-                    picture_t *p_picture,
-                    vlc_fourcc_t i_format,
-                    int i_override_width, int i_override_height,
-                    bool b_crop )
+int picture_ExportWith( image_handler_t *p_image,
+                        block_t **pp_image,
+                        video_format_t *p_fmt,
+                        picture_t *p_picture,
+                        vlc_fourcc_t i_format,
+                        int i_override_width, int i_override_height,
+                        bool b_crop )
 {
     /* */
     video_format_t fmt_in = p_picture->format;
@@ -522,14 +522,7 @@ int picture_Export( vlc_object_t *p_obj,
                          * fmt_in.i_sar_num / fmt_in.i_height / fmt_in.i_sar_den;
     }
 
-    image_handler_t *p_image = image_HandlerCreate( p_obj );
-    if( !p_image )
-        return VLC_ENOMEM;
-
     block_t *p_block = image_Write( p_image, p_picture, &fmt_in, &fmt_out );
-
-    image_HandlerDelete( p_image );
-
     if( !p_block )
         return VLC_EGENERIC;
 
@@ -542,3 +535,22 @@ int picture_Export( vlc_object_t *p_obj,
 
     return VLC_SUCCESS;
 }
+
+int picture_Export( vlc_object_t *p_obj,
+                    block_t **pp_image,
+                    video_format_t *p_fmt,
+                    picture_t *p_picture,
+                    vlc_fourcc_t i_format,
+                    int i_override_width, int i_override_height,
+                    bool b_crop )
+{
+    image_handler_t *p_image = image_HandlerCreate( p_obj );
+    if( !p_image )
+        return VLC_ENOMEM;
+
+    int i_ret = picture_ExportWith( p_image, pp_image, p_fmt, p_picture,
+                                    i_format, i_override_width,
+                                    i_override_height, b_crop );
+    image_HandlerDelete( p_image );
+    return i_ret;
+}
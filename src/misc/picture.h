@@ -37,3 +37,12 @@ typedef struct
 
 void *picture_Allocate(int *, size_t);
 void picture_Deallocate(int, void *, size_t);
+
+/**
+ * Exports a picture like picture_Export(), through the given image handler.
+ *
+ * The handler keeps its encoder and converter from one call to the next, as
+ * long as the formats do not change.
+ */
+int picture_ExportWith(image_handler_t *, block_t **, video_format_t *,
+                       picture_t *, vlc_fourcc_t, int, int, bool);
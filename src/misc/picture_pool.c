@@ -26,17 +26,26 @@
 # include "config.h"
 #endif
 #include <assert.h>
-#include <limits.h>
 #include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
 #include <vlc_picture_pool.h>
 #include "picture.h"
 
-#define POOL_MAX (CHAR_BIT * sizeof (unsigned long long))
-
-static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
+/* Free pictures are kept in a lock-free LIFO. The head packs the index of the
+ * top slot plus one (zero if the list is empty) in the low bits, and a
+ * generation counter in the high bits to prevent ABA issues. */
+#define POOL_EMPTY 0
+#define POOL_INDEX(head) ((unsigned)((head) & 0xffffffff))
+#define POOL_HEAD(index, gen) ((((uint_least64_t)(gen)) << 32) | (index))
+
+struct picture_pool_slot {
+    picture_t        *picture;
+    picture_pool_t   *pool;
+    atomic_uint       next; /* index of the next free slot plus one */
+};
 
 struct picture_pool_t {
     int       (*pic_lock)(picture_t *);
@@ -44,13 +53,61 @@ struct picture_pool_t {
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
-    atomic_ushort      refs;
-    unsigned short     picture_count;
-    picture_t  *picture[];
+    atomic_bool          canceled;
+    atomic_uint_least64_t free_head;
+    atomic_uint          waiters;
+    atomic_uint          refs;
+
+    /* Statistics */
+    atomic_uint          in_use;
+    atomic_uint          peak_in_use;
+    atomic_uint_least64_t exhausted;
+    atomic_uint_least64_t waited;
+
+    unsigned             picture_count;
+    struct picture_pool_slot slots[];
 };
 
+static void picture_pool_Push(picture_pool_t *pool, unsigned offset)
+{
+    uint_least64_t head = atomic_load_explicit(&pool->free_head,
+                                               memory_order_relaxed);
+    uint_least64_t newhead;
+
+    do {
+        atomic_store_explicit(&pool->slots[offset].next, POOL_INDEX(head),
+                              memory_order_relaxed);
+        newhead = POOL_HEAD(offset + 1, (head >> 32) + 1);
+    } while (!atomic_compare_exchange_weak(&pool->free_head, &head, newhead));
+
+    /* A waiter registers itself before checking the free list again, so
+     * either it sees the picture pushed above, or it is seen here. */
+    if (atomic_load(&pool->waiters) > 0) {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
+static int picture_pool_Pop(picture_pool_t *pool)
+{
+    uint_least64_t head = atomic_load(&pool->free_head);
+    uint_least64_t newhead;
+
+    do {
+        unsigned index = POOL_INDEX(head);
+
+        if (index == POOL_EMPTY)
+            return -1;
+
+        unsigned next = atomic_load_explicit(&pool->slots[index - 1].next,
+                                             memory_order_relaxed);
+        newhead = POOL_HEAD(next, (head >> 32) + 1);
+    } while (!atomic_compare_exchange_weak(&pool->free_head, &head, newhead));
+
+    return POOL_INDEX(head) - 1;
+}
+
 static void picture_pool_Destroy(picture_pool_t *pool)
 {
     if (atomic_fetch_sub_explicit(&pool->refs, 1, memory_order_release) != 1)
@@ -59,33 +116,29 @@ static void picture_pool_Destroy(picture_pool_t *pool)
     atomic_thread_fence(memory_order_acquire);
     vlc_cond_destroy(&pool->wait);
     vlc_mutex_destroy(&pool->lock);
-    aligned_free(pool);
+    free(pool);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
 {
     for (unsigned i = 0; i < pool->picture_count; i++)
-        picture_Release(pool->picture[i]);
+        picture_Release(pool->slots[i].picture);
     picture_pool_Destroy(pool);
 }
 
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
-    uintptr_t sys = (uintptr_t)priv->gc.opaque;
-    picture_pool_t *pool = (void *)(sys & ~(POOL_MAX - 1));
-    unsigned offset = sys & (POOL_MAX - 1);
-    picture_t *picture = pool->picture[offset];
+    struct picture_pool_slot *slot = priv->gc.opaque;
+    picture_pool_t *pool = slot->pool;
+    picture_t *picture = slot->picture;
 
     if (pool->pic_unlock != NULL)
         pool->pic_unlock(picture);
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
+    atomic_fetch_sub_explicit(&pool->in_use, 1, memory_order_relaxed);
+    picture_pool_Push(pool, slot - pool->slots);
 
     picture_pool_Destroy(pool);
 }
@@ -93,8 +146,8 @@ static void picture_pool_ReleasePicture(picture_t *clone)
 static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
                                             unsigned offset)
 {
-    picture_t *picture = pool->picture[offset];
-    uintptr_t sys = ((uintptr_t)pool) + offset;
+    struct picture_pool_slot *slot = &pool->slots[offset];
+    picture_t *picture = slot->picture;
     picture_resource_t res = {
         .p_sys = picture->p_sys,
         .pf_destroy = picture_pool_ReleasePicture,
@@ -108,22 +161,51 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
 
     picture_t *clone = picture_NewFromResource(&picture->format, &res);
     if (likely(clone != NULL)) {
-        ((picture_priv_t *)clone)->gc.opaque = (void *)sys;
+        ((picture_priv_t *)clone)->gc.opaque = slot;
         picture_Hold(picture);
     }
     return clone;
 }
 
+/**
+ * Turns a locked slot taken from the free list into a picture.
+ */
+static picture_t *picture_pool_Take(picture_pool_t *pool, unsigned offset)
+{
+    picture_t *picture = pool->slots[offset].picture;
+
+    picture_t *clone = picture_pool_ClonePicture(pool, offset);
+    if (clone == NULL) {
+        if (pool->pic_unlock != NULL)
+            pool->pic_unlock(picture);
+        picture_pool_Push(pool, offset);
+        return NULL;
+    }
+
+    assert(clone->p_next == NULL);
+    atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+
+    unsigned in_use = atomic_fetch_add_explicit(&pool->in_use, 1,
+                                                memory_order_relaxed) + 1;
+    unsigned peak = atomic_load_explicit(&pool->peak_in_use,
+                                         memory_order_relaxed);
+    while (peak < in_use
+        && !atomic_compare_exchange_weak_explicit(&pool->peak_in_use, &peak,
+                                                  in_use, memory_order_relaxed,
+                                                  memory_order_relaxed));
+    return clone;
+}
+
 picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg)
 {
-    if (unlikely(cfg->picture_count > POOL_MAX))
+    if (unlikely(cfg->picture_count >= UINT32_MAX))
         return NULL;
 
     picture_pool_t *pool;
-    size_t size = sizeof (*pool) + cfg->picture_count * sizeof (picture_t *);
+    size_t size = sizeof (*pool)
+                + cfg->picture_count * sizeof (struct picture_pool_slot);
 
-    size += (-size) & (POOL_MAX - 1);
-    pool = aligned_alloc(POOL_MAX, size);
+    pool = malloc(size);
     if (unlikely(pool == NULL))
         return NULL;
 
@@ -131,15 +213,24 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     pool->pic_unlock = cfg->unlock;
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
-    if (cfg->picture_count == POOL_MAX)
-        pool->available = ~0ULL;
-    else
-        pool->available = (1ULL << cfg->picture_count) - 1;
+    atomic_init(&pool->canceled, false);
+    atomic_init(&pool->waiters, 0);
     atomic_init(&pool->refs,  1);
+    atomic_init(&pool->in_use, 0);
+    atomic_init(&pool->peak_in_use, 0);
+    atomic_init(&pool->exhausted, 0);
+    atomic_init(&pool->waited, 0);
     pool->picture_count = cfg->picture_count;
-    memcpy(pool->picture, cfg->picture,
-           cfg->picture_count * sizeof (picture_t *));
-    pool->canceled = false;
+
+    /* Lower indexes are handed out first, as with the former bitmap */
+    for (unsigned i = 0; i < cfg->picture_count; i++) {
+        pool->slots[i].picture = cfg->picture[i];
+        pool->slots[i].pool = pool;
+        atomic_init(&pool->slots[i].next,
+                    (i + 1 < cfg->picture_count) ? i + 2 : POOL_EMPTY);
+    }
+    atomic_init(&pool->free_head,
+                POOL_HEAD(cfg->picture_count > 0 ? 1 : POOL_EMPTY, 0));
     return pool;
 }
 
@@ -202,86 +293,83 @@ error:
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    unsigned long long available;
+    unsigned failed = POOL_EMPTY;
+    picture_t *clone = NULL;
 
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-    available = pool->available;
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    while (available != 0)
+    while (likely(!atomic_load(&pool->canceled)))
     {
-        int i = ctz(available);
-
-        if (unlikely(pool->canceled))
+        int i = picture_pool_Pop(pool);
+        if (i < 0) {
+            atomic_fetch_add_explicit(&pool->exhausted, 1,
+                                      memory_order_relaxed);
             break;
+        }
 
-        pool->available &= ~(1ULL << i);
-        vlc_mutex_unlock(&pool->lock);
-        available &= ~(1ULL << i);
-
-        picture_t *picture = pool->picture[i];
+        picture_t *picture = pool->slots[i].picture;
 
         if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-            vlc_mutex_lock(&pool->lock);
-            pool->available |= 1ULL << i;
+            /* Keep the slot aside so that the next pop returns another one */
+            atomic_store_explicit(&pool->slots[i].next, failed,
+                                  memory_order_relaxed);
+            failed = i + 1;
             continue;
         }
 
-        picture_t *clone = picture_pool_ClonePicture(pool, i);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
-        }
-        return clone;
+        clone = picture_pool_Take(pool, i);
+        break;
     }
 
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
+    while (failed != POOL_EMPTY) {
+        unsigned next = atomic_load_explicit(&pool->slots[failed - 1].next,
+                                             memory_order_relaxed);
+        picture_pool_Push(pool, failed - 1);
+        failed = next;
+    }
+    return clone;
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    int i;
 
-    while (pool->available == 0)
-    {
-        if (pool->canceled)
-        {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
-        }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
-
-    int i = ctz(pool->available);
-    pool->available &= ~(1ULL << i);
-    vlc_mutex_unlock(&pool->lock);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    picture_t *picture = pool->picture[i];
+    while ((i = picture_pool_Pop(pool)) < 0)
+    {
+        bool canceled;
 
-    if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
         vlc_mutex_lock(&pool->lock);
-        pool->available |= 1ULL << i;
-        vlc_cond_signal(&pool->wait);
+        atomic_fetch_add(&pool->waiters, 1);
+        atomic_fetch_add_explicit(&pool->waited, 1, memory_order_relaxed);
+        while (!(canceled = atomic_load(&pool->canceled))
+            && POOL_INDEX(atomic_load(&pool->free_head)) == POOL_EMPTY)
+            vlc_cond_wait(&pool->wait, &pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
         vlc_mutex_unlock(&pool->lock);
-        return NULL;
+
+        if (canceled)
+            return NULL;
     }
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    picture_t *picture = pool->slots[i].picture;
+
+    if (atomic_load(&pool->canceled)
+     || (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS))
+    {
+        picture_pool_Push(pool, i);
+        return NULL;
     }
-    return clone;
+    return picture_pool_Take(pool, i);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
     vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    pool->canceled = canceled;
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
@@ -300,13 +388,12 @@ bool picture_pool_OwnsPic(picture_pool_t *pool, picture_t *pic)
     }
 
     do {
-        uintptr_t sys = (uintptr_t)priv->gc.opaque;
-        picture_pool_t *picpool = (void *)(sys & ~(POOL_MAX - 1));
+        struct picture_pool_slot *slot = priv->gc.opaque;
 
-        if (pool == picpool)
+        if (pool == slot->pool)
             return true;
 
-        pic = picpool->picture[sys & (POOL_MAX - 1 )];
+        pic = slot->picture;
         priv = (picture_priv_t *)pic;
     } while (priv->gc.destroy == picture_pool_ReleasePicture);
 
@@ -317,3 +404,14 @@ unsigned picture_pool_GetSize(const picture_pool_t *pool)
 {
     return pool->picture_count;
 }
+
+void picture_pool_GetStats(picture_pool_t *pool, picture_pool_stats_t *stats)
+{
+    stats->size = pool->picture_count;
+    stats->in_use = atomic_load_explicit(&pool->in_use, memory_order_relaxed);
+    stats->peak_in_use = atomic_load_explicit(&pool->peak_in_use,
+                                              memory_order_relaxed);
+    stats->exhausted = atomic_load_explicit(&pool->exhausted,
+                                            memory_order_relaxed);
+    stats->waited = atomic_load_explicit(&pool->waited, memory_order_relaxed);
+}
@@ -31,6 +31,9 @@
 #include <vlc_picture_pool.h>
 
 #define PICTURES 10
+#define LARGE_PICTURES 300
+#define STRESS_THREADS 4
+#define STRESS_LOOPS 20000
 
 const char vlc_module_name[] = "test_picture_pool";
 
@@ -108,6 +111,88 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+static void test_large(void)
+{
+    picture_t *pics[LARGE_PICTURES];
+    picture_pool_stats_t stats;
+
+    /* More pictures than bits in a machine word */
+    pool = picture_pool_NewFromFormat(&fmt, LARGE_PICTURES);
+    assert(pool != NULL);
+    assert(picture_pool_GetSize(pool) == LARGE_PICTURES);
+
+    for (unsigned i = 0; i < LARGE_PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+        for (unsigned j = 0; j < i; j++)
+            assert(pics[j]->p[0].p_pixels != pics[i]->p[0].p_pixels);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.size == LARGE_PICTURES);
+    assert(stats.in_use == LARGE_PICTURES);
+    assert(stats.peak_in_use == LARGE_PICTURES);
+    assert(stats.exhausted == 1);
+
+    for (unsigned i = 0; i < LARGE_PICTURES; i++)
+        picture_Release(pics[i]);
+
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.in_use == 0);
+    assert(stats.peak_in_use == LARGE_PICTURES);
+
+    picture_pool_Release(pool);
+}
+
+static void *stress_thread(void *data)
+{
+    picture_pool_t *p = data;
+    picture_t *pics[3];
+
+    for (unsigned i = 0; i < STRESS_LOOPS; i++) {
+        /* Hold several pictures at once to exhaust the pool regularly */
+        for (unsigned j = 0; j < ARRAY_SIZE(pics); j++) {
+            pics[j] = picture_pool_Wait(p);
+            assert(pics[j] != NULL);
+        }
+        for (unsigned j = 0; j < ARRAY_SIZE(pics); j++)
+            picture_Release(pics[j]);
+    }
+    return NULL;
+}
+
+static void test_stress(void)
+{
+    vlc_thread_t threads[STRESS_THREADS];
+    picture_pool_stats_t stats;
+
+    /* Fewer pictures than the threads can hold, so that they have to wait,
+     * but enough that at least one thread can always make progress */
+    pool = picture_pool_NewFromFormat(&fmt, 2 * STRESS_THREADS + 1);
+    assert(pool != NULL);
+
+    for (unsigned i = 0; i < STRESS_THREADS; i++) {
+        int val = vlc_clone(&threads[i], stress_thread, pool,
+                            VLC_THREAD_PRIORITY_LOW);
+        assert(val == 0);
+    }
+    for (unsigned i = 0; i < STRESS_THREADS; i++)
+        vlc_join(threads[i], NULL);
+
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.in_use == 0);
+    assert(stats.peak_in_use <= 2 * STRESS_THREADS + 1);
+
+    /* Cancellation must wake up the waiting threads */
+    picture_pool_Cancel(pool, true);
+    assert(picture_pool_Wait(pool) == NULL);
+    assert(picture_pool_Get(pool) == NULL);
+    picture_pool_Cancel(pool, false);
+
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -124,6 +209,8 @@ int main(void)
 
     test(false);
     test(true);
+    test_large();
+    test_stress();
 
     return 0;
 }
@@ -100,4 +100,11 @@ static inline void test_init (void)
     setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
 }
 
+/* Whether to run the benchmarks along with the checks: they only slow down
+ * "make check", so they run only with VLC_TEST_BENCH set in the environment */
+static inline bool test_bench (void)
+{
+    return getenv("VLC_TEST_BENCH") != NULL;
+}
+
 #endif /* TEST_H */
@@ -0,0 +1,257 @@
+/*****************************************************************************
+ * bandlimited.c: band-limited resampler unit testing
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+#include <vlc_tick.h>
+
+#define FRAMES   1024 /* per input block */
+#define SECONDS  2    /* of input, per sweep */
+#define MARGIN   0.05 /* seconds skipped at both ends of the sweep */
+#define MIN_SNR  80.  /* dB */
+
+static const struct
+{
+    unsigned in;
+    unsigned out;
+} rates[] = {
+    { 44100, 48000 },
+    { 48000, 44100 },
+    { 96000, 48000 },
+    { 22050, 48000 },
+    { 44117, 48000 }, /* no simple ratio: interpolated coefficients */
+};
+
+static filter_t *CreateResampler(libvlc_instance_t *vlc, unsigned in_rate,
+                                 unsigned out_rate)
+{
+    filter_t *filter = vlc_object_create(vlc->p_libvlc_int, sizeof (*filter));
+    if (filter == NULL)
+        return NULL;
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = in_rate;
+    filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_STEREO;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Init(&filter->fmt_out, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_out.audio = filter->fmt_in.audio;
+    filter->fmt_out.audio.i_rate = out_rate;
+
+    filter->p_module = module_need(filter, "audio resampler", "bandlimited",
+                                   true);
+    if (filter->p_module == NULL)
+    {
+        vlc_object_delete(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+static void DeleteResampler(filter_t *filter)
+{
+    module_unneed(filter, filter->p_module);
+    vlc_object_delete(filter);
+}
+
+/* Linear sweep from 20 Hz to 3/4 of the lowest Nyquist frequency, that is
+ * within the pass band of the filter */
+static double Sweep(double t, double top)
+{
+    const double f0 = 20.;
+
+    return .5 * sin(2. * M_PI * (f0 * t + (top - f0) * t * t
+                                 / (2. * SECONDS)));
+}
+
+static block_t *NewSweep(size_t first, unsigned rate, double top)
+{
+    block_t *block = block_Alloc(FRAMES * 2 * sizeof (float));
+    assert(block != NULL);
+
+    float *p = (float *)block->p_buffer;
+    for (size_t n = first; n < first + FRAMES; n++)
+    {
+        double v = Sweep((double)n / rate, top);
+        *p++ = v;
+        *p++ = -v;
+    }
+    block->i_nb_samples = FRAMES;
+    block->i_pts = block->i_dts = VLC_TICK_0
+                                + vlc_tick_from_samples(first, rate);
+    block->i_length = vlc_tick_from_samples(FRAMES, rate);
+    return block;
+}
+
+/*
+ * Resamples a sine sweep, and compares the output with the sweep computed at
+ * the output rate. The first output sample is centered on the first input
+ * sample.
+ */
+static int TestSweep(libvlc_instance_t *vlc, unsigned in_rate,
+                     unsigned out_rate)
+{
+    filter_t *filter = CreateResampler(vlc, in_rate, out_rate);
+    if (filter == NULL)
+    {
+        fprintf(stderr, "no bandlimited resampler\n");
+        return 1;
+    }
+
+    const double top = .75 * __MIN(in_rate, out_rate) / 2.;
+    const size_t skip = MARGIN * out_rate;
+    const size_t end = (SECONDS - MARGIN) * out_rate;
+    double signal = 0., noise = 0.;
+    size_t in_frames = 0, out_frames = 0;
+
+    while (in_frames < SECONDS * in_rate)
+    {
+        block_t *out = filter->pf_audio_filter(filter,
+                                               NewSweep(in_frames, in_rate,
+                                                        top));
+        in_frames += FRAMES;
+        if (out == NULL)
+            continue;
+
+        /* Contiguous timestamps, from the first input block */
+        vlc_tick_t pts = VLC_TICK_0
+                       + vlc_tick_from_samples(out_frames, out_rate);
+        assert(llabs(out->i_pts - pts) <= 1);
+
+        const float *q = (const float *)out->p_buffer;
+        for (size_t n = 0; n < out->i_nb_samples; n++, out_frames++)
+        {
+            if (out_frames < skip || out_frames >= end)
+                continue;
+
+            double ref = Sweep((double)out_frames / out_rate, top);
+            signal += 2. * ref * ref;
+            noise += (q[2 * n] - ref) * (q[2 * n] - ref)
+                   + (q[2 * n + 1] + ref) * (q[2 * n + 1] + ref);
+        }
+        block_Release(out);
+    }
+    DeleteResampler(filter);
+
+    const double snr = 10. * log10(signal / noise);
+    printf("%5u -> %5u Hz: %zu frames out of %zu, SNR %.1f dB\n",
+           in_rate, out_rate, out_frames, in_frames, snr);
+
+    return out_frames < end || snr < MIN_SNR;
+}
+
+/*
+ * Once drift compensation brings the input rate back to the output rate, the
+ * samples still pending are output once and the next blocks pass through.
+ */
+static int TestPassthrough(libvlc_instance_t *vlc)
+{
+    const unsigned rate = 48000;
+    const double top = 1000.;
+
+    /* Slightly too slow, as aout_FiltersAdjustResampling() would do */
+    filter_t *filter = CreateResampler(vlc, rate - 10, rate);
+    if (filter == NULL)
+    {
+        fprintf(stderr, "no bandlimited resampler\n");
+        return 1;
+    }
+
+    size_t in_frames = 0, out_frames = 0;
+    for (unsigned i = 0; i < 16; i++)
+    {
+        block_t *out = filter->pf_audio_filter(filter,
+                                               NewSweep(in_frames, rate,
+                                                        top));
+        in_frames += FRAMES;
+        if (out != NULL)
+        {
+            out_frames += out->i_nb_samples;
+            block_Release(out);
+        }
+    }
+
+    filter->fmt_in.audio.i_rate = rate;
+
+    /* The pending samples are output with the first block, after the
+     * previous output */
+    block_t *out = filter->pf_audio_filter(filter,
+                                           NewSweep(in_frames, rate, top));
+    in_frames += FRAMES;
+    assert(out != NULL);
+    assert(out->i_nb_samples > FRAMES);
+    assert(llabs(out->i_pts - VLC_TICK_0
+                 - vlc_tick_from_samples(out_frames, rate)) <= 1);
+    out_frames += out->i_nb_samples;
+    block_Release(out);
+
+    /* Nothing is lost nor repeated */
+    const double expected = 16. * FRAMES * rate / (rate - 10) + FRAMES;
+    printf("passthrough: %zu frames out of %zu (%.1f expected)\n",
+           out_frames, in_frames, expected);
+    assert(fabs(out_frames - expected) < 2.);
+
+    /* The next blocks are returned as is */
+    for (unsigned i = 0; i < 4; i++)
+    {
+        block_t *in = NewSweep(in_frames, rate, top);
+        in_frames += FRAMES;
+        out = filter->pf_audio_filter(filter, in);
+        assert(out == in);
+        assert(out->i_nb_samples == FRAMES);
+        block_Release(out);
+    }
+
+    DeleteResampler(filter);
+    return 0;
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    if (vlc == NULL)
+        return 1;
+
+    int ret = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(rates); i++)
+        ret |= TestSweep(vlc, rates[i].in, rates[i].out);
+    ret |= TestPassthrough(vlc);
+
+    libvlc_release(vlc);
+    return ret;
+}
@@ -0,0 +1,200 @@
+/*****************************************************************************
+ * convolver.c: partitioned convolution engine unit testing and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "../../libvlc/test.h"
+#include "../modules/audio_filter/convolution/convolver.c"
+
+#include <vlc_tick.h>
+
+const char vlc_module_name[] = "test_convolver";
+
+#define FRAMES   20000
+#define INPUTS   3
+#define OUTPUTS  2
+#define DURATION VLC_TICK_FROM_MS(200) /* per benchmark */
+
+static float Random(void)
+{
+    return rand() / (float)RAND_MAX - .5f;
+}
+
+/* Compares the engine with a direct convolution */
+static int TestConvolution(unsigned block, size_t length)
+{
+    float *ir[INPUTS][OUTPUTS];
+    convolver_t *conv = convolver_New(block, INPUTS, OUTPUTS, length);
+    assert(conv != NULL);
+
+    for (unsigned i = 0; i < INPUTS; i++)
+        for (unsigned o = 0; o < OUTPUTS; o++)
+        {
+            /* Leave one route disconnected, and use shorter responses */
+            if (i == INPUTS - 1 && o == 0)
+            {
+                ir[i][o] = NULL;
+                continue;
+            }
+            size_t len = length - i;
+            ir[i][o] = malloc(len * sizeof (float));
+            assert(ir[i][o] != NULL);
+            for (size_t k = 0; k < len; k++)
+                ir[i][o][k] = Random() * expf(-3.f * k / length);
+            int val = convolver_SetIR(conv, i, o, ir[i][o], len);
+            assert(val == 0);
+        }
+
+    float *in = malloc(FRAMES * INPUTS * sizeof (float));
+    float *out = malloc(FRAMES * OUTPUTS * sizeof (float));
+    assert(in != NULL && out != NULL);
+    for (size_t k = 0; k < FRAMES * INPUTS; k++)
+        in[k] = Random();
+
+    /* Process chunks of random sizes */
+    for (size_t pos = 0; pos < FRAMES;)
+    {
+        size_t count = 1 + (size_t)rand() % 700;
+        if (count > FRAMES - pos)
+            count = FRAMES - pos;
+        convolver_Process(conv, in + pos * INPUTS, out + pos * OUTPUTS, count);
+        pos += count;
+    }
+
+    double max_error = 0.;
+    for (unsigned o = 0; o < OUTPUTS; o++)
+        for (size_t t = block; t < FRAMES; t++)
+        {
+            double ref = 0.;
+            size_t now = t - block; /* the output is delayed by one block */
+
+            for (unsigned i = 0; i < INPUTS; i++)
+            {
+                if (ir[i][o] == NULL)
+                    continue;
+                for (size_t k = 0; k < length - i && k <= now; k++)
+                    ref += ir[i][o][k] * in[(now - k) * INPUTS + i];
+            }
+            max_error = fmax(max_error, fabs(ref - out[t * OUTPUTS + o]));
+        }
+
+    printf("block %4u, length %5zu: max error %g\n", block, length,
+           max_error);
+
+    for (unsigned i = 0; i < INPUTS; i++)
+        for (unsigned o = 0; o < OUTPUTS; o++)
+            free(ir[i][o]);
+    free(in);
+    free(out);
+    convolver_Delete(conv);
+    return max_error > 1e-4;
+}
+
+/* Checks that the dry signal is delayed like the convolved one */
+static int TestResponses(void)
+{
+    const float ir[2] = { 0.f, 1.f };
+    float buf[2 * CONVOLVER_BLOCK * 2];
+    convolver_t *conv = convolver_New(CONVOLVER_BLOCK, 2, 2, 2);
+    assert(conv != NULL);
+    int val = convolver_SetResponses(conv, ir, 1, 2, .5f, .25f);
+    assert(val == 0);
+    /* Neither 1, 2 nor 4 channels */
+    val = convolver_SetResponses(conv, ir, 3, 2, .5f, .25f);
+    assert(val != 0);
+
+    memset(buf, 0, sizeof (buf));
+    buf[0] = 1.f; /* impulse on the left channel */
+    convolver_Process(conv, buf, buf, 2 * CONVOLVER_BLOCK);
+
+    int ret = 0;
+    for (unsigned k = 0; k < 2 * CONVOLVER_BLOCK * 2; k++)
+    {
+        float expected = 0.f;
+        if (k == 2 * CONVOLVER_BLOCK)
+            expected = .25f;
+        else if (k == 2 * (CONVOLVER_BLOCK + 1))
+            expected = .5f;
+        if (fabsf(buf[k] - expected) > 1e-6f)
+            ret = 1;
+    }
+    convolver_Delete(conv);
+    return ret;
+}
+
+/* Measures the speed of a stereo room response, in real time factor */
+static void Benchmark(size_t length)
+{
+    const unsigned rate = 48000;
+    float *ir = malloc(length * sizeof (float));
+    float *buf = calloc(2 * rate, sizeof (float));
+    convolver_t *conv = convolver_New(CONVOLVER_BLOCK, 2, 2, length);
+    assert(ir != NULL && buf != NULL && conv != NULL);
+
+    for (size_t k = 0; k < length; k++)
+        ir[k] = Random() * expf(-5.f * k / length);
+    int val = convolver_SetResponses(conv, ir, 1, length, 1.f, 0.f);
+    assert(val == 0);
+
+    unsigned seconds = 0;
+    vlc_tick_t start = vlc_tick_now(), elapsed;
+    do
+    {
+        convolver_Process(conv, buf, buf, rate);
+        seconds++;
+        elapsed = vlc_tick_now() - start;
+    }
+    while (elapsed < DURATION);
+
+    /* A direct convolution costs one multiply-add per tap and sample */
+    printf("stereo %6zu taps: %7.1fx real time (%.1f Gmac/s direct equivalent)\n",
+           length, seconds / secf_from_vlc_tick(elapsed),
+           2. * length * rate * seconds / secf_from_vlc_tick(elapsed) / 1e9);
+
+    convolver_Delete(conv);
+    free(buf);
+    free(ir);
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    srand(0);
+    ret |= TestConvolution(16, 40);
+    ret |= TestConvolution(64, 5000);
+    ret |= TestConvolution(256, 1000);
+    ret |= TestConvolution(1024, 300);
+    ret |= TestResponses();
+
+    if (test_bench())
+    {
+        Benchmark(4800);
+        Benchmark(48000);
+        Benchmark(144000);
+    }
+    return ret;
+}
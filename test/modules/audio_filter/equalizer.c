@@ -0,0 +1,264 @@
+/*****************************************************************************
+ * equalizer.c: 10 bands equalizer kernels and gains smoothing unit testing
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "../modules/audio_filter/equalizer.c"
+
+#include <stdio.h>
+
+const char vlc_module_name[] = "test_equalizer";
+
+#define RATE   48000
+#define FRAMES 9600 /* per run */
+
+static const struct
+{
+    const char *name;
+    eqz_kernel_t bank;
+} kernels[] = {
+#define KERNEL(name) { #name, EqzBank_##name }
+#ifdef HAVE_SSE2_INTRINSICS
+    KERNEL(SSE2),
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    KERNEL(AVX2),
+#endif
+#ifdef EQZ_NEON
+    KERNEL(NEON),
+#endif
+#undef KERNEL
+};
+
+/* Whether EqzInit() can select the kernel on this CPU */
+static bool Available(const char *name)
+{
+#ifdef HAVE_SSE2_INTRINSICS
+    if (!strcmp(name, "SSE2"))
+        return vlc_CPU_SSE2();
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if (!strcmp(name, "AVX2"))
+        return vlc_CPU_AVX2();
+#endif
+#ifdef EQZ_NEON
+    if (!strcmp(name, "NEON"))
+        return vlc_CPU_ARM_NEON();
+#endif
+    VLC_UNUSED(name);
+    return true;
+}
+
+static uint32_t seed;
+
+static float Random(void)
+{
+    seed = seed * 1664525 + 1013904223;
+    return (seed >> 8) / (float)(1 << 24) - .5f;
+}
+
+/* Sets the filter up as EqzInit() does, without the variables */
+static void Setup(filter_t *filter, filter_sys_t *sys, unsigned channels,
+                  const eqz_preset_t *preset, eqz_kernel_t bank, bool twopass)
+{
+    eqz_config_t cfg;
+
+    EqzCoeffs(RATE, 1.0f, true, &cfg);
+    sys->i_band = cfg.i_band;
+    sys->f_alpha = vlc_alloc(sys->i_band, sizeof (float));
+    sys->f_beta = vlc_alloc(sys->i_band, sizeof (float));
+    sys->f_gamma = vlc_alloc(sys->i_band, sizeof (float));
+    sys->f_amp = vlc_alloc(sys->i_band, sizeof (float));
+    assert(sys->f_alpha != NULL && sys->f_beta != NULL
+           && sys->f_gamma != NULL && sys->f_amp != NULL);
+
+    for (int i = 0; i < sys->i_band; i++)
+    {
+        sys->f_alpha[i] = cfg.band[i].f_alpha;
+        sys->f_beta[i] = cfg.band[i].f_beta;
+        sys->f_gamma[i] = cfg.band[i].f_gamma;
+        sys->f_amp[i] = sys->f_amp_cur[i] = EqzConvertdB(preset->f_amp[i]);
+    }
+    sys->f_gamp = sys->f_gamp_cur = powf(10.f, preset->f_preamp / 20.f);
+    sys->b_2eqz = twopass;
+
+    sys->i_groups = (channels + EQZ_LANES - 1) / EQZ_LANES;
+    sys->state = calloc(sys->i_groups, sizeof (*sys->state));
+    sys->state2 = calloc(sys->i_groups, sizeof (*sys->state2));
+    assert(sys->state != NULL && sys->state2 != NULL);
+    sys->pf_bank = bank;
+    vlc_mutex_init(&sys->lock);
+
+    memset(filter, 0, sizeof (*filter));
+    filter->p_sys = sys;
+}
+
+static void Clean(filter_sys_t *sys)
+{
+    vlc_mutex_destroy(&sys->lock);
+    free(sys->state2);
+    free(sys->state);
+    free(sys->f_amp);
+    free(sys->f_gamma);
+    free(sys->f_beta);
+    free(sys->f_alpha);
+}
+
+/* Filters noise and tones, in chunks of random sizes */
+static float *Run(unsigned channels, const eqz_preset_t *preset,
+                  eqz_kernel_t bank, bool twopass)
+{
+    filter_t filter;
+    filter_sys_t sys;
+    float *buf = vlc_alloc(FRAMES * channels, sizeof (float));
+    assert(buf != NULL);
+
+    seed = 0x12345678;
+    for (unsigned n = 0; n < FRAMES; n++)
+        for (unsigned c = 0; c < channels; c++)
+            buf[n * channels + c] = .1f * Random()
+                + .2f * sinf(2.f * M_PI * (60.f + 700.f * c) * n / RATE);
+
+    Setup(&filter, &sys, channels, preset, bank, twopass);
+    for (unsigned n = 0; n < FRAMES;)
+    {
+        unsigned count = 1 + (seed >> 16) % 500;
+        if (count > FRAMES - n)
+            count = FRAMES - n;
+        EqzFilter(&filter, buf + n * channels, buf + n * channels, count,
+                  channels);
+        n += count;
+        Random();
+    }
+    Clean(&sys);
+    return buf;
+}
+
+/* Runs every preset through every kernel, and compares with the C code */
+static int TestKernels(unsigned channels)
+{
+    int ret = 0;
+
+    for (size_t k = 0; k < ARRAY_SIZE(kernels); k++)
+    {
+        if (!Available(kernels[k].name))
+        {
+            printf("%u channels %s: unsupported\n", channels,
+                   kernels[k].name);
+            continue;
+        }
+
+        float max_error = 0.f;
+        for (unsigned p = 0; p < NB_PRESETS; p++)
+            for (int twopass = 0; twopass < 2; twopass++)
+            {
+                float *ref = Run(channels, &eqz_preset_10b[p], EqzBank,
+                                 twopass);
+                float *out = Run(channels, &eqz_preset_10b[p],
+                                 kernels[k].bank, twopass);
+
+                for (unsigned i = 0; i < FRAMES * channels; i++)
+                    max_error = fmaxf(max_error, fabsf(out[i] - ref[i]));
+                free(out);
+                free(ref);
+            }
+
+        bool ok = max_error <= 1e-4f;
+        printf("%u channels %s: max error %g%s\n", channels, kernels[k].name,
+               max_error, ok ? "" : " FAILED");
+        ret |= !ok;
+    }
+    return ret;
+}
+
+/*
+ * Boosts the band of a tone at its center frequency while filtering it: the
+ * output amplitude must ramp over several blocks, so that its variation
+ * between two samples never exceeds the variation of the louder tone.
+ */
+static int TestRamp(eqz_kernel_t bank, const char *name)
+{
+    const unsigned channels = 2, band = 4; /* 1 kHz */
+    const unsigned change = 4800 + 7, frames = 4 * RATE / 10;
+    eqz_preset_t flat = { "flat", EQZ_BANDS_MAX, 0.f, { 0.f } };
+    filter_t filter;
+    filter_sys_t sys;
+    float *buf = vlc_alloc(frames * channels, sizeof (float));
+    assert(buf != NULL);
+
+    for (unsigned n = 0; n < frames; n++)
+        for (unsigned c = 0; c < channels; c++)
+            buf[n * channels + c] = .5f * sinf(2.f * M_PI * 1000.f * n / RATE);
+
+    Setup(&filter, &sys, channels, &flat, bank, false);
+    EqzFilter(&filter, buf, buf, change, channels);
+    vlc_mutex_lock(&sys.lock); /* as BandsCallback() */
+    sys.f_amp[band] = EqzConvertdB(12.f);
+    vlc_mutex_unlock(&sys.lock);
+    EqzFilter(&filter, buf + change * channels, buf + change * channels,
+              frames - change, channels);
+
+    /* The steady amplitudes, before and long after the change */
+    float before = 0.f, after = 0.f, max_delta = 0.f;
+    for (unsigned n = change - 480; n < change; n++)
+        before = fmaxf(before, fabsf(buf[n * channels]));
+    for (unsigned n = frames - 480; n < frames; n++)
+        after = fmaxf(after, fabsf(buf[n * channels]));
+    for (unsigned n = change - 480; n < frames; n++)
+        max_delta = fmaxf(max_delta, fabsf(buf[n * channels]
+                                           - buf[(n - 1) * channels]));
+
+    /* The largest step of a sine of that amplitude, between two samples */
+    const float step = 2.f * sinf(M_PI * 1000.f / RATE) * after;
+    /* The amplitude must still be far from its target after one block */
+    float first = 0.f;
+    for (unsigned n = change; n < change + EQZ_BLOCK; n++)
+        first = fmaxf(first, fabsf(buf[n * channels]));
+
+    bool ok = after > 3.f * before && max_delta <= 1.01f * step
+           && first < (before + after) / 2.f;
+    printf("%s ramp: %.3f -> %.3f (%.3f after a block), max delta %.4f "
+           "(sine %.4f)%s\n", name, before, after, first, max_delta, step,
+           ok ? "" : " FAILED");
+
+    Clean(&sys);
+    free(buf);
+    return !ok;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    ret |= TestKernels(2);
+    ret |= TestKernels(8); /* 7.1 */
+
+    ret |= TestRamp(EqzBank, "C");
+    for (size_t k = 0; k < ARRAY_SIZE(kernels); k++)
+        if (Available(kernels[k].name))
+            ret |= TestRamp(kernels[k].bank, kernels[k].name);
+    return ret;
+}
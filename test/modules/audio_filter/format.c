@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * format.c: audio sample format converter unit testing and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+#include <vlc_tick.h>
+
+#define SAMPLES  (4096 * 2) /* stereo frames of 4096 samples */
+#define DURATION VLC_TICK_FROM_MS(50) /* per conversion */
+
+static const vlc_fourcc_t formats[] = {
+    VLC_CODEC_U8, VLC_CODEC_S16N, VLC_CODEC_S32N, VLC_CODEC_FL32,
+    VLC_CODEC_FL64,
+};
+
+static double GetSample(vlc_fourcc_t fmt, const void *buf, size_t i)
+{
+    switch (fmt)
+    {
+        case VLC_CODEC_U8:
+            return (((const uint8_t *)buf)[i] - 128) / 128.;
+        case VLC_CODEC_S16N:
+            return ((const int16_t *)buf)[i] / 32768.;
+        case VLC_CODEC_S32N:
+            return ((const int32_t *)buf)[i] / 2147483648.;
+        case VLC_CODEC_FL32:
+            return ((const float *)buf)[i];
+        case VLC_CODEC_FL64:
+            return ((const double *)buf)[i];
+    }
+    vlc_assert_unreachable();
+}
+
+static void SetSample(vlc_fourcc_t fmt, void *buf, size_t i, double v)
+{
+    switch (fmt)
+    {
+        case VLC_CODEC_U8:
+            ((uint8_t *)buf)[i] = lround(v * 127.) + 128;
+            break;
+        case VLC_CODEC_S16N:
+            ((int16_t *)buf)[i] = lround(v * 32767.);
+            break;
+        case VLC_CODEC_S32N:
+            ((int32_t *)buf)[i] = lround(v * 2147483647.);
+            break;
+        case VLC_CODEC_FL32:
+            ((float *)buf)[i] = v;
+            break;
+        case VLC_CODEC_FL64:
+            ((double *)buf)[i] = v;
+            break;
+    }
+}
+
+/* Largest acceptable error: one quantization step of the output */
+static double GetTolerance(vlc_fourcc_t fmt)
+{
+    switch (fmt)
+    {
+        case VLC_CODEC_U8:   return 1. / 128.;
+        case VLC_CODEC_S16N: return 1. / 32768.;
+        default:             return 1. / 8388608.;
+    }
+}
+
+static filter_t *CreateConverter(libvlc_instance_t *vlc,
+                                 vlc_fourcc_t src, vlc_fourcc_t dst)
+{
+    filter_t *filter = vlc_object_create(vlc->p_libvlc_int, sizeof (*filter));
+    if (filter == NULL)
+        return NULL;
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, src);
+    filter->fmt_in.audio.i_format = src;
+    filter->fmt_in.audio.i_rate = 48000;
+    filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_STEREO;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+
+    es_format_Init(&filter->fmt_out, AUDIO_ES, dst);
+    filter->fmt_out.audio = filter->fmt_in.audio;
+    filter->fmt_out.audio.i_format = dst;
+    aout_FormatPrepare(&filter->fmt_out.audio);
+
+    filter->p_module = module_need(filter, "audio converter", "audio_format",
+                                   true);
+    if (filter->p_module == NULL)
+    {
+        vlc_object_delete(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+static void DeleteConverter(filter_t *filter)
+{
+    module_unneed(filter, filter->p_module);
+    vlc_object_delete(filter);
+}
+
+static int TestConversion(libvlc_instance_t *vlc,
+                          vlc_fourcc_t src, vlc_fourcc_t dst)
+{
+    const unsigned src_size = aout_BitsPerSample(src) / 8;
+    const unsigned dst_size = aout_BitsPerSample(dst) / 8;
+
+    filter_t *filter = CreateConverter(vlc, src, dst);
+    if (filter == NULL)
+    {
+        fprintf(stderr, "%4.4s->%4.4s: no converter\n",
+                (const char *)&src, (const char *)&dst);
+        return 1;
+    }
+
+    /* Check the output against the input, including out of range floats */
+    const double amplitude = (src == VLC_CODEC_FL32 || src == VLC_CODEC_FL64)
+                             ? 1.125 : 1.;
+    block_t *in = block_Alloc(SAMPLES * src_size);
+    assert(in != NULL);
+    for (size_t i = 0; i < SAMPLES; i++)
+        SetSample(src, in->p_buffer, i, sin(i * .01) * amplitude);
+    in->i_nb_samples = SAMPLES / 2;
+
+    block_t *ref = block_Duplicate(in);
+    assert(ref != NULL);
+    block_t *out = filter->pf_audio_filter(filter, in);
+    assert(out != NULL);
+    assert(out->i_buffer == SAMPLES * dst_size);
+
+    const double tolerance = GetTolerance(dst) + GetTolerance(src);
+    for (size_t i = 0; i < SAMPLES; i++)
+    {
+        double v = GetSample(src, ref->p_buffer, i);
+        if (v > 1.)
+            v = 1.;
+        else if (v < -1.)
+            v = -1.;
+
+        double diff = fabs(GetSample(dst, out->p_buffer, i) - v);
+        if (diff > tolerance)
+        {
+            fprintf(stderr, "%4.4s->%4.4s: sample %zu: %f instead of %f\n",
+                    (const char *)&src, (const char *)&dst, i,
+                    GetSample(dst, out->p_buffer, i), v);
+            block_Release(out);
+            block_Release(ref);
+            DeleteConverter(filter);
+            return 1;
+        }
+    }
+    block_Release(out);
+
+    /* Measure the throughput, on request only */
+    if (test_bench())
+    {
+        unsigned long long count = 0;
+        vlc_tick_t start = vlc_tick_now(), elapsed;
+        do
+        {
+            for (unsigned i = 0; i < 16; i++)
+            {
+                in = block_Duplicate(ref);
+                assert(in != NULL);
+                block_Release(filter->pf_audio_filter(filter, in));
+            }
+            count += 16 * SAMPLES;
+            elapsed = vlc_tick_now() - start;
+        }
+        while (elapsed < DURATION);
+
+        printf("%4.4s->%4.4s: %8.1f Msamples/s\n",
+               (const char *)&src, (const char *)&dst,
+               count / (double)US_FROM_VLC_TICK(elapsed));
+    }
+
+    block_Release(ref);
+    DeleteConverter(filter);
+    return 0;
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    if (vlc == NULL)
+        return 1;
+
+    int ret = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(formats); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(formats); j++)
+            if (i != j)
+                ret |= TestConversion(vlc, formats[i], formats[j]);
+
+    libvlc_release(vlc);
+    return ret;
+}
@@ -0,0 +1,271 @@
+/*****************************************************************************
+ * r128.c: EBU R128 loudness meter unit testing and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include "../../libvlc/test.h"
+#include "../modules/audio_filter/loudness/r128.c"
+
+#include <stdio.h>
+#include <vlc_tick.h>
+
+const char vlc_module_name[] = "test_r128";
+
+#define RATE     48000
+#define DURATION VLC_TICK_FROM_MS(300) /* per benchmark */
+
+static float Random(void)
+{
+    return rand() / (float)RAND_MAX - .5f;
+}
+
+/* Appends a sine wave to every channel */
+static void Sine(r128_t *r, unsigned channels, float freq, float dbfs,
+                 float phase, unsigned seconds)
+{
+    const float amp = powf(10.f, dbfs / 20.f);
+    float *buf = malloc(RATE * channels * sizeof (float));
+    assert(buf != NULL);
+
+    for (unsigned s = 0; s < seconds; s++)
+    {
+        for (unsigned n = 0; n < RATE; n++)
+            for (unsigned c = 0; c < channels; c++)
+                buf[n * channels + c] = amp * sinf(2.f * M_PI * freq * n
+                                                   / RATE + phase);
+
+        /* Process chunks of random sizes */
+        for (size_t pos = 0; pos < RATE;)
+        {
+            size_t count = 1 + (size_t)rand() % 2000;
+            if (count > RATE - pos)
+                count = RATE - pos;
+            r128_Process(r, buf + pos * channels, count);
+            pos += count;
+        }
+    }
+    free(buf);
+}
+
+static int Check(const char *name, float value, float expected, float tol)
+{
+    bool ok = fabsf(value - expected) <= tol;
+    printf("%-28s %7.2f (expected %7.2f)%s\n", name, value, expected,
+           ok ? "" : " FAILED");
+    return !ok;
+}
+
+/* EBU Tech 3341 and 3342 minimal conformance cases */
+static int TestMeter(void)
+{
+    struct vlc_audio_loudness l;
+    int ret = 0;
+
+    /* Stereo 1 kHz sine at -23 dBFS */
+    r128_t *r = r128_New(RATE, 2, NULL);
+    assert(r != NULL);
+    Sine(r, 2, 1000.f, -23.f, 0.f, 20);
+    r128_GetLoudness(r, &l);
+    ret |= Check("momentary", l.momentary, -23.f, .1f);
+    ret |= Check("short-term", l.short_term, -23.f, .1f);
+    ret |= Check("integrated", l.integrated, -23.f, .1f);
+    r128_Delete(r);
+
+    /* Gating: -36, -23 then -36 dBFS */
+    r = r128_New(RATE, 2, NULL);
+    assert(r != NULL);
+    Sine(r, 2, 1000.f, -36.f, 0.f, 10);
+    Sine(r, 2, 1000.f, -23.f, 0.f, 60);
+    Sine(r, 2, 1000.f, -36.f, 0.f, 10);
+    r128_GetLoudness(r, &l);
+    ret |= Check("gated integrated", l.integrated, -23.f, .1f);
+    r128_Delete(r);
+
+    /* Loudness range: -20 then -30 dBFS */
+    r = r128_New(RATE, 2, NULL);
+    assert(r != NULL);
+    Sine(r, 2, 1000.f, -20.f, 0.f, 20);
+    Sine(r, 2, 1000.f, -30.f, 0.f, 20);
+    r128_GetLoudness(r, &l);
+    ret |= Check("loudness range", l.range, 10.f, 1.f);
+    r128_Delete(r);
+
+    /* True peak between the samples: 0 dBFS at fs/4, sampled at 45 deg */
+    r = r128_New(RATE, 1, NULL);
+    assert(r != NULL);
+    Sine(r, 1, RATE / 4.f, 0.f, M_PI / 4., 1);
+    r128_GetLoudness(r, &l);
+    ret |= Check("true peak", l.true_peak, 0.f, .4f);
+    r128_Delete(r);
+
+    /* Many channels, weighted */
+    float weights[50];
+    for (unsigned c = 0; c < 50; c++)
+        weights[c] = c < 25 ? 1.f : 0.f;
+    r = r128_New(RATE, 50, weights);
+    assert(r != NULL);
+    Sine(r, 50, 1000.f, -40.f, 0.f, 4);
+    r128_GetLoudness(r, &l);
+    ret |= Check("25 of 50 channels", l.short_term,
+                 -40.f - 3.01f + 10.f * log10f(25.f), .1f);
+    r128_Delete(r);
+    return ret;
+}
+
+/* Compares the vector kernel with the C one */
+static int TestKernel(void)
+{
+    r128_filter_t f;
+    r128_lanes_t *st = aligned_alloc(R128_ALIGN, 2 * sizeof (*st));
+    float *x = AllocFloats((R128_TAPS - 1 + R128_CHUNK) * R128_LANES);
+    float *peak = AllocFloats(2 * R128_CHUNK * R128_LANES);
+    float energy[2][R128_LANES] = { { 0.f } };
+    r128_t *r = r128_New(RATE, 1, NULL);
+    assert(st != NULL && x != NULL && peak != NULL && r != NULL);
+
+    InitFilter(&f, RATE);
+    memset(st, 0, 2 * sizeof (*st));
+    for (unsigned i = 0; i < (R128_TAPS - 1 + R128_CHUNK) * R128_LANES; i++)
+        x[i] = Random();
+
+    Kernel(&st[0], &f, x, energy[0], peak, R128_CHUNK, R128_LANES);
+    r->kernel(&st[1], &f, x, energy[1], peak + R128_CHUNK * R128_LANES,
+              R128_CHUNK, R128_LANES);
+
+    float max_error = 0.f;
+    for (unsigned i = 0; i < R128_CHUNK * R128_LANES; i++)
+        max_error = fmaxf(max_error,
+                          fabsf(peak[i] - peak[R128_CHUNK * R128_LANES + i]));
+    for (unsigned l = 0; l < R128_LANES; l++)
+        max_error = fmaxf(max_error, fabsf(energy[0][l] - energy[1][l])
+                                     / energy[0][l]);
+    printf("kernel: max error %g\n", max_error);
+
+    r128_Delete(r);
+    aligned_free(peak);
+    aligned_free(x);
+    aligned_free(st);
+    return max_error > 1e-4f;
+}
+
+/* Normalizes bursts of noise, and checks the output with another meter */
+static int TestNormalization(void)
+{
+    const unsigned channels = 6, seconds = 30;
+    const float ceiling = -1.f;
+    r128_t *r = r128_New(RATE, channels, NULL);
+    r128_t *out = r128_New(RATE, channels, NULL);
+    float *buf = malloc(RATE * channels * sizeof (float));
+    assert(r != NULL && out != NULL && buf != NULL);
+
+    r128_SetNormalization(r, -23.f, 12.f, ceiling);
+    assert(r128_GetDelay(r) == RATE * R128_LOOKAHEAD / 1000 + R128_PEAK_DELAY);
+
+    const float limit = powf(10.f, ceiling / 20.f) * 1.0001f;
+    float max_sample = 0.f;
+    for (unsigned s = 0; s < seconds; s++)
+    {
+        for (unsigned n = 0; n < RATE; n++)
+        {
+            /* Loud noise, with short and very loud clicks */
+            float amp = (n % 9000) < 30 ? 40.f : .5f;
+            for (unsigned c = 0; c < channels; c++)
+                buf[n * channels + c] = amp * Random();
+        }
+
+        r128_Process(r, buf, RATE);
+        for (unsigned k = 0; k < RATE * channels; k++)
+            max_sample = fmaxf(max_sample, fabsf(buf[k]));
+        /* Measure once the gain has converged */
+        if (s >= seconds / 2)
+            r128_Process(out, buf, RATE);
+    }
+
+    struct vlc_audio_loudness l;
+    r128_GetLoudness(out, &l);
+
+    int ret = Check("normalized integrated", l.integrated, -23.f, 1.f);
+    ret |= Check("normalized true peak", l.true_peak, ceiling, .5f);
+    if (max_sample > limit)
+    {
+        printf("sample peak above the ceiling: %g\n", max_sample);
+        ret = 1;
+    }
+
+    free(buf);
+    r128_Delete(out);
+    r128_Delete(r);
+    return ret;
+}
+
+/* Measures the speed of a many channels playout, in real time factor */
+static void Benchmark(unsigned channels, bool normalize)
+{
+    float *buf = malloc(RATE * channels * sizeof (float));
+    r128_t *r = r128_New(RATE, channels, NULL);
+    assert(buf != NULL && r != NULL);
+
+    for (size_t k = 0; k < RATE * channels; k++)
+        buf[k] = Random() * .1f;
+    if (normalize)
+        r128_SetNormalization(r, -23.f, 12.f, -1.f);
+
+    unsigned seconds = 0;
+    vlc_tick_t start = vlc_tick_now(), elapsed;
+    do
+    {
+        r128_Process(r, buf, RATE);
+        seconds++;
+        elapsed = vlc_tick_now() - start;
+    }
+    while (elapsed < DURATION);
+
+    printf("%2u channels%s: %7.1fx real time\n", channels,
+           normalize ? ", normalized" : "",
+           seconds / secf_from_vlc_tick(elapsed));
+
+    r128_Delete(r);
+    free(buf);
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    srand(0);
+    ret |= TestMeter();
+    ret |= TestKernel();
+    ret |= TestNormalization();
+
+    if (test_bench())
+    {
+        Benchmark(2, false);
+        Benchmark(2, true);
+        Benchmark(50, false);
+        Benchmark(50, true);
+    }
+    return ret;
+}
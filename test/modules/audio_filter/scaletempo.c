@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * scaletempo.c: audio tempo scaler unit testing and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+#include <vlc_tick.h>
+
+#define RATE    48000
+#define FRAMES  1024 /* per input block */
+#define SECONDS 20   /* of input, per test */
+#define WINDOW  480  /* frames of the output level check */
+
+static const struct
+{
+    unsigned channels;
+    uint32_t layout;
+} layouts[] = {
+    { 1, AOUT_CHAN_CENTER },
+    { 2, AOUT_CHANS_STEREO },
+    { 6, AOUT_CHANS_5_1 },
+};
+
+static const float rates[] = { 1.25f, 1.5f, 2.f };
+
+static filter_t *CreateScaletempo(libvlc_instance_t *vlc, uint32_t layout)
+{
+    filter_t *filter = vlc_object_create(vlc->p_libvlc_int, sizeof (*filter));
+    if (filter == NULL)
+        return NULL;
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = RATE;
+    filter->fmt_in.audio.i_physical_channels = layout;
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Init(&filter->fmt_out, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_out.audio = filter->fmt_in.audio;
+
+    filter->p_module = module_need(filter, "audio filter", "scaletempo",
+                                   true);
+    if (filter->p_module == NULL)
+    {
+        vlc_object_delete(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+static void DeleteScaletempo(filter_t *filter)
+{
+    module_unneed(filter, filter->p_module);
+    vlc_object_delete(filter);
+}
+
+/*
+ * Scales a sine wave. When the best overlap positions are found, the
+ * overlapping strides are in phase, and the level of the output stays the
+ * level of the input.
+ */
+static int TestRate(libvlc_instance_t *vlc, unsigned channels,
+                    uint32_t layout, float rate)
+{
+    filter_t *filter = CreateScaletempo(vlc, layout);
+    if (filter == NULL)
+    {
+        fprintf(stderr, "no scaletempo filter\n");
+        return 1;
+    }
+
+    /* The audio output signals the playback rate through the input rate */
+    filter->fmt_in.audio.i_rate = lroundf(RATE * rate);
+
+    size_t in_frames = 0, out_frames = 0, window = 0;
+    double energy = 0., min_level = 1., max_level = 0.;
+    vlc_tick_t elapsed = 0;
+
+    while (in_frames < SECONDS * RATE)
+    {
+        block_t *in = block_Alloc(FRAMES * channels * sizeof (float));
+        assert(in != NULL);
+        float *p = (float *)in->p_buffer;
+        for (unsigned n = 0; n < FRAMES; n++)
+            for (unsigned c = 0; c < channels; c++)
+                *p++ = sinf(2.f * M_PI * 440.f * (in_frames + n) / RATE);
+        in->i_nb_samples = FRAMES;
+        in->i_pts = in->i_dts = VLC_TICK_0
+                              + vlc_tick_from_samples(in_frames, RATE);
+        in_frames += FRAMES;
+
+        vlc_tick_t start = vlc_tick_now();
+        block_t *out = filter->pf_audio_filter(filter, in);
+        elapsed += vlc_tick_now() - start;
+        if (out == NULL)
+            continue;
+
+        /* Check the level of the first channel, after the first strides */
+        const float *q = (const float *)out->p_buffer;
+        for (size_t n = 0; n < out->i_nb_samples; n++, out_frames++)
+        {
+            if (out_frames < RATE / 5)
+                continue;
+            energy += q[n * channels] * q[n * channels];
+            max_level = fmax(max_level, fabsf(q[n * channels]));
+            if (++window == WINDOW)
+            {
+                min_level = fmin(min_level, sqrt(2. * energy / WINDOW));
+                energy = 0.;
+                window = 0;
+            }
+        }
+        block_Release(out);
+    }
+
+    const double expected = in_frames / rate;
+    printf("%u channel(s), rate %.2f: %6zu frames out of %6zu, "
+           "level %.3f to %.3f, %6.1fx real time\n", channels, rate,
+           out_frames, in_frames, min_level, max_level,
+           SECONDS / secf_from_vlc_tick(elapsed));
+
+    DeleteScaletempo(filter);
+    return fabs(out_frames - expected) > RATE / 10
+        || min_level < .9 || max_level > 1.05;
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    if (vlc == NULL)
+        return 1;
+
+    int ret = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(layouts); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(rates); j++)
+            ret |= TestRate(vlc, layouts[i].channels, layouts[i].layout,
+                            rates[j]);
+
+    libvlc_release(vlc);
+    return ret;
+}
@@ -0,0 +1,257 @@
+/*****************************************************************************
+ * araw.c: raw audio decoder unit testing and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_codec.h>
+#include <vlc_block.h>
+#include <vlc_tick.h>
+
+#define CHANNELS    2
+#define BENCH_BLOCK 4096    /* frames */
+#define BENCH_SIZE  (48000 * 60) /* frames, per format */
+
+static const struct
+{
+    vlc_fourcc_t codec;
+    unsigned bits;
+} formats[] = {
+    { VLC_CODEC_S16I, 16 },
+    { VLC_CODEC_S24L, 24 },
+    { VLC_CODEC_S24B, 24 },
+    { VLC_CODEC_S32I, 32 },
+    { VLC_CODEC_FL32, 32 },
+    { VLC_CODEC_F32B, 32 },
+};
+
+static block_t *output;
+
+static int FormatUpdate(decoder_t *dec)
+{
+    VLC_UNUSED(dec);
+    return 0;
+}
+
+static void QueueAudio(decoder_t *dec, block_t *block)
+{
+    VLC_UNUSED(dec);
+    assert(output == NULL);
+    output = block;
+}
+
+static decoder_t *CreateDecoder(libvlc_instance_t *vlc, vlc_fourcc_t codec,
+                                unsigned bits)
+{
+    static const struct decoder_owner_callbacks cbs =
+    {
+        .audio = {
+            .format_update = FormatUpdate,
+            .queue = QueueAudio,
+        },
+    };
+
+    decoder_t *dec = vlc_object_create(vlc->p_libvlc_int, sizeof (*dec));
+    if (dec == NULL)
+        return NULL;
+
+    es_format_t fmt;
+    es_format_Init(&fmt, AUDIO_ES, codec);
+    fmt.audio.i_rate = 48000;
+    fmt.audio.i_channels = CHANNELS;
+    fmt.audio.i_bitspersample = bits;
+    decoder_Init(dec, &fmt);
+    dec->cbs = &cbs;
+
+    dec->p_module = module_need(dec, "audio decoder", "araw", true);
+    if (dec->p_module == NULL)
+    {
+        decoder_Clean(dec);
+        vlc_object_delete(dec);
+        return NULL;
+    }
+    return dec;
+}
+
+static void DeleteDecoder(decoder_t *dec)
+{
+    module_unneed(dec, dec->p_module);
+    decoder_Clean(dec);
+    vlc_object_delete(dec);
+}
+
+/* Sample by sample, from the byte layout of the format */
+static void Reference(vlc_fourcc_t codec, void *out, const uint8_t *in,
+                      size_t samples)
+{
+    for (size_t i = 0; i < samples; i++)
+    {
+        uint32_t u;
+        float f;
+
+        switch (codec)
+        {
+            case VLC_CODEC_S16I:
+            {
+#ifdef WORDS_BIGENDIAN
+                uint16_t s = GetWLE(&in[2 * i]);
+#else
+                uint16_t s = GetWBE(&in[2 * i]);
+#endif
+                memcpy((uint16_t *)out + i, &s, 2);
+                continue;
+            }
+            case VLC_CODEC_S24L:
+                u = (in[3 * i + 2] << 24) | (in[3 * i + 1] << 16)
+                  | (in[3 * i] << 8);
+                break;
+            case VLC_CODEC_S24B:
+                u = (in[3 * i] << 24) | (in[3 * i + 1] << 16)
+                  | (in[3 * i + 2] << 8);
+                break;
+            case VLC_CODEC_S32I:
+#ifdef WORDS_BIGENDIAN
+                u = GetDWLE(&in[4 * i]);
+#else
+                u = GetDWBE(&in[4 * i]);
+#endif
+                break;
+            case VLC_CODEC_FL32:
+            case VLC_CODEC_F32B:
+                u = codec == VLC_CODEC_FL32 ? ((const uint32_t *)in)[i]
+                                            : GetDWBE(&in[4 * i]);
+                memcpy(&f, &u, 4);
+                if (!isfinite(f))
+                    u = 0;
+                break;
+            default:
+                vlc_assert_unreachable();
+        }
+        memcpy((uint32_t *)out + i, &u, 4);
+    }
+}
+
+static block_t *Decode(decoder_t *dec, const uint8_t *in, size_t size,
+                       vlc_tick_t pts)
+{
+    block_t *block = block_Alloc(size);
+    assert(block != NULL);
+    memcpy(block->p_buffer, in, size);
+    block->i_pts = block->i_dts = pts;
+
+    int ret = dec->pf_decode(dec, block);
+    assert(ret == VLCDEC_SUCCESS);
+
+    block_t *out = output;
+    output = NULL;
+    return out;
+}
+
+static int TestFormat(libvlc_instance_t *vlc, vlc_fourcc_t codec,
+                      unsigned bits)
+{
+    decoder_t *dec = CreateDecoder(vlc, codec, bits);
+    if (dec == NULL)
+    {
+        fprintf(stderr, "no decoder for %4.4s\n", (const char *)&codec);
+        return 1;
+    }
+
+    const size_t in_size = bits / 8, out_size = bits == 16 ? 2 : 4;
+    uint8_t *in = malloc(BENCH_BLOCK * CHANNELS * in_size);
+    uint8_t *ref = malloc(BENCH_BLOCK * CHANNELS * out_size);
+    assert(in != NULL && ref != NULL);
+
+    /* All lengths, including the tails of the vector loops */
+    for (size_t frames = 1; frames < 300; frames++)
+    {
+        const size_t samples = frames * CHANNELS;
+
+        for (size_t i = 0; i < samples * in_size; i++)
+            in[i] = rand();
+        if (bits == 32 && samples >= 4) /* infinity and NaN */
+        {
+            memset(&in[0], 0xff, 4);
+            memcpy(&in[4], (const uint8_t[]){ 0x7f, 0x80, 0x00, 0x00 }, 4);
+            memcpy(&in[8], (const uint8_t[]){ 0x00, 0x00, 0x80, 0x7f }, 4);
+        }
+
+        block_t *out = Decode(dec, in, samples * in_size,
+                              VLC_TICK_0 + frames);
+        assert(out != NULL);
+        assert(out->i_nb_samples == frames);
+        Reference(codec, ref, in, samples);
+        if (memcmp(out->p_buffer, ref, samples * out_size))
+        {
+            fprintf(stderr, "%4.4s: mismatch with %zu frames\n",
+                    (const char *)&codec, frames);
+            abort();
+        }
+        block_Release(out);
+    }
+
+    if (test_bench())
+    {
+        for (size_t i = 0; i < BENCH_BLOCK * CHANNELS * in_size; i++)
+            in[i] = rand();
+
+        vlc_tick_t start = vlc_tick_now();
+        for (size_t frames = 0; frames < BENCH_SIZE; frames += BENCH_BLOCK)
+            block_Release(Decode(dec, in, BENCH_BLOCK * CHANNELS * in_size,
+                                 VLC_TICK_0 + frames));
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+
+        printf("%4.4s: %7.1f Msamples/s\n", (const char *)&codec,
+               BENCH_SIZE * CHANNELS / 1e6 / secf_from_vlc_tick(elapsed + 1));
+    }
+
+    free(ref);
+    free(in);
+    DeleteDecoder(dec);
+    return 0;
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    if (vlc == NULL)
+        return 1;
+
+    int ret = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(formats); i++)
+        ret |= TestFormat(vlc, formats[i].codec, formats[i].bits);
+
+    libvlc_release(vlc);
+    return ret;
+}
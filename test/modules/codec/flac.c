@@ -0,0 +1,258 @@
+/*****************************************************************************
+ * flac.c: FLAC encoder and decoder round trip, with and without threads
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_codec.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+#include <vlc_tick.h>
+
+#define RATE     44100
+#define CHANNELS 2
+#define FRAMES   1024 /* per input block */
+#define BLOCKS   128
+
+static int16_t input[BLOCKS * FRAMES * CHANNELS];
+
+static block_t *output;
+
+static int FormatUpdate(decoder_t *dec)
+{
+    VLC_UNUSED(dec);
+    return 0;
+}
+
+static void QueueAudio(decoder_t *dec, block_t *block)
+{
+    VLC_UNUSED(dec);
+    block_ChainAppend(&output, block);
+}
+
+/* Tones with some noise, so that the encoder uses several subframe types */
+static void Fill(void)
+{
+    for (size_t n = 0; n < BLOCKS * FRAMES; n++)
+    {
+        double t = (double)n / RATE;
+
+        input[2 * n] = 8000. * sin(2. * M_PI * 440. * t) + rand() % 64;
+        input[2 * n + 1] = 8000. * sin(2. * M_PI * 1000. * t)
+                         + ((n / 4096) % 4 ? rand() % 16384 : 0);
+    }
+}
+
+/* Encodes the input with the FLAC encoder, one frame per block */
+static block_t *Encode(libvlc_instance_t *vlc, es_format_t *fmt)
+{
+    encoder_t *enc = sout_EncoderCreate(vlc->p_libvlc_int);
+    assert(enc != NULL);
+
+    es_format_Init(&enc->fmt_in, AUDIO_ES, VLC_CODEC_S16N);
+    enc->fmt_in.audio.i_format = VLC_CODEC_S16N;
+    enc->fmt_in.audio.i_rate = RATE;
+    enc->fmt_in.audio.i_channels = CHANNELS;
+    enc->fmt_in.audio.i_physical_channels = AOUT_CHANS_STEREO;
+    enc->fmt_in.audio.i_bitspersample = 16;
+    es_format_Init(&enc->fmt_out, AUDIO_ES, VLC_CODEC_FLAC);
+
+    enc->p_module = module_need(enc, "encoder", "flac", true);
+    if (enc->p_module == NULL)
+    {
+        vlc_object_delete(enc);
+        return NULL;
+    }
+
+    block_t *chain = NULL;
+    for (size_t i = 0; i < BLOCKS; i++)
+    {
+        block_t *block = block_Alloc(FRAMES * CHANNELS * sizeof (int16_t));
+        assert(block != NULL);
+        memcpy(block->p_buffer, &input[i * FRAMES * CHANNELS],
+               block->i_buffer);
+        block->i_nb_samples = FRAMES;
+        block->i_pts = block->i_dts = VLC_TICK_0
+                                    + vlc_tick_from_samples(i * FRAMES, RATE);
+        block->i_length = vlc_tick_from_samples(FRAMES, RATE);
+
+        block_ChainAppend(&chain, enc->pf_encode_audio(enc, block));
+        block_Release(block);
+    }
+
+    /* The STREAMINFO header, for the decoder */
+    es_format_Init(fmt, AUDIO_ES, VLC_CODEC_FLAC);
+    fmt->audio.i_rate = RATE;
+    fmt->audio.i_channels = CHANNELS;
+    fmt->i_extra = enc->fmt_out.i_extra;
+    fmt->p_extra = malloc(fmt->i_extra);
+    assert(fmt->p_extra != NULL);
+    memcpy(fmt->p_extra, enc->fmt_out.p_extra, fmt->i_extra);
+
+    module_unneed(enc, enc->p_module);
+    es_format_Clean(&enc->fmt_in);
+    es_format_Clean(&enc->fmt_out);
+    vlc_object_delete(enc);
+    return chain;
+}
+
+/* Decodes all the frames, and returns the decoded blocks */
+static block_t *Decode(libvlc_instance_t *vlc, const es_format_t *fmt,
+                       const block_t *frames, unsigned threads)
+{
+    static const struct decoder_owner_callbacks cbs =
+    {
+        .audio = {
+            .format_update = FormatUpdate,
+            .queue = QueueAudio,
+        },
+    };
+
+    decoder_t *dec = vlc_object_create(vlc->p_libvlc_int, sizeof (*dec));
+    assert(dec != NULL);
+
+    var_Create(dec, "flac-threads", VLC_VAR_INTEGER);
+    var_SetInteger(dec, "flac-threads", threads);
+    decoder_Init(dec, fmt);
+    dec->cbs = &cbs;
+
+    dec->p_module = module_need(dec, "audio decoder", "flac", true);
+    if (dec->p_module == NULL)
+    {
+        decoder_Clean(dec);
+        vlc_object_delete(dec);
+        return NULL;
+    }
+
+    for (const block_t *frame = frames; frame != NULL; frame = frame->p_next)
+    {
+        block_t *block = block_Alloc(frame->i_buffer);
+        assert(block != NULL);
+        memcpy(block->p_buffer, frame->p_buffer, frame->i_buffer);
+        block->i_pts = frame->i_pts;
+        block->i_dts = frame->i_dts;
+
+        int ret = dec->pf_decode(dec, block);
+        assert(ret == VLCDEC_SUCCESS);
+    }
+    dec->pf_decode(dec, NULL); /* drain */
+
+    module_unneed(dec, dec->p_module);
+    decoder_Clean(dec);
+    vlc_object_delete(dec);
+
+    block_t *out = output;
+    output = NULL;
+    return out;
+}
+
+/* Lossless: the decoded samples are the input ones, in order, with
+ * contiguous dates */
+static size_t Check(const block_t *out, unsigned threads)
+{
+    size_t frames = 0;
+
+    for (; out != NULL; out = out->p_next)
+    {
+        /* The encoder dates in whole microseconds */
+        assert(llabs(out->i_pts - VLC_TICK_0
+                     - vlc_tick_from_samples(frames, RATE)) <= 2);
+
+        const int32_t *samples = (const int32_t *)out->p_buffer;
+        for (size_t i = 0; i < out->i_nb_samples * CHANNELS; i++)
+            if (samples[i] != input[frames * CHANNELS + i] * 65536)
+            {
+                fprintf(stderr, "%u threads: frame %zu channel %zu: %"PRId32
+                        " instead of %d\n", threads, frames + i / CHANNELS,
+                        i % CHANNELS, samples[i] / 65536,
+                        input[frames * CHANNELS + i]);
+                abort();
+            }
+        frames += out->i_nb_samples;
+        assert(frames <= BLOCKS * FRAMES);
+    }
+    return frames;
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    if (vlc == NULL)
+        return 1;
+
+    Fill();
+
+    es_format_t fmt;
+    block_t *frames = Encode(vlc, &fmt);
+    if (frames == NULL)
+    {
+        fprintf(stderr, "no FLAC encoder\n");
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    block_t *single = Decode(vlc, &fmt, frames, 1);
+    if (single == NULL)
+    {
+        fprintf(stderr, "no FLAC decoder\n");
+        block_ChainRelease(frames);
+        es_format_Clean(&fmt);
+        libvlc_release(vlc);
+        return 77;
+    }
+    block_t *threaded = Decode(vlc, &fmt, frames, 4);
+    assert(threaded != NULL);
+
+    /* The encoder keeps the last partial frame */
+    size_t count = Check(single, 1);
+    printf("1 thread: %zu frames out of %u\n", count, BLOCKS * FRAMES);
+    assert(count >= (BLOCKS - 8) * FRAMES);
+    assert(Check(threaded, 4) == count);
+
+    /* Same blocks, whether threaded or not */
+    const block_t *a = single, *b = threaded;
+    for (; a != NULL && b != NULL; a = a->p_next, b = b->p_next)
+    {
+        assert(a->i_nb_samples == b->i_nb_samples);
+        assert(a->i_pts == b->i_pts && a->i_length == b->i_length);
+    }
+    assert(a == NULL && b == NULL);
+
+    block_ChainRelease(threaded);
+    block_ChainRelease(single);
+    block_ChainRelease(frames);
+    es_format_Clean(&fmt);
+    libvlc_release(vlc);
+    return 0;
+}
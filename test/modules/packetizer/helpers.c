@@ -30,6 +30,7 @@
 #include <vlc_block_helper.h>
 
 #include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/packetizer_helper.h"
 
 struct results_s
 {
@@ -90,6 +91,107 @@ static int run_annexb_sets( const uint8_t *p_set, const uint8_t *p_end,
     return 0;
 }
 
+static void zerocopy_reset( void *p_private, bool b_flush )
+{
+    VLC_UNUSED(p_private); VLC_UNUSED(b_flush);
+}
+
+static block_t *zerocopy_parse( void *p_private, bool *pb_ts_used, block_t *p_block )
+{
+    unsigned *pi_sliced = p_private;
+    *pb_ts_used = false;
+    while( p_block->i_buffer > 5 && p_block->p_buffer[p_block->i_buffer-1] == 0x00 )
+        p_block->i_buffer--;
+    if( p_block->cbs == &packetizer_slice_cbs )
+        (*pi_sliced)++;
+    return p_block;
+}
+
+static int zerocopy_validate( void *p_private, block_t *p_block )
+{
+    VLC_UNUSED(p_private); VLC_UNUSED(p_block);
+    return 0;
+}
+
+/* Packetizes the stream in blocks of various sizes, and checks that the
+ * fragments are the same, whether they are copied or sliced */
+static unsigned run_zerocopy( const uint8_t *p_stream, size_t i_stream,
+                              bool b_zero_copy, block_t **pp_out )
+{
+    static const uint8_t p_startcode[3] = { 0, 0, 1 };
+    packetizer_t packetizer;
+    unsigned i_sliced = 0;
+    size_t i_block = 1000;
+
+    packetizer_Init( &packetizer, p_startcode, 3, startcode_FindAnnexB,
+                     p_startcode, 1, 5, zerocopy_reset, zerocopy_parse,
+                     zerocopy_validate, NULL, &i_sliced );
+    packetizer.b_zero_copy = b_zero_copy;
+
+    for( size_t i = 0; i < i_stream; i += i_block, i_block = i_block * 3 % 65521 )
+    {
+        block_t *p_block = block_Alloc( __MIN(i_block, i_stream - i) );
+        assert( p_block );
+        memcpy( p_block->p_buffer, &p_stream[i], p_block->i_buffer );
+
+        block_t *p_out;
+        while( (p_out = packetizer_Packetize( &packetizer, &p_block )) )
+            block_ChainLastAppend( &pp_out, p_out );
+    }
+
+    block_t *p_out;
+    while( (p_out = packetizer_Packetize( &packetizer, NULL )) )
+        block_ChainLastAppend( &pp_out, p_out );
+
+    packetizer_Clean( &packetizer );
+    return i_sliced;
+}
+
+static int test_zerocopy( void )
+{
+    const size_t i_stream = 1 << 20;
+    uint8_t *p_stream = malloc( i_stream );
+    assert( p_stream );
+
+    /* NALs of 10 to 20000 bytes, with 3 and 4 bytes startcodes */
+    size_t i_next = 0, i_nal = 0;
+    for( size_t i = 0; i < i_stream; i++ )
+    {
+        if( i == i_next && i + 4 <= i_stream )
+        {
+            i_next = i + 10 + (i_nal * i_nal * 7919) % 20000;
+            if( i_nal++ & 1 )
+                p_stream[i++] = 0x00;
+            p_stream[i++] = 0x00;
+            p_stream[i++] = 0x00;
+            p_stream[i] = 0x01;
+        }
+        else
+            p_stream[i] = 0x02 + i % 0xfd;
+    }
+
+    block_t *p_copied = NULL, *p_sliced = NULL;
+    run_zerocopy( p_stream, i_stream, false, &p_copied );
+    unsigned i_count = run_zerocopy( p_stream, i_stream, true, &p_sliced );
+    printf("%u fragments sliced\n", i_count);
+
+    int i_ret = i_count > 0 ? 0 : 1;
+    for( block_t *a = p_copied, *b = p_sliced; a || b; a = a->p_next, b = b->p_next )
+    {
+        if( !a || !b || a->i_buffer != b->i_buffer ||
+            memcmp( a->p_buffer, b->p_buffer, a->i_buffer ) )
+        {
+            i_ret = 1;
+            break;
+        }
+    }
+
+    block_ChainRelease( p_copied );
+    block_ChainRelease( p_sliced );
+    free( p_stream );
+    return i_ret;
+}
+
 int main( void )
 {
     const uint8_t test1_annexbdata[] = { 0, 0, 0, 1, 0x55, 0x55, 0x55, 0x55, 0x55, // 9
@@ -134,5 +236,6 @@ int main( void )
             return i_ret;
     }
 
-    return 0;
+    printf("* Running zero-copy packetizer tests:\n");
+    return test_zerocopy();
 }
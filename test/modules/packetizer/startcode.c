@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * startcode.c: Annex B startcode scanners unit testing and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/hxxx_ep3b.h"
+
+#define BENCH_SIZE  (4 << 20)
+#define BENCH_LOOPS 8
+
+typedef const uint8_t *(*startcode_find_t)(const uint8_t *, const uint8_t *);
+
+static const struct
+{
+    const char *name;
+    startcode_find_t find;
+} scanners[] = {
+#define SCANNER(name) { #name, startcode_FindAnnexB_##name }
+    SCANNER(Bits),
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    SCANNER(SSE2),
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    SCANNER(AVX2),
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    SCANNER(NEON),
+#endif
+#undef SCANNER
+};
+
+static bool Available(const char *name)
+{
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    if (!strcmp(name, "SSE2"))
+        return vlc_CPU_SSE2();
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if (!strcmp(name, "AVX2"))
+        return vlc_CPU_AVX2();
+#endif
+    VLC_UNUSED(name);
+    return true;
+}
+
+static uint32_t seed = 0x12345678;
+
+static uint8_t Random(void)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 24;
+}
+
+/* Mostly zeros and ones, to hit every partial match */
+static void FillSparse(uint8_t *buf, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        uint8_t r = Random();
+        buf[i] = r < 0x60 ? 0x00 : r < 0x80 ? 0x01 : r < 0x90 ? 0x03 : r;
+    }
+}
+
+static const uint8_t *FindReference(const uint8_t *p, const uint8_t *end)
+{
+    for (; end - p >= 3; p++)
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    return NULL;
+}
+
+static void TestScanners(void)
+{
+    uint8_t buf[256 + 64];
+
+    for (unsigned run = 0; run < 2000; run++)
+    {
+        FillSparse(buf, sizeof (buf));
+
+        /* All alignments and lengths, including the tails */
+        size_t offset = Random() % 64;
+        size_t size = Random();
+        const uint8_t *p = buf + offset, *end = p + size;
+
+        for (size_t i = 0; i < ARRAY_SIZE(scanners); i++)
+        {
+            if (!Available(scanners[i].name))
+                continue;
+
+            const uint8_t *q = p, *ref = p;
+            do
+            {
+                ref = FindReference(ref, end);
+                q = scanners[i].find(q, end);
+                if (q != ref)
+                {
+                    fprintf(stderr, "%s: got %td, expected %td (offset %zu size %zu)\n",
+                            scanners[i].name, q ? q - p : -1,
+                            ref ? ref - p : -1, offset, size);
+                    abort();
+                }
+                if (ref != NULL)
+                    ref = ++q;
+            } while (ref != NULL);
+        }
+    }
+}
+
+/* Byte by byte, as hxxx_ep3b_total_size() used to */
+static size_t TotalSizeReference(const uint8_t *p, const uint8_t *end)
+{
+    unsigned prev = 0;
+    size_t i = 0;
+    while (p < end)
+    {
+        uint8_t *n = hxxx_ep3b_to_rbsp((uint8_t *)p, (uint8_t *)end, &prev, 1);
+        if (n > p)
+            ++i;
+        p = n;
+    }
+    return i;
+}
+
+static void TestEp3b(void)
+{
+    uint8_t buf[512];
+
+    for (unsigned run = 0; run < 2000; run++)
+    {
+        size_t size = 1 + Random() * 2;
+
+        /* From dense to sparse zeros */
+        for (size_t i = 0; i < size; i++)
+            buf[i] = (Random() & 0x7f) > run / 16 ? Random() | 1 : 0x00;
+        for (size_t i = 0; i < size; i++)
+            if (Random() < 0x20)
+                buf[i] = 0x03;
+
+        assert(hxxx_ep3b_total_size(buf, buf + size)
+               == TotalSizeReference(buf, buf + size));
+    }
+}
+
+static void Benchmark(void)
+{
+    uint8_t *buf = malloc(BENCH_SIZE);
+    assert(buf != NULL);
+
+    /* Coded data: random bytes with a NAL every 1500 bytes or so */
+    for (size_t i = 0; i < BENCH_SIZE; i++)
+        buf[i] = Random();
+    for (size_t i = 0; i + 4 < BENCH_SIZE; i += 1000 + Random() * 4)
+        memcpy(&buf[i], (const uint8_t[]){ 0, 0, 0, 1 }, 4);
+
+    for (size_t i = 0; i < ARRAY_SIZE(scanners); i++)
+    {
+        if (!Available(scanners[i].name))
+            continue;
+
+        unsigned count = 0;
+        vlc_tick_t start = vlc_tick_now();
+        for (unsigned loop = 0; loop < BENCH_LOOPS; loop++)
+            for (const uint8_t *p = buf;
+                 (p = scanners[i].find(p, buf + BENCH_SIZE)) != NULL; p += 3)
+                count++;
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+
+        printf("%-4s: %u startcodes, %7.1f MiB/s\n", scanners[i].name,
+               count / BENCH_LOOPS, BENCH_LOOPS * (BENCH_SIZE >> 20)
+               / secf_from_vlc_tick(elapsed + 1));
+    }
+
+    vlc_tick_t start = vlc_tick_now();
+    size_t total = 0;
+    for (unsigned loop = 0; loop < BENCH_LOOPS; loop++)
+        total += hxxx_ep3b_total_size(buf, buf + BENCH_SIZE);
+    printf("EP3B: %zu bytes of RBSP, %7.1f MiB/s\n", total / BENCH_LOOPS,
+           BENCH_LOOPS * (BENCH_SIZE >> 20)
+           / secf_from_vlc_tick(vlc_tick_now() - start + 1));
+
+    free(buf);
+}
+
+int main(void)
+{
+    test_init();
+
+    TestScanners();
+    TestEp3b();
+    if (test_bench())
+        Benchmark();
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*****************************************************************************
+ * yuv_rgba.c: YUV to RGBA converter test, against swscale
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#define WIDTH     320
+#define HEIGHT    240
+#define X_OFFSET  6
+#define Y_OFFSET  3
+
+/* swscale interpolates the chroma where yuv_rgba duplicates it: on smooth
+ * chroma, the results differ by a few steps at most. */
+#define TOLERANCE 3
+
+static const vlc_fourcc_t inputs[] = {
+    VLC_CODEC_I420, VLC_CODEC_YV12, VLC_CODEC_NV12,
+};
+
+static const vlc_fourcc_t outputs[] = {
+    VLC_CODEC_RGBA, VLC_CODEC_BGRA,
+};
+
+static filter_t *CreateConverter(libvlc_instance_t *vlc, const char *name,
+                                 const video_format_t *src, vlc_fourcc_t dst)
+{
+    filter_t *filter = vlc_object_create(vlc->p_libvlc_int, sizeof (*filter));
+    if (filter == NULL)
+        return NULL;
+
+    es_format_Init(&filter->fmt_in, VIDEO_ES, src->i_chroma);
+    filter->fmt_in.video = *src;
+
+    es_format_Init(&filter->fmt_out, VIDEO_ES, dst);
+    video_format_Setup(&filter->fmt_out.video, dst,
+                       src->i_visible_width, src->i_visible_height,
+                       src->i_visible_width, src->i_visible_height, 1, 1);
+
+    filter->p_module = module_need(filter, "video converter", name, true);
+    if (filter->p_module == NULL)
+    {
+        vlc_object_delete(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+static void DeleteConverter(filter_t *filter)
+{
+    module_unneed(filter, filter->p_module);
+    vlc_object_delete(filter);
+}
+
+static picture_t *Convert(libvlc_instance_t *vlc, const char *name,
+                          const video_format_t *src, vlc_fourcc_t dst,
+                          picture_t *pic)
+{
+    filter_t *filter = CreateConverter(vlc, name, src, dst);
+    if (filter == NULL)
+        return NULL;
+
+    picture_t *out = filter->pf_video_filter(filter, picture_Hold(pic));
+    assert(out != NULL);
+    DeleteConverter(filter);
+    return out;
+}
+
+/* Random luma, smooth chroma */
+static void Fill(picture_t *pic)
+{
+    for (int i = 0; i < pic->p[0].i_visible_lines; i++)
+        for (int x = 0; x < pic->p[0].i_visible_pitch; x++)
+            pic->p[0].p_pixels[i * pic->p[0].i_pitch + x] = 16 + rand() % 220;
+
+    for (int p = 1; p < pic->i_planes; p++)
+    {
+        plane_t *c = &pic->p[p];
+
+        const int range = c->i_visible_pitch / c->i_pixel_pitch
+                        + c->i_visible_lines;
+
+        /* Diagonal gradients, in opposite directions for U and V */
+        for (int i = 0; i < c->i_visible_lines; i++)
+            for (int x = 0; x < c->i_visible_pitch; x++)
+            {
+                int val = 48 + (x / c->i_pixel_pitch + i) * 160 / range;
+
+                if (p == 2 || x % c->i_pixel_pitch)
+                    val = 256 - val;
+                c->p_pixels[i * c->i_pitch + x] = val;
+            }
+    }
+}
+
+static int TestConversion(libvlc_instance_t *vlc, vlc_fourcc_t src,
+                          vlc_fourcc_t dst)
+{
+    video_format_t fmt;
+
+    video_format_Setup(&fmt, src, WIDTH, HEIGHT, WIDTH, HEIGHT, 1, 1);
+    fmt.space = COLOR_SPACE_BT601;
+    fmt.color_range = COLOR_RANGE_LIMITED;
+
+    picture_t *pic = picture_NewFromFormat(&fmt);
+    assert(pic != NULL);
+    Fill(pic);
+
+    picture_t *out = Convert(vlc, "yuv_rgba", &fmt, dst, pic);
+    if (out == NULL)
+    {   /* Not on this CPU */
+        picture_Release(pic);
+        return 77;
+    }
+
+    picture_t *ref = Convert(vlc, "swscale", &fmt, dst, pic);
+    if (ref == NULL)
+    {
+        picture_Release(out);
+        picture_Release(pic);
+        return 77;
+    }
+
+    unsigned long long error = 0;
+    for (unsigned y = 0; y < HEIGHT; y++)
+    {
+        const uint8_t *a = &out->p[0].p_pixels[y * out->p[0].i_pitch];
+        const uint8_t *b = &ref->p[0].p_pixels[y * ref->p[0].i_pitch];
+
+        for (unsigned x = 0; x < 4 * WIDTH; x++)
+        {
+            int diff = abs(a[x] - b[x]);
+            if (diff > TOLERANCE)
+            {
+                fprintf(stderr, "%4.4s->%4.4s: pixel %ux%u component %u: "
+                        "%u instead of %u\n", (const char *)&src,
+                        (const char *)&dst, x / 4, y, x % 4, a[x], b[x]);
+                abort();
+            }
+            error += diff;
+        }
+    }
+    printf("%4.4s->%4.4s: average error %.3f\n", (const char *)&src,
+           (const char *)&dst, error / (4. * WIDTH * HEIGHT));
+    assert(error < 4ull * WIDTH * HEIGHT);
+    picture_Release(ref);
+
+    /* Cropped: same pixels as the matching area of the whole picture */
+    video_format_t crop = fmt;
+    crop.i_x_offset = X_OFFSET;
+    crop.i_y_offset = Y_OFFSET;
+    crop.i_visible_width = WIDTH - 2 * X_OFFSET;
+    crop.i_visible_height = HEIGHT - 2 * Y_OFFSET;
+
+    picture_t *cropped = Convert(vlc, "yuv_rgba", &crop, dst, pic);
+    assert(cropped != NULL);
+    for (unsigned y = 0; y < crop.i_visible_height; y++)
+        assert(!memcmp(&cropped->p[0].p_pixels[y * cropped->p[0].i_pitch],
+                       &out->p[0].p_pixels[(y + Y_OFFSET) * out->p[0].i_pitch
+                                           + 4 * X_OFFSET],
+                       4 * crop.i_visible_width));
+    picture_Release(cropped);
+
+    picture_Release(out);
+    picture_Release(pic);
+    return 0;
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    if (vlc == NULL)
+        return 1;
+
+    int ret = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(inputs) * ARRAY_SIZE(outputs); i++)
+    {
+        ret = TestConversion(vlc, inputs[i / ARRAY_SIZE(outputs)],
+                             outputs[i % ARRAY_SIZE(outputs)]);
+        if (ret != 0)
+            break;
+    }
+
+    libvlc_release(vlc);
+    return ret;
+}
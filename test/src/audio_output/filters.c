@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * filters.c: audio filters chain buffers test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+
+#define FRAMES 1024 /* per input block */
+#define WARMUP 16   /* blocks */
+#define BLOCKS 512
+
+static block_t *NewInput(unsigned index)
+{
+    block_t *block = block_Alloc(FRAMES * 2 * sizeof (int16_t));
+    assert(block != NULL);
+
+    int16_t *samples = (int16_t *)block->p_buffer;
+    for (unsigned i = 0; i < 2 * FRAMES; i++)
+        samples[i] = (index * FRAMES + i / 2) * 64;
+
+    block->i_nb_samples = FRAMES;
+    block->i_pts = block->i_dts = VLC_TICK_0
+        + vlc_tick_from_samples(index * FRAMES, 44100);
+    block->i_length = vlc_tick_from_samples(FRAMES, 44100);
+    return block;
+}
+
+/* Converts and resamples, and checks that the chain output buffers are
+ * recycled once the chain is running */
+static void TestChain(vlc_object_t *obj)
+{
+    audio_sample_format_t in = {
+        .i_format = VLC_CODEC_S16N,
+        .i_rate = 44100,
+        .i_physical_channels = AOUT_CHANS_STEREO,
+        .i_chan_mode = 0,
+        .channel_type = AUDIO_CHANNEL_TYPE_BITMAP,
+    };
+    audio_sample_format_t out = in;
+
+    out.i_format = VLC_CODEC_FL32;
+    out.i_rate = 48000;
+    aout_FormatPrepare(&in);
+    aout_FormatPrepare(&out);
+
+    aout_filters_t *filters = aout_FiltersNew(obj, &in, &out, NULL);
+    assert(filters != NULL);
+
+    aout_filters_stats_t warm, stats;
+    size_t frames = 0;
+
+    for (unsigned i = 0; i < BLOCKS; i++)
+    {
+        if (i == WARMUP)
+            aout_FiltersGetStats(filters, &warm);
+
+        block_t *block = aout_FiltersPlay(filters, NewInput(i), 1.f);
+        if (block != NULL)
+        {
+            frames += block->i_nb_samples;
+            block_Release(block);
+        }
+    }
+    aout_FiltersGetStats(filters, &stats);
+
+    printf("%"PRIu64" buffers, %"PRIu64" allocations (%"PRIu64" after %u "
+           "blocks), %zu frames out\n", stats.buffers, stats.allocations,
+           warm.allocations, WARMUP, frames);
+
+    /* At least one filter needs output buffers */
+    assert(stats.buffers > warm.buffers);
+    /* None allocates once the pool holds enough buffers */
+    assert(stats.allocations == warm.allocations);
+    assert(frames > 0);
+
+    aout_FiltersDelete(obj, filters);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    if (vlc == NULL)
+        return 1;
+
+    vlc_object_t *obj = vlc_object_create(vlc->p_libvlc_int, sizeof (*obj));
+    assert(obj != NULL);
+
+    TestChain(obj);
+
+    vlc_object_delete(obj);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*****************************************************************************
+ * ring.c: audio output ring buffer test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+
+#define RATE     48000
+#define CHANNELS 3
+#define FRAMES   (RATE * 5) /* through the threaded test */
+
+typedef struct
+{
+    uint32_t s[CHANNELS];
+} frame_t;
+
+static void Fill(frame_t *f, size_t count, uint32_t first)
+{
+    for (size_t i = 0; i < count; i++)
+        for (unsigned c = 0; c < CHANNELS; c++)
+            f[i].s[c] = first + i;
+}
+
+static void Check(const frame_t *f, size_t count, uint32_t first)
+{
+    for (size_t i = 0; i < count; i++)
+        for (unsigned c = 0; c < CHANNELS; c++)
+            assert(f[i].s[c] == first + i);
+}
+
+static void TestSingleThread(void)
+{
+    frame_t buf[300];
+    const void *p;
+
+    /* 100 ms at 48 kHz rounds up to 8192 frames */
+    vlc_aout_ring_t *ring = vlc_aout_ring_New(sizeof (frame_t), RATE,
+                                              VLC_TICK_FROM_MS(100));
+    assert(ring != NULL);
+    assert(vlc_aout_ring_Peek(ring, &p) == 0);
+    assert(vlc_aout_ring_GetDelay(ring, VLC_TICK_0) == 0);
+
+    /* Wrap around many times */
+    uint32_t written = 0, read = 0;
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        Fill(buf, 300, written);
+        written += vlc_aout_ring_Write(ring, buf, 300);
+        assert(written - read <= 8192);
+
+        size_t count = vlc_aout_ring_Read(ring, buf, 250, VLC_TICK_INVALID);
+        Check(buf, count, read);
+        read += count;
+    }
+
+    /* Full */
+    while (written - read < 8192)
+    {
+        Fill(buf, 300, written);
+        written += vlc_aout_ring_Write(ring, buf, 300);
+    }
+    assert(vlc_aout_ring_Write(ring, buf, 1) == 0);
+    assert(vlc_aout_ring_GetDelay(ring, VLC_TICK_0)
+           == vlc_tick_from_samples(8192, RATE));
+
+    /* Zero-copy read, in at most two parts */
+    size_t count = vlc_aout_ring_Peek(ring, &p);
+    assert(count > 0 && count <= 8192);
+    Check(p, count, read);
+    vlc_aout_ring_Consume(ring, count, VLC_TICK_0);
+    read += count;
+    if (written != read)
+    {
+        count = vlc_aout_ring_Peek(ring, &p);
+        assert(count == written - read);
+        Check(p, count, read);
+    }
+
+    /* The consumed frames are still being rendered */
+    vlc_aout_ring_Consume(ring, 0, VLC_TICK_0 + VLC_TICK_FROM_MS(10));
+    assert(vlc_aout_ring_GetDelay(ring, VLC_TICK_0)
+           == vlc_tick_from_samples(written - read, RATE)
+              + VLC_TICK_FROM_MS(10));
+    assert(vlc_aout_ring_GetDelay(ring, VLC_TICK_0 + VLC_TICK_FROM_MS(4))
+           == vlc_tick_from_samples(written - read, RATE)
+              + VLC_TICK_FROM_MS(6));
+    assert(vlc_aout_ring_GetDelay(ring, VLC_TICK_0 + VLC_TICK_FROM_MS(20))
+           == vlc_tick_from_samples(written - read, RATE));
+
+    /* Flush, before the consumer applies it */
+    vlc_aout_ring_Flush(ring);
+    assert(vlc_aout_ring_GetDelay(ring, VLC_TICK_0 + VLC_TICK_FROM_MS(20))
+           == 0);
+    assert(vlc_aout_ring_Peek(ring, &p) == 0);
+
+    Fill(buf, 10, 1234);
+    assert(vlc_aout_ring_Write(ring, buf, 10) == 10);
+    assert(vlc_aout_ring_Read(ring, buf, 300, VLC_TICK_INVALID) == 10);
+    Check(buf, 10, 1234);
+
+    vlc_aout_ring_Delete(ring);
+}
+
+struct consumer
+{
+    vlc_aout_ring_t *ring;
+    uint32_t read;
+};
+
+/* Mimics a real-time callback, reading periods of various sizes */
+static void *Consumer(void *data)
+{
+    struct consumer *c = data;
+
+    while (c->read < FRAMES)
+    {
+        frame_t buf[256];
+        const void *p;
+        size_t period = 1 + (c->read * 7919) % 256;
+
+        size_t count = vlc_aout_ring_Peek(c->ring, &p);
+        if (count > period)
+            count = period;
+        Check(p, count, c->read);
+        vlc_aout_ring_Consume(c->ring, count, vlc_tick_now());
+        c->read += count;
+
+        count = vlc_aout_ring_Read(c->ring, buf, period, vlc_tick_now());
+        Check(buf, count, c->read);
+        c->read += count;
+        if (count == 0)
+            vlc_tick_wait(vlc_tick_now() + VLC_HARD_MIN_SLEEP);
+    }
+    return NULL;
+}
+
+static void TestThreads(void)
+{
+    struct consumer c = { .read = 0 };
+    vlc_thread_t th;
+    frame_t buf[1000];
+
+    c.ring = vlc_aout_ring_New(sizeof (frame_t), RATE, VLC_TICK_FROM_MS(200));
+    assert(c.ring != NULL);
+
+    int ret = vlc_clone(&th, Consumer, &c, VLC_THREAD_PRIORITY_LOW);
+    assert(ret == 0);
+
+    uint32_t written = 0;
+    while (written < FRAMES)
+    {
+        size_t count = 1 + (written * 104729) % 1000;
+        if (count > FRAMES - written)
+            count = FRAMES - written;
+
+        Fill(buf, count, written);
+        for (size_t done = 0; done < count;)
+        {
+            size_t n = vlc_aout_ring_Write(c.ring, buf + done, count - done);
+
+            assert(vlc_aout_ring_GetDelay(c.ring, vlc_tick_now()) >= 0);
+            if (n == 0) /* full */
+                vlc_tick_wait(vlc_tick_now() + VLC_HARD_MIN_SLEEP);
+            done += n;
+        }
+        written += count;
+    }
+
+    vlc_join(th, NULL);
+    assert(c.read == FRAMES);
+    vlc_aout_ring_Delete(c.ring);
+}
+
+int main(void)
+{
+    test_init();
+
+    TestSingleThread();
+    TestThreads();
+    return 0;
+}
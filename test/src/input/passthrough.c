@@ -0,0 +1,201 @@
+/*****************************************************************************
+ * passthrough.c: test the stream output passthrough of packetized streams
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+
+#define MOCK_URL "mock://video_track_count=1;sub_track_count=1;" \
+                 "length=500000;video_codec="
+#define MAX_BLOCKS 32 /* per track, 25 fps for 0.5 s */
+
+/* Per-block timestamps, as written by the stats stream output */
+struct track
+{
+    int id;
+    char type[16];
+    size_t count;
+    struct
+    {
+        int64_t dts_difference;
+        int64_t length;
+    } blocks[MAX_BLOCKS];
+};
+
+struct remux
+{
+    size_t count;
+    struct track tracks[2];
+};
+
+static void on_end_reached(const struct libvlc_event_t *event, void *data)
+{
+    (void) event;
+    vlc_sem_post(data);
+}
+
+static void Remux(const char *path, const char *codec, bool passthrough)
+{
+    char *sout, *url;
+    int ret = asprintf(&sout, "--sout=#stats{output=%s}", path);
+    assert(ret != -1);
+
+    const char *argv[] = {
+        "-v", sout, "--sout-all",
+        passthrough ? "--sout-passthrough" : "--no-sout-passthrough",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+    free(sout);
+
+    ret = asprintf(&url, MOCK_URL"%s", codec);
+    assert(ret != -1);
+    libvlc_media_t *media = libvlc_media_new_location(vlc, url);
+    assert(media != NULL);
+    free(url);
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media(media);
+    assert(mp != NULL);
+    libvlc_media_release(media);
+
+    vlc_sem_t sem;
+    vlc_sem_init(&sem, 0);
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager(mp);
+    ret = libvlc_event_attach(em, libvlc_MediaPlayerEndReached,
+                              on_end_reached, &sem);
+    assert(ret == 0);
+
+    ret = libvlc_media_player_play(mp);
+    assert(ret == 0);
+    vlc_sem_wait(&sem);
+
+    libvlc_event_detach(em, libvlc_MediaPlayerEndReached, on_end_reached,
+                        &sem);
+    /* The stats file is complete once the stream output is closed */
+    libvlc_media_player_release(mp);
+    libvlc_release(vlc);
+    vlc_sem_destroy(&sem);
+}
+
+static void Parse(const char *path, struct remux *remux)
+{
+    FILE *file = fopen(path, "r");
+    assert(file != NULL);
+
+    remux->count = 0;
+
+    char line[256];
+    while (fgets(line, sizeof (line), file) != NULL)
+    {
+        if (line[0] == '#')
+            continue;
+
+        int id;
+        char type[16];
+        uint64_t segment;
+        int64_t dts_difference, length;
+        int ret = sscanf(line, "%*s\t%d\t%15s\t%"SCNu64"\t%"SCNd64"\t%"SCNd64,
+                         &id, type, &segment, &dts_difference, &length);
+        assert(ret == 5);
+
+        struct track *track = NULL;
+        for (size_t i = 0; i < remux->count; i++)
+            if (remux->tracks[i].id == id)
+                track = &remux->tracks[i];
+        if (track == NULL)
+        {
+            assert(remux->count < ARRAY_SIZE(remux->tracks));
+            track = &remux->tracks[remux->count++];
+            track->id = id;
+            strcpy(track->type, type);
+            track->count = 0;
+        }
+
+        assert(track->count < MAX_BLOCKS);
+        assert(segment == track->count + 1);
+        track->blocks[track->count].dts_difference = dts_difference;
+        track->blocks[track->count].length = length;
+        track->count++;
+    }
+    fclose(file);
+}
+
+static const struct track *Find(const struct remux *remux, int id)
+{
+    for (size_t i = 0; i < remux->count; i++)
+        if (remux->tracks[i].id == id)
+            return &remux->tracks[i];
+    return NULL;
+}
+
+/*
+ * Remuxes a video and a SUBT ES, with and without passthrough. VP8 is passed
+ * through, VP9 is not: either way, the output blocks are the same.
+ */
+static void Test(const char *path, const char *codec)
+{
+    struct remux packetized, passthrough;
+
+    Remux(path, codec, false);
+    Parse(path, &packetized);
+    Remux(path, codec, true);
+    Parse(path, &passthrough);
+
+    /* The video and the subtitles */
+    assert(packetized.count == 2);
+    assert(passthrough.count == packetized.count);
+
+    /* Same blocks, with the same dates and lengths */
+    for (size_t i = 0; i < packetized.count; i++)
+    {
+        const struct track *a = &packetized.tracks[i];
+        const struct track *b = Find(&passthrough, a->id);
+
+        assert(b != NULL);
+        assert(strcmp(a->type, b->type) == 0);
+        assert(a->count > 0 && b->count == a->count);
+
+        for (size_t j = 0; j < a->count; j++)
+        {
+            assert(a->blocks[j].dts_difference
+                   == b->blocks[j].dts_difference);
+            assert(a->blocks[j].length == b->blocks[j].length);
+        }
+    }
+}
+
+int main(void)
+{
+    test_init();
+
+    char path[] = "/tmp/vlc-passthrough-XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+
+    Test(path, "VP80");
+    Test(path, "VP90");
+
+    unlink(path);
+    return 0;
+}
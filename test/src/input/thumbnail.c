@@ -25,8 +25,12 @@
 #include <vlc_thumbnailer.h>
 #include <vlc_input_item.h>
 #include <vlc_picture.h>
+#include <vlc_modules.h>
 
 #include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define MOCK_DURATION VLC_TICK_FROM_SEC( 5 * 60 )
 
@@ -207,6 +211,161 @@ static void test_cancel_thumbnail( libvlc_instance_t* p_vlc )
     vlc_thumbnailer_Release( p_thumbnailer );
 }
 
+static void thumbnailer_callback_batch( void* data, size_t index,
+                                       picture_t* p_thumbnail )
+{
+    struct test_ctx* p_ctx = data;
+    vlc_mutex_lock( &p_ctx->lock );
+
+    /* One thumbnail per requested time, in order */
+    assert( index == p_ctx->test_idx );
+    assert( p_thumbnail != NULL );
+    assert( p_thumbnail->format.i_chroma == VLC_CODEC_ARGB );
+
+    if ( ++p_ctx->test_idx == 3 )
+    {
+        p_ctx->b_done = true;
+        vlc_cond_signal( &p_ctx->cond );
+    }
+    vlc_mutex_unlock( &p_ctx->lock );
+}
+
+static void test_batch_thumbnails( libvlc_instance_t* p_vlc,
+                                   enum vlc_thumbnailer_seek_speed speed )
+{
+    static const vlc_tick_t times[] = {
+        VLC_TICK_FROM_SEC( 10 ), VLC_TICK_FROM_SEC( 60 ), VLC_TICK_FROM_SEC( 120 ),
+    };
+
+    vlc_thumbnailer_t* p_thumbnailer = vlc_thumbnailer_Create(
+                VLC_OBJECT( p_vlc->p_libvlc_int ) );
+    assert( p_thumbnailer != NULL );
+
+    struct test_ctx ctx;
+    vlc_cond_init( &ctx.cond );
+    vlc_mutex_init( &ctx.lock );
+    ctx.test_idx = 0;
+    ctx.b_done = false;
+
+    char* psz_mrl;
+    if ( asprintf( &psz_mrl, "mock://video_track_count=1;audio_track_count=1"
+                   ";length=%" PRId64 ";video_chroma=ARGB", MOCK_DURATION ) < 0 )
+        assert( !"Failed to allocate mock mrl" );
+    input_item_t* p_item = input_item_New( psz_mrl, "mock item" );
+    assert( p_item != NULL );
+
+    vlc_mutex_lock( &ctx.lock );
+    int res = 0;
+    vlc_thumbnailer_request_t* p_req = vlc_thumbnailer_RequestBatch(
+        p_thumbnailer, times, ARRAY_SIZE( times ), speed, p_item,
+        VLC_TICK_FROM_SEC( 3 ), thumbnailer_callback_batch, &ctx );
+    assert( p_req != NULL );
+    while ( ctx.b_done == false )
+    {
+        vlc_tick_t timeout = vlc_tick_now() + VLC_TICK_FROM_SEC( 3 );
+        res = vlc_cond_timedwait( &ctx.cond, &ctx.lock, timeout );
+        assert( res != ETIMEDOUT );
+    }
+    vlc_mutex_unlock( &ctx.lock );
+
+    input_item_Release( p_item );
+    free( psz_mrl );
+    vlc_thumbnailer_Release( p_thumbnailer );
+}
+
+struct file_ctx
+{
+    vlc_cond_t cond;
+    vlc_mutex_t lock;
+    unsigned count;
+    char *path;
+};
+
+static void thumbnailer_callback_file( void* data, const char* path )
+{
+    struct file_ctx* p_ctx = data;
+    struct stat st;
+
+    vlc_mutex_lock( &p_ctx->lock );
+    assert( path != NULL );
+    /* Complete when notified */
+    int res = stat( path, &st );
+    assert( res == 0 && st.st_size > 0 );
+    if ( p_ctx->path == NULL )
+        p_ctx->path = strdup( path );
+    else
+        assert( strcmp( p_ctx->path, path ) == 0 );
+    p_ctx->count++;
+    vlc_cond_signal( &p_ctx->cond );
+    vlc_mutex_unlock( &p_ctx->lock );
+}
+
+static void test_file_thumbnails( libvlc_instance_t* p_vlc )
+{
+    /* The files are encoded with the PNG encoder */
+    if ( !module_exists( "png" ) )
+        return;
+
+    char dir[] = "/tmp/vlc-thumbnail-XXXXXX";
+    char *res = mkdtemp( dir );
+    assert( res != NULL );
+
+    vlc_thumbnailer_t* p_thumbnailer = vlc_thumbnailer_Create(
+                VLC_OBJECT( p_vlc->p_libvlc_int ) );
+    assert( p_thumbnailer != NULL );
+
+    struct file_ctx ctx;
+    vlc_cond_init( &ctx.cond );
+    vlc_mutex_init( &ctx.lock );
+    ctx.count = 0;
+    ctx.path = NULL;
+
+    char* psz_mrl;
+    if ( asprintf( &psz_mrl, "mock://video_track_count=1;audio_track_count=1"
+                   ";length=%" PRId64 ";video_chroma=ARGB", MOCK_DURATION ) < 0 )
+        assert( !"Failed to allocate mock mrl" );
+    input_item_t* p_item = input_item_New( psz_mrl, "mock item" );
+    assert( p_item != NULL );
+
+    /* The same thumbnail twice at once, then once more from the cache */
+    static const unsigned expected[] = { 0, 2, 3 };
+
+    vlc_mutex_lock( &ctx.lock );
+    for ( unsigned i = 0; i < ARRAY_SIZE( expected ); i++ )
+    {
+        vlc_thumbnailer_request_t* p_req = vlc_thumbnailer_RequestToFile(
+            p_thumbnailer, VLC_TICK_FROM_SEC( 60 ), VLC_THUMBNAILER_SEEK_FAST,
+            p_item, VLC_TICK_FROM_SEC( 3 ), VLC_CODEC_PNG, 64, 0, false, dir,
+            thumbnailer_callback_file, &ctx );
+        assert( p_req != NULL );
+
+        while ( ctx.count < expected[i] )
+        {
+            vlc_tick_t timeout = vlc_tick_now() + VLC_TICK_FROM_SEC( 3 );
+            int val = vlc_cond_timedwait( &ctx.cond, &ctx.lock, timeout );
+            assert( val != ETIMEDOUT );
+        }
+    }
+    vlc_mutex_unlock( &ctx.lock );
+    vlc_thumbnailer_Release( p_thumbnailer );
+
+    /* No temporary file left behind */
+    DIR *d = opendir( dir );
+    assert( d != NULL );
+    unsigned files = 0;
+    for ( struct dirent *ent; ( ent = readdir( d ) ) != NULL; )
+        if ( ent->d_name[0] != '.' )
+            files++;
+    closedir( d );
+    assert( files == 1 );
+
+    unlink( ctx.path );
+    rmdir( dir );
+    free( ctx.path );
+    input_item_Release( p_item );
+    free( psz_mrl );
+}
+
 int main()
 {
     test_init();
@@ -220,6 +379,9 @@ int main()
 
     test_thumbnails( vlc );
     test_cancel_thumbnail( vlc );
+    test_batch_thumbnails( vlc, VLC_THUMBNAILER_SEEK_FAST );
+    test_batch_thumbnails( vlc, VLC_THUMBNAILER_SEEK_KEYFRAME );
+    test_file_thumbnails( vlc );
 
     libvlc_release( vlc );
 }